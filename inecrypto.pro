@@ -4,6 +4,9 @@
 ########################################################################################################################
 
 TEMPLATE = subdirs
-SUBDIRS = inecrypto test
+SUBDIRS = inecrypto test allocations
 
 test.depends = inecrypto
+
+allocations.subdir = test/allocations
+allocations.depends = inecrypto
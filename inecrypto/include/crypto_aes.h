@@ -0,0 +1,136 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header provides pointer and length based AES-256 functions that do not depend on Qt.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_AES_H
+#define CRYPTO_AES_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Crypto {
+    /**
+     * The AES-256 key length, in bytes.
+     */
+    constexpr unsigned aesKeyLength = 32;
+
+    /**
+     * The AES block length, in bytes.  This is also the length of the CBC IV and the CTR counter block.
+     */
+    constexpr unsigned aesBlockLength = 16;
+
+    /**
+     * Function you can use to determine the number of bytes \ref Crypto::aesCbcEncrypt will produce.
+     *
+     * \param[in] inputLength The number of bytes to be encrypted.
+     *
+     * \return Returns the encrypted size, in bytes.
+     */
+    constexpr std::size_t aesCbcEncryptedSize(std::size_t inputLength) {
+        return ((inputLength + aesBlockLength - 1) / aesBlockLength) * aesBlockLength;
+    }
+
+    /**
+     * Function you can use to encrypt a buffer using AES-256 in CBC mode.  A partial final block is padded the same
+     * way as \ref Crypto::AesCbcEncryptor so the output matches that class, less any IV header.
+     *
+     * \param[in]  keys           Pointer to the aesKeyLength byte key.
+     *
+     * \param[in]  iv             Pointer to the aesBlockLength byte IV.
+     *
+     * \param[in]  inputData      Pointer to the data to be encrypted.
+     *
+     * \param[in]  inputLength    The number of bytes to be encrypted.
+     *
+     * \param[out] outputData     Pointer to the buffer to receive the encrypted data.  The buffer may be the input
+     *                            buffer but must not otherwise overlap it.
+     *
+     * \param[in]  outputCapacity The size of the output buffer, in bytes.
+     *
+     * \return Returns the number of bytes written.  A value of 0 is returned if the output buffer is too small.
+     */
+    std::size_t aesCbcEncrypt(
+        const std::uint8_t* keys,
+        const std::uint8_t* iv,
+        const std::uint8_t* inputData,
+        std::size_t         inputLength,
+        std::uint8_t*       outputData,
+        std::size_t         outputCapacity
+    );
+
+    /**
+     * Function you can use to decrypt a buffer using AES-256 in CBC mode.  Any partial final block is ignored and
+     * padding is not removed.
+     *
+     * \param[in]  keys           Pointer to the aesKeyLength byte key.
+     *
+     * \param[in]  iv             Pointer to the aesBlockLength byte IV.
+     *
+     * \param[in]  inputData      Pointer to the data to be decrypted.
+     *
+     * \param[in]  inputLength    The number of bytes to be decrypted.
+     *
+     * \param[out] outputData     Pointer to the buffer to receive the decrypted data.  The buffer may be the input
+     *                            buffer but must not otherwise overlap it.
+     *
+     * \param[in]  outputCapacity The size of the output buffer, in bytes.
+     *
+     * \return Returns the number of bytes written.  A value of 0 is returned if the output buffer is too small.
+     */
+    std::size_t aesCbcDecrypt(
+        const std::uint8_t* keys,
+        const std::uint8_t* iv,
+        const std::uint8_t* inputData,
+        std::size_t         inputLength,
+        std::uint8_t*       outputData,
+        std::size_t         outputCapacity
+    );
+
+    /**
+     * Function you can use to encrypt or decrypt a buffer using AES-256 in CTR mode.  The counter block is treated as
+     * a 128-bit big endian value, matching \ref Crypto::AesCtrEncryptor.
+     *
+     * \param[in]  keys           Pointer to the aesKeyLength byte key.
+     *
+     * \param[in]  initialCounter Pointer to the aesBlockLength byte counter block for the first byte of the stream.
+     *
+     * \param[in]  byteOffset     The offset of the first input byte within the stream.
+     *
+     * \param[in]  inputData      Pointer to the data to be processed.
+     *
+     * \param[out] outputData     Pointer to the buffer to receive the processed data.  The input and output pointers
+     *                            may be identical.
+     *
+     * \param[in]  length         The number of bytes to be processed.
+     */
+    void aesCtrApply(
+        const std::uint8_t* keys,
+        const std::uint8_t* initialCounter,
+        unsigned long long  byteOffset,
+        const std::uint8_t* inputData,
+        std::uint8_t*       outputData,
+        std::size_t         length
+    );
+}
+
+#endif
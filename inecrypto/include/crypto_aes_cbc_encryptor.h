@@ -39,6 +39,8 @@ class QObject;
 struct AES_ctx;
 
 namespace Crypto {
+    class AesCbcKeyRoller;
+
     /**
      * Class that provides support for AES-256 encryption with CBC.
      */
@@ -148,12 +150,69 @@ namespace Crypto {
              */
             unsigned inputChunkSize() const override;
 
+            /**
+             * Method you can use to enable or disable the IV header.  When enabled, a new random IV is generated each
+             * time the engine is reset and is sent ahead of the encrypted data.  The IV supplied to the constructor
+             * or to \ref Crypto::AesCbcEncryptor::setIV is ignored while the IV header is enabled.
+             *
+             * \param[in] nowEnabled If true, the IV header will be enabled.  If false, the IV header will be
+             *                       disabled.
+             */
+            void setIVHeaderEnabled(bool nowEnabled = true);
+
+            /**
+             * Method you can use to determine if the IV header is enabled.
+             *
+             * \return Returns true if the IV header is enabled.  Returns false if the IV header is disabled.
+             */
+            bool ivHeaderEnabled() const;
+
+            /**
+             * Method you can use to rotate the keys at fixed intervals within a stream.  The keys for each interval
+             * after the first are derived from the initial keys and the interval index using HKDF-Expand with
+             * HMAC-SHA256.  The decryptor must use the same interval.  The interval takes effect the next time the
+             * engine is reset.
+             *
+             * \param[in] newRekeyInterval The number of bytes encrypted with each key.  The value is rounded up to a
+             *                             multiple of the AES block size.  A value of 0, the default, disables key
+             *                             rotation.
+             */
+            void setRekeyInterval(unsigned long long newRekeyInterval);
+
+            /**
+             * Method you can use to determine the key rotation interval.
+             *
+             * \return Returns the number of bytes encrypted with each key.  A value of 0 indicates that key rotation
+             *         is disabled.
+             */
+            unsigned long long rekeyInterval() const;
+
+            /**
+             * Method you can use to determine the size of the header placed ahead of the encrypted data.
+             *
+             * \return Returns the header size, in bytes.
+             */
+            unsigned headerSize() const override;
+
         protected:
             /**
              * Method that is called to reset the encryption engine.
              */
             void resetEngine() override;
 
+            /**
+             * Method that is called once a buffer has been encrypted and when the device is closed.  The method clears
+             * any keys derived while rotating.
+             */
+            void finishEngine() override;
+
+            /**
+             * Method that is called to generate the header placed ahead of the encrypted data.
+             *
+             * \param[out] headerData Pointer to the buffer to receive the header.
+             */
+            void generateHeader(std::uint8_t* headerData) override;
+
             /**
              * Method you should overload to perform encryption on a single chunk.  Data will always be supplied in
              * full chunks.
@@ -164,6 +223,22 @@ namespace Crypto {
              */
             void encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) override;
 
+            /**
+             * Method that encrypts a run of contiguous chunks in one call.  The run is handed to tiny-aes at once
+             * rather than one chunk at a time.
+             *
+             * \param[in]  inputData    Pointer to the unencrypted data to be processed.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
+             */
+            void encryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
+
         private:
             /**
              * Method that initializes the IV to a default state.
@@ -181,9 +256,65 @@ namespace Crypto {
             IV initialIV;
 
             /**
-             * The encryption pointer.
+             * Flag indicating that the context holds the expanded form of the current keys.
+             */
+            bool keysExpanded;
+
+            /**
+             * Flag indicating if the IV is sent in the stream header.
+             */
+            bool includeIVHeader;
+
+            /**
+             * The configured key rotation interval, in blocks.
+             */
+            unsigned long long rekeyBlocks;
+
+            /**
+             * The key rotation interval, in blocks, in effect since the last reset.  A value of 0 indicates that key
+             * rotation is disabled.
+             */
+            unsigned long long activeRekeyBlocks;
+
+            /**
+             * Method that provides the AES context held by this instance.
+             *
+             * \return Returns a pointer to the AES context.
+             */
+            inline AES_ctx* context() {
+                return reinterpret_cast<AES_ctx*>(contextStorage);
+            }
+
+            /**
+             * The storage reserved for the AES context, in bytes.  This must be large enough to hold the expanded
+             * AES-256 key and the IV.
+             */
+            static constexpr unsigned contextStorageSize = 256;
+
+            /**
+             * Storage for the AES context.  The context is held in-line, aligned for vector loads, so that no heap
+             * allocation is needed per instance.
+             */
+            alignas(16) std::uint8_t contextStorage[contextStorageSize];
+
+            /**
+             * Method that provides the key roller held by this instance.
+             *
+             * \return Returns a pointer to the key roller.
+             */
+            inline AesCbcKeyRoller* keyRoller() {
+                return reinterpret_cast<AesCbcKeyRoller*>(keyRollerStorage);
+            }
+
+            /**
+             * The storage reserved for the key roller, in bytes.
+             */
+            static constexpr unsigned keyRollerStorageSize = 384;
+
+            /**
+             * Storage for the key roller.
              */
-            AES_ctx* context;
+            alignas(16) std::uint8_t keyRollerStorage[keyRollerStorageSize];
     };
 }
 
@@ -0,0 +1,342 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::AesCtrDecryptor class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_AES_CTR_DECRYPTOR_H
+#define CRYPTO_AES_CTR_DECRYPTOR_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+#include <cstddef>
+
+#include <crypto_decryptor.h>
+
+class QObject;
+
+namespace Crypto {
+    class AesCtrEngine;
+
+    /**
+     * Class that provides support for AES-256 decryption in counter (CTR) mode.  No padding is expected so the
+     * decrypted data is exactly the length of the encrypted data.  The keystream is generated several blocks at a time
+     * and, where available, the processor AES instructions are used.
+     */
+    class AesCtrDecryptor:public Decryptor {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The IV length, in bytes.
+             */
+            static constexpr unsigned ivLength = 16;
+
+            /**
+             * Array used to define the AES encryption key.
+             */
+            typedef std::uint8_t Keys[keyLength];
+
+            /**
+             * Array used to define the AES IV.  The IV is the initial counter block.
+             */
+            typedef std::uint8_t IV[ivLength];
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit AesCtrDecryptor(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit AesCtrDecryptor(QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit AesCtrDecryptor(const Keys& keys, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit AesCtrDecryptor(const Keys& keys, QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] iv     The decryptor initialization vector.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            AesCtrDecryptor(const Keys& keys, const IV& iv, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] iv     The decryptor initialization vector.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            AesCtrDecryptor(const Keys& keys, const IV& iv, QObject* parent = Q_NULLPTR);
+
+            ~AesCtrDecryptor() override;
+
+            /**
+             * Method you can use to obtain the length of the raw encryption key, in bytes.
+             *
+             * \return Returns the raw encryption key length, in bytes.
+             */
+            unsigned keyLengthInBytes() const override;
+
+            /**
+             * Method you can use to set the AES keys.
+             *
+             * \param[in] newKeys The new AES keys to be used.
+             */
+            void setKeys(const Keys& newKeys);
+
+            /**
+             * Method you can use to set the AES initialization vector.
+             *
+             * \param[in] newIV The new AES initialization vector to be used.
+             */
+            void setIV(const IV& newIV);
+
+            /**
+             * Method you can use to determine the decryption output chunk size.  Counter mode decrypts data a byte
+             * at a time so this method always returns 1.
+             *
+             * \return Returns the decrypted chunk size.
+             */
+            unsigned outputChunkSize() const override;
+
+            /**
+             * Method you can use to set the position in the keystream used for the first byte of data.  The offset
+             * is applied each time the engine is reset.  Together with a seek on the input device, this lets you
+             * decrypt any region of a larger stream without processing the data ahead of it.
+             *
+             * \param[in] newOffset The byte offset into the keystream.
+             */
+            void setStreamOffset(unsigned long long newOffset);
+
+            /**
+             * Method you can use to determine the position in the keystream used for the first byte of data.
+             *
+             * \return Returns the byte offset into the keystream.
+             */
+            unsigned long long streamOffset() const;
+
+            /**
+             * Method you can use to enable or disable the IV header.  When enabled, the IV is read from the start of
+             * the encrypted data.  The IV supplied to the constructor or to \ref Crypto::AesCtrDecryptor::setIV is
+             * ignored while the IV header is enabled.  The IV header is enabled by default unless an IV is supplied to
+             * the constructor.
+             *
+             * \param[in] nowEnabled If true, the IV header will be enabled.  If false, the IV header will be
+             *                       disabled.
+             */
+            void setIVHeaderEnabled(bool nowEnabled = true);
+
+            /**
+             * Method you can use to determine if the IV header is enabled.
+             *
+             * \return Returns true if the IV header is enabled.  Returns false if the IV header is disabled.
+             */
+            bool ivHeaderEnabled() const;
+
+            /**
+             * Method you can use to determine the size of the header expected ahead of the encrypted data.
+             *
+             * \return Returns the header size, in bytes.
+             */
+            unsigned headerSize() const override;
+
+            /**
+             * Method you can use to determine if the engine can start decrypting at an arbitrary chunk.
+             * The counter for any chunk can be calculated directly.
+             *
+             * \return Returns true.
+             */
+            bool supportsRandomAccess() const override;
+
+            /**
+             * Method you can use to determine if the engine can decrypt separate runs of chunks concurrently.  Each
+             * run only depends on its starting counter.
+             *
+             * \return Returns true.
+             */
+            bool supportsParallelDecryption() const override;
+
+        protected:
+            /**
+             * Method that is called to reset the encryption engine.
+             */
+            void resetEngine() override;
+
+            /**
+             * Method that is called to process the header received ahead of the encrypted data.
+             *
+             * \param[in] headerData Pointer to the received header.
+             */
+            void processHeader(const std::uint8_t* headerData) override;
+
+            /**
+             * Method that is called to position the engine at a given chunk.
+             *
+             * \param[in] chunkIndex    The zero based index of the next chunk to be decrypted.
+             *
+             * \param[in] previousChunk Pointer to the encrypted chunk ahead of the chunk to be decrypted, or null.
+             *
+             * \return Returns true on success.
+             */
+            bool seekEngine(unsigned long long chunkIndex, const std::uint8_t* previousChunk) override;
+
+            /**
+             * Method that decrypts a run of contiguous chunks using a private copy of the engine state.  This method
+             * may be called concurrently from multiple threads.
+             *
+             * \param[in]  chunkIndex    The zero based index of the first chunk in the run.
+             *
+             * \param[in]  previousChunk Pointer to a copy of the encrypted chunk ahead of the run, or null.
+             *
+             * \param[in]  inputData     Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData    Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks  The number of chunks to be processed.
+             */
+            void decryptChunkRange(
+                unsigned long long  chunkIndex,
+                const std::uint8_t* previousChunk,
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
+
+            /**
+             * Method you should overload to perform decryption on a single chunk.  Data will always be supplied in
+             * full chunks.
+             *
+             * \param[in]  inputData  Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the resulting data.
+             */
+            void decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) override;
+
+            /**
+             * Method that decrypts a run of contiguous chunks in one call.
+             *
+             * \param[in]  inputData    Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
+             */
+            void decryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
+
+        private:
+            /**
+             * Method that initializes the IV to a default state.
+             */
+            void initializeIV();
+
+            /**
+             * The initial key values.
+             */
+            Keys initialKeys;
+
+            /**
+             * The initial IV.
+             */
+            IV initialIV;
+
+            /**
+             * Flag indicating that the context holds the expanded form of the current keys.
+             */
+            bool keysExpanded;
+
+            /**
+             * Flag indicating if the IV is received in the stream header.
+             */
+            bool includeIVHeader;
+
+            /**
+             * The keystream offset applied when the engine is reset.
+             */
+            unsigned long long initialOffset;
+
+            /**
+             * The initial counter block used by the current stream.
+             */
+            IV currentIV;
+
+            /**
+             * Method that provides the counter mode engine held by this instance.
+             *
+             * \return Returns a pointer to the counter mode engine.
+             */
+            inline AesCtrEngine* engine() {
+                return reinterpret_cast<AesCtrEngine*>(engineStorage);
+            }
+
+            /**
+             * The storage reserved for the counter mode engine, in bytes.  This must be large enough to hold the
+             * expanded AES-256 key, the counter and the buffered keystream.
+             */
+            static constexpr unsigned engineStorageSize = 448;
+
+            /**
+             * Storage for the counter mode engine.  The engine is held in-line, aligned for vector loads, so that no
+             * heap allocation is needed per instance.
+             */
+            alignas(16) std::uint8_t engineStorage[engineStorageSize];
+    };
+}
+
+#endif
@@ -0,0 +1,297 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::AesCtrEncryptor class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_AES_CTR_ENCRYPTOR_H
+#define CRYPTO_AES_CTR_ENCRYPTOR_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+#include <cstddef>
+
+#include "crypto_encryptor.h"
+
+class QObject;
+
+namespace Crypto {
+    class AesCtrEngine;
+
+    /**
+     * Class that provides support for AES-256 encryption in counter (CTR) mode.  Counter mode turns AES into a stream
+     * cipher so no padding is applied and the encrypted data is exactly the length of the unencrypted data.  The
+     * keystream is generated several blocks at a time and, where available, the processor AES instructions are used.
+     *
+     * As with any stream cipher, a key and IV pair must never be used to encrypt two different streams.  The IV
+     * header is enabled by default so each stream starts from a new random counter block.  When an IV is supplied to
+     * the constructor the header is disabled and the caller must supply a fresh IV for each stream.
+     */
+    class AesCtrEncryptor:public Encryptor {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The IV length, in bytes.
+             */
+            static constexpr unsigned ivLength = 16;
+
+            /**
+             * Array used to define the AES encryption key.
+             */
+            typedef std::uint8_t Keys[keyLength];
+
+            /**
+             * Array used to define the AES IV.  The IV is the initial counter block.
+             */
+            typedef std::uint8_t IV[ivLength];
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit AesCtrEncryptor(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit AesCtrEncryptor(QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit AesCtrEncryptor(const Keys& keys, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit AesCtrEncryptor(const Keys& keys, QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] iv     The encryptor initialization vector.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            AesCtrEncryptor(const Keys& keys, const IV& iv, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] iv     The encryptor initialization vector.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            AesCtrEncryptor(const Keys& keys, const IV& iv, QObject* parent = Q_NULLPTR);
+
+            ~AesCtrEncryptor() override;
+
+            /**
+             * Method you can use to obtain the length of the raw encryption key, in bytes.
+             *
+             * \return Returns the raw encryption key length, in bytes.
+             */
+            unsigned keyLengthInBytes() const override;
+
+            /**
+             * Method you can use to set the AES keys.
+             *
+             * \param[in] newKeys The new AES keys to be used.
+             */
+            void setKeys(const Keys& newKeys);
+
+            /**
+             * Method you can use to set the AES initialization vector.
+             *
+             * \param[in] newIV The new AES initialization vector to be used.
+             */
+            void setIV(const IV& newIV);
+
+            /**
+             * Method you can use to determine the encryption input chunk size.  Counter mode encrypts data a byte
+             * at a time so this method always returns 1.
+             *
+             * \return Returns the encryption chunk size.
+             */
+            unsigned inputChunkSize() const override;
+
+            /**
+             * Method you can use to set the position in the keystream used for the first byte of data.  The offset
+             * is applied each time the engine is reset and lets you encrypt any region of a larger stream in
+             * isolation.
+             *
+             * \param[in] newOffset The byte offset into the keystream.
+             */
+            void setStreamOffset(unsigned long long newOffset);
+
+            /**
+             * Method you can use to determine the position in the keystream used for the first byte of data.
+             *
+             * \return Returns the byte offset into the keystream.
+             */
+            unsigned long long streamOffset() const;
+
+            /**
+             * Method you can use to enable or disable the IV header.  When enabled, a new random IV is generated each
+             * time the engine is reset and is sent ahead of the encrypted data.  The IV supplied to the constructor
+             * or to \ref Crypto::AesCtrEncryptor::setIV is ignored while the IV header is enabled.  The IV header is
+             * enabled by default unless an IV is supplied to the constructor.
+             *
+             * \param[in] nowEnabled If true, the IV header will be enabled.  If false, the IV header will be
+             *                       disabled.
+             */
+            void setIVHeaderEnabled(bool nowEnabled = true);
+
+            /**
+             * Method you can use to determine if the IV header is enabled.
+             *
+             * \return Returns true if the IV header is enabled.  Returns false if the IV header is disabled.
+             */
+            bool ivHeaderEnabled() const;
+
+            /**
+             * Method you can use to determine the size of the header placed ahead of the encrypted data.
+             *
+             * \return Returns the header size, in bytes.
+             */
+            unsigned headerSize() const override;
+
+        protected:
+            /**
+             * Method that is called to reset the encryption engine.
+             */
+            void resetEngine() override;
+
+            /**
+             * Method that is called to generate the header placed ahead of the encrypted data.
+             *
+             * \param[out] headerData Pointer to the buffer to receive the header.
+             */
+            void generateHeader(std::uint8_t* headerData) override;
+
+            /**
+             * Method you should overload to perform encryption on a single chunk.  Data will always be supplied in
+             * full chunks.
+             *
+             * \param[in]  inputData  Pointer to the unencrypted data to be processed.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the resulting data.
+             */
+            void encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) override;
+
+            /**
+             * Method that encrypts a run of contiguous chunks in one call.
+             *
+             * \param[in]  inputData    Pointer to the unencrypted data to be processed.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
+             */
+            void encryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
+
+        private:
+            /**
+             * Method that initializes the IV to a default state.
+             */
+            void initializeIV();
+
+            /**
+             * The initial key values.
+             */
+            Keys initialKeys;
+
+            /**
+             * The initial IV.
+             */
+            IV initialIV;
+
+            /**
+             * Flag indicating that the context holds the expanded form of the current keys.
+             */
+            bool keysExpanded;
+
+            /**
+             * Flag indicating if the IV is sent in the stream header.
+             */
+            bool includeIVHeader;
+
+            /**
+             * The keystream offset applied when the engine is reset.
+             */
+            unsigned long long initialOffset;
+
+            /**
+             * The IV used by the current stream.
+             */
+            IV currentIV;
+
+            /**
+             * Method that provides the counter mode engine held by this instance.
+             *
+             * \return Returns a pointer to the counter mode engine.
+             */
+            inline AesCtrEngine* engine() {
+                return reinterpret_cast<AesCtrEngine*>(engineStorage);
+            }
+
+            /**
+             * The storage reserved for the counter mode engine, in bytes.  This must be large enough to hold the
+             * expanded AES-256 key, the counter and the buffered keystream.
+             */
+            static constexpr unsigned engineStorageSize = 448;
+
+            /**
+             * Storage for the counter mode engine.  The engine is held in-line, aligned for vector loads, so that no
+             * heap allocation is needed per instance.
+             */
+            alignas(16) std::uint8_t engineStorage[engineStorageSize];
+    };
+}
+
+#endif
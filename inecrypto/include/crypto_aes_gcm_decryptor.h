@@ -0,0 +1,309 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::AesGcmDecryptor class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_AES_GCM_DECRYPTOR_H
+#define CRYPTO_AES_GCM_DECRYPTOR_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+#include <cstddef>
+
+#include <crypto_decryptor.h>
+
+class QObject;
+
+namespace Crypto {
+    class AesGcmEngine;
+
+    /**
+     * Class that provides AES-256 authenticated decryption in Galois/Counter mode (GCM).  The 16 byte
+     * authentication tag following the encrypted data is verified once the end of the input is reached.  The block
+     * API returns no data if the tag is invalid.  When streaming, data is released before the tag is verified so
+     * check \ref Crypto::Decryptor::trailerVerified before trusting it.
+     */
+    class AesGcmDecryptor:public Decryptor {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The IV length, in bytes.
+             */
+            static constexpr unsigned ivLength = 12;
+
+            /**
+             * The authentication tag length, in bytes.
+             */
+            static constexpr unsigned tagLength = 16;
+
+            /**
+             * Array used to define the AES encryption key.
+             */
+            typedef std::uint8_t Keys[keyLength];
+
+            /**
+             * Array used to define the AES-GCM IV.
+             */
+            typedef std::uint8_t IV[ivLength];
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit AesGcmDecryptor(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit AesGcmDecryptor(QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit AesGcmDecryptor(const Keys& keys, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit AesGcmDecryptor(const Keys& keys, QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] iv     The decryptor initialization vector.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            AesGcmDecryptor(const Keys& keys, const IV& iv, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] iv     The decryptor initialization vector.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            AesGcmDecryptor(const Keys& keys, const IV& iv, QObject* parent = Q_NULLPTR);
+
+            ~AesGcmDecryptor() override;
+
+            /**
+             * Method you can use to obtain the length of the raw encryption key, in bytes.
+             *
+             * \return Returns the raw encryption key length, in bytes.
+             */
+            unsigned keyLengthInBytes() const override;
+
+            /**
+             * Method you can use to set the AES keys.
+             *
+             * \param[in] newKeys The new AES keys to be used.
+             */
+            void setKeys(const Keys& newKeys);
+
+            /**
+             * Method you can use to set the AES initialization vector.
+             *
+             * \param[in] newIV The new AES initialization vector to be used.
+             */
+            void setIV(const IV& newIV);
+
+            /**
+             * Method you can use to determine the decryption output chunk size.  Galois/Counter mode decrypts data a
+             * byte at a time so this method always returns 1.
+             *
+             * \return Returns the decrypted chunk size.
+             */
+            unsigned outputChunkSize() const override;
+
+            /**
+             * Method you can use to set data that is authenticated, but not encrypted, along with each stream.  The
+             * data must match the data supplied to the encryptor.
+             *
+             * \param[in] newAssociatedData The associated data.
+             */
+            void setAssociatedData(const QByteArray& newAssociatedData);
+
+            /**
+             * Method you can use to obtain the data authenticated along with each stream.
+             *
+             * \return Returns the associated data.
+             */
+            QByteArray associatedData() const;
+
+            /**
+             * Method you can use to enable or disable the IV header.  When enabled, the IV is read from the start of
+             * the encrypted data.  The IV supplied to the constructor or to \ref Crypto::AesGcmDecryptor::setIV is
+             * ignored while the IV header is enabled.  The IV header is enabled by default unless an IV is supplied to
+             * the constructor.
+             *
+             * \param[in] nowEnabled If true, the IV header will be enabled.  If false, the IV header will be
+             *                       disabled.
+             */
+            void setIVHeaderEnabled(bool nowEnabled = true);
+
+            /**
+             * Method you can use to determine if the IV header is enabled.
+             *
+             * \return Returns true if the IV header is enabled.  Returns false if the IV header is disabled.
+             */
+            bool ivHeaderEnabled() const;
+
+            /**
+             * Method you can use to determine the size of the header expected ahead of the encrypted data.
+             *
+             * \return Returns the header size, in bytes.
+             */
+            unsigned headerSize() const override;
+
+            /**
+             * Method you can use to determine the size of the authentication tag expected after the encrypted data.
+             *
+             * \return Returns the trailer size, in bytes.
+             */
+            unsigned trailerSize() const override;
+
+        protected:
+            /**
+             * Method that is called to reset the encryption engine.
+             */
+            void resetEngine() override;
+
+            /**
+             * Method that is called to process the header received ahead of the encrypted data.
+             *
+             * \param[in] headerData Pointer to the received header.
+             */
+            void processHeader(const std::uint8_t* headerData) override;
+
+            /**
+             * Method that is called to verify the authentication tag received after the encrypted data.
+             *
+             * \param[in] trailerData Pointer to the received tag.
+             *
+             * \return Returns true if the tag is valid.  Returns false if the tag is invalid.
+             */
+            bool processTrailer(const std::uint8_t* trailerData) override;
+
+            /**
+             * Method you should overload to perform decryption on a single chunk.  Data will always be supplied in
+             * full chunks.
+             *
+             * \param[in]  inputData  Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the resulting data.
+             */
+            void decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) override;
+
+            /**
+             * Method that decrypts a run of contiguous chunks in one call.
+             *
+             * \param[in]  inputData    Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
+             */
+            void decryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
+
+        private:
+            /**
+             * Method that initializes the IV to a default state.
+             */
+            void initializeIV();
+
+            /**
+             * The initial key values.
+             */
+            Keys initialKeys;
+
+            /**
+             * The initial IV.
+             */
+            IV initialIV;
+
+            /**
+             * Flag indicating that the context holds the expanded form of the current keys.
+             */
+            bool keysExpanded;
+
+            /**
+             * Flag indicating if the IV is received in the stream header.
+             */
+            bool includeIVHeader;
+
+            /**
+             * The data authenticated along with each stream.
+             */
+            QByteArray currentAssociatedData;
+
+            /**
+             * Method that provides the Galois/Counter mode engine held by this instance.
+             *
+             * \return Returns a pointer to the Galois/Counter mode engine.
+             */
+            inline AesGcmEngine* engine() {
+                return reinterpret_cast<AesGcmEngine*>(engineStorage);
+            }
+
+            /**
+             * The storage reserved for the Galois/Counter mode engine, in bytes.  This must be large enough to hold
+             * the counter mode engine and the GHASH tables.
+             */
+            static constexpr unsigned engineStorageSize = 832;
+
+            /**
+             * Storage for the Galois/Counter mode engine.  The engine is held in-line, aligned for vector loads, so
+             * that no heap allocation is needed per instance.
+             */
+            alignas(16) std::uint8_t engineStorage[engineStorageSize];
+    };
+}
+
+#endif
@@ -0,0 +1,251 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::BlockEncryptor and \ref Crypto::BlockDecryptor templates.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_BLOCK_CIPHER_H
+#define CRYPTO_BLOCK_CIPHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Crypto {
+    /** \rst:leading-asterisk
+     *
+     * Template base class for block encryption engines that are bound at compile time.  The engine derives from
+     * ``Crypto::BlockEncryptor<Engine>`` and must provide:
+     *
+     * * ``static constexpr unsigned blockSize`` -- the block size, in bytes.
+     * * ``void reset()`` -- returns the engine to its initial state.
+     * * ``void encryptBlock(const std::uint8_t* inputData, std::uint8_t* outputData)`` -- encrypts one block.
+     *
+     * Because the engine type is known, the block loop calls the engine directly and the compiler is free to inline
+     * and unroll it.  An engine that can process several blocks more efficiently can provide its own
+     * ``encryptBlocks`` method which will be used instead of the default loop.  The padding applied by
+     * ``Crypto::BlockEncryptor::encrypt`` matches ``Crypto::Encryptor::encrypt`` so the output is identical to the
+     * ``QIODevice`` based classes, less any header or trailer.
+     *
+     * .. code-block:: c++
+     *    :caption: Example use of the ``Crypto::BlockEncryptor`` template
+     *
+     *    Crypto::XteaEncryptEngine engine(keys);
+     *
+     *    std::vector<std::uint8_t> output(Crypto::XteaEncryptEngine::encryptedSize(length));
+     *    engine.encrypt(input, length, output.data(), output.size());
+     *
+     * \endrst
+     */
+    template<typename Engine> class BlockEncryptor {
+        public:
+            /**
+             * Method you can use to determine the number of bytes \ref Crypto::BlockEncryptor::encrypt will produce.
+             *
+             * \param[in] inputLength The number of bytes to be encrypted.
+             *
+             * \return Returns the encrypted size, in bytes.
+             */
+            static constexpr std::size_t encryptedSize(std::size_t inputLength) {
+                return ((inputLength + Engine::blockSize - 1) / Engine::blockSize) * Engine::blockSize;
+            }
+
+            /**
+             * Method you can call to encrypt a data buffer.  The engine is reset first and a partial final block is
+             * padded.
+             *
+             * \param[in]  inputData      Pointer to the data to be encrypted.
+             *
+             * \param[in]  inputLength    The number of bytes to be encrypted.
+             *
+             * \param[out] outputData     Pointer to the buffer to receive the encrypted data.  The buffer may be the
+             *                            input buffer but must not otherwise overlap it.
+             *
+             * \param[in]  outputCapacity The size of the output buffer, in bytes.
+             *
+             * \return Returns the number of bytes written to the output buffer.  A value of 0 is returned if the
+             *         output buffer is too small.
+             */
+            std::size_t encrypt(
+                    const std::uint8_t* inputData,
+                    std::size_t         inputLength,
+                    std::uint8_t*       outputData,
+                    std::size_t         outputCapacity
+                ) {
+                Engine&     engine            = static_cast<Engine&>(*this);
+                std::size_t numberOutputBytes = encryptedSize(inputLength);
+                std::size_t result;
+
+                if (outputCapacity >= numberOutputBytes) {
+                    std::size_t numberBlocks   = inputLength / Engine::blockSize;
+                    std::size_t bytesRemaining = inputLength - numberBlocks * Engine::blockSize;
+
+                    engine.reset();
+                    engine.encryptBlocks(inputData, outputData, numberBlocks);
+
+                    if (bytesRemaining > 0) {
+                        std::uint8_t tail[Engine::blockSize];
+                        std::memcpy(tail, inputData + numberBlocks * Engine::blockSize, bytesRemaining);
+
+                        std::size_t bytesToAppend = Engine::blockSize - bytesRemaining;
+                        std::memset(tail + bytesRemaining, static_cast<int>(bytesToAppend), bytesToAppend);
+
+                        engine.encryptBlock(tail, outputData + numberBlocks * Engine::blockSize);
+                        std::memset(tail, 0, Engine::blockSize);
+                    }
+
+                    result = numberOutputBytes;
+                } else {
+                    result = 0;
+                }
+
+                return result;
+            }
+
+            /**
+             * Method that encrypts a run of whole blocks, continuing from the current engine state.
+             *
+             * \param[in]  inputData    Pointer to the data to be encrypted.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the encrypted data.  The buffer may be the
+             *                          input buffer but must not otherwise overlap it.
+             *
+             * \param[in]  numberBlocks The number of blocks to be encrypted.
+             */
+            inline void encryptBlocks(
+                    const std::uint8_t* inputData,
+                    std::uint8_t*       outputData,
+                    std::size_t         numberBlocks
+                ) {
+                Engine& engine = static_cast<Engine&>(*this);
+
+                for (std::size_t block=0 ; block<numberBlocks ; ++block) {
+                    engine.encryptBlock(inputData, outputData);
+
+                    inputData  += Engine::blockSize;
+                    outputData += Engine::blockSize;
+                }
+            }
+
+        protected:
+            BlockEncryptor() = default;
+
+            ~BlockEncryptor() = default;
+    };
+
+    /** \rst:leading-asterisk
+     *
+     * Template base class for block decryption engines that are bound at compile time.  The engine derives from
+     * ``Crypto::BlockDecryptor<Engine>`` and must provide:
+     *
+     * * ``static constexpr unsigned blockSize`` -- the block size, in bytes.
+     * * ``void reset()`` -- returns the engine to its initial state.
+     * * ``void decryptBlock(const std::uint8_t* inputData, std::uint8_t* outputData)`` -- decrypts one block.
+     *
+     * As with ``Crypto::BlockEncryptor``, an engine may provide its own ``decryptBlocks`` method.  Padding is
+     * retained in the output, matching ``Crypto::Decryptor::decrypt``.
+     *
+     * \endrst
+     */
+    template<typename Engine> class BlockDecryptor {
+        public:
+            /**
+             * Method you can use to determine the number of bytes \ref Crypto::BlockDecryptor::decrypt will produce.
+             *
+             * \param[in] inputLength The number of bytes to be decrypted.
+             *
+             * \return Returns the decrypted size, in bytes.
+             */
+            static constexpr std::size_t decryptedSize(std::size_t inputLength) {
+                return (inputLength / Engine::blockSize) * Engine::blockSize;
+            }
+
+            /**
+             * Method you can call to decrypt a data buffer.  The engine is reset first and any partial final block is
+             * ignored.
+             *
+             * \param[in]  inputData      Pointer to the data to be decrypted.
+             *
+             * \param[in]  inputLength    The number of bytes to be decrypted.
+             *
+             * \param[out] outputData     Pointer to the buffer to receive the decrypted data.  The buffer may be the
+             *                            input buffer but must not otherwise overlap it.
+             *
+             * \param[in]  outputCapacity The size of the output buffer, in bytes.
+             *
+             * \return Returns the number of bytes written to the output buffer.  A value of 0 is returned if the
+             *         output buffer is too small.
+             */
+            std::size_t decrypt(
+                    const std::uint8_t* inputData,
+                    std::size_t         inputLength,
+                    std::uint8_t*       outputData,
+                    std::size_t         outputCapacity
+                ) {
+                Engine&     engine            = static_cast<Engine&>(*this);
+                std::size_t numberOutputBytes = decryptedSize(inputLength);
+                std::size_t result;
+
+                if (outputCapacity >= numberOutputBytes) {
+                    engine.reset();
+                    engine.decryptBlocks(inputData, outputData, inputLength / Engine::blockSize);
+
+                    result = numberOutputBytes;
+                } else {
+                    result = 0;
+                }
+
+                return result;
+            }
+
+            /**
+             * Method that decrypts a run of whole blocks, continuing from the current engine state.
+             *
+             * \param[in]  inputData    Pointer to the data to be decrypted.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the decrypted data.  The buffer may be the
+             *                          input buffer but must not otherwise overlap it.
+             *
+             * \param[in]  numberBlocks The number of blocks to be decrypted.
+             */
+            inline void decryptBlocks(
+                    const std::uint8_t* inputData,
+                    std::uint8_t*       outputData,
+                    std::size_t         numberBlocks
+                ) {
+                Engine& engine = static_cast<Engine&>(*this);
+
+                for (std::size_t block=0 ; block<numberBlocks ; ++block) {
+                    engine.decryptBlock(inputData, outputData);
+
+                    inputData  += Engine::blockSize;
+                    outputData += Engine::blockSize;
+                }
+            }
+
+        protected:
+            BlockDecryptor() = default;
+
+            ~BlockDecryptor() = default;
+    };
+}
+
+#endif
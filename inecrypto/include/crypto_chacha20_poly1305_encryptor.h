@@ -0,0 +1,327 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::ChaCha20Poly1305Encryptor class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_CHACHA20_POLY1305_ENCRYPTOR_H
+#define CRYPTO_CHACHA20_POLY1305_ENCRYPTOR_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+#include <cstddef>
+
+#include "crypto_encryptor.h"
+
+class QObject;
+
+namespace Crypto {
+    class ChaCha20Poly1305Engine;
+
+    /**
+     * Class that provides ChaCha20-Poly1305 authenticated encryption as described in RFC 8439.  Data is encrypted
+     * with the ChaCha20 stream cipher and authenticated with Poly1305 in a single pass.  No padding is applied.  A 16
+     * byte authentication tag is appended after the encrypted data when the encryptor is closed or, for the block
+     * API, at the end of the output.  The cipher needs no special instructions so it is a fast alternative to
+     * \ref Crypto::AesGcmEncryptor on processors without the AES instructions.  Where available, SSE2 or AVX2 are
+     * used to generate four or eight keystream blocks at once.
+     *
+     * A key and nonce pair must never be used to encrypt two different streams.  The IV header is enabled by default
+     * so each stream gets a new random nonce.  When a nonce is supplied to the constructor the header is disabled and
+     * the nonce can only be used for one stream.  Further streams are refused until
+     * \ref Crypto::ChaCha20Poly1305Encryptor::setIV is called.  Streams are limited to just under 256 GiB.
+     */
+    class ChaCha20Poly1305Encryptor:public Encryptor {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The nonce length, in bytes.
+             */
+            static constexpr unsigned ivLength = 12;
+
+            /**
+             * The authentication tag length, in bytes.
+             */
+            static constexpr unsigned tagLength = 16;
+
+            /**
+             * Array used to define the ChaCha20 key.
+             */
+            typedef std::uint8_t Keys[keyLength];
+
+            /**
+             * Array used to define the ChaCha20-Poly1305 nonce.
+             */
+            typedef std::uint8_t IV[ivLength];
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit ChaCha20Poly1305Encryptor(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit ChaCha20Poly1305Encryptor(QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit ChaCha20Poly1305Encryptor(const Keys& keys, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit ChaCha20Poly1305Encryptor(const Keys& keys, QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] iv     The encryptor initialization vector.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            ChaCha20Poly1305Encryptor(const Keys& keys, const IV& iv, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The default encryption keys to be used.
+             *
+             * \param[in] iv     The encryptor initialization vector.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            ChaCha20Poly1305Encryptor(const Keys& keys, const IV& iv, QObject* parent = Q_NULLPTR);
+
+            ~ChaCha20Poly1305Encryptor() override;
+
+            /**
+             * Method you can use to obtain the length of the raw encryption key, in bytes.
+             *
+             * \return Returns the raw encryption key length, in bytes.
+             */
+            unsigned keyLengthInBytes() const override;
+
+            /**
+             * Method you can use to set the ChaCha20 keys.
+             *
+             * \param[in] newKeys The new ChaCha20 keys to be used.
+             */
+            void setKeys(const Keys& newKeys);
+
+            /**
+             * Method you can use to set the nonce.  Without the IV header, each nonce can be used for a single stream.
+             *
+             * \param[in] newIV The new nonce to be used.
+             */
+            void setIV(const IV& newIV);
+
+            /**
+             * Method you can use to determine the encryption input chunk size.  ChaCha20-Poly1305 encrypts data a byte
+             * at a time so this method always returns 1.
+             *
+             * \return Returns the encryption chunk size.
+             */
+            unsigned inputChunkSize() const override;
+
+            /**
+             * Method you can use to set data that is authenticated, but not encrypted, along with each stream.  The
+             * same data must be supplied to the decryptor.
+             *
+             * \param[in] newAssociatedData The associated data.
+             */
+            void setAssociatedData(const QByteArray& newAssociatedData);
+
+            /**
+             * Method you can use to obtain the data authenticated along with each stream.
+             *
+             * \return Returns the associated data.
+             */
+            QByteArray associatedData() const;
+
+            /**
+             * Method you can use to enable or disable the IV header.  When enabled, a new random IV is generated each
+             * time the engine is reset and is sent ahead of the encrypted data.  The IV supplied to the constructor
+             * or to \ref Crypto::ChaCha20Poly1305Encryptor::setIV is ignored while the IV header is enabled.  The IV
+             * header is enabled by default unless an IV is supplied to the constructor.
+             *
+             * \param[in] nowEnabled If true, the IV header will be enabled.  If false, the IV header will be
+             *                       disabled.
+             */
+            void setIVHeaderEnabled(bool nowEnabled = true);
+
+            /**
+             * Method you can use to determine if the IV header is enabled.
+             *
+             * \return Returns true if the IV header is enabled.  Returns false if the IV header is disabled.
+             */
+            bool ivHeaderEnabled() const;
+
+            /**
+             * Method you can use to determine the size of the header placed ahead of the encrypted data.
+             *
+             * \return Returns the header size, in bytes.
+             */
+            unsigned headerSize() const override;
+
+            /**
+             * Method you can use to determine the size of the authentication tag placed after the encrypted data.
+             *
+             * \return Returns the trailer size, in bytes.
+             */
+            unsigned trailerSize() const override;
+
+        protected:
+            /**
+             * Method that is called to reset the encryption engine.
+             */
+            void resetEngine() override;
+
+            /**
+             * Method that is called before a new stream is started.  Without the IV header, an IV can only be used
+             * for one stream.
+             *
+             * \return Returns true if the IV header is enabled or if the current IV has not yet been used.
+             */
+            bool streamAllowed() const override;
+
+            /**
+             * Method that is called to generate the header placed ahead of the encrypted data.
+             *
+             * \param[out] headerData Pointer to the buffer to receive the header.
+             */
+            void generateHeader(std::uint8_t* headerData) override;
+
+            /**
+             * Method that is called to generate the authentication tag placed after the encrypted data.
+             *
+             * \param[out] trailerData Pointer to the buffer to receive the tag.
+             */
+            void generateTrailer(std::uint8_t* trailerData) override;
+
+            /**
+             * Method you should overload to perform encryption on a single chunk.  Data will always be supplied in
+             * full chunks.
+             *
+             * \param[in]  inputData  Pointer to the unencrypted data to be processed.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the resulting data.
+             */
+            void encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) override;
+
+            /**
+             * Method that encrypts a run of contiguous chunks in one call.
+             *
+             * \param[in]  inputData    Pointer to the unencrypted data to be processed.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
+             */
+            void encryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
+
+        private:
+            /**
+             * Method that initializes the IV to a default state.
+             */
+            void initializeIV();
+
+            /**
+             * The initial key values.
+             */
+            Keys initialKeys;
+
+            /**
+             * The initial IV.
+             */
+            IV initialIV;
+
+            /**
+             * Flag indicating if the IV is sent in the stream header.
+             */
+            bool includeIVHeader;
+
+            /**
+             * Flag indicating that the IV supplied by the caller has been used by a stream.
+             */
+            bool ivUsed;
+
+            /**
+             * The data authenticated along with each stream.
+             */
+            QByteArray currentAssociatedData;
+
+            /**
+             * The IV used by the current stream.
+             */
+            IV currentIV;
+
+            /**
+             * Method that provides the ChaCha20-Poly1305 engine held by this instance.
+             *
+             * \return Returns a pointer to the ChaCha20-Poly1305 engine.
+             */
+            inline ChaCha20Poly1305Engine* engine() {
+                return reinterpret_cast<ChaCha20Poly1305Engine*>(engineStorage);
+            }
+
+            /**
+             * The storage reserved for the ChaCha20-Poly1305 engine, in bytes.  This must be large enough to hold
+             * the buffered keystream and the Poly1305 state.
+             */
+            static constexpr unsigned engineStorageSize = 704;
+
+            /**
+             * Storage for the ChaCha20-Poly1305 engine.  The engine is held in-line, aligned for vector loads, so
+             * that no heap allocation is needed per instance.
+             */
+            alignas(16) std::uint8_t engineStorage[engineStorageSize];
+    };
+}
+
+#endif
@@ -38,6 +38,11 @@ namespace Crypto {
      */
     class CipherBase {
         public:
+            /**
+             * The default PBKDF2 iteration count used by \ref Crypto::CipherBase::deriveKey.
+             */
+            static constexpr unsigned long defaultIterations = 600000;
+
             /**
              * Method you can use to obtain the length of the raw encryption key, in bytes.
              *
@@ -46,7 +51,9 @@ namespace Crypto {
             virtual unsigned keyLengthInBytes() const = 0;
 
             /**
-             * Method you can use to convert an arbitrary byte array to a properly sized encryption key.
+             * Method you can use to convert an arbitrary byte array to a properly sized encryption key.  The bytes are
+             * simply folded into the key so this method must not be used with passwords.  The method is retained so
+             * existing keys can be reproduced.  Use \ref Crypto::CipherBase::deriveKey for new keys.
              *
              * \param[out] keyArray An array to hold the generated encryption key.
              *
@@ -63,6 +70,60 @@ namespace Crypto {
              * \param[in]  str      The string to be converted.
              */
             void generateKey(std::uint8_t* keyArray, const QString& str) const;
+
+            /**
+             * Method you can use to derive a properly sized encryption key from a password using
+             * PBKDF2-HMAC-SHA256.
+             *
+             * \param[out] keyArray   An array to hold the derived encryption key.
+             *
+             * \param[in]  password   The password.
+             *
+             * \param[in]  salt       The salt.  The salt should be random, at least 16 bytes long and unique to each
+             *                        key.  The salt does not need to be kept secret.
+             *
+             * \param[in]  iterations The PBKDF2 iteration count.
+             *
+             * \return Returns true on success.  Returns false if the iteration count is 0.
+             */
+            bool deriveKey(
+                std::uint8_t*     keyArray,
+                const QByteArray& password,
+                const QByteArray& salt,
+                unsigned long     iterations = defaultIterations
+            ) const;
+
+            /**
+             * Method you can use to derive a properly sized encryption key from a string using PBKDF2-HMAC-SHA256.
+             * The string will be converted to a UTF-8 encoded byte array and then used as the password.
+             *
+             * \param[out] keyArray   An array to hold the derived encryption key.
+             *
+             * \param[in]  password   The password.
+             *
+             * \param[in]  salt       The salt.  The salt should be random, at least 16 bytes long and unique to each
+             *                        key.  The salt does not need to be kept secret.
+             *
+             * \param[in]  iterations The PBKDF2 iteration count.
+             *
+             * \return Returns true on success.  Returns false if the iteration count is 0.
+             */
+            bool deriveKey(
+                std::uint8_t*     keyArray,
+                const QString&    password,
+                const QByteArray& salt,
+                unsigned long     iterations = defaultIterations
+            ) const;
+
+        protected:
+            /**
+             * Method that fills a buffer with an unpredictable IV or nonce.
+             *
+             * \param[out] ivData   Pointer to the buffer to receive the IV.
+             *
+             * \param[in]  ivLength The IV length, in bytes.
+             */
+            static void generateRandomIV(std::uint8_t* ivData, unsigned ivLength);
     };
 }
 
@@ -0,0 +1,245 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::Compressor class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_COMPRESSOR_H
+#define CRYPTO_COMPRESSOR_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+
+class QObject;
+
+namespace Crypto {
+    /**
+     * Class that compresses a stream before it is handed to an encryptor.  Data written to the compressor is
+     * collected into blocks of a fixed size, each block is compressed with zlib and the framed block is written to
+     * the output device, typically a \ref Crypto::Encryptor.  Blocks that do not shrink are stored uncompressed.  At
+     * most one block is buffered so memory use is bounded regardless of the stream length.  Use
+     * \ref Crypto::Decompressor to recover the stream.
+     *
+     * Each block is framed by a 32-bit big endian header.  The lower 31 bits hold the length of the block payload.
+     * The upper bit is set if the payload is stored uncompressed.  Compressed payloads are in the format produced by
+     * qCompress.
+     *
+     * Note that the length of compressed data depends on its content.  Do not compress data that mixes secrets
+     * with data an attacker can influence if the attacker can also observe the length of the ciphertext.
+     */
+    class Compressor:public QIODevice {
+        public:
+            /**
+             * The length of the header preceding each block, in bytes.
+             */
+            static constexpr unsigned blockHeaderLength = 4;
+
+            /**
+             * The default block size, in bytes.
+             */
+            static constexpr unsigned defaultBlockSize = 64 * 1024;
+
+            /**
+             * The largest supported block size, in bytes.
+             */
+            static constexpr unsigned maximumBlockSize = 16 * 1024 * 1024;
+
+            /**
+             * Flag set in the block header when the block is stored uncompressed.
+             */
+            static constexpr std::uint32_t storedFlag = 0x80000000UL;
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit Compressor(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit Compressor(QObject* parent = Q_NULLPTR);
+
+            ~Compressor() override;
+
+            /**
+             * Method you can use to set the block size.  Larger blocks compress better at the cost of memory and
+             * latency.  The block size can only be changed while the device is closed.
+             *
+             * \param[in] newBlockSize The new block size, in bytes.  The value is limited to between 1 and
+             *                         \ref Crypto::Compressor::maximumBlockSize.
+             */
+            void setBlockSize(unsigned newBlockSize);
+
+            /**
+             * Method you can use to determine the block size.
+             *
+             * \return Returns the block size, in bytes.
+             */
+            unsigned blockSize() const;
+
+            /**
+             * Method you can use to set the zlib compression level.
+             *
+             * \param[in] newCompressionLevel The new compression level, 0 through 9.  A value of -1 selects the zlib
+             *                                default.
+             */
+            void setCompressionLevel(int newCompressionLevel);
+
+            /**
+             * Method you can use to determine the zlib compression level.
+             *
+             * \return Returns the compression level.
+             */
+            int compressionLevel() const;
+
+            /**
+             * Method you can call to compress a block of data in one pass.  The result uses the same framing as the
+             * stream so it can be decompressed with either API of \ref Crypto::Decompressor.
+             *
+             * \param[in] inputBuffer The data to be compressed.
+             *
+             * \return Returns the compressed data.
+             */
+            QByteArray compress(const QByteArray& inputBuffer) const;
+
+            /**
+             * Method you can use to set the output device.
+             *
+             * \param[in] outputDevice The device to receive the compressed stream.  This class does not take
+             *                         ownership of the output device.
+             */
+            void setOutputDevice(QIODevice* outputDevice);
+
+            /**
+             * Method you can use to determine the output device.
+             *
+             * \return Returns the output device.  A null pointer is returned if no output device is set.
+             */
+            QIODevice* outputDevice() const;
+
+            /**
+             * Method you can use to open the device.
+             *
+             * \param[in] openMode The desired open mode.  Only QIODevice::WriteOnly is supported.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool open(Compressor::OpenMode openMode) override;
+
+            /**
+             * Method you can use to close the device.  The final, partial, block is written to the output device.
+             * The output device is left open.
+             */
+            void close() override;
+
+            /**
+             * Method you can use to write the buffered partial block to the output device.  Flushing often reduces
+             * the compression ratio.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool flush();
+
+            /**
+             * Method you can use to determine if this device is sequential.
+             *
+             * \return Returns true.
+             */
+            bool isSequential() const override;
+
+        protected:
+            /**
+             * Method that rejects reads.
+             *
+             * \param[in] data    Unused.
+             *
+             * \param[in] maxSize Unused.
+             *
+             * \return Returns -1.
+             */
+            qint64 readData(char* data, qint64 maxSize) override;
+
+            /**
+             * Method that compresses data.
+             *
+             * \param[in] data    The data to be compressed.
+             *
+             * \param[in] maxSize The number of bytes to be compressed.
+             *
+             * \return Returns the number of bytes accepted or -1 on error.
+             */
+            qint64 writeData(const char* data, qint64 maxSize) override;
+
+        private:
+            /**
+             * Method that compresses a block and appends the framed block to a buffer.
+             *
+             * \param[in]     data   The block to be compressed.
+             *
+             * \param[in]     length The length of the block, in bytes.
+             *
+             * \param[in,out] output The buffer to receive the framed block.
+             */
+            void appendBlock(const char* data, unsigned length, QByteArray& output) const;
+
+            /**
+             * Method that writes the buffered block to the output device.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool writePendingBlock();
+
+            /**
+             * The block size, in bytes.
+             */
+            unsigned currentBlockSize;
+
+            /**
+             * The zlib compression level.
+             */
+            int currentCompressionLevel;
+
+            /**
+             * The output device.
+             */
+            QIODevice* currentOutputDevice;
+
+            /**
+             * The data waiting to be compressed.  This never holds more than one block.
+             */
+            QByteArray pendingData;
+
+            /**
+             * Scratch buffer holding the framed block being written.
+             */
+            QByteArray frameData;
+    };
+}
+
+#endif
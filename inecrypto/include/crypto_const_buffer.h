@@ -0,0 +1,67 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::ConstBuffer structure used by the scatter-gather methods.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_CONST_BUFFER_H
+#define CRYPTO_CONST_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Crypto {
+    /**
+     * Structure describing one piece of a message assembled from several buffers.  The scatter-gather methods treat
+     * an array of these structures as one logical stream so the pieces never need to be concatenated.
+     */
+    struct ConstBuffer {
+        /**
+         * Pointer to the data.
+         */
+        const std::uint8_t* data;
+
+        /**
+         * The number of bytes of data.
+         */
+        std::size_t length;
+    };
+
+    /**
+     * Function you can use to determine the total length of a list of buffers.
+     *
+     * \param[in] buffers       Pointer to the first buffer.
+     *
+     * \param[in] numberBuffers The number of buffers.
+     *
+     * \return Returns the sum of the buffer lengths, in bytes.
+     */
+    inline std::size_t totalLength(const ConstBuffer* buffers, std::size_t numberBuffers) {
+        std::size_t result = 0;
+        for (std::size_t i=0 ; i<numberBuffers ; ++i) {
+            result += buffers[i].length;
+        }
+
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header provides a basic CRC calculation routine that operates on a pointer and length and does not depend on
+* Qt.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_CRC_H
+#define CRYPTO_CRC_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace Crypto {
+    /**
+     * Template function that calculates a systematic CRC by shifting.  While slow, the routine can operate with any
+     * polynomial.
+     *
+     * Template parameters are:
+     *   T -          The desired type of the result.  This type should be unsigned.
+     *
+     *   polynomial - The CRC polynomial represented as an integer value.  The value should be larger than the value
+     *                that can be held in the BaseName type by a single bit.  For example, if BaseName is set to
+     *                std::uint32_t, then a valid CRC might be 0x123456789.
+     *
+     * \param[in] data   Pointer to the data to calculate the CRC over.
+     *
+     * \param[in] length The number of bytes to calculate the CRC over.
+     *
+     * \return Returns the calculated CRC.
+     */
+    template<typename T, std::uint64_t polynomial> T systematicCrc(const std::uint8_t* data, std::size_t length) {
+        assert(T(-1) > 0);                                                                         // Validates type.
+        assert(sizeof(T) == 8 || T(-1) < polynomial);                                              // Validates the CRC.
+        assert(sizeof(T) == 8 || ((static_cast<std::uint64_t>(T(-1)) << 1ULL) | 1) >= polynomial); // Validates the CRC.
+
+        constexpr unsigned crcLength = 8 * sizeof(T);
+        constexpr T        crcMask   = T(1) << (crcLength-1);
+        T                  crc       = 0;
+
+        for (std::size_t i=0 ; i<length ; ++i) {
+            std::uint8_t value = data[i];
+
+            for (unsigned bit=0 ; bit<8 ; ++bit) {
+                T msb = crc & crcMask;
+
+                crc = (crc << 1) | (value & 1);
+                if (msb) {
+                    crc ^= static_cast<T>(polynomial);
+                }
+
+                value >>= 1;
+            }
+        }
+
+        return crc;
+    }
+}
+
+#endif
@@ -31,12 +31,14 @@
 #include <QDebug>
 
 #include "crypto_helpers.h"
+#include "crypto_crc.h"
 
 namespace Crypto {
     /**
      * Template function that calculates a systematic CRC by shifting.  While slow, the routine can operate with any
      * polynomial.  Note that this routine can be made much faster using table based CRC calculation methods which
-     * requires one or more tables to be generated for each CRC polynomial.
+     * requires one or more tables to be generated for each CRC polynomial.  This version forwards to the pointer and
+     * length version in crypto_crc.h.
      *
      * Template parameters are:
      *   T -          The desired type of the result.  This type should be unsigned.
@@ -48,30 +50,10 @@ namespace Crypto {
      * \param[in] array The array to calculate the CRC over.
      */
     template<typename T, quint64 polynomial> T systematicCrc(QByteArray const& array) {
-        Q_ASSERT(T(-1) > 0);                                                                   // Validates type.
-        Q_ASSERT(sizeof(T) == 8 || T(-1) < polynomial);                                        // Validates the CRC.
-        Q_ASSERT(sizeof(T) == 8 || ((static_cast<quint64>(T(-1)) << 1ULL) | 1) >= polynomial); // Validates the CRC.
-
-        unsigned crcLength = numberOnes64(T(-1));
-        T        crcMask   = T(1) << (crcLength-1);
-        T        crc       = 0;
-
-        for (auto it=array.begin(), end=array.end() ; it!=end ; ++it) {
-            quint8 value = *it;
-
-            for (unsigned bit=0 ; bit<8 ; ++bit) {
-                T msb = crc & crcMask;
-
-                crc = (crc << 1) | (value & 1);
-                if (msb) {
-                    crc ^= polynomial;
-                }
-
-                value >>= 1;
-            }
-        }
-
-        return crc;
+        return systematicCrc<T, polynomial>(
+            reinterpret_cast<const std::uint8_t*>(array.constData()),
+            static_cast<std::size_t>(array.size())
+        );
     }
 
     /**
@@ -0,0 +1,228 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::Decompressor class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_DECOMPRESSOR_H
+#define CRYPTO_DECOMPRESSOR_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+
+class QObject;
+
+namespace Crypto {
+    /**
+     * Class that decompresses a stream produced by \ref Crypto::Compressor, typically as it is read from a
+     * \ref Crypto::Decryptor.  Blocks are read from the input device one at a time and at most one compressed and one
+     * decompressed block are held in memory.  Blocks claiming to decompress to more than the maximum block size are
+     * rejected before any memory is allocated for them.
+     *
+     * Reads return the data that can be decompressed from the bytes currently available from the input device.  A
+     * partial block at the end of the input is held until the rest arrives.  The block API reports a truncated
+     * stream as an error.
+     */
+    class Decompressor:public QIODevice {
+        public:
+            /**
+             * The length of the header preceding each block, in bytes.
+             */
+            static constexpr unsigned blockHeaderLength = 4;
+
+            /**
+             * The largest block size supported by the format, in bytes.
+             */
+            static constexpr unsigned maximumBlockSize = 16 * 1024 * 1024;
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the input device.
+             */
+            explicit Decompressor(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit Decompressor(QObject* parent = Q_NULLPTR);
+
+            ~Decompressor() override;
+
+            /**
+             * Method you can use to limit the size of the blocks that will be accepted.  The limit bounds the memory
+             * used when decompressing untrusted data.
+             *
+             * \param[in] newBlockSizeLimit The largest accepted block size, in bytes.  The value is limited to between
+             *                              1 and \ref Crypto::Decompressor::maximumBlockSize.
+             */
+            void setBlockSizeLimit(unsigned newBlockSizeLimit);
+
+            /**
+             * Method you can use to determine the largest block size that will be accepted.
+             *
+             * \return Returns the block size limit, in bytes.
+             */
+            unsigned blockSizeLimit() const;
+
+            /**
+             * Method you can call to decompress a complete stream held in memory.
+             *
+             * \param[in] inputBuffer The compressed stream.
+             *
+             * \return Returns the decompressed data.  An empty array is returned if the stream is not valid.
+             */
+            QByteArray decompress(const QByteArray& inputBuffer);
+
+            /**
+             * Method you can use to set the input device.
+             *
+             * \param[in] inputDevice The device providing the compressed stream.  This class does not take ownership
+             *                        of the input device.
+             */
+            void setInputDevice(QIODevice* inputDevice);
+
+            /**
+             * Method you can use to determine the input device.
+             *
+             * \return Returns the input device.  A null pointer is returned if no input device is set.
+             */
+            QIODevice* inputDevice() const;
+
+            /**
+             * Method you can use to open the device.
+             *
+             * \param[in] openMode The desired open mode.  Only QIODevice::ReadOnly is supported.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool open(Decompressor::OpenMode openMode) override;
+
+            /**
+             * Method you can use to close the device.  The input device is left open.
+             */
+            void close() override;
+
+            /**
+             * Method you can use to determine if this device is sequential.
+             *
+             * \return Returns true.
+             */
+            bool isSequential() const override;
+
+            /**
+             * Method you can use to determine the number of decompressed bytes that can be read without reading from
+             * the input device.
+             *
+             * \return Returns the number of bytes available.
+             */
+            qint64 bytesAvailable() const override;
+
+        protected:
+            /**
+             * Method that reads decompressed data.
+             *
+             * \param[in] data    Buffer to receive the decompressed data.
+             *
+             * \param[in] maxSize The maximum number of bytes to read.
+             *
+             * \return Returns the number of bytes read or -1 on error.
+             */
+            qint64 readData(char* data, qint64 maxSize) override;
+
+            /**
+             * Method that rejects writes.
+             *
+             * \param[in] data    Unused.
+             *
+             * \param[in] maxSize Unused.
+             *
+             * \return Returns -1.
+             */
+            qint64 writeData(const char* data, qint64 maxSize) override;
+
+        private:
+            /**
+             * Method that determines the payload length from a block header.
+             *
+             * \param[in]  header        The block header.
+             *
+             * \param[out] payloadLength Returns the length of the block payload, in bytes.
+             *
+             * \return Returns true if the header is valid.  Returns false if the header is not valid.
+             */
+            bool decodeHeader(const std::uint8_t* header, unsigned& payloadLength) const;
+
+            /**
+             * Method that decompresses a block.
+             *
+             * \param[in]  frame  The block, including its header.
+             *
+             * \param[out] output Returns the decompressed block.
+             *
+             * \return Returns true on success.  Returns false if the block is not valid.
+             */
+            bool decodeBlock(const std::uint8_t* frame, QByteArray& output) const;
+
+            /**
+             * Method that reads the next block from the input device.
+             *
+             * \param[out] blockRead Returns true if a block was read.  Returns false if the input device does not yet
+             *                       hold a complete block.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool readBlock(bool& blockRead);
+
+            /**
+             * The largest accepted block size, in bytes.
+             */
+            unsigned currentBlockSizeLimit;
+
+            /**
+             * The input device.
+             */
+            QIODevice* currentInputDevice;
+
+            /**
+             * The partial block read from the input device.
+             */
+            QByteArray frameData;
+
+            /**
+             * The current decompressed block.
+             */
+            QByteArray currentBlock;
+
+            /**
+             * The read position in the current decompressed block.
+             */
+            int blockOffset;
+    };
+}
+
+#endif
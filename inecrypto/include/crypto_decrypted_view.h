@@ -0,0 +1,466 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::DecryptedView class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_DECRYPTED_VIEW_H
+#define CRYPTO_DECRYPTED_VIEW_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+#include <QHash>
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "crypto_cipher_base.h"
+
+class QObject;
+class QThreadPool;
+
+namespace Crypto {
+    class SegmentEngine;
+
+    /**
+     * Class that provides random access to the plaintext of a container written by
+     * \ref Crypto::SegmentedEncryptor.  Each segment of the container is treated as a page.  Pages are decrypted and
+     * verified on demand and the most recently used plaintext pages are held in a bounded cache so repeated reads
+     * of the same range do not decrypt the data again.  A cold read only decrypts the pages it touches.  Runs of
+     * consecutive cold pages are decrypted together, in parallel when a thread pool is supplied.
+     *
+     * The container can be supplied either as a random access \ref QIODevice that is open for reading or as a block
+     * of memory, such as a memory mapped file.  Memory is decrypted in place without being copied.
+     *
+     * You can read from the view either through \ref Crypto::DecryptedView::readAt or through the \ref QIODevice
+     * API.  The class is not thread safe.
+     */
+    class DecryptedView:public QIODevice, public CipherBase {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The default number of pages held in the cache.
+             */
+            static constexpr unsigned defaultCacheCapacity = 16;
+
+            /**
+             * Array used to define the AES encryption key.
+             */
+            typedef std::uint8_t Keys[keyLength];
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the input device.
+             */
+            explicit DecryptedView(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit DecryptedView(QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The keys to use for decryption.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the input device.
+             */
+            explicit DecryptedView(const Keys& keys, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The keys to use for decryption.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit DecryptedView(const Keys& keys, QObject* parent = Q_NULLPTR);
+
+            ~DecryptedView() override;
+
+            /**
+             * Method that returns the key length, in bytes.
+             *
+             * \return Returns the key length, in bytes.
+             */
+            unsigned keyLengthInBytes() const override;
+
+            /**
+             * Method you can use to set the keys.  The keys are used the next time the view is opened.
+             *
+             * \param[in] newKeys The new keys to use.
+             */
+            void setKeys(const Keys& newKeys);
+
+            /**
+             * Method you can use to set the maximum number of plaintext pages held in the cache.  Reducing the
+             * capacity of an open view discards the cached pages.
+             *
+             * \param[in] newCacheCapacity The new cache capacity, in pages.  A value of 0 is treated as 1.
+             */
+            void setCacheCapacity(unsigned newCacheCapacity);
+
+            /**
+             * Method you can use to determine the maximum number of plaintext pages held in the cache.
+             *
+             * \return Returns the cache capacity, in pages.
+             */
+            unsigned cacheCapacity() const;
+
+            /**
+             * Method you can use to set a thread pool used to decrypt runs of cold pages in parallel.
+             *
+             * \param[in] newThreadPool The thread pool to use.  A null pointer decrypts on the calling thread.
+             */
+            void setThreadPool(QThreadPool* newThreadPool);
+
+            /**
+             * Method you can use to determine the thread pool used to decrypt pages.
+             *
+             * \return Returns the thread pool.  A null pointer is returned if pages are decrypted on the calling
+             *         thread.
+             */
+            QThreadPool* threadPool() const;
+
+            /**
+             * Method you can use to determine the page size of the open container.
+             *
+             * \return Returns the page size, in bytes.  A value of 0 is returned if the view is not open.
+             */
+            unsigned pageSize() const;
+
+            /**
+             * Method you can use to determine the number of pages decrypted since the view was opened.  You can use
+             * this value to gauge the effectiveness of the cache.
+             *
+             * \return Returns the number of pages decrypted.
+             */
+            unsigned long long pagesDecrypted() const;
+
+            /**
+             * Method you can use to set the source device.  Setting a device clears any memory set with
+             * \ref Crypto::DecryptedView::setInputData.
+             *
+             * \param[in] inputDevice The device holding the container.  This class does not take ownership of the
+             *                        input device.
+             */
+            void setInputDevice(QIODevice* inputDevice);
+
+            /**
+             * Method you can use to determine the source device.
+             *
+             * \return Returns the source device.  A null pointer is returned if no device is set.
+             */
+            QIODevice* inputDevice() const;
+
+            /**
+             * Method you can use to read the container directly from memory.  Setting memory clears any input device.
+             *
+             * \param[in] inputData   Pointer to the container.  The memory must remain valid while the view is open.
+             *
+             * \param[in] inputLength The length of the container, in bytes.
+             */
+            void setInputData(const std::uint8_t* inputData, unsigned long long inputLength);
+
+            /**
+             * Method you can use to read a range of the plaintext without changing the current position.
+             *
+             * \param[in]  offset The offset of the first byte to read.
+             *
+             * \param[out] data   Buffer to receive the plaintext.
+             *
+             * \param[in]  length The number of bytes to read.
+             *
+             * \return Returns the number of bytes read.  The value is smaller than the requested length if the range
+             *         extends past the end of the plaintext.  A value of -1 is returned if the view is not open or a
+             *         page fails verification.
+             */
+            qint64 readAt(qint64 offset, char* data, qint64 length);
+
+            /**
+             * Method you can use to read a range of the plaintext without changing the current position.
+             *
+             * \param[in] offset The offset of the first byte to read.
+             *
+             * \param[in] length The number of bytes to read.
+             *
+             * \return Returns the plaintext.  The array is shorter than the requested length if the range extends
+             *         past the end of the plaintext.  An empty array is returned on error.
+             */
+            QByteArray readAt(qint64 offset, qint64 length);
+
+            /**
+             * Method you can use to open the view.  The input must already be available and the container header
+             * is read and checked.
+             *
+             * \param[in] openMode The desired open mode.  Only QIODevice::ReadOnly is supported.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool open(DecryptedView::OpenMode openMode) override;
+
+            /**
+             * Method you can use to close the view.  Cached pages are scrubbed.
+             */
+            void close() override;
+
+            /**
+             * Method you can use to determine if this device is sequential.
+             *
+             * \return Returns false.
+             */
+            bool isSequential() const override;
+
+            /**
+             * Method you can use to determine the size of the plaintext.
+             *
+             * \return Returns the plaintext size, in bytes.
+             */
+            qint64 size() const override;
+
+            /**
+             * Method you can use to move to a new position in the plaintext.  No data is decrypted until it is read.
+             *
+             * \param[in] position The new position.
+             *
+             * \return Returns true on success.  Returns false if the position is outside the plaintext.
+             */
+            bool seek(qint64 position) override;
+
+        protected:
+            /**
+             * Method that reads plaintext at the current position.
+             *
+             * \param[in] data    Buffer to receive the plaintext.
+             *
+             * \param[in] maxSize The maximum number of bytes to read.
+             *
+             * \return Returns the number of bytes read or -1 on error.
+             */
+            qint64 readData(char* data, qint64 maxSize) override;
+
+            /**
+             * Method that rejects writes.
+             *
+             * \param[in] data    Unused.
+             *
+             * \param[in] maxSize Unused.
+             *
+             * \return Returns -1.
+             */
+            qint64 writeData(const char* data, qint64 maxSize) override;
+
+        private:
+            /**
+             * Structure holding one cached page.
+             */
+            struct Page {
+                /**
+                 * The index of the page in the container.
+                 */
+                unsigned long long index;
+
+                /**
+                 * The use count at the last access.  The page with the smallest value is evicted first.
+                 */
+                unsigned long long lastUsed;
+
+                /**
+                 * The plaintext.
+                 */
+                QByteArray data;
+            };
+
+            /**
+             * Method that locates a page, decrypting it and any cold pages that follow it in the requested range.
+             *
+             * \param[in] pageIndex The index of the page.
+             *
+             * \param[in] lastPage  The index of the last page of the range being read.
+             *
+             * \return Returns the page.  A null pointer is returned if the page could not be decrypted.
+             */
+            const Page* fetchPage(unsigned long long pageIndex, unsigned long long lastPage);
+
+            /**
+             * Method that decrypts a run of consecutive pages into the cache.
+             *
+             * \param[in] firstPage     The index of the first page.
+             *
+             * \param[in] numberPages   The number of pages to decrypt.
+             *
+             * \return Returns true on success.  Returns false if the pages could not be read or verified.
+             */
+            bool loadPages(unsigned long long firstPage, unsigned long long numberPages);
+
+            /**
+             * Method that selects the cache slot to hold a new page, evicting the least recently used page when the
+             * cache is full.
+             *
+             * \return Returns the index of the slot.
+             */
+            unsigned allocateSlot();
+
+            /**
+             * Method that scrubs and discards every cached page.
+             */
+            void clearCache();
+
+            /**
+             * Method that reads a run of the container.
+             *
+             * \param[in] offset The offset into the container.
+             *
+             * \param[in] length The number of bytes to read.
+             *
+             * \return Returns a pointer to the data.  A null pointer is returned on error.
+             */
+            const std::uint8_t* containerData(unsigned long long offset, std::size_t length);
+
+            /**
+             * Method that expands the keys if they have changed.
+             */
+            void expandKeys();
+
+            /**
+             * The unexpanded keys.
+             */
+            Keys initialKeys;
+
+            /**
+             * Flag indicating that the engine holds the current keys.
+             */
+            bool keysExpanded;
+
+            /**
+             * The maximum number of cached pages.
+             */
+            unsigned currentCacheCapacity;
+
+            /**
+             * The thread pool used to decrypt pages.
+             */
+            QThreadPool* currentThreadPool;
+
+            /**
+             * The input device.
+             */
+            QIODevice* currentInputDevice;
+
+            /**
+             * The container in memory.
+             */
+            const std::uint8_t* currentInputData;
+
+            /**
+             * The length of the container in memory, in bytes.
+             */
+            unsigned long long currentInputLength;
+
+            /**
+             * The page size, in bytes.
+             */
+            unsigned currentPageSize;
+
+            /**
+             * The length of the plaintext, in bytes.
+             */
+            unsigned long long currentDataLength;
+
+            /**
+             * The number of pages in the container.
+             */
+            unsigned long long currentNumberPages;
+
+            /**
+             * The current position in the plaintext.
+             */
+            unsigned long long currentPosition;
+
+            /**
+             * The number of pages decrypted since the view was opened.
+             */
+            unsigned long long currentPagesDecrypted;
+
+            /**
+             * Counter used to order page accesses.
+             */
+            unsigned long long useCounter;
+
+            /**
+             * The cache slots.
+             */
+            std::vector<Page> pages;
+
+            /**
+             * Map from page index to cache slot.
+             */
+            QHash<unsigned long long, unsigned> slotsByPage;
+
+            /**
+             * Scratch buffer holding encrypted data read from the input device.
+             */
+            QByteArray encryptedData;
+
+            /**
+             * Scratch array holding the cache slot claimed for each page of a run.
+             */
+            std::vector<unsigned> runSlots;
+
+            /**
+             * Scratch array holding the output buffer for each page of a run.
+             */
+            std::vector<std::uint8_t*> runOutputs;
+
+            /**
+             * Method that provides the segment engine held by this instance.
+             *
+             * \return Returns a pointer to the segment engine.
+             */
+            inline SegmentEngine* engine() {
+                return reinterpret_cast<SegmentEngine*>(engineStorage);
+            }
+
+            /**
+             * The storage reserved for the segment engine, in bytes.
+             */
+            static constexpr unsigned engineStorageSize = 880;
+
+            /**
+             * Storage for the segment engine.  The engine is held in-line, aligned for vector loads, so that no heap
+             * allocation is needed per instance.
+             */
+            alignas(16) std::uint8_t engineStorage[engineStorageSize];
+    };
+}
+
+#endif
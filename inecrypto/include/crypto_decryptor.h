@@ -28,13 +28,17 @@
 #include <QtGlobal>
 #include <QIODevice>
 #include <QByteArray>
+#include <QByteArrayList>
 #include <QObject>
 
+#include <cstddef>
 #include <cstdint>
 
+#include "crypto_const_buffer.h"
 #include "crypto_cipher_base.h"
 
 class QObject;
+class QThreadPool;
 
 namespace Crypto {
     /**
@@ -71,6 +75,120 @@ namespace Crypto {
              */
             QByteArray decrypt(const QByteArray& inputBuffer);
 
+            /**
+             * Method you can call to decrypt a data buffer into memory you supply.  The input and output buffers must
+             * not overlap.  Use \ref Crypto::Decryptor::decryptInPlace to decrypt a buffer in place.
+             *
+             * \param[in]  inputData      Pointer to the data to be decrypted.
+             *
+             * \param[in]  inputLength    The number of bytes to be decrypted.
+             *
+             * \param[out] outputData     Pointer to the buffer to receive the decrypted data.
+             *
+             * \param[in]  outputCapacity The size of the output buffer, in bytes.
+             *
+             * \return Returns the number of bytes written to the output buffer.  A value of 0 is returned if the
+             *         output buffer is too small or if the trailer fails verification.
+             */
+            std::size_t decrypt(
+                const std::uint8_t* inputData,
+                std::size_t         inputLength,
+                std::uint8_t*       outputData,
+                std::size_t         outputCapacity
+            );
+
+            /**
+             * Method you can call to decrypt a message split across several buffers.  The buffers are treated as one
+             * logical stream so the output is identical to decrypting their concatenation.
+             *
+             * \param[in] inputBuffers The buffers to be decrypted, in order.
+             *
+             * \return Returns a decrypted version of the supplied buffers.  An empty array is returned if the trailer
+             *         fails verification.
+             */
+            QByteArray decrypt(const QByteArrayList& inputBuffers);
+
+            /**
+             * Method you can call to decrypt a message split across several buffers into memory you supply.  The
+             * buffers are treated as one logical stream.  Runs of whole chunks are decrypted directly from the supplied
+             * buffers and only the header, the trailer and chunks that straddle two buffers are copied.  The input
+             * buffers must not overlap the output buffer.  The thread pool is only used when a single buffer is
+             * supplied.
+             *
+             * \param[in]  inputBuffers       Pointer to the buffers to be decrypted, in order.
+             *
+             * \param[in]  numberInputBuffers The number of input buffers.
+             *
+             * \param[out] outputData         Pointer to the buffer to receive the decrypted data.
+             *
+             * \param[in]  outputCapacity     The size of the output buffer, in bytes.
+             *
+             * \return Returns the number of bytes written to the output buffer.  A value of 0 is returned if the
+             *         output buffer is too small or if the trailer fails verification.
+             */
+            std::size_t decrypt(
+                const ConstBuffer* inputBuffers,
+                std::size_t        numberInputBuffers,
+                std::uint8_t*      outputData,
+                std::size_t        outputCapacity
+            );
+
+            /**
+             * Method you can call to decrypt a data buffer in place.  The decrypted data will start at the beginning
+             * of the buffer.  This method requires equal input and output chunk sizes.
+             *
+             * \param[in,out] buffer      The buffer holding the data to be decrypted.
+             *
+             * \param[in]     inputLength The number of bytes to be decrypted.
+             *
+             * \return Returns the number of decrypted bytes in the buffer.  A value of 0 is returned if the chunk
+             *         sizes differ or if the trailer fails verification.
+             */
+            std::size_t decryptInPlace(std::uint8_t* buffer, std::size_t inputLength);
+
+            /**
+             * Method you can use to determine the number of bytes the block decryption methods will produce for a
+             * given input.
+             *
+             * \param[in] inputLength The number of bytes to be decrypted, including any header and trailer.
+             *
+             * \return Returns the decrypted size, in bytes.
+             */
+            std::size_t decryptedSize(std::size_t inputLength) const;
+
+            /**
+             * Method you can use to have the block decryption methods spread large buffers across a thread pool.  The
+             * buffer is split into one segment per thread and each segment is decrypted independently.  Only engines
+             * that report \ref Crypto::Decryptor::supportsParallelDecryption are split.  Smaller buffers and other
+             * engines are decrypted on the calling thread.
+             *
+             * \param[in] newThreadPool The thread pool to use.  A null pointer, the default, disables parallel
+             *                          decryption.  This class does not take ownership of the thread pool.
+             */
+            void setThreadPool(QThreadPool* newThreadPool);
+
+            /**
+             * Method you can use to determine the thread pool used for parallel decryption.
+             *
+             * \return Returns the thread pool.  A null pointer is returned if parallel decryption is disabled.
+             */
+            QThreadPool* threadPool() const;
+
+            /**
+             * Method you can use to determine if the engine can decrypt separate runs of chunks concurrently.  The
+             * default implementation returns false.  Engines that return true must overload
+             * \ref Crypto::Decryptor::decryptChunkRange.
+             *
+             * \return Returns true if the engine supports parallel decryption.
+             */
+            virtual bool supportsParallelDecryption() const;
+
+            /**
+             * The smallest segment, in bytes, that will be handed to a thread pool thread.  Buffers smaller than
+             * twice this size are always decrypted on the calling thread.
+             */
+            static constexpr unsigned minimumParallelSegmentSize = 256 * 1024;
+
             /**
              * Method you can use to set the source device.
              *
@@ -93,6 +211,30 @@ namespace Crypto {
              */
             unsigned long long inputBytesPending() const;
 
+            /**
+             * Method you can use to bound the amount of data buffered from the input device.  When a limit is set,
+             * data is decrypted as soon as it arrives, in batches of \ref Crypto::Decryptor::decryptionBatchSize
+             * bytes, and no more input is read once the buffered encrypted and decrypted data reaches the limit.
+             * The remaining data is left in the input device and is read as decrypted data is consumed.  For sockets,
+             * also limit the socket's own read buffer so that the socket stops reading from the network.
+             *
+             * \param[in] newMaximumBufferedInput The new limit, in bytes.  A value of 0, the default, removes the
+             *                                    limit and decrypts data as it is read.
+             */
+            void setMaximumBufferedInput(qint64 newMaximumBufferedInput);
+
+            /**
+             * Method you can use to determine the limit on the amount of data buffered from the input device.
+             *
+             * \return Returns the limit, in bytes.  A value of 0 indicates no limit.
+             */
+            qint64 maximumBufferedInput() const;
+
+            /**
+             * The amount of input, in bytes, read and decrypted per pass when a buffering limit is set.
+             */
+            static constexpr unsigned decryptionBatchSize = 64 * 1024;
+
             /**
              * Method that determines the number of bytes of data that can be read.
              *
@@ -118,14 +260,67 @@ namespace Crypto {
              */
             bool open(Decryptor ::OpenMode openMode) override;
 
+            /**
+             * Method you can use to close the device.
+             */
+            void close() override;
+
             /**
              * Method you can use to determine if this is a sequential device.
              *
              * \return Returns true if this is a sequential device.  Returns false if this is not a sequential device.
-             *         this method always returns true.
+             *         The decryptor is only random-access when random access is enabled, the engine supports it and
+             *         the input device is itself random-access.
              */
             bool isSequential() const override;
 
+            /**
+             * Method you can use to determine the size of the decrypted stream.  For a random-access decryptor, the
+             * size is calculated from the size of the input device.
+             *
+             * \return Returns the decrypted size, in bytes.
+             */
+            qint64 size() const override;
+
+            /**
+             * Method you can use to move to a new position in the decrypted stream.  Only the chunk holding the new
+             * position and, depending on the engine, the chunk before it are read from the input device, so the
+             * cost does not depend on the position.
+             *
+             * \param[in] pos The new position in the decrypted stream.
+             *
+             * \return Returns true on success.  Returns false if the decryptor is sequential, the position is out of
+             *         range or the input device could not be read.
+             */
+            bool seek(qint64 pos) override;
+
+            /**
+             * Method you can use to enable or disable random access.  When enabled and the input device is
+             * random-access, the decryptor reports itself as non-sequential and supports
+             * \ref Crypto::Decryptor::seek.  Reads then only pull as much input as is needed to satisfy each request.
+             * Random access must be enabled before the decryptor is opened.
+             *
+             * \param[in] nowEnabled If true, random access will be enabled.  If false, random access will be
+             *                       disabled.
+             */
+            void setRandomAccessEnabled(bool nowEnabled = true);
+
+            /**
+             * Method you can use to determine if random access is enabled.
+             *
+             * \return Returns true if random access is enabled.  Returns false if random access is disabled.
+             */
+            bool randomAccessEnabled() const;
+
+            /**
+             * Method you can use to determine if the engine can start decrypting at an arbitrary chunk.  The default
+             * implementation returns false.  Engines that return true must overload
+             * \ref Crypto::Decryptor::seekEngine and must not use a trailer.
+             *
+             * \return Returns true if the engine supports random access.
+             */
+            virtual bool supportsRandomAccess() const;
+
             /**
              * Method you can use to determine the encryption output chunk size.
              *
@@ -141,6 +336,33 @@ namespace Crypto {
              */
             virtual unsigned inputChunkSize() const;
 
+            /**
+             * Method you can use to determine the size of the header expected ahead of the encrypted data.  The
+             * default implementation returns 0, indicating no header.
+             *
+             * \return Returns the header size, in bytes.
+             */
+            virtual unsigned headerSize() const;
+
+            /**
+             * Method you can use to determine the size of the trailer expected after the encrypted data, such as an
+             * authentication tag.  The default implementation returns 0, indicating no trailer.
+             *
+             * \return Returns the trailer size, in bytes.
+             */
+            virtual unsigned trailerSize() const;
+
+            /**
+             * Method you can use to determine if the trailer has been received and verified.  When streaming, the
+             * trailer is verified once the end of the input is reached and all of the data has been read.  Data read
+             * before then has not yet been authenticated.
+             *
+             * \return Returns true if the trailer has been verified.  Returns false if the trailer has not yet been
+             *         received or failed verification.  Engines with no trailer report true once the end of the
+             *         input has been reached.
+             */
+            bool trailerVerified() const;
+
             /**
              * Method you can use to determine the total number of input bytes that have been processed.
              *
@@ -162,6 +384,13 @@ namespace Crypto {
              */
             void processData(const QByteArray& data);
 
+            /**
+             * Method you can call after the final call to \ref Crypto::Decryptor::processData, or when a sequential
+             * input device such as a socket has delivered all of its data, to indicate the end of the input.
+             * Engines with a trailer need to know where the input ends in order to locate the trailer.
+             */
+            void finishData();
+
         protected:
             /**
              * Method that is called to request data from the decryptor.
@@ -191,8 +420,77 @@ namespace Crypto {
             virtual void resetEngine() = 0;
 
             /**
-             * Method you should overload to perform encryption on a single chunk.  Data will always be supplied in
-             * full chunks.
+             * Method you can overload to process the header received ahead of the encrypted data.  The method is
+             * called after the engine is reset and before the first chunk is decrypted.  The default implementation
+             * does nothing.
+             *
+             * \param[in] headerData Pointer to the received header.  The header will be
+             *                       \ref Crypto::Decryptor::headerSize bytes in length.
+             */
+            virtual void processHeader(const std::uint8_t* headerData);
+
+            /**
+             * Method you can overload to verify the trailer received after the encrypted data.  The method is called
+             * after the last chunk is decrypted.  The default implementation accepts the trailer.
+             *
+             * \param[in] trailerData Pointer to the received trailer.  The trailer will be
+             *                        \ref Crypto::Decryptor::trailerSize bytes in length.
+             *
+             * \return Returns true if the trailer is valid.  Returns false if the trailer is invalid.
+             */
+            virtual bool processTrailer(const std::uint8_t* trailerData);
+
+            /**
+             * Method you can overload to clear state that only applies to the stream just processed, such as keys
+             * derived during the stream.  The method is called once a buffer has been decrypted and when the device
+             * is closed.  The default implementation does nothing.
+             */
+            virtual void finishEngine();
+
+            /**
+             * Method you can overload to position the engine so that the next chunk decrypted is the chunk at a given
+             * index.  The method is called after the engine is reset and after any header has been processed.  The
+             * default implementation returns false.
+             *
+             * \param[in] chunkIndex    The zero based index of the next chunk to be decrypted.
+             *
+             * \param[in] previousChunk Pointer to the encrypted chunk ahead of the chunk to be decrypted.  The pointer
+             *                          will be null if the chunk index is 0.
+             *
+             * \return Returns true on success.  Returns false if the engine can not be positioned.
+             */
+            virtual bool seekEngine(unsigned long long chunkIndex, const std::uint8_t* previousChunk);
+
+            /**
+             * Method you can overload to decrypt a run of chunks starting at a given chunk index without changing the
+             * state of the engine.  The method is called concurrently from several threads, after the engine has
+             * been reset and any header processed, and must only read the engine state.  The default implementation
+             * does nothing and is never called unless \ref Crypto::Decryptor::supportsParallelDecryption returns
+             * true.
+             *
+             * \param[in]  chunkIndex    The zero based index of the first chunk in the run.
+             *
+             * \param[in]  previousChunk Pointer to a copy of the encrypted chunk ahead of the run.  The pointer will be
+             *                          null if the chunk index is 0.
+             *
+             * \param[in]  inputData     Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData    Pointer to the buffer to receive the resulting data.  The input and output
+             *                          pointers may be identical but will never otherwise overlap.
+             *
+             * \param[in]  numberChunks  The number of chunks to be processed.
+             */
+            virtual void decryptChunkRange(
+                unsigned long long  chunkIndex,
+                const std::uint8_t* previousChunk,
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            );
+
+            /**
+             * Method you should overload to perform decryption on a single chunk.  Data will always be supplied in
+             * full chunks.  The input and output pointers may be identical but will never otherwise overlap.
              *
              * \param[in]  inputData  Pointer to the encrypted data to be processed.
              *
@@ -200,6 +498,24 @@ namespace Crypto {
              */
             virtual void decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) = 0;
 
+            /**
+             * Method you can overload to decrypt a run of contiguous chunks in one call.  Engines that can process
+             * several chunks at once, such as counter mode engines, should overload this method.  The default
+             * implementation calls \ref Crypto::Decryptor::decryptChunk once per chunk.
+             *
+             * \param[in]  inputData    Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.  The input and output
+             *                          pointers may be identical but will never otherwise overlap.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
+             */
+            virtual void decryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            );
+
         private slots:
             /**
              * Slot that is triggered when the input device has data available.
@@ -207,6 +523,8 @@ namespace Crypto {
             void inputDataAvailable();
 
         private:
+            class SegmentTask;
+
             /**
              * Method that is called to perform common configuration tasks.
              *
@@ -214,14 +532,102 @@ namespace Crypto {
              */
             void configure(QIODevice* inputDevice = Q_NULLPTR);
 
+            /**
+             * Method that decrypts a buffer for the block decryption methods, splitting the work across the thread
+             * pool when possible.
+             *
+             * \param[in]  inputData    Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
+             */
+            void decryptBuffer(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t numberChunks);
+
             /**
              * Method that reads the available data.
              *
-             * \param[out] bytesRead Returns the number of bytes read.
+             * \param[out] bytesRead    Returns the number of bytes read.
+             *
+             * \param[in]  maximumBytes The maximum number of bytes to read.
              *
              * \return Returns true on success, returns false if an error occurs.
              */
-            bool readAvailableData(unsigned long long& bytesRead);
+            bool readAvailableData(
+                unsigned long long& bytesRead,
+                unsigned long long  maximumBytes = static_cast<unsigned long long>(-1)
+            );
+
+            /**
+             * Method that reads data from a given offset in the input device.
+             *
+             * \param[in]  offset The offset into the input device.
+             *
+             * \param[out] buffer The buffer to receive the data.
+             *
+             * \param[in]  length The number of bytes to read.
+             *
+             * \return Returns true on success, returns false if the data could not be read.
+             */
+            bool readInputAt(unsigned long long offset, std::uint8_t* buffer, unsigned length);
+
+            /**
+             * Method that determines if random access can currently be used.
+             *
+             * \return Returns true if random access is enabled, supported by the engine and by the input device.
+             */
+            bool randomAccessAvailable() const;
+
+            /**
+             * Method that processes any header and decrypts the complete chunks held in the input buffer, verifying
+             * the trailer once the end of the input is reached.
+             *
+             * \return Returns true on success.  Returns false if the trailer could not be verified.
+             */
+            bool decryptPendingInput();
+
+            /**
+             * Method that reads and decrypts input in batches until the buffering limit is reached or no further
+             * input is available.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool fillToLimit();
+
+            /**
+             * Method that determines the number of decrypted bytes waiting to be read.
+             *
+             * \return Returns the number of unread bytes in the output buffer.
+             */
+            int outputBytesBuffered() const;
+
+            /**
+             * Method that copies decrypted data out of the output buffer.
+             *
+             * \param[out] data   The buffer to receive the data.
+             *
+             * \param[in]  length The number of bytes to copy.  The value must not exceed
+             *                    \ref Crypto::Decryptor::outputBytesBuffered.
+             */
+            void consumeOutput(char* data, int length);
+
+            /**
+             * Method that scrubs and empties the output buffer.
+             */
+            void discardOutput();
+
+            /**
+             * Method that looks for the next newline in the output buffer.  Only bytes not yet scanned are examined
+             * so line oriented reads remain linear in the size of the stream.
+             */
+            void scanForNewline();
+
+            /**
+             * Method that determines if the end of the input has been reached.
+             *
+             * \return Returns true if no further input will be received.
+             */
+            bool inputFinished() const;
 
             /**
              * Pointer to the input device.
@@ -238,11 +644,67 @@ namespace Crypto {
              */
             QByteArray outputBuffer;
 
+            /**
+             * The number of bytes at the start of the output buffer that have already been read.
+             */
+            int outputBufferOffset;
+
+            /**
+             * The index of the first unread newline in the output buffer.  A value of -1 indicates that there is no
+             * newline ahead of \ref Crypto::Decryptor::newlineScanEnd.
+             */
+            int newlineIndex;
+
+            /**
+             * The index of the first output buffer byte not yet scanned for a newline.
+             */
+            int newlineScanEnd;
+
+            /**
+             * The number of read bytes that must accumulate before they are dropped from the output buffer.
+             */
+            static constexpr int minimumCompactionSize = 4096;
+
             /**
              * Flag that is set if a source read error is detected.
              */
             bool sourceReportedError;
 
+            /**
+             * Flag that is set while we are still waiting on the stream header.
+             */
+            bool headerPending;
+
+            /**
+             * Flag that is set while we are still waiting on the stream trailer.
+             */
+            bool trailerPending;
+
+            /**
+             * Flag that is set once the trailer, if any, has been verified.
+             */
+            bool trailerValid;
+
+            /**
+             * Flag that is set once the end of the input has been signalled.
+             */
+            bool dataFinished;
+
+            /**
+             * Flag indicating if random access is enabled.
+             */
+            bool randomAccess;
+
+            /**
+             * The limit on buffered input.  A value of 0 indicates no limit.
+             */
+            qint64 currentMaximumBufferedInput;
+
+            /**
+             * The thread pool used for parallel decryption.
+             */
+            QThreadPool* currentThreadPool;
+
             /**
              * Value that holds the current number of processed input bytes.
              */
@@ -0,0 +1,225 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::DerivedKeyCache class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_DERIVED_KEY_CACHE_H
+#define CRYPTO_DERIVED_KEY_CACHE_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+
+#include <cstdint>
+
+namespace Crypto {
+    /**
+     * Class that holds recently derived keys so services that repeatedly derive the same key, such as when
+     * re-authenticating a user, do not pay for the key derivation function each time.  Keys are derived with
+     * \ref Crypto::Kdf on a miss.
+     *
+     * Entries are found by an HMAC, under a random secret generated for each cache, of the password, the salt and
+     * the derivation parameters.  The cache never holds the passwords themselves.  The least recently used entry is
+     * discarded when the cache is full.  The class is thread safe.
+     */
+    class DerivedKeyCache {
+        public:
+            /**
+             * The default number of keys held in the cache.
+             */
+            static constexpr unsigned defaultCapacity = 64;
+
+            /**
+             * Constructor
+             *
+             * \param[in] capacity The maximum number of keys held in the cache.
+             */
+            explicit DerivedKeyCache(unsigned capacity = defaultCapacity);
+
+            ~DerivedKeyCache();
+
+            /**
+             * Method you can use to set the maximum number of keys held in the cache.  Entries are discarded if the
+             * cache holds more keys than the new capacity.
+             *
+             * \param[in] newCapacity The new capacity.  A value of 0 disables caching.
+             */
+            void setCapacity(unsigned newCapacity);
+
+            /**
+             * Method you can use to determine the maximum number of keys held in the cache.
+             *
+             * \return Returns the cache capacity.
+             */
+            unsigned capacity() const;
+
+            /**
+             * Method you can use to determine the number of keys held in the cache.
+             *
+             * \return Returns the number of cached keys.
+             */
+            unsigned size() const;
+
+            /**
+             * Method you can use to discard every cached key.
+             */
+            void clear();
+
+            /**
+             * Method you can use to derive a key from a password using PBKDF2-HMAC-SHA256.
+             *
+             * \param[in] password   The password.
+             *
+             * \param[in] salt       The salt.
+             *
+             * \param[in] iterations The iteration count.
+             *
+             * \param[in] keyLength  The key length, in bytes.
+             *
+             * \return Returns the derived key.  An empty array is returned if the iteration count is 0.
+             */
+            QByteArray pbkdf2(
+                const QByteArray& password,
+                const QByteArray& salt,
+                unsigned long     iterations,
+                unsigned          keyLength
+            );
+
+            /**
+             * Method you can use to derive a key using HKDF with HMAC-SHA256.
+             *
+             * \param[in] inputKey  The input keying material.
+             *
+             * \param[in] salt      The salt.
+             *
+             * \param[in] info      The context information.
+             *
+             * \param[in] keyLength The key length, in bytes.
+             *
+             * \return Returns the derived key.  An empty array is returned if the key length exceeds
+             *         \ref Crypto::Kdf::maximumHkdfLength.
+             */
+            QByteArray hkdf(
+                const QByteArray& inputKey,
+                const QByteArray& salt,
+                const QByteArray& info,
+                unsigned          keyLength
+            );
+
+        private:
+            /**
+             * Structure holding a single cached key.
+             */
+            struct Entry {
+                /**
+                 * The derived key.
+                 */
+                QByteArray key;
+
+                /**
+                 * The use counter value when the entry was last used.
+                 */
+                unsigned long long lastUsed;
+            };
+
+            /**
+             * Method that calculates the lookup key for a derivation.
+             *
+             * \param[in] function    Value identifying the key derivation function.
+             *
+             * \param[in] secretInput The password or input keying material.
+             *
+             * \param[in] salt        The salt.
+             *
+             * \param[in] parameters  The remaining derivation parameters.
+             *
+             * \return Returns the lookup key.
+             */
+            QByteArray lookupKey(
+                std::uint8_t      function,
+                const QByteArray& secretInput,
+                const QByteArray& salt,
+                const QByteArray& parameters
+            ) const;
+
+            /**
+             * Method that finds a cached key.
+             *
+             * \param[in]  lookup The lookup key.
+             *
+             * \param[out] key    The cached key.
+             *
+             * \return Returns true if the key was found.
+             */
+            bool find(const QByteArray& lookup, QByteArray& key);
+
+            /**
+             * Method that adds a key to the cache.
+             *
+             * \param[in] lookup The lookup key.
+             *
+             * \param[in] key    The derived key.
+             */
+            void insert(const QByteArray& lookup, const QByteArray& key);
+
+            /**
+             * Method that discards the least recently used entries until the cache holds no more than a number of
+             * entries.  The caller must hold the mutex.
+             *
+             * \param[in] maximumEntries The number of entries to keep.
+             */
+            void evict(unsigned maximumEntries);
+
+            /**
+             * The length of the lookup secret, in bytes.
+             */
+            static constexpr unsigned secretLength = 32;
+
+            /**
+             * The secret used to calculate lookup keys.
+             */
+            std::uint8_t secret[secretLength];
+
+            /**
+             * Mutex protecting the cache.
+             */
+            mutable QMutex mutex;
+
+            /**
+             * The cached keys, by lookup key.
+             */
+            QHash<QByteArray, Entry> entries;
+
+            /**
+             * The cache capacity.
+             */
+            unsigned currentCapacity;
+
+            /**
+             * Counter used to track how recently each entry was used.
+             */
+            unsigned long long useCounter;
+    };
+}
+
+#endif
@@ -0,0 +1,471 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::EncryptedChannel class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_ENCRYPTED_CHANNEL_H
+#define CRYPTO_ENCRYPTED_CHANNEL_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+
+#include "crypto_cipher_base.h"
+
+class QObject;
+
+namespace Crypto {
+    class AesGcmEngine;
+
+    /**
+     * Class that provides a single bidirectional, encrypted, channel over a stream device such as a QTcpSocket or
+     * QLocalSocket.  Data written to the channel is encrypted and sent to the device.  Data received from the device
+     * is authenticated, decrypted and made available to read.  The send and receive directions use independent keys
+     * and independent AES-GCM states so the two ends of a connection use the same key pair, swapped.
+     *
+     * When opened, each end sends a hello holding a 4 byte magic value and a random 12 byte IV for its send
+     * direction.  Data is then sent as records.  Each record holds a 32-bit big endian plaintext length, the
+     * ciphertext and a 16 byte tag.  The length is included in the tag as associated data.  The nonce for a record
+     * is the IV with the record number, as a 64-bit big endian value, XORed into the last 8 bytes.
+     *
+     * Small writes are collected and sent as a single record, with a single write to the device, when control
+     * returns to the event loop or when \ref Crypto::EncryptedChannel::flush is called.  Received records are
+     * decrypted in place in the receive buffer and reads are served directly from that buffer.
+     *
+     * Any error, including a record that fails authentication, is fatal to the channel.  Data authenticated before
+     * the error can still be read.  Keys should be unique to each connection.
+     */
+    class EncryptedChannel:public QIODevice, public CipherBase {
+        public:
+            /**
+             * The length of each key, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The length of the IV sent in the hello, in bytes.
+             */
+            static constexpr unsigned ivLength = 12;
+
+            /**
+             * The length of the tag following each record, in bytes.
+             */
+            static constexpr unsigned tagLength = 16;
+
+            /**
+             * The length of the header preceding each record, in bytes.
+             */
+            static constexpr unsigned recordHeaderLength = 4;
+
+            /**
+             * The length of the hello sent by each end when the channel is opened, in bytes.
+             */
+            static constexpr unsigned helloLength = 4 + ivLength;
+
+            /**
+             * The default maximum record size, in bytes.
+             */
+            static constexpr unsigned defaultRecordSize = 16 * 1024;
+
+            /**
+             * The largest record size supported, in bytes.  Larger records received from the peer are rejected.
+             */
+            static constexpr unsigned maximumRecordSize = 1024 * 1024;
+
+            /**
+             * Type used to represent a key.
+             */
+            typedef std::uint8_t Keys[keyLength];
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the underlying
+             *                   device.
+             */
+            explicit EncryptedChannel(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit EncryptedChannel(QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] sendKeys    The keys used to encrypt data sent to the peer.
+             *
+             * \param[in] receiveKeys The keys used to decrypt data received from the peer.
+             *
+             * \param[in] parent      Pointer to the parent object.  This device will also be used as the underlying
+             *                        device.
+             */
+            explicit EncryptedChannel(const Keys& sendKeys, const Keys& receiveKeys, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] sendKeys    The keys used to encrypt data sent to the peer.
+             *
+             * \param[in] receiveKeys The keys used to decrypt data received from the peer.
+             *
+             * \param[in] parent      Pointer to the parent object.
+             */
+            explicit EncryptedChannel(const Keys& sendKeys, const Keys& receiveKeys, QObject* parent = Q_NULLPTR);
+
+            ~EncryptedChannel() override;
+
+            /**
+             * Method that returns the key length, in bytes.
+             *
+             * \return Returns the required key length, in bytes.
+             */
+            unsigned keyLengthInBytes() const override;
+
+            /**
+             * Method you can use to set the keys.  The new keys are used the next time the channel is opened.
+             *
+             * \param[in] newSendKeys    The keys used to encrypt data sent to the peer.
+             *
+             * \param[in] newReceiveKeys The keys used to decrypt data received from the peer.
+             */
+            void setKeys(const Keys& newSendKeys, const Keys& newReceiveKeys);
+
+            /**
+             * Method you can use to set the underlying device.  The device can only be changed while the channel is
+             * closed.
+             *
+             * \param[in] device The device carrying the channel.  The device must be open before the channel is
+             *                   opened.  This class does not take ownership of the device.
+             */
+            void setDevice(QIODevice* device);
+
+            /**
+             * Method you can use to determine the underlying device.
+             *
+             * \return Returns the underlying device.  A null pointer is returned if no device is set.
+             */
+            QIODevice* device() const;
+
+            /**
+             * Method you can use to set the maximum size of the records sent to the peer.  Larger records reduce
+             * overhead at the cost of latency.  The record size can only be changed while the channel is closed.
+             *
+             * \param[in] newRecordSize The new record size, in bytes.  The value is limited to between 1 and
+             *                          \ref Crypto::EncryptedChannel::maximumRecordSize.
+             */
+            void setRecordSize(unsigned newRecordSize);
+
+            /**
+             * Method you can use to determine the maximum size of the records sent to the peer.
+             *
+             * \return Returns the record size, in bytes.
+             */
+            unsigned recordSize() const;
+
+            /**
+             * Method you can use to open the channel.  The hello is sent if the channel is writable.
+             *
+             * \param[in] openMode The desired open mode.  QIODevice::ReadOnly, QIODevice::WriteOnly and
+             *                     QIODevice::ReadWrite are supported.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool open(EncryptedChannel::OpenMode openMode) override;
+
+            /**
+             * Method you can use to close the channel.  Pending data is sent first.  The underlying device is left
+             * open.
+             */
+            void close() override;
+
+            /**
+             * Method you can use to send the pending data immediately rather than waiting for the event loop.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool flush();
+
+            /**
+             * Method you can use to determine if this device is sequential.
+             *
+             * \return Returns true.
+             */
+            bool isSequential() const override;
+
+            /**
+             * Method you can use to determine the number of decrypted bytes waiting to be read.
+             *
+             * \return Returns the number of bytes available.
+             */
+            qint64 bytesAvailable() const override;
+
+            /**
+             * Method you can use to determine the number of bytes waiting to be sent.
+             *
+             * \return Returns the number of pending plaintext bytes plus the bytes pending in the underlying device.
+             */
+            qint64 bytesToWrite() const override;
+
+            /**
+             * Method you can use to wait for decrypted data.
+             *
+             * \param[in] msecs The maximum time to wait, in milliseconds.  A value of -1 waits indefinitely.
+             *
+             * \return Returns true if data is available to read.  Returns false on timeout or error.
+             */
+            bool waitForReadyRead(int msecs) override;
+
+            /**
+             * Method you can use to send the pending data and wait for the underlying device to write it.
+             *
+             * \param[in] msecs The maximum time to wait, in milliseconds.  A value of -1 waits indefinitely.
+             *
+             * \return Returns true on success.  Returns false on timeout or error.
+             */
+            bool waitForBytesWritten(int msecs) override;
+
+        protected:
+            /**
+             * Method that reads decrypted data.
+             *
+             * \param[in] data    The buffer to receive the data.
+             *
+             * \param[in] maxSize The maximum number of bytes to read.
+             *
+             * \return Returns the number of bytes read or -1 on error.
+             */
+            qint64 readData(char* data, qint64 maxSize) override;
+
+            /**
+             * Method that queues data to be encrypted and sent.
+             *
+             * \param[in] data    The data to be sent.
+             *
+             * \param[in] maxSize The number of bytes to be sent.
+             *
+             * \return Returns the number of bytes accepted or -1 on error.
+             */
+            qint64 writeData(const char* data, qint64 maxSize) override;
+
+        private slots:
+            /**
+             * Slot that is triggered when the underlying device has data available.
+             */
+            void deviceDataAvailable();
+
+        private:
+            /**
+             * Method that encrypts a record and appends it to the send buffer.
+             *
+             * \param[in] data   The record plaintext.
+             *
+             * \param[in] length The length of the record plaintext, in bytes.
+             */
+            void sealRecord(const char* data, unsigned length);
+
+            /**
+             * Method that writes the send buffer to the underlying device.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool writeSendBuffer();
+
+            /**
+             * Method that authenticates and decrypts, in place, every complete record in the receive buffer.
+             *
+             * \return Returns the number of plaintext bytes made available.
+             */
+            qint64 openRecords();
+
+            /**
+             * Method that moves the read position to the next record if the current record is exhausted.
+             *
+             * \return Returns true if plaintext is available at the read position.
+             */
+            bool advanceRecord();
+
+            /**
+             * Method that discards the consumed front of the receive buffer.
+             */
+            void compactReceiveBuffer();
+
+            /**
+             * Method that marks the channel as failed.
+             *
+             * \param[in] reason The reason for the failure.
+             */
+            void fail(const QString& reason);
+
+            /**
+             * Method that calculates the nonce for a record.
+             *
+             * \param[in]  iv           The IV for the direction.
+             *
+             * \param[in]  recordNumber The zero based record number.
+             *
+             * \param[out] nonce        Buffer to receive the nonce.
+             */
+            static void calculateNonce(const std::uint8_t* iv, std::uint64_t recordNumber, std::uint8_t* nonce);
+
+            /**
+             * The keys used to encrypt data sent to the peer.
+             */
+            Keys initialSendKeys;
+
+            /**
+             * The keys used to decrypt data received from the peer.
+             */
+            Keys initialReceiveKeys;
+
+            /**
+             * Flag indicating that the engines hold the expanded keys.
+             */
+            bool keysExpanded;
+
+            /**
+             * The underlying device.
+             */
+            QIODevice* currentDevice;
+
+            /**
+             * The maximum size of the records we send, in bytes.
+             */
+            unsigned currentRecordSize;
+
+            /**
+             * The IV for the send direction.
+             */
+            std::uint8_t sendIV[ivLength];
+
+            /**
+             * The IV for the receive direction, taken from the peer's hello.
+             */
+            std::uint8_t receiveIV[ivLength];
+
+            /**
+             * The number of records sent.
+             */
+            std::uint64_t sendRecordNumber;
+
+            /**
+             * The number of records received.
+             */
+            std::uint64_t receiveRecordNumber;
+
+            /**
+             * Flag indicating that the peer's hello has been received.
+             */
+            bool helloReceived;
+
+            /**
+             * Flag indicating that a flush has been posted to the event loop.
+             */
+            bool flushPosted;
+
+            /**
+             * Flag indicating that the channel has failed.
+             */
+            bool failed;
+
+            /**
+             * The plaintext waiting to be sent.  This never holds more than one record.
+             */
+            QByteArray pendingData;
+
+            /**
+             * The encrypted records waiting to be written to the underlying device.
+             */
+            QByteArray sendBuffer;
+
+            /**
+             * The data received from the peer.  Records before \ref Crypto::EncryptedChannel::decryptedEnd have been
+             * decrypted in place.  The header and tag of each record are left in the buffer.
+             */
+            QByteArray receiveBuffer;
+
+            /**
+             * Offset of the next byte to be read in the receive buffer.
+             */
+            int readOffset;
+
+            /**
+             * Offset just past the plaintext of the record being read.
+             */
+            int readEnd;
+
+            /**
+             * Offset of the next record to be read.
+             */
+            int recordOffset;
+
+            /**
+             * Offset just past the last decrypted record.
+             */
+            int decryptedEnd;
+
+            /**
+             * The number of decrypted bytes waiting to be read.
+             */
+            qint64 availablePlaintext;
+
+            /**
+             * Method that provides the engine used for the send direction.
+             *
+             * \return Returns a pointer to the send engine.
+             */
+            inline AesGcmEngine* sendEngine() {
+                return reinterpret_cast<AesGcmEngine*>(sendEngineStorage);
+            }
+
+            /**
+             * Method that provides the engine used for the receive direction.
+             *
+             * \return Returns a pointer to the receive engine.
+             */
+            inline AesGcmEngine* receiveEngine() {
+                return reinterpret_cast<AesGcmEngine*>(receiveEngineStorage);
+            }
+
+            /**
+             * The storage reserved for each engine, in bytes.
+             */
+            static constexpr unsigned engineStorageSize = 832;
+
+            /**
+             * Storage for the send engine.
+             */
+            alignas(16) std::uint8_t sendEngineStorage[engineStorageSize];
+
+            /**
+             * Storage for the receive engine.
+             */
+            alignas(16) std::uint8_t receiveEngineStorage[engineStorageSize];
+    };
+}
+
+#endif
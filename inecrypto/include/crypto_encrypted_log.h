@@ -0,0 +1,396 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::EncryptedLog class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_ENCRYPTED_LOG_H
+#define CRYPTO_ENCRYPTED_LOG_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QString>
+
+#include <cstdint>
+#include <cstddef>
+
+class QIODevice;
+
+namespace Crypto {
+    class Encryptor;
+    class Decryptor;
+
+    /**
+     * Class that maintains an append-only log of individually encrypted records along with a sidecar index holding
+     * the offset of every record.  Any record can be located with a single index lookup and decrypted without
+     * touching the records before it.  Runs of consecutive records can be read with a single read of the log.
+     *
+     * Each record is encrypted with the supplied \ref Crypto::Encryptor using its block API and decrypted with the
+     * matching \ref Crypto::Decryptor.  The encryptor should place a fresh IV in each message, for example by
+     * enabling the IV header, and an authenticated cipher such as AES-GCM is recommended so damaged or altered
+     * records are detected.  The encryptor and decryptor must not be open as devices while used by the log.
+     *
+     * Each record in the log is framed as a 32-bit big endian length of the encrypted record followed by the
+     * encrypted record.  The encrypted record holds a 64-bit big endian record number and a 32-bit big endian
+     * plaintext length followed by the plaintext so the position and length of the record are authenticated along
+     * with its contents.  A record that is moved, swapped with another record, or shifted by the removal of an
+     * earlier record is rejected.  Removing records from the end of the log cannot be detected by the log itself.
+     *
+     * The index starts with an 8 byte header holding a magic value and the format version followed by one 64-bit
+     * big endian log offset per record.  Entries are a fixed size and 8 byte aligned so that index files can be
+     * memory mapped.  When the index device is a file, the index is mapped when the log is opened.
+     *
+     * Records are written to the log before their index entry.  Opening the log adds index entries for complete
+     * records missing from the index and discards a partially written record at the end of the log so the log
+     * survives an interrupted append.
+     */
+    class EncryptedLog {
+        public:
+            /**
+             * The length of the frame header preceding each encrypted record, in bytes.
+             */
+            static constexpr unsigned frameHeaderLength = 4;
+
+            /**
+             * The length of the record number and plaintext length encrypted ahead of each record, in bytes.
+             */
+            static constexpr unsigned recordHeaderLength = 12;
+
+            /**
+             * The length of the index header, in bytes.
+             */
+            static constexpr unsigned indexHeaderLength = 8;
+
+            /**
+             * The length of each index entry, in bytes.
+             */
+            static constexpr unsigned indexEntryLength = 8;
+
+            /**
+             * Constructor
+             *
+             * \param[in] encryptor   The encryptor used to encrypt new records.  This class does not take ownership
+             *                        of the encryptor.
+             *
+             * \param[in] decryptor   The decryptor used to decrypt records.  This class does not take ownership of
+             *                        the decryptor.
+             *
+             * \param[in] logDevice   The device holding the records.  This class does not take ownership of the
+             *                        device.
+             *
+             * \param[in] indexDevice The device holding the index.  This class does not take ownership of the
+             *                        device.
+             */
+            EncryptedLog(
+                Encryptor* encryptor = Q_NULLPTR,
+                Decryptor* decryptor = Q_NULLPTR,
+                QIODevice* logDevice = Q_NULLPTR,
+                QIODevice* indexDevice = Q_NULLPTR
+            );
+
+            ~EncryptedLog();
+
+            /**
+             * Method you can use to set the encryptor.
+             *
+             * \param[in] newEncryptor The encryptor used to encrypt new records.
+             */
+            void setEncryptor(Encryptor* newEncryptor);
+
+            /**
+             * Method you can use to obtain the encryptor.
+             *
+             * \return Returns the encryptor.
+             */
+            Encryptor* encryptor() const;
+
+            /**
+             * Method you can use to set the decryptor.
+             *
+             * \param[in] newDecryptor The decryptor used to decrypt records.
+             */
+            void setDecryptor(Decryptor* newDecryptor);
+
+            /**
+             * Method you can use to obtain the decryptor.
+             *
+             * \return Returns the decryptor.
+             */
+            Decryptor* decryptor() const;
+
+            /**
+             * Method you can use to set the device holding the records.  Setting the device closes the log.
+             *
+             * \param[in] newLogDevice The log device.
+             */
+            void setLogDevice(QIODevice* newLogDevice);
+
+            /**
+             * Method you can use to obtain the device holding the records.
+             *
+             * \return Returns the log device.
+             */
+            QIODevice* logDevice() const;
+
+            /**
+             * Method you can use to set the device holding the index.  Setting the device closes the log.
+             *
+             * \param[in] newIndexDevice The index device.
+             */
+            void setIndexDevice(QIODevice* newIndexDevice);
+
+            /**
+             * Method you can use to obtain the device holding the index.
+             *
+             * \return Returns the index device.
+             */
+            QIODevice* indexDevice() const;
+
+            /**
+             * Method you can use to open the log.  Both devices must already be open for reading and writing and
+             * must be random access devices.  An empty index device is initialized.  The index is brought up to date
+             * with the log.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool open();
+
+            /**
+             * Method you can use to close the log.  The devices are left open.
+             */
+            void close();
+
+            /**
+             * Method you can use to determine if the log is open.
+             *
+             * \return Returns true if the log is open.  Returns false if the log is closed.
+             */
+            bool isOpen() const;
+
+            /**
+             * Method you can use to determine the number of records in the log.
+             *
+             * \return Returns the number of records.
+             */
+            unsigned long long numberRecords() const;
+
+            /**
+             * Method you can use to append a record to the log.
+             *
+             * \param[in] record The record to append.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool append(const QByteArray& record);
+
+            /**
+             * Method you can use to read a single record.
+             *
+             * \param[in]  recordIndex The zero based index of the record.
+             *
+             * \param[out] record      Returns the decrypted record.
+             *
+             * \return Returns true on success.  Returns false if the record does not exist or could not be read or
+             *         decrypted.
+             */
+            bool readRecord(unsigned long long recordIndex, QByteArray& record);
+
+            /**
+             * Method you can use to read a run of consecutive records.  The records are read from the log with a
+             * single read and decrypted in order.
+             *
+             * \param[in]  firstRecord     The zero based index of the first record.
+             *
+             * \param[in]  numberToRead    The number of records to read.  The run is shortened if it extends past
+             *                             the last record.
+             *
+             * \param[out] records         Returns the decrypted records.
+             *
+             * \return Returns true on success.  Returns false if the first record does not exist or if any record
+             *         could not be read or decrypted.
+             */
+            bool readRecords(unsigned long long firstRecord, unsigned long long numberToRead, QByteArrayList& records);
+
+            /**
+             * Method you can use to obtain a description of the last error.
+             *
+             * \return Returns a description of the last error.
+             */
+            QString errorString() const;
+
+        private:
+            /**
+             * Method that prepares the index device, writing the header to an empty index.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool loadIndex();
+
+            /**
+             * Method that brings the index up to date with the log, discarding index entries for records that are
+             * not in the log, indexing complete records that are not in the index and discarding a partial record at
+             * the end of the log.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool recoverIndex();
+
+            /**
+             * Method that reads a frame header from the log.
+             *
+             * \param[in]  offset      The offset of the frame in the log.
+             *
+             * \param[out] frameLength Returns the length of the frame, including the frame header.
+             *
+             * \return Returns true if a complete frame is held in the log at the offset.  Returns false otherwise.
+             */
+            bool readFrameLength(unsigned long long offset, unsigned long long& frameLength);
+
+            /**
+             * Method that reads an index entry.
+             *
+             * \param[in]  recordIndex The zero based index of the record.
+             *
+             * \param[out] offset      Returns the offset of the record in the log.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool readIndexEntry(unsigned long long recordIndex, unsigned long long& offset);
+
+            /**
+             * Method that determines the offset just past a record in the log.
+             *
+             * \param[in]  recordIndex The zero based index of the record.
+             *
+             * \param[out] offset      Returns the offset of the following record or the end of the log.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool readRecordEnd(unsigned long long recordIndex, unsigned long long& offset);
+
+            /**
+             * Method that reads a run of the log.
+             *
+             * \param[in]  startOffset The offset of the first byte.
+             *
+             * \param[in]  endOffset   The offset just past the last byte.
+             *
+             * \param[out] data        Returns the data.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool readLog(unsigned long long startOffset, unsigned long long endOffset, QByteArray& data);
+
+            /**
+             * Method that writes an index entry.
+             *
+             * \param[in] recordIndex The zero based index of the record.
+             *
+             * \param[in] offset      The offset of the record in the log.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool writeIndexEntry(unsigned long long recordIndex, unsigned long long offset);
+
+            /**
+             * Method that decrypts a single framed record.
+             *
+             * \param[in]  recordIndex The zero based index of the record the frame is expected to hold.
+             *
+             * \param[in]  frameData   Pointer to the frame.
+             *
+             * \param[in]  frameLength The length of the frame, including the frame header.
+             *
+             * \param[out] record      Returns the decrypted record.
+             *
+             * \return Returns true on success.  Returns false on error or if the frame holds a different record.
+             */
+            bool decryptFrame(
+                unsigned long long  recordIndex,
+                const std::uint8_t* frameData,
+                unsigned long long  frameLength,
+                QByteArray&         record
+            );
+
+            /**
+             * Method that maps the index into memory when the index device supports it.
+             */
+            void mapIndex();
+
+            /**
+             * Method that releases the index mapping.
+             */
+            void unmapIndex();
+
+            /**
+             * The encryptor.
+             */
+            Encryptor* currentEncryptor;
+
+            /**
+             * The decryptor.
+             */
+            Decryptor* currentDecryptor;
+
+            /**
+             * The log device.
+             */
+            QIODevice* currentLogDevice;
+
+            /**
+             * The index device.
+             */
+            QIODevice* currentIndexDevice;
+
+            /**
+             * Flag indicating that the log is open.
+             */
+            bool currentlyOpen;
+
+            /**
+             * The number of records in the log.
+             */
+            unsigned long long currentNumberRecords;
+
+            /**
+             * The offset just past the last complete record in the log.
+             */
+            unsigned long long logEndOffset;
+
+            /**
+             * The mapped index, including the index header.  A null pointer if the index is not mapped.
+             */
+            const std::uint8_t* mappedIndex;
+
+            /**
+             * The number of index entries covered by the mapping.
+             */
+            unsigned long long numberMappedEntries;
+
+            /**
+             * The description of the last error.
+             */
+            QString currentErrorString;
+    };
+}
+
+#endif
@@ -28,10 +28,13 @@
 #include <QtGlobal>
 #include <QIODevice>
 #include <QByteArray>
+#include <QByteArrayList>
 #include <QObject>
 
+#include <cstddef>
 #include <cstdint>
 
+#include "crypto_const_buffer.h"
 #include "crypto_cipher_base.h"
 
 class QObject;
@@ -46,6 +49,11 @@ namespace Crypto {
      */
     class Encryptor:public QIODevice, public CipherBase {
         public:
+            /**
+             * The largest input chunk size supported by this class, in bytes.
+             */
+            static constexpr unsigned maximumInputChunkSize = 256;
+
             /**
              * Constructor
              *
@@ -67,10 +75,94 @@ namespace Crypto {
              *
              * \param[in] inputBuffer The buffer to be encrypted.
              *
-             * \return Returns an encrypted version of the supplied buffer.
+             * \return Returns an encrypted version of the supplied buffer.  An empty array is returned if the engine
+             *         refuses to start a new stream.
              */
             QByteArray encrypt(const QByteArray& inputBuffer);
 
+            /**
+             * Method you can call to encrypt a data buffer into memory you supply.  The input and output buffers must
+             * not overlap.  Use \ref Crypto::Encryptor::encryptInPlace to encrypt a buffer in place.
+             *
+             * \param[in]  inputData      Pointer to the data to be encrypted.
+             *
+             * \param[in]  inputLength    The number of bytes to be encrypted.
+             *
+             * \param[out] outputData     Pointer to the buffer to receive the encrypted data.
+             *
+             * \param[in]  outputCapacity The size of the output buffer, in bytes.
+             *
+             * \return Returns the number of bytes written to the output buffer.  A value of 0 is returned if the
+             *         output buffer is too small or if the engine refuses to start a new stream.
+             */
+            std::size_t encrypt(
+                const std::uint8_t* inputData,
+                std::size_t         inputLength,
+                std::uint8_t*       outputData,
+                std::size_t         outputCapacity
+            );
+
+            /**
+             * Method you can call to encrypt a message assembled from several buffers.  The buffers are treated as one
+             * logical stream so the output is identical to encrypting their concatenation.
+             *
+             * \param[in] inputBuffers The buffers to be encrypted, in order.
+             *
+             * \return Returns an encrypted version of the supplied buffers.  An empty array is returned if the engine
+             *         refuses to start a new stream.
+             */
+            QByteArray encrypt(const QByteArrayList& inputBuffers);
+
+            /**
+             * Method you can call to encrypt a message assembled from several buffers into memory you supply.  The
+             * buffers are treated as one logical stream.  Whole chunks are encrypted directly from the supplied
+             * buffers and only chunks that straddle two buffers are copied.  The input buffers must not overlap the
+             * output buffer.
+             *
+             * \param[in]  inputBuffers       Pointer to the buffers to be encrypted, in order.
+             *
+             * \param[in]  numberInputBuffers The number of input buffers.
+             *
+             * \param[out] outputData         Pointer to the buffer to receive the encrypted data.
+             *
+             * \param[in]  outputCapacity     The size of the output buffer, in bytes.
+             *
+             * \return Returns the number of bytes written to the output buffer.  A value of 0 is returned if the
+             *         output buffer is too small or if the engine refuses to start a new stream.
+             */
+            std::size_t encrypt(
+                const ConstBuffer* inputBuffers,
+                std::size_t        numberInputBuffers,
+                std::uint8_t*      outputData,
+                std::size_t        outputCapacity
+            );
+
+            /**
+             * Method you can call to encrypt a data buffer in place.  The encrypted data, including any header, will
+             * start at the beginning of the buffer.  This method requires equal input and output chunk sizes.
+             *
+             * \param[in,out] buffer      The buffer holding the data to be encrypted.
+             *
+             * \param[in]     inputLength The number of bytes to be encrypted.
+             *
+             * \param[in]     capacity    The size of the buffer, in bytes.  Use
+             *                            \ref Crypto::Encryptor::encryptedSize to determine the required size.
+             *
+             * \return Returns the number of encrypted bytes in the buffer.  A value of 0 is returned if the buffer
+             *         is too small, the chunk sizes differ or the engine refuses to start a new stream.
+             */
+            std::size_t encryptInPlace(std::uint8_t* buffer, std::size_t inputLength, std::size_t capacity);
+
+            /**
+             * Method you can use to determine the number of bytes the block encryption methods will produce for a
+             * given input.
+             *
+             * \param[in] inputLength The number of bytes to be encrypted.
+             *
+             * \return Returns the encrypted size, in bytes, including any header and trailer.
+             */
+            std::size_t encryptedSize(std::size_t inputLength) const;
+
             /**
              * Method you can use to set the destination device.
              *
@@ -96,6 +188,12 @@ namespace Crypto {
              */
             bool open(Encryptor::OpenMode openMode) override;
 
+            /**
+             * Method you can use to close the device.  If the engine produces a trailer, any pending data is flushed
+             * and the trailer is written to the output device before the device is closed.
+             */
+            void close() override;
+
             /**
              * Method you can use to flush the current encryption buffer.  This method will append
              * a PKCS#7 sequence, if needed, and then flush the internal buffer.
@@ -112,6 +210,69 @@ namespace Crypto {
              */
             bool flushAndPad();
 
+            /**
+             * Method you can use to enable or disable asynchronous encryption.  When enabled, data written to the
+             * encryptor is queued and encrypted on a worker thread so that writes return immediately.  Encrypted data
+             * is written to the output device from the thread that owns the encryptor, either from the event loop or
+             * from \ref Crypto::Encryptor::waitForBytesWritten, so devices such as sockets are only ever used from
+             * their own thread.  The setting takes effect the next time the encryptor is opened.
+             *
+             * \param[in] nowEnabled If true, asynchronous encryption will be enabled.  If false, data is encrypted
+             *                       and written out on the calling thread.  Asynchronous encryption is disabled by
+             *                       default.
+             */
+            void setAsynchronousEnabled(bool nowEnabled = true);
+
+            /**
+             * Method you can use to determine if asynchronous encryption is enabled.
+             *
+             * \return Returns true if asynchronous encryption is enabled.  Returns false if asynchronous encryption is
+             *         disabled.
+             */
+            bool asynchronousEnabled() const;
+
+            /**
+             * Method you can use to set the maximum number of bytes that can be queued for asynchronous encryption.
+             * Writes beyond this limit are truncated so \ref Crypto::Encryptor::write may accept fewer bytes than
+             * requested, or none.  Callers should write the remainder once \ref Crypto::Encryptor::bytesWritten is
+             * emitted or \ref Crypto::Encryptor::waitForBytesWritten returns.
+             *
+             * \param[in] newMaximumQueuedBytes The new queue limit, in bytes.
+             */
+            void setMaximumQueuedBytes(qint64 newMaximumQueuedBytes);
+
+            /**
+             * Method you can use to determine the maximum number of bytes that can be queued for asynchronous
+             * encryption.
+             *
+             * \return Returns the queue limit, in bytes.
+             */
+            qint64 maximumQueuedBytes() const;
+
+            /**
+             * The default limit on the number of bytes queued for asynchronous encryption.
+             */
+            static constexpr qint64 defaultMaximumQueuedBytes = 1024 * 1024;
+
+            /**
+             * Method you can use to determine the number of written bytes that have not yet been encrypted and sent
+             * to the output device.  The value is always 0 unless asynchronous encryption is enabled.
+             *
+             * \return Returns the number of queued bytes.
+             */
+            qint64 bytesToWrite() const override;
+
+            /**
+             * Method you can use to block until queued data has been encrypted and written to the output device.
+             * The method only blocks when asynchronous encryption is enabled.
+             *
+             * \param[in] msecs The maximum time to wait, in milliseconds.  A value of -1 waits indefinitely.
+             *
+             * \return Returns true if encrypted data was written to the output device.  Returns false on timeout,
+             *         on error, or if there was nothing left to write.
+             */
+            bool waitForBytesWritten(int msecs) override;
+
             /**
              * Method you can use to determine if this is a sequential device.
              *
@@ -121,7 +282,8 @@ namespace Crypto {
             bool isSequential() const override;
 
             /**
-             * Method you can use to determine the encryption input chunk size.
+             * Method you can use to determine the encryption input chunk size.  The value must not exceed
+             * \ref Crypto::Encryptor::maximumInputChunkSize.
              *
              * \return Returns the input chunk size.
              */
@@ -135,6 +297,22 @@ namespace Crypto {
              */
             virtual unsigned outputChunkSize() const;
 
+            /**
+             * Method you can use to determine the size of the header placed ahead of the encrypted data.  The default
+             * implementation returns 0, indicating no header.
+             *
+             * \return Returns the header size, in bytes.
+             */
+            virtual unsigned headerSize() const;
+
+            /**
+             * Method you can use to determine the size of the trailer placed after the encrypted data, such as an
+             * authentication tag.  The default implementation returns 0, indicating no trailer.
+             *
+             * \return Returns the trailer size, in bytes.
+             */
+            virtual unsigned trailerSize() const;
+
             /**
              * Method you can use to determine the total number of input bytes that have been processed.
              *
@@ -178,9 +356,43 @@ namespace Crypto {
              */
             virtual void resetEngine() = 0;
 
+            /**
+             * Method you can overload to generate the header placed ahead of the encrypted data.  The method is
+             * called immediately after the engine is reset.  The default implementation does nothing.
+             *
+             * \param[out] headerData Pointer to the buffer to receive the header.  The buffer will be
+             *                        \ref Crypto::Encryptor::headerSize bytes in length.
+             */
+            virtual void generateHeader(std::uint8_t* headerData);
+
+            /**
+             * Method you can overload to generate the trailer placed after the encrypted data.  The method is called
+             * once all of the data has been encrypted.  The default implementation does nothing.
+             *
+             * \param[out] trailerData Pointer to the buffer to receive the trailer.  The buffer will be
+             *                         \ref Crypto::Encryptor::trailerSize bytes in length.
+             */
+            virtual void generateTrailer(std::uint8_t* trailerData);
+
+            /**
+             * Method you can overload to clear state that only applies to the stream just processed, such as keys
+             * derived during the stream.  The method is called once a buffer has been encrypted and when the device
+             * is closed.  The default implementation does nothing.
+             */
+            virtual void finishEngine();
+
+            /**
+             * Method you can overload to refuse to start a new stream, for example because starting it would reuse a
+             * nonce.  The method is called before the engine is reset.  The default implementation always returns
+             * true.
+             *
+             * \return Returns true if a new stream can be started.  Returns false if the stream must be refused.
+             */
+            virtual bool streamAllowed() const;
+
             /**
              * Method you should overload to perform encryption on a single chunk.  Data will always be supplied in
-             * full chunks.
+             * full chunks.  The input and output pointers may be identical but will never otherwise overlap.
              *
              * \param[in]  inputData  Pointer to the unencrypted data to be processed.
              *
@@ -188,7 +400,62 @@ namespace Crypto {
              */
             virtual void encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) = 0;
 
+            /**
+             * Method you can overload to encrypt a run of contiguous chunks in one call.  Engines that can process
+             * several chunks at once, such as counter mode engines, should overload this method.  The default
+             * implementation calls \ref Crypto::Encryptor::encryptChunk once per chunk.
+             *
+             * \param[in]  inputData    Pointer to the unencrypted data to be processed.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.  The input and output
+             *                          pointers may be identical but will never otherwise overlap.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
+             */
+            virtual void encryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            );
+
         private:
+            class Worker;
+
+            /**
+             * Method that encrypts data and writes the encrypted chunks to a device.  Any partial chunk is held back
+             * until more data arrives or the encryptor is flushed.
+             *
+             * \param[in] data    The data to be encrypted.
+             *
+             * \param[in] maxSize The number of bytes to be encrypted.
+             *
+             * \param[in] device  The device to receive the encrypted data.
+             *
+             * \return Returns the number of bytes consumed.  A value of -1 is returned on error.
+             */
+            qint64 encryptToDevice(const char* data, qint64 maxSize, QIODevice* device);
+
+            /**
+             * Method that writes any data encrypted by the worker thread to the output device.
+             *
+             * \return Returns true on success.  Returns false if the output device reported an error.
+             */
+            bool writeEncryptedData();
+
+            /**
+             * Method that blocks until the worker thread has encrypted all queued data and then writes the encrypted
+             * data to the output device.
+             *
+             * \return Returns true on success.  Returns false if the output device reported an error.
+             */
+            bool drainWorker();
+
+            /**
+             * Method that stops and releases the worker thread.  Queued data that has not been encrypted is
+             * discarded.
+             */
+            void stopWorker();
+
             /**
              * Method that is called to perform common configuration tasks.
              *
@@ -217,10 +484,22 @@ namespace Crypto {
             QByteArray inputBuffer;
 
             /**
-             * The output buffer.
+             * The output buffer.  The buffer is sized to hold the output from a full pass through
+             * \ref Crypto::Encryptor::writeData.
              */
             QByteArray outputBuffer;
 
+            /**
+             * The approximate number of input bytes to be encrypted per pass through
+             * \ref Crypto::Encryptor::writeData.
+             */
+            static constexpr unsigned writeBatchSize = 4096;
+
+            /**
+             * The number of chunks encrypted per pass through \ref Crypto::Encryptor::writeData.
+             */
+            unsigned chunksPerPass;
+
             /**
              * The current input buffer index;
              */
@@ -240,6 +519,22 @@ namespace Crypto {
              * Value that holds the current number of processed output bytes.
              */
             unsigned long long currentNumberOutputBytesProcessed;
+
+            /**
+             * Flag indicating if asynchronous encryption should be used when the encryptor is opened.
+             */
+            bool asynchronous;
+
+            /**
+             * The limit on the number of bytes queued for asynchronous encryption.
+             */
+            qint64 currentMaximumQueuedBytes;
+
+            /**
+             * The worker thread used for asynchronous encryption.  The pointer is null unless the encryptor was opened
+             * with asynchronous encryption enabled.
+             */
+            Worker* currentWorker;
     };
 }
 
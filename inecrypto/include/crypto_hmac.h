@@ -27,8 +27,11 @@
 
 #include <QtGlobal>
 #include <QByteArray>
+#include <QByteArrayList>
 #include <QCryptographicHash>
 
+#include "crypto_const_buffer.h"
+
 namespace Crypto {
     /** \rst:leading-asterisk
      *
@@ -167,6 +170,32 @@ namespace Crypto {
                 inner.addData(newData);
             }
 
+            /**
+             * Adds a message assembled from several buffers to the hash.  The buffers are hashed in order without
+             * being concatenated.
+             *
+             * \param[in] newData The buffers to be added.
+             */
+            inline void addData(QByteArrayList const& newData) {
+                for (QByteArray const& buffer : newData) {
+                    inner.addData(buffer);
+                }
+            }
+
+            /**
+             * Adds a message assembled from several buffers to the hash.  The buffers are hashed in order without
+             * being concatenated.
+             *
+             * \param[in] buffers       Pointer to the buffers to be added.
+             *
+             * \param[in] numberBuffers The number of buffers.
+             */
+            inline void addData(ConstBuffer const* buffers, std::size_t const numberBuffers) {
+                for (std::size_t i=0 ; i<numberBuffers ; ++i) {
+                    inner.addData(reinterpret_cast<char const*>(buffers[i].data), static_cast<int>(buffers[i].length));
+                }
+            }
+
             /**
              * Resets all internally stored data.
              *
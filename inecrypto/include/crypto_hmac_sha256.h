@@ -0,0 +1,131 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::HmacSha256 class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_HMAC_SHA256_H
+#define CRYPTO_HMAC_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <crypto_sha256.h>
+#include <crypto_const_buffer.h>
+
+namespace Crypto {
+    /**
+     * Class that calculates an HMAC using SHA-256.  The class is part of the Qt-free core library.  The inner and
+     * outer hash states are keyed once at construction so each message only hashes the message itself plus one
+     * additional block for the outer hash.
+     */
+    class HmacSha256 {
+        public:
+            /**
+             * The HMAC block size, in bytes.
+             */
+            static constexpr unsigned blockSize = Sha256::blockSize;
+
+            /**
+             * The HMAC digest size, in bytes.
+             */
+            static constexpr unsigned digestSize = Sha256::digestSize;
+
+            /**
+             * Constructor.  Keys longer than blockSize are hashed first, per RFC 2104.
+             *
+             * \param[in] key       Pointer to the key.
+             *
+             * \param[in] keyLength The key length, in bytes.
+             */
+            HmacSha256(const std::uint8_t* key, std::size_t keyLength);
+
+            /**
+             * Method you can use to discard any message data added so far.  The key is retained.
+             */
+            void reset();
+
+            /**
+             * Method you can use to add message data.
+             *
+             * \param[in] data   Pointer to the data to be added.
+             *
+             * \param[in] length The number of bytes to be added.
+             */
+            void addData(const std::uint8_t* data, std::size_t length);
+
+            /**
+             * Method you can use to add message data held in several buffers.  The buffers are hashed in order without
+             * being concatenated.
+             *
+             * \param[in] buffers       Pointer to the buffers to be added.
+             *
+             * \param[in] numberBuffers The number of buffers.
+             */
+            void addData(const ConstBuffer* buffers, std::size_t numberBuffers);
+
+            /**
+             * Method you can use to obtain the HMAC of the message data added so far.
+             *
+             * \param[out] digest Pointer to the buffer to receive the digestSize byte HMAC.
+             */
+            void result(std::uint8_t* digest) const;
+
+            /**
+             * Method you can use to calculate the HMAC of a buffer in one call.
+             *
+             * \param[in]  key       Pointer to the key.
+             *
+             * \param[in]  keyLength The key length, in bytes.
+             *
+             * \param[in]  data      Pointer to the message.
+             *
+             * \param[in]  length    The message length, in bytes.
+             *
+             * \param[out] digest    Pointer to the buffer to receive the digestSize byte HMAC.
+             */
+            static void hmac(
+                const std::uint8_t* key,
+                std::size_t         keyLength,
+                const std::uint8_t* data,
+                std::size_t         length,
+                std::uint8_t*       digest
+            );
+
+        private:
+            /**
+             * The hash state after absorbing the key XORed with the inner pad.
+             */
+            Sha256 innerKeyed;
+
+            /**
+             * The hash state after absorbing the key XORed with the outer pad.
+             */
+            Sha256 outerKeyed;
+
+            /**
+             * The inner hash of the current message.
+             */
+            Sha256 inner;
+    };
+}
+
+#endif
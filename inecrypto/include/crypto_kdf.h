@@ -0,0 +1,197 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::Kdf class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_KDF_H
+#define CRYPTO_KDF_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <crypto_const_buffer.h>
+
+namespace Crypto {
+    /**
+     * Class that provides the HKDF (RFC 5869) and PBKDF2 (RFC 8018) key derivation functions, both using
+     * HMAC-SHA256.  The class is part of the Qt-free core library.
+     *
+     * PBKDF2 keys the inner and outer HMAC hash states once per password so each iteration costs two SHA-256
+     * compressions.  Independent output blocks, and the keys of several passwords derived in one call, are iterated
+     * side by side across SIMD lanes when the processor supports SSE2 or AVX2.
+     */
+    class Kdf {
+        public:
+            /**
+             * The HMAC-SHA256 digest size, in bytes.  This is also the length of an HKDF pseudo-random key.
+             */
+            static constexpr unsigned digestSize = 32;
+
+            /**
+             * The longest key HKDF-Expand can produce, in bytes.
+             */
+            static constexpr unsigned maximumHkdfLength = 255 * digestSize;
+
+            /**
+             * Method you can use to perform the HKDF-Extract step.
+             *
+             * \param[in]  salt            Pointer to the salt.  May be null if the salt length is 0.
+             *
+             * \param[in]  saltLength      The salt length, in bytes.  An empty salt is treated as digestSize zero
+             *                             bytes.
+             *
+             * \param[in]  inputKey        Pointer to the input keying material.
+             *
+             * \param[in]  inputKeyLength  The input keying material length, in bytes.
+             *
+             * \param[out] pseudoRandomKey Buffer to receive the digestSize byte pseudo-random key.
+             */
+            static void hkdfExtract(
+                const std::uint8_t* salt,
+                std::size_t         saltLength,
+                const std::uint8_t* inputKey,
+                std::size_t         inputKeyLength,
+                std::uint8_t*       pseudoRandomKey
+            );
+
+            /**
+             * Method you can use to perform the HKDF-Expand step.
+             *
+             * \param[in]  pseudoRandomKey       Pointer to the pseudo-random key.
+             *
+             * \param[in]  pseudoRandomKeyLength The pseudo-random key length, in bytes.
+             *
+             * \param[in]  info                  Pointer to the context information.  May be null if the length is 0.
+             *
+             * \param[in]  infoLength            The context information length, in bytes.
+             *
+             * \param[out] outputKey             Buffer to receive the derived key.
+             *
+             * \param[in]  outputKeyLength       The derived key length, in bytes.
+             *
+             * \return Returns true on success.  Returns false if the derived key length exceeds maximumHkdfLength.
+             */
+            static bool hkdfExpand(
+                const std::uint8_t* pseudoRandomKey,
+                std::size_t         pseudoRandomKeyLength,
+                const std::uint8_t* info,
+                std::size_t         infoLength,
+                std::uint8_t*       outputKey,
+                std::size_t         outputKeyLength
+            );
+
+            /**
+             * Method you can use to perform HKDF-Extract followed by HKDF-Expand.
+             *
+             * \param[in]  salt            Pointer to the salt.  May be null if the salt length is 0.
+             *
+             * \param[in]  saltLength      The salt length, in bytes.
+             *
+             * \param[in]  inputKey        Pointer to the input keying material.
+             *
+             * \param[in]  inputKeyLength  The input keying material length, in bytes.
+             *
+             * \param[in]  info            Pointer to the context information.  May be null if the length is 0.
+             *
+             * \param[in]  infoLength      The context information length, in bytes.
+             *
+             * \param[out] outputKey       Buffer to receive the derived key.
+             *
+             * \param[in]  outputKeyLength The derived key length, in bytes.
+             *
+             * \return Returns true on success.  Returns false if the derived key length exceeds maximumHkdfLength.
+             */
+            static bool hkdf(
+                const std::uint8_t* salt,
+                std::size_t         saltLength,
+                const std::uint8_t* inputKey,
+                std::size_t         inputKeyLength,
+                const std::uint8_t* info,
+                std::size_t         infoLength,
+                std::uint8_t*       outputKey,
+                std::size_t         outputKeyLength
+            );
+
+            /**
+             * Method you can use to derive a key from a password using PBKDF2-HMAC-SHA256.
+             *
+             * \param[in]  password         Pointer to the password.
+             *
+             * \param[in]  passwordLength   The password length, in bytes.
+             *
+             * \param[in]  salt             Pointer to the salt.  May be null if the salt length is 0.
+             *
+             * \param[in]  saltLength       The salt length, in bytes.
+             *
+             * \param[in]  iterations       The iteration count.  Must be at least 1.
+             *
+             * \param[out] derivedKey       Buffer to receive the derived key.
+             *
+             * \param[in]  derivedKeyLength The derived key length, in bytes.
+             *
+             * \return Returns true on success.  Returns false if the iteration count is 0.
+             */
+            static bool pbkdf2(
+                const std::uint8_t* password,
+                std::size_t         passwordLength,
+                const std::uint8_t* salt,
+                std::size_t         saltLength,
+                unsigned long       iterations,
+                std::uint8_t*       derivedKey,
+                std::size_t         derivedKeyLength
+            );
+
+            /**
+             * Method you can use to derive keys from several passwords sharing a salt and iteration count.  The
+             * passwords are iterated side by side so a batch costs little more than a single password on processors
+             * with SIMD support.
+             *
+             * \param[in]  passwords        Pointer to the passwords.
+             *
+             * \param[in]  numberPasswords  The number of passwords.
+             *
+             * \param[in]  salt             Pointer to the salt.  May be null if the salt length is 0.
+             *
+             * \param[in]  saltLength       The salt length, in bytes.
+             *
+             * \param[in]  iterations       The iteration count.  Must be at least 1.
+             *
+             * \param[out] derivedKeys      Buffer to receive the derived keys, one after another.  The buffer must
+             *                              hold numberPasswords times derivedKeyLength bytes.
+             *
+             * \param[in]  derivedKeyLength The length of each derived key, in bytes.
+             *
+             * \return Returns true on success.  Returns false if the iteration count is 0.
+             */
+            static bool pbkdf2(
+                const ConstBuffer*  passwords,
+                std::size_t         numberPasswords,
+                const std::uint8_t* salt,
+                std::size_t         saltLength,
+                unsigned long       iterations,
+                std::uint8_t*       derivedKeys,
+                std::size_t         derivedKeyLength
+            );
+    };
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header provides support for the Poly1305 one-time authenticator.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_POLY1305_H
+#define CRYPTO_POLY1305_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+#include <cstdint>
+
+namespace Crypto {
+    class Poly1305Engine;
+
+    /** \rst:leading-asterisk
+     *
+     * Class that calculates the RFC-8439 Poly1305 one-time authenticator.  Poly1305 is much faster than an HMAC but
+     * each 32 byte key must only ever be used to authenticate a single message.  Keys are normally derived per
+     * message, as done by ``Crypto::ChaCha20Poly1305Encryptor``.  Note that all internal data structures are cleared
+     * when the class is destroyed.
+     *
+     * Typical use of this class is shown in listing :num:`crypo-poly1305-example-listing-1` below.
+     *
+     * .. _crypo-poly1305-example-listing-1:
+     * .. code-block:: c++
+     *    :caption: Example use of the ``Crypto::Poly1305`` module
+     *
+     *    Crypto::Poly1305 poly1305(oneTimeKey);
+     *
+     *    . . . .
+     *
+     *    poly1305.addData(receivedData);
+     *
+     *    . . . .
+     *
+     *    QByteArray tag = poly1305.digest();
+     *
+     * \endrst
+     */
+    class Poly1305 {
+        public:
+            /**
+             * The key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The digest length, in bytes.
+             */
+            static constexpr unsigned digestLength = 16;
+
+            /**
+             * Constructor.
+             *
+             * \param[in] newKey The 32 byte one-time key.
+             */
+            explicit Poly1305(QByteArray const& newKey);
+
+            /**
+             * Constructor.
+             *
+             * \param[in] key  The 32 byte one-time key.
+             *
+             * \param[in] data The new starting data.
+             */
+            Poly1305(QByteArray const& key, QByteArray const& data);
+
+            ~Poly1305();
+
+            /**
+             * Adds data to the message.
+             *
+             * \param[in] newData    The data to be added.
+             *
+             * \param[in] dataLength The number of bytes of data.
+             */
+            void addData(char const* newData, int const dataLength);
+
+            /**
+             * Adds data to the message.
+             *
+             * \param[in] newData    The data to be added.
+             *
+             * \param[in] dataLength The number of bytes of data.
+             */
+            inline void addData(unsigned char const* newData, int const dataLength) {
+                addData(reinterpret_cast<char const*>(newData), dataLength);
+            }
+
+            /**
+             * Adds data to the message.
+             *
+             * \param[in] newData The data to be added.
+             */
+            inline void addData(QByteArray const& newData) {
+                addData(newData.constData(), newData.size());
+            }
+
+            /**
+             * Resets all internally stored data, assigning a new key.  Unlike \ref Crypto::Hmac, there is no reset
+             * that keeps the key as a Poly1305 key must not be reused.
+             *
+             * \param[in] newKey The new 32 byte one-time key.
+             */
+            void reset(QByteArray const& newKey);
+
+            /**
+             * Calculates the tag and returns the result.  Note that once the digest is calculated, the class must be
+             * reset with a new key before it can be used further.
+             *
+             * \return Returns an array of 16 bytes containing the calculated tag.
+             */
+            QByteArray digest();
+
+        private:
+            /**
+             * Method that provides the Poly1305 engine held by this instance.
+             *
+             * \return Returns a pointer to the Poly1305 engine.
+             */
+            inline Poly1305Engine* engine() {
+                return reinterpret_cast<Poly1305Engine*>(engineStorage);
+            }
+
+            /**
+             * The storage reserved for the Poly1305 engine, in bytes.
+             */
+            static constexpr unsigned engineStorageSize = 96;
+
+            /**
+             * Flag indicating that the digest has been calculated.
+             */
+            bool instanceSpent;
+
+            /**
+             * Storage for the Poly1305 engine.  The engine is held in-line so that no heap allocation is needed per
+             * instance.
+             */
+            alignas(16) std::uint8_t engineStorage[engineStorageSize];
+    };
+};
+#endif
@@ -0,0 +1,333 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::SegmentedDecryptor class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_SEGMENTED_DECRYPTOR_H
+#define CRYPTO_SEGMENTED_DECRYPTOR_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+#include <cstddef>
+
+#include "crypto_cipher_base.h"
+
+class QObject;
+class QThreadPool;
+
+namespace Crypto {
+    class SegmentEngine;
+
+    /**
+     * Class that reads the framed container written by \ref Crypto::SegmentedEncryptor.  The device is a random
+     * access device reporting the size of the decrypted stream.  Reads decrypt and verify whole segments, fetching a
+     * batch of segments that is decrypted in parallel when a thread pool is supplied.  Seeking only decrypts the
+     * segments that are subsequently read.
+     *
+     * The input device must be a random access device such as a file or buffer and must already be open for reading.
+     * Opening the decryptor reads the container header and verifies the first segments so a wrong key or a damaged
+     * header is reported by \ref Crypto::SegmentedDecryptor::open.
+     */
+    class SegmentedDecryptor:public QIODevice, public CipherBase {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * Array used to define the AES encryption key.
+             */
+            typedef std::uint8_t Keys[keyLength];
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the input device.
+             */
+            explicit SegmentedDecryptor(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit SegmentedDecryptor(QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The encryption keys.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the input device.
+             */
+            explicit SegmentedDecryptor(const Keys& keys, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The encryption keys.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit SegmentedDecryptor(const Keys& keys, QObject* parent = Q_NULLPTR);
+
+            ~SegmentedDecryptor() override;
+
+            /**
+             * Method you can use to determine the required key length in bytes.
+             *
+             * \return Returns the key length, in bytes.
+             */
+            unsigned keyLengthInBytes() const override;
+
+            /**
+             * Method you can use to change the keys.
+             *
+             * \param[in] newKeys The new keys to apply.
+             */
+            void setKeys(const Keys& newKeys);
+
+            /**
+             * Method you can use to have batches of segments decrypted across a thread pool.
+             *
+             * \param[in] newThreadPool The thread pool to use.  A null pointer, the default, decrypts every segment
+             *                          on the calling thread.  This class does not take ownership of the thread pool.
+             */
+            void setThreadPool(QThreadPool* newThreadPool);
+
+            /**
+             * Method you can use to determine the thread pool used for parallel decryption.
+             *
+             * \return Returns the thread pool.  A null pointer is returned if parallel decryption is disabled.
+             */
+            QThreadPool* threadPool() const;
+
+            /**
+             * Method you can use to determine the segment size of the open container.
+             *
+             * \return Returns the segment size, in bytes.  A value of 0 is returned if the device is not open.
+             */
+            unsigned segmentSize() const;
+
+            /**
+             * Method you can call to decrypt a complete container held in memory.  Do not call this method while the
+             * device is open.
+             *
+             * \param[in] inputBuffer The container to be decrypted.
+             *
+             * \return Returns the decrypted data.  An empty array is returned if the container is not valid or fails
+             *         verification.
+             */
+            QByteArray decrypt(const QByteArray& inputBuffer);
+
+            /**
+             * Method you can use to set the source device.
+             *
+             * \param[in] inputDevice The device holding the container.  This class does not take ownership of the
+             *                        input device.
+             */
+            void setInputDevice(QIODevice* inputDevice);
+
+            /**
+             * Method you can use to determine the current source device.
+             *
+             * \return Returns a pointer to the input device.
+             */
+            QIODevice* inputDevice() const;
+
+            /**
+             * Method you can use to open the container for reading.
+             *
+             * \param[in] openMode The open mode.  This method will return false if this value is not
+             *                     QIODevice::ReadOnly.
+             *
+             * \return Returns true on success, returns false on error.
+             */
+            bool open(SegmentedDecryptor::OpenMode openMode) override;
+
+            /**
+             * Method you can use to close the device.
+             */
+            void close() override;
+
+            /**
+             * Method you can use to determine if this is a sequential device.
+             *
+             * \return Returns true if this is a sequential device.  This method always returns false.
+             */
+            bool isSequential() const override;
+
+            /**
+             * Method you can use to determine the size of the decrypted stream.
+             *
+             * \return Returns the decrypted size, in bytes.  A value of 0 is returned if the device is not open.
+             */
+            qint64 size() const override;
+
+            /**
+             * Method you can use to move to a new position in the decrypted stream.
+             *
+             * \param[in] position The new position, in bytes.
+             *
+             * \return Returns true on success.  Returns false if the position is outside of the stream.
+             */
+            bool seek(qint64 position) override;
+
+        protected:
+            /**
+             * Method that is called to read decrypted data.
+             *
+             * \param[in] data    Pointer to the buffer to receive the decrypted data.
+             *
+             * \param[in] maxSize The maximum amount of data to be read.
+             *
+             * \return Returns the actual amount of data read.  A value of -1 is returned if a segment could not be
+             *         read or fails verification.
+             */
+            qint64 readData(char* data, qint64 maxSize) override;
+
+            /**
+             * Method that is called to write data.
+             *
+             * \param[in] data    The data to be written.
+             *
+             * \param[in] maxSize The number of available bytes
+             *
+             * \return Returns the actual number of bytes written.  This method always returns -1.
+             */
+            qint64 writeData(const char* data, qint64 maxSize) override;
+
+        private:
+            /**
+             * Method that reads, decrypts and verifies a batch of segments into the segment cache.
+             *
+             * \param[in] firstSegment The index of the first segment to be loaded.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool loadSegments(unsigned long long firstSegment);
+
+            /**
+             * Method that discards the segment cache.
+             */
+            void clearCache();
+
+            /**
+             * Method that expands the keys, if needed.
+             */
+            void expandKeys();
+
+            /**
+             * Method that determines the number of segments decrypted in each pass.
+             *
+             * \return Returns the number of segments per pass.
+             */
+            unsigned segmentsPerPass() const;
+
+            /**
+             * The initial key values.
+             */
+            Keys initialKeys;
+
+            /**
+             * Flag indicating that the engine holds the current keys.
+             */
+            bool keysExpanded;
+
+            /**
+             * The thread pool used for parallel decryption.
+             */
+            QThreadPool* currentThreadPool;
+
+            /**
+             * Pointer to the input device.
+             */
+            QIODevice* currentInputDevice;
+
+            /**
+             * The segment size of the open container, in bytes.
+             */
+            unsigned currentSegmentSize;
+
+            /**
+             * The length of the decrypted stream, in bytes.
+             */
+            unsigned long long currentDataLength;
+
+            /**
+             * The total number of segments in the open container.
+             */
+            unsigned long long currentNumberSegments;
+
+            /**
+             * The current position in the decrypted stream.
+             */
+            unsigned long long currentPosition;
+
+            /**
+             * The index of the first segment held in the cache.
+             */
+            unsigned long long cachedFirstSegment;
+
+            /**
+             * The number of segments held in the cache.
+             */
+            unsigned long long cachedNumberSegments;
+
+            /**
+             * The decrypted segments held in the cache.
+             */
+            QByteArray cachedData;
+
+            /**
+             * Buffer holding encrypted segments read from the input device.
+             */
+            QByteArray encryptedData;
+
+            /**
+             * Method that provides the segment engine held by this instance.
+             *
+             * \return Returns a pointer to the segment engine.
+             */
+            inline SegmentEngine* engine() {
+                return reinterpret_cast<SegmentEngine*>(engineStorage);
+            }
+
+            /**
+             * The storage reserved for the segment engine, in bytes.
+             */
+            static constexpr unsigned engineStorageSize = 880;
+
+            /**
+             * Storage for the segment engine.  The engine is held in-line, aligned for vector loads, so that no heap
+             * allocation is needed per instance.
+             */
+            alignas(16) std::uint8_t engineStorage[engineStorageSize];
+    };
+}
+
+#endif
@@ -0,0 +1,332 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::SegmentedEncryptor class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_SEGMENTED_ENCRYPTOR_H
+#define CRYPTO_SEGMENTED_ENCRYPTOR_H
+
+#include <QtGlobal>
+#include <QIODevice>
+#include <QByteArray>
+#include <QObject>
+
+#include <cstdint>
+#include <cstddef>
+
+#include "crypto_cipher_base.h"
+
+class QObject;
+class QThreadPool;
+
+namespace Crypto {
+    class SegmentEngine;
+
+    /**
+     * Class that writes a framed container in which the stream is split into fixed size segments.  Each segment is
+     * encrypted and authenticated on its own with AES-256-GCM using an IV derived from a random per-stream nonce and
+     * the segment index.  Because segments do not depend on one another, batches of segments are encrypted in
+     * parallel when a thread pool is supplied and \ref Crypto::SegmentedDecryptor can decrypt and seek to any
+     * segment.  The last segment is marked in its IV so truncated or extended streams are rejected.
+     *
+     * The container is a 48 byte header followed by the segments.  Each segment is up to one segment size of
+     * encrypted data followed by a 16 byte tag.  Streams are limited to 2^32 segments.  Each container is encrypted
+     * with its own key, derived with HKDF from the supplied key and a random salt held in the header, so any number
+     * of containers can safely share one key.
+     */
+    class SegmentedEncryptor:public QIODevice, public CipherBase {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The container header length, in bytes.
+             */
+            static constexpr unsigned headerLength = 48;
+
+            /**
+             * The per-segment authentication tag length, in bytes.
+             */
+            static constexpr unsigned tagLength = 16;
+
+            /**
+             * The default segment size, in bytes.
+             */
+            static constexpr unsigned defaultSegmentSize = 64 * 1024;
+
+            /**
+             * The largest supported segment size, in bytes.
+             */
+            static constexpr unsigned maximumSegmentSize = 16 * 1024 * 1024;
+
+            /**
+             * Array used to define the AES encryption key.
+             */
+            typedef std::uint8_t Keys[keyLength];
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit SegmentedEncryptor(QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit SegmentedEncryptor(QObject* parent = Q_NULLPTR);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The encryption keys.
+             *
+             * \param[in] parent Pointer to the parent object.  This device will also be used as the output device.
+             */
+            explicit SegmentedEncryptor(const Keys& keys, QIODevice* parent);
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys   The encryption keys.
+             *
+             * \param[in] parent Pointer to the parent object.
+             */
+            explicit SegmentedEncryptor(const Keys& keys, QObject* parent = Q_NULLPTR);
+
+            ~SegmentedEncryptor() override;
+
+            /**
+             * Method you can use to determine the required key length in bytes.
+             *
+             * \return Returns the key length, in bytes.
+             */
+            unsigned keyLengthInBytes() const override;
+
+            /**
+             * Method you can use to change the keys.
+             *
+             * \param[in] newKeys The new keys to apply.
+             */
+            void setKeys(const Keys& newKeys);
+
+            /**
+             * Method you can use to set the segment size.  The setting takes effect the next time the encryptor is
+             * opened or the block API is used.
+             *
+             * \param[in] newSegmentSize The new segment size, in bytes.  The value is limited to between 1 and
+             *                           \ref Crypto::SegmentedEncryptor::maximumSegmentSize.
+             */
+            void setSegmentSize(unsigned newSegmentSize);
+
+            /**
+             * Method you can use to determine the segment size.
+             *
+             * \return Returns the segment size, in bytes.
+             */
+            unsigned segmentSize() const;
+
+            /**
+             * Method you can use to have batches of segments encrypted across a thread pool.
+             *
+             * \param[in] newThreadPool The thread pool to use.  A null pointer, the default, encrypts every segment
+             *                          on the calling thread.  This class does not take ownership of the thread pool.
+             */
+            void setThreadPool(QThreadPool* newThreadPool);
+
+            /**
+             * Method you can use to determine the thread pool used for parallel encryption.
+             *
+             * \return Returns the thread pool.  A null pointer is returned if parallel encryption is disabled.
+             */
+            QThreadPool* threadPool() const;
+
+            /**
+             * Method you can call to encrypt a data buffer into a complete container.
+             *
+             * \param[in] inputBuffer The buffer to be encrypted.
+             *
+             * \return Returns the encrypted container.
+             */
+            QByteArray encrypt(const QByteArray& inputBuffer);
+
+            /**
+             * Method you can use to determine the size of the container produced for a given amount of data.
+             *
+             * \param[in] inputLength The number of bytes to be encrypted.
+             *
+             * \return Returns the container size, in bytes, including the header and tags.
+             */
+            unsigned long long encryptedSize(unsigned long long inputLength) const;
+
+            /**
+             * Method you can use to set the destination device.
+             *
+             * \param[in] outputDevice The device to receive the container.  This class does not take ownership of the
+             *                         output device.
+             */
+            void setOutputDevice(QIODevice* outputDevice);
+
+            /**
+             * Method you can use to determine the current destination device.
+             *
+             * \return Returns a pointer to the output device.
+             */
+            QIODevice* outputDevice() const;
+
+            /**
+             * Method you can use to start a new container.  The container header is written immediately.
+             *
+             * \param[in] openMode The open mode.  This method will return false if this value is not a writable mode.
+             *
+             * \return Returns true on success, returns false on error.
+             */
+            bool open(SegmentedEncryptor::OpenMode openMode) override;
+
+            /**
+             * Method you can use to close the device.  Any pending data is written as the last segment.
+             */
+            void close() override;
+
+            /**
+             * Method you can use to determine if this is a sequential device.
+             *
+             * \return Returns true if this is a sequential device.  This method always returns true.
+             */
+            bool isSequential() const override;
+
+        protected:
+            /**
+             * Method that is called to request data from the encryptor.
+             *
+             * \param[in] data    Pointer to the buffer to receive the requested data.
+             *
+             * \param[in] maxSize The maximum amount of data to be read.
+             *
+             * \return Returns the actual amount of data read.  This method always returns a length
+             *         of -1, indicating an error condition.
+             */
+            qint64 readData(char* data, qint64 maxSize) override;
+
+            /**
+             * Method that is called to write data.  Data is buffered until a batch of segments can be encrypted.
+             *
+             * \param[in] data    The data to be encrypted and written out.
+             *
+             * \param[in] maxSize The number of available bytes
+             *
+             * \return Returns the actual number of bytes written.
+             */
+            qint64 writeData(const char* data, qint64 maxSize) override;
+
+        private:
+            /**
+             * Method that expands the keys, if needed, and starts a new container.
+             *
+             * \param[out] header Buffer to receive the container header.
+             */
+            void startContainer(std::uint8_t* header);
+
+            /**
+             * Method that encrypts buffered data and writes the segments to the output device.
+             *
+             * \param[in] final If true, all buffered data is written and the final segment ends the container.  If
+             *                  false, only full segments known not to be the last are written.
+             *
+             * \return Returns true on success.  Returns false on error.
+             */
+            bool encryptPending(bool final);
+
+            /**
+             * Method that determines the number of segments encrypted in each pass.
+             *
+             * \return Returns the number of segments per pass.
+             */
+            unsigned segmentsPerPass() const;
+
+            /**
+             * The initial key values.
+             */
+            Keys initialKeys;
+
+            /**
+             * Flag indicating that the engine holds the current keys.
+             */
+            bool keysExpanded;
+
+            /**
+             * The configured segment size, in bytes.
+             */
+            unsigned currentSegmentSize;
+
+            /**
+             * The thread pool used for parallel encryption.
+             */
+            QThreadPool* currentThreadPool;
+
+            /**
+             * Pointer to the output device.
+             */
+            QIODevice* currentOutputDevice;
+
+            /**
+             * Data waiting to be encrypted.
+             */
+            QByteArray pendingData;
+
+            /**
+             * Buffer holding encrypted segments before they are written.
+             */
+            QByteArray encryptedData;
+
+            /**
+             * The index of the next segment to be written.
+             */
+            unsigned long long nextSegment;
+
+            /**
+             * Method that provides the segment engine held by this instance.
+             *
+             * \return Returns a pointer to the segment engine.
+             */
+            inline SegmentEngine* engine() {
+                return reinterpret_cast<SegmentEngine*>(engineStorage);
+            }
+
+            /**
+             * The storage reserved for the segment engine, in bytes.
+             */
+            static constexpr unsigned engineStorageSize = 880;
+
+            /**
+             * Storage for the segment engine.  The engine is held in-line, aligned for vector loads, so that no heap
+             * allocation is needed per instance.
+             */
+            alignas(16) std::uint8_t engineStorage[engineStorageSize];
+    };
+}
+
+#endif
@@ -0,0 +1,119 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::Sha256 class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_SHA256_H
+#define CRYPTO_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Crypto {
+    /**
+     * Class that calculates a SHA-256 digest.  The class is part of the Qt-free core library and works directly on
+     * pointers and lengths so no intermediate buffers are allocated.
+     */
+    class Sha256 {
+        public:
+            /**
+             * The SHA-256 block size, in bytes.
+             */
+            static constexpr unsigned blockSize = 64;
+
+            /**
+             * The SHA-256 digest size, in bytes.
+             */
+            static constexpr unsigned digestSize = 32;
+
+            Sha256();
+
+            Sha256(const Sha256& other) = default;
+
+            ~Sha256();
+
+            /**
+             * Method you can use to discard any data added so far.
+             */
+            void reset();
+
+            /**
+             * Method you can use to add data to the digest.
+             *
+             * \param[in] data   Pointer to the data to be added.
+             *
+             * \param[in] length The number of bytes to be added.
+             */
+            void addData(const std::uint8_t* data, std::size_t length);
+
+            /**
+             * Method you can use to obtain the digest of the data added so far.  The instance is not modified so more
+             * data can be added afterwards.
+             *
+             * \param[out] digest Pointer to the buffer to receive the digestSize byte digest.
+             */
+            void result(std::uint8_t* digest) const;
+
+            /**
+             * Method you can use to calculate the digest of a buffer in one call.
+             *
+             * \param[in]  data   Pointer to the data to be hashed.
+             *
+             * \param[in]  length The number of bytes to be hashed.
+             *
+             * \param[out] digest Pointer to the buffer to receive the digestSize byte digest.
+             */
+            static void hash(const std::uint8_t* data, std::size_t length, std::uint8_t* digest);
+
+        private:
+            /**
+             * Method that applies the compression function to one block.
+             *
+             * \param[in,out] state The eight word hash state.
+             *
+             * \param[in]     block Pointer to the blockSize byte block.
+             */
+            static void compress(std::uint32_t* state, const std::uint8_t* block);
+
+            /**
+             * The hash state.
+             */
+            std::uint32_t state[8];
+
+            /**
+             * The total number of bytes added.
+             */
+            std::uint64_t totalLength;
+
+            /**
+             * Bytes waiting for a full block.
+             */
+            std::uint8_t pending[blockSize];
+
+            /**
+             * The number of bytes in the pending buffer.
+             */
+            unsigned pendingLength;
+    };
+}
+
+#endif
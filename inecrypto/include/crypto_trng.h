@@ -25,7 +25,8 @@
 #ifndef CRYPTO_TRNG_H
 #define CRYPTO_TRNG_H
 
-#include <QtGlobal>
+#include <cstddef>
+#include <cstdint>
 
 namespace Crypto {
     /**
@@ -33,14 +34,26 @@ namespace Crypto {
      * Function that returns a random 32-bit value meeting the requirements for a cryptographic system.  The function
      * relies on the APIs of the underlying operating system.
      */
-    quint32 random32();
+    std::uint32_t random32();
 
     /**
      *
      * Function that returns a random 64-bit value meeting the requirements for a cryptographic system.  The function
      * relies on the APIs of the underlying operating system.
      */
-    quint64 random64();
+    std::uint64_t random64();
+
+    /**
+     * Function that fills a buffer with random bytes meeting the requirements for a cryptographic system.  The function
+     * relies on the APIs of the underlying operating system.
+     *
+     * \param[out] buffer Pointer to the buffer to be filled.
+     *
+     * \param[in]  length The number of bytes to be written.
+     *
+     * \return Returns true on success, returns false if the operating system could not supply the requested bytes.
+     */
+    bool randomBytes(std::uint8_t* buffer, std::size_t length);
 };
 
 #endif
@@ -33,6 +33,7 @@
 #include <cstdint>
 
 #include <crypto_decryptor.h>
+#include <crypto_xtea_engine.h>
 
 class QObject;
 
@@ -52,6 +53,24 @@ namespace Crypto {
              */
             typedef std::uint8_t Keys[keyLength];
 
+            /**
+             * Supported key schedules.  The encryptor and decryptor must use the same schedule.
+             */
+            enum KeySchedule {
+                /**
+                 * The first key is chained to the plain text of the previous block.  This is the original format.
+                 * Both encryption and decryption are strictly serial.
+                 */
+                PlainTextChaining,
+
+                /**
+                 * The keys depend only on the block index and the first key is chained to the cipher text of the
+                 * previous block.  Encryption is serial but decryption can be split across threads, SIMD lanes and
+                 * arbitrary seek positions.
+                 */
+                CipherTextChaining
+            };
+
             /**
              * Constructor
              *
@@ -100,6 +119,22 @@ namespace Crypto {
              */
             void setKeys(const Keys& newKeys);
 
+            /**
+             * Method you can use to select the key schedule.  The schedule takes effect the next time the engine is
+             * reset.
+             *
+             * \param[in] newKeySchedule The new key schedule.  The default is
+             *                           \ref Crypto::XteaDecryptor::PlainTextChaining.
+             */
+            void setKeySchedule(KeySchedule newKeySchedule);
+
+            /**
+             * Method you can use to determine the current key schedule.
+             *
+             * \return Returns the current key schedule.
+             */
+            KeySchedule keySchedule() const;
+
             /**
              * Method you can use to determine the encryption output chunk size.
              *
@@ -107,12 +142,62 @@ namespace Crypto {
              */
             unsigned outputChunkSize() const override;
 
+            /**
+             * Method you can use to determine if the engine can start decrypting at an arbitrary chunk.  The keys for
+             * any chunk can be calculated directly under \ref Crypto::XteaDecryptor::CipherTextChaining.
+             *
+             * \return Returns true if the cipher text chaining key schedule is selected.
+             */
+            bool supportsRandomAccess() const override;
+
+            /**
+             * Method you can use to determine if the engine can decrypt separate runs of chunks concurrently.  Each
+             * run only depends on its starting chunk index and the encrypted chunk ahead of it under
+             * \ref Crypto::XteaDecryptor::CipherTextChaining.
+             *
+             * \return Returns true if the cipher text chaining key schedule is selected.
+             */
+            bool supportsParallelDecryption() const override;
+
         protected:
             /**
              * Method that is called to reset the encryption engine.
              */
             void resetEngine() override;
 
+            /**
+             * Method that is called to position the engine at a given chunk.
+             *
+             * \param[in] chunkIndex    The zero based index of the next chunk to be decrypted.
+             *
+             * \param[in] previousChunk Pointer to the encrypted chunk ahead of the chunk to be decrypted, or null.
+             *
+             * \return Returns true if the cipher text chaining key schedule is selected.
+             */
+            bool seekEngine(unsigned long long chunkIndex, const std::uint8_t* previousChunk) override;
+
+            /**
+             * Method that decrypts a run of contiguous chunks using a private copy of the engine state.  This method
+             * may be called concurrently from multiple threads.
+             *
+             * \param[in]  chunkIndex    The zero based index of the first chunk in the run.
+             *
+             * \param[in]  previousChunk Pointer to a copy of the encrypted chunk ahead of the run, or null.
+             *
+             * \param[in]  inputData     Pointer to the encrypted data to be processed.
+             *
+             * \param[out] outputData    Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks  The number of chunks to be processed.
+             */
+            void decryptChunkRange(
+                unsigned long long  chunkIndex,
+                const std::uint8_t* previousChunk,
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
+
             /**
              * Method you should overload to perform decryption on a single chunk.  Data will always be supplied in
              * full chunks.
@@ -123,30 +208,55 @@ namespace Crypto {
              */
             void decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) override;
 
-        private:
-            static constexpr std::uint32_t keyRollPolynomial   = 0x100D4E63;
-            static constexpr std::uint32_t numberFeistelRounds = 64;
-            static constexpr std::uint32_t xteaDelta           = 0x9E3779B9UL;
-
             /**
-             * Method that is called to roll the active key value.
+             * Method that decrypts a run of contiguous chunks in one call.  Under
+             * \ref Crypto::XteaDecryptor::CipherTextChaining the chunks are decrypted several at a time across SIMD
+             * lanes.  Otherwise the compile-time bound engine runs the block loop without per chunk dispatch.
              *
-             * \param[in] currentKey The current key value.
+             * \param[in]  inputData    Pointer to the encrypted data to be processed.
              *
-             * \return Returns the new/modified key value.
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
              */
-            static std::uint32_t rollKey(std::uint32_t currentKey);
+            void decryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
 
+        private:
             /**
-             * The initial key values.
+             * The number of chunks handed to the SIMD lanes at once under
+             * \ref Crypto::XteaDecryptor::CipherTextChaining.
              */
-            std::uint32_t initialKeys[keyLength / 4];
+            static constexpr unsigned chainedBatchSize = 64;
 
             /**
-             * The current running keys.  We update the keys after each chunk.
+             * Method that decrypts chunks under \ref Crypto::XteaDecryptor::CipherTextChaining, several at a time
+             * across SIMD lanes.
+             *
+             * \param[in,out] chainedEngine The engine positioned at the first chunk.  The engine is left positioned
+             *                              after the last chunk.
+             *
+             * \param[in]     inputData     Pointer to the encrypted data to be processed.
+             *
+             * \param[out]    outputData    Pointer to the buffer to receive the resulting data.  The input and
+             *                              output pointers may be identical.
+             *
+             * \param[in]     numberChunks  The number of chunks to be processed.
              */
-            std::uint32_t activeKeys[keyLength / 4];
+            static void decryptChained(
+                XteaDecryptEngine&  chainedEngine,
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            );
 
+            /**
+             * The engine that performs the decryption.
+             */
+            XteaDecryptEngine engine;
     };
 }
 
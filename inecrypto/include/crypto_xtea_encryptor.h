@@ -33,6 +33,7 @@
 #include <cstdint>
 
 #include "crypto_encryptor.h"
+#include "crypto_xtea_engine.h"
 
 class QObject;
 
@@ -52,6 +53,24 @@ namespace Crypto {
              */
             typedef std::uint8_t Keys[keyLength];
 
+            /**
+             * Supported key schedules.  The encryptor and decryptor must use the same schedule.
+             */
+            enum KeySchedule {
+                /**
+                 * The first key is chained to the plain text of the previous block.  This is the original format.
+                 * Both encryption and decryption are strictly serial.
+                 */
+                PlainTextChaining,
+
+                /**
+                 * The keys depend only on the block index and the first key is chained to the cipher text of the
+                 * previous block.  Encryption is serial but decryption can be split across threads, SIMD lanes and
+                 * arbitrary seek positions.
+                 */
+                CipherTextChaining
+            };
+
             /**
              * Constructor
              *
@@ -100,6 +119,22 @@ namespace Crypto {
              */
             void setKeys(const Keys& newKeys);
 
+            /**
+             * Method you can use to select the key schedule.  The schedule takes effect the next time the engine is
+             * reset.
+             *
+             * \param[in] newKeySchedule The new key schedule.  The default is
+             *                           \ref Crypto::XteaEncryptor::PlainTextChaining.
+             */
+            void setKeySchedule(KeySchedule newKeySchedule);
+
+            /**
+             * Method you can use to determine the current key schedule.
+             *
+             * \return Returns the current key schedule.
+             */
+            KeySchedule keySchedule() const;
+
             /**
              * Method you can use to determine the encryption input chunk size.
              *
@@ -123,29 +158,27 @@ namespace Crypto {
              */
             void encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) override;
 
-        private:
-            static constexpr std::uint32_t keyRollPolynomial   = 0x100D4E63;
-            static constexpr std::uint32_t numberFeistelRounds = 64;
-            static constexpr std::uint32_t xteaDelta           = 0x9E3779B9UL;
-
             /**
-             * Method that is called to roll the active key value.
+             * Method that encrypts a run of contiguous chunks in one call.  The engine is bound at compile time so
+             * the block loop is not dispatched per chunk.
              *
-             * \param[in] currentKey The current key value.
+             * \param[in]  inputData    Pointer to the unencrypted data to be processed.
              *
-             * \return Returns the new/modified key value.
-             */
-            static std::uint32_t rollKey(std::uint32_t currentKey);
-
-            /**
-             * The initial key values.
+             * \param[out] outputData   Pointer to the buffer to receive the resulting data.
+             *
+             * \param[in]  numberChunks The number of chunks to be processed.
              */
-            std::uint32_t initialKeys[keyLength / 4];
+            void encryptChunks(
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         numberChunks
+            ) override;
 
+        private:
             /**
-             * The current running keys.  We update the keys after each chunk.
+             * The engine that performs the encryption.
              */
-            std::uint32_t activeKeys[keyLength / 4];
+            XteaEncryptEngine engine;
     };
 }
 
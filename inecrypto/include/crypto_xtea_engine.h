@@ -0,0 +1,615 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::XteaEncryptEngine and \ref Crypto::XteaDecryptEngine classes along with the
+* XTEA round function they share.  The round loop is unrolled at compile time so that the running sum and the key
+* index used by every half-round are constants.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_XTEA_ENGINE_H
+#define CRYPTO_XTEA_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <crypto_block_cipher.h>
+
+namespace Crypto {
+    /**
+     * Function that calculates the XTEA mixing function.
+     *
+     * \param[in] v The word to be mixed.
+     *
+     * \return Returns ((v << 4) ^ (v >> 5)) + v.
+     */
+    inline std::uint32_t xteaMix(std::uint32_t v) {
+        return ((v << 4) ^ (v >> 5)) + v;
+    }
+
+    /**
+     * Function that performs one XTEA encryption cycle (two Feistel half-rounds).
+     *
+     * \param[in]     delta The key schedule constant.
+     *
+     * \param[in]     cycle The zero based cycle number.
+     *
+     * \param[in,out] v0    The first word of the block.
+     *
+     * \param[in,out] v1    The second word of the block.
+     *
+     * \param[in]     keys  The four active keys.
+     */
+    template<std::uint32_t delta, unsigned cycle> inline void xteaEncryptCycle(
+            std::uint32_t&       v0,
+            std::uint32_t&       v1,
+            const std::uint32_t* keys
+        ) {
+        constexpr std::uint32_t sumBefore = static_cast<std::uint32_t>(delta * cycle);
+        constexpr std::uint32_t sumAfter  = static_cast<std::uint32_t>(delta * (cycle + 1));
+
+        v0 += xteaMix(v1) ^ (sumBefore + keys[sumBefore & 3]);
+        v1 += xteaMix(v0) ^ (sumAfter + keys[(sumAfter >> 11) & 3]);
+    }
+
+    /**
+     * Function that performs one XTEA decryption cycle (two Feistel half-rounds).
+     *
+     * \param[in]     delta  The key schedule constant.
+     *
+     * \param[in]     cycles The total number of cycles.
+     *
+     * \param[in]     cycle  The zero based cycle number, counting in decryption order.
+     *
+     * \param[in,out] v0     The first word of the block.
+     *
+     * \param[in,out] v1     The second word of the block.
+     *
+     * \param[in]     keys   The four active keys.
+     */
+    template<std::uint32_t delta, unsigned cycles, unsigned cycle> inline void xteaDecryptCycle(
+            std::uint32_t&       v0,
+            std::uint32_t&       v1,
+            const std::uint32_t* keys
+        ) {
+        constexpr std::uint32_t sumBefore = static_cast<std::uint32_t>(delta * (cycles - cycle));
+        constexpr std::uint32_t sumAfter  = static_cast<std::uint32_t>(delta * (cycles - cycle - 1));
+
+        v1 -= xteaMix(v0) ^ (sumBefore + keys[(sumBefore >> 11) & 3]);
+        v0 -= xteaMix(v1) ^ (sumAfter + keys[sumAfter & 3]);
+    }
+
+    /**
+     * Function that expands the encryption cycles in order.
+     *
+     * \param[in,out] v0   The first word of the block.
+     *
+     * \param[in,out] v1   The second word of the block.
+     *
+     * \param[in]     keys The four active keys.
+     */
+    template<std::uint32_t delta, unsigned... cycle> inline void xteaEncryptCycles(
+            std::uint32_t&       v0,
+            std::uint32_t&       v1,
+            const std::uint32_t* keys,
+            std::integer_sequence<unsigned, cycle...>
+        ) {
+        // Braced initializers are evaluated left to right so the cycles run in order.
+        int expansion[] = { 0, (xteaEncryptCycle<delta, cycle>(v0, v1, keys), 0)... };
+        (void) expansion;
+    }
+
+    /**
+     * Function that expands the decryption cycles in order.
+     *
+     * \param[in,out] v0   The first word of the block.
+     *
+     * \param[in,out] v1   The second word of the block.
+     *
+     * \param[in]     keys The four active keys.
+     */
+    template<std::uint32_t delta, unsigned... cycle> inline void xteaDecryptCycles(
+            std::uint32_t&       v0,
+            std::uint32_t&       v1,
+            const std::uint32_t* keys,
+            std::integer_sequence<unsigned, cycle...>
+        ) {
+        int expansion[] = { 0, (xteaDecryptCycle<delta, sizeof...(cycle), cycle>(v0, v1, keys), 0)... };
+        (void) expansion;
+    }
+
+    /**
+     * Function that encrypts a single XTEA block using a fully unrolled round loop.
+     *
+     * \param[in]     cycles The number of cycles.
+     *
+     * \param[in]     delta  The key schedule constant.
+     *
+     * \param[in,out] v0     The first word of the block.
+     *
+     * \param[in,out] v1     The second word of the block.
+     *
+     * \param[in]     keys   The four active keys.
+     */
+    template<unsigned cycles, std::uint32_t delta> inline void xteaEncryptBlock(
+            std::uint32_t&       v0,
+            std::uint32_t&       v1,
+            const std::uint32_t* keys
+        ) {
+        xteaEncryptCycles<delta>(v0, v1, keys, std::make_integer_sequence<unsigned, cycles>());
+    }
+
+    /**
+     * Function that decrypts a single XTEA block using a fully unrolled round loop.
+     *
+     * \param[in]     cycles The number of cycles.
+     *
+     * \param[in]     delta  The key schedule constant.
+     *
+     * \param[in,out] v0     The first word of the block.
+     *
+     * \param[in,out] v1     The second word of the block.
+     *
+     * \param[in]     keys   The four active keys.
+     */
+    template<unsigned cycles, std::uint32_t delta> inline void xteaDecryptBlock(
+            std::uint32_t&       v0,
+            std::uint32_t&       v1,
+            const std::uint32_t* keys
+        ) {
+        xteaDecryptCycles<delta>(v0, v1, keys, std::make_integer_sequence<unsigned, cycles>());
+    }
+
+    /**
+     * Function that rolls a key value between blocks without branching.
+     *
+     * \param[in] polynomial The key roll polynomial.
+     *
+     * \param[in] currentKey The current key value.
+     *
+     * \return Returns the new key value.  The value equals ((currentKey ^ polynomial) << 1) | 1 if the upper bit of
+     *         currentKey is set and currentKey << 1 otherwise.
+     */
+    template<std::uint32_t polynomial> inline std::uint32_t xteaRollKey(std::uint32_t currentKey) {
+        std::uint32_t mask = 0U - (currentKey >> 31);
+        return (currentKey << 1) ^ (mask & ((polynomial << 1) | 1U));
+    }
+
+    /**
+     * Function that multiplies two key values in the ring used by the key roll.  Rolling a key multiplies it by x
+     * modulo x^32 + ((polynomial << 1) | 1) so products in that ring let us jump the roll forward.
+     *
+     * \param[in] polynomial The key roll polynomial.
+     *
+     * \param[in] a          The first value.
+     *
+     * \param[in] b          The second value.
+     *
+     * 
+eturn Returns the product.
+     */
+    template<std::uint32_t polynomial> inline std::uint32_t xteaMultiplyKeys(std::uint32_t a, std::uint32_t b) {
+        std::uint32_t result = 0;
+        for (int bit=31 ; bit>=0 ; --bit) {
+            result = xteaRollKey<polynomial>(result) ^ (a & (0U - ((b >> bit) & 1U)));
+        }
+
+        return result;
+    }
+
+    /**
+     * Function that rolls a key value a given number of times in logarithmic time.
+     *
+     * \param[in] polynomial The key roll polynomial.
+     *
+     * \param[in] currentKey The current key value.
+     *
+     * \param[in] count      The number of times to roll the key.
+     *
+     * 
+eturn Returns the key value after count rolls.
+     */
+    template<std::uint32_t polynomial> inline std::uint32_t xteaAdvanceKey(
+            std::uint32_t      currentKey,
+            unsigned long long count
+        ) {
+        std::uint32_t power = 1;
+        for (int bit=63 ; bit>=0 ; --bit) {
+            power = xteaMultiplyKeys<polynomial>(power, power);
+            if ((count >> bit) & 1U) {
+                power = xteaRollKey<polynomial>(power);
+            }
+        }
+
+        return xteaMultiplyKeys<polynomial>(currentKey, power);
+    }
+
+    /**
+     * Compile-time bound XTEA encryption engine.  The engine produces the same output as
+     * \ref Crypto::XteaEncryptor and is used by that class.  The engine does not depend on Qt.
+     */
+    class XteaEncryptEngine:public BlockEncryptor<XteaEncryptEngine> {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 16;
+
+            /**
+             * The block size, in bytes.
+             */
+            static constexpr unsigned blockSize = 8;
+
+            XteaEncryptEngine() {
+                std::memset(initialKeys, 0, keyLength);
+                std::memset(activeKeys, 0, keyLength);
+
+                chainValue         = 0;
+                cipherTextChaining = false;
+            }
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys The keyLength byte encryption key.
+             */
+            explicit XteaEncryptEngine(const std::uint8_t* keys) {
+                std::memcpy(initialKeys, keys, keyLength);
+                std::memset(activeKeys, 0, keyLength);
+
+                chainValue         = 0;
+                cipherTextChaining = false;
+            }
+
+            XteaEncryptEngine(const XteaEncryptEngine& other) = default;
+
+            ~XteaEncryptEngine() {
+                std::memset(initialKeys, 0, keyLength);
+                std::memset(activeKeys, 0, keyLength);
+                chainValue = 0;
+            }
+
+            /**
+             * Method you can use to set the keys.  The keys take effect on the next reset.
+             *
+             * \param[in] keys The keyLength byte encryption key.
+             */
+            void setKeys(const std::uint8_t* keys) {
+                std::memcpy(initialKeys, keys, keyLength);
+                std::memset(activeKeys, 0, keyLength);
+            }
+
+            /**
+             * Method you can use to select cipher text chaining in place of the original plain text chaining.  See
+             * \ref Crypto::XteaEncryptor::CipherTextChaining.
+             *
+             * \param[in] nowEnabled If true, cipher text chaining is used.  If false, plain text chaining is used.
+             */
+            void setCipherTextChainingEnabled(bool nowEnabled = true) {
+                cipherTextChaining = nowEnabled;
+            }
+
+            /**
+             * Method you can use to determine if cipher text chaining is selected.
+             *
+             * \return Returns true if cipher text chaining is selected.
+             */
+            bool cipherTextChainingEnabled() const {
+                return cipherTextChaining;
+            }
+
+            /**
+             * Method that returns the engine to its initial state.
+             */
+            void reset() {
+                std::memcpy(activeKeys, initialKeys, keyLength);
+                chainValue = 0;
+            }
+
+            /**
+             * Method that encrypts a single block.
+             *
+             * \param[in]  inputData  Pointer to the block to be encrypted.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the encrypted block.
+             */
+            inline void encryptBlock(const std::uint8_t* inputData, std::uint8_t* outputData) {
+                // The algorithm has been shamelessly lifted from:
+                //
+                //   http://en.wikipedia.org/wiki/XTEA
+                //
+                // We've modify the algorithm to roll our keys before each cycle so that the key in each cycle
+                // changes.
+
+                std::uint32_t v0 = (
+                      (inputData[0]      )
+                    | (inputData[1] <<  8)
+                    | (inputData[2] << 16)
+                    | (inputData[3] << 24)
+                );
+
+                std::uint32_t v1 = (
+                      (inputData[4]      )
+                    | (inputData[5] <<  8)
+                    | (inputData[6] << 16)
+                    | (inputData[7] << 24)
+                );
+
+                std::uint32_t input_v0 = v0;
+
+                if (cipherTextChaining) {
+                    std::uint32_t keys[4] = { activeKeys[0] ^ chainValue, activeKeys[1], activeKeys[2], activeKeys[3] };
+                    xteaEncryptBlock<numberFeistelRounds, xteaDelta>(v0, v1, keys);
+                } else {
+                    xteaEncryptBlock<numberFeistelRounds, xteaDelta>(v0, v1, activeKeys);
+                }
+
+                outputData[0] = static_cast<std::uint8_t>(v0      );
+                outputData[1] = static_cast<std::uint8_t>(v0 >>  8);
+                outputData[2] = static_cast<std::uint8_t>(v0 >> 16);
+                outputData[3] = static_cast<std::uint8_t>(v0 >> 24);
+                outputData[4] = static_cast<std::uint8_t>(v1      );
+                outputData[5] = static_cast<std::uint8_t>(v1 >>  8);
+                outputData[6] = static_cast<std::uint8_t>(v1 >> 16);
+                outputData[7] = static_cast<std::uint8_t>(v1 >> 24);
+
+                if (cipherTextChaining) {
+                    chainValue    = v0;
+                    activeKeys[0] = xteaRollKey<keyRollPolynomial>(activeKeys[0]);
+                } else {
+                    activeKeys[0] = xteaRollKey<keyRollPolynomial>(activeKeys[0]) ^ input_v0;
+                }
+
+                activeKeys[1] = xteaRollKey<keyRollPolynomial>(activeKeys[1]);
+                activeKeys[2] = xteaRollKey<keyRollPolynomial>(activeKeys[2]);
+                activeKeys[3] = xteaRollKey<keyRollPolynomial>(activeKeys[3]);
+            }
+
+        private:
+            static constexpr std::uint32_t keyRollPolynomial   = 0x100D4E63;
+            static constexpr std::uint32_t numberFeistelRounds = 64;
+            static constexpr std::uint32_t xteaDelta           = 0x9E3779B9UL;
+
+            /**
+             * The initial key values.
+             */
+            std::uint32_t initialKeys[keyLength / 4];
+
+            /**
+             * The current running keys.  We update the keys after each block.
+             */
+            std::uint32_t activeKeys[keyLength / 4];
+
+            /**
+             * The cipher text word chained into the first key when cipher text chaining is selected.
+             */
+            std::uint32_t chainValue;
+
+            /**
+             * Flag indicating that cipher text chaining is selected.
+             */
+            bool cipherTextChaining;
+    };
+
+    /**
+     * Compile-time bound XTEA decryption engine.  The engine produces the same output as
+     * \ref Crypto::XteaDecryptor and is used by that class.  The engine does not depend on Qt.
+     */
+    class XteaDecryptEngine:public BlockDecryptor<XteaDecryptEngine> {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 16;
+
+            /**
+             * The block size, in bytes.
+             */
+            static constexpr unsigned blockSize = 8;
+
+            XteaDecryptEngine() {
+                std::memset(initialKeys, 0, keyLength);
+                std::memset(activeKeys, 0, keyLength);
+
+                chainValue         = 0;
+                cipherTextChaining = false;
+            }
+
+            /**
+             * Constructor
+             *
+             * \param[in] keys The keyLength byte encryption key.
+             */
+            explicit XteaDecryptEngine(const std::uint8_t* keys) {
+                std::memcpy(initialKeys, keys, keyLength);
+                std::memset(activeKeys, 0, keyLength);
+
+                chainValue         = 0;
+                cipherTextChaining = false;
+            }
+
+            XteaDecryptEngine(const XteaDecryptEngine& other) = default;
+
+            ~XteaDecryptEngine() {
+                std::memset(initialKeys, 0, keyLength);
+                std::memset(activeKeys, 0, keyLength);
+                chainValue = 0;
+            }
+
+            /**
+             * Method you can use to set the keys.  The keys take effect on the next reset.
+             *
+             * \param[in] keys The keyLength byte encryption key.
+             */
+            void setKeys(const std::uint8_t* keys) {
+                std::memcpy(initialKeys, keys, keyLength);
+                std::memset(activeKeys, 0, keyLength);
+            }
+
+            /**
+             * Method you can use to select cipher text chaining in place of the original plain text chaining.  See
+             * \ref Crypto::XteaDecryptor::CipherTextChaining.
+             *
+             * \param[in] nowEnabled If true, cipher text chaining is used.  If false, plain text chaining is used.
+             */
+            void setCipherTextChainingEnabled(bool nowEnabled = true) {
+                cipherTextChaining = nowEnabled;
+            }
+
+            /**
+             * Method you can use to determine if cipher text chaining is selected.
+             *
+             * \return Returns true if cipher text chaining is selected.
+             */
+            bool cipherTextChainingEnabled() const {
+                return cipherTextChaining;
+            }
+
+            /**
+             * Method that returns the engine to its initial state.
+             */
+            void reset() {
+                std::memcpy(activeKeys, initialKeys, keyLength);
+                chainValue = 0;
+            }
+
+            /**
+             * Method that positions the engine at a given block.  Only valid with cipher text chaining.
+             *
+             * \param[in] blockIndex    The zero based index of the next block to be decrypted.
+             *
+             * \param[in] previousBlock Pointer to the encrypted block ahead of the next block, or null if the block
+             *                          index is 0.
+             */
+            void seek(unsigned long long blockIndex, const std::uint8_t* previousBlock) {
+                for (unsigned i=0 ; i<keyLength / 4 ; ++i) {
+                    activeKeys[i] = xteaAdvanceKey<keyRollPolynomial>(initialKeys[i], blockIndex);
+                }
+
+                chainValue = previousBlock != nullptr ? firstWord(previousBlock) : 0;
+            }
+
+            /**
+             * Method that calculates the keys used by each of the next blocks and moves the engine past them.  Only
+             * valid with cipher text chaining, where the keys depend on the encrypted data alone.
+             *
+             * \param[in]  inputData    Pointer to the encrypted blocks.
+             *
+             * \param[out] blockKeys    Pointer to the buffer to receive keyLength bytes per block.  The keys are in
+             *                          the layout used by \ref Crypto::XteaMultiStream.
+             *
+             * \param[in]  numberBlocks The number of blocks.
+             */
+            void deriveBlockKeys(const std::uint8_t* inputData, std::uint8_t* blockKeys, std::size_t numberBlocks) {
+                for (std::size_t block=0 ; block<numberBlocks ; ++block) {
+                    std::uint32_t keys[4] = { activeKeys[0] ^ chainValue, activeKeys[1], activeKeys[2], activeKeys[3] };
+                    std::memcpy(blockKeys + block * keyLength, keys, keyLength);
+
+                    chainValue = firstWord(inputData + block * blockSize);
+                    for (unsigned i=0 ; i<keyLength / 4 ; ++i) {
+                        activeKeys[i] = xteaRollKey<keyRollPolynomial>(activeKeys[i]);
+                    }
+                }
+            }
+
+            /**
+             * Method that decrypts a single block.
+             *
+             * \param[in]  inputData  Pointer to the block to be decrypted.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the decrypted block.
+             */
+            inline void decryptBlock(const std::uint8_t* inputData, std::uint8_t* outputData) {
+                std::uint32_t v0 = firstWord(inputData);
+                std::uint32_t v1 = firstWord(inputData + 4);
+
+                std::uint32_t chainedKey = activeKeys[0];
+                if (cipherTextChaining) {
+                    std::uint32_t keys[4] = { activeKeys[0] ^ chainValue, activeKeys[1], activeKeys[2], activeKeys[3] };
+                    chainValue = v0;
+
+                    xteaDecryptBlock<numberFeistelRounds, xteaDelta>(v0, v1, keys);
+                    chainedKey = xteaRollKey<keyRollPolynomial>(chainedKey);
+                } else {
+                    xteaDecryptBlock<numberFeistelRounds, xteaDelta>(v0, v1, activeKeys);
+                    chainedKey = xteaRollKey<keyRollPolynomial>(chainedKey) ^ v0;
+                }
+
+                outputData[0] = static_cast<std::uint8_t>(v0      );
+                outputData[1] = static_cast<std::uint8_t>(v0 >>  8);
+                outputData[2] = static_cast<std::uint8_t>(v0 >> 16);
+                outputData[3] = static_cast<std::uint8_t>(v0 >> 24);
+                outputData[4] = static_cast<std::uint8_t>(v1      );
+                outputData[5] = static_cast<std::uint8_t>(v1 >>  8);
+                outputData[6] = static_cast<std::uint8_t>(v1 >> 16);
+                outputData[7] = static_cast<std::uint8_t>(v1 >> 24);
+
+                activeKeys[0] = chainedKey;
+                activeKeys[1] = xteaRollKey<keyRollPolynomial>(activeKeys[1]);
+                activeKeys[2] = xteaRollKey<keyRollPolynomial>(activeKeys[2]);
+                activeKeys[3] = xteaRollKey<keyRollPolynomial>(activeKeys[3]);
+            }
+
+        private:
+            static constexpr std::uint32_t keyRollPolynomial   = 0x100D4E63;
+            static constexpr std::uint32_t numberFeistelRounds = 64;
+            static constexpr std::uint32_t xteaDelta           = 0x9E3779B9UL;
+
+            /**
+             * Method that reads a little-endian word.
+             *
+             * \param[in] data Pointer to the word.
+             *
+             * \return Returns the word.
+             */
+            static inline std::uint32_t firstWord(const std::uint8_t* data) {
+                return (
+                      static_cast<std::uint32_t>(data[0])
+                    | (static_cast<std::uint32_t>(data[1]) <<  8)
+                    | (static_cast<std::uint32_t>(data[2]) << 16)
+                    | (static_cast<std::uint32_t>(data[3]) << 24)
+                );
+            }
+
+            /**
+             * The initial key values.
+             */
+            std::uint32_t initialKeys[keyLength / 4];
+
+            /**
+             * The current running keys.  We update the keys after each block.
+             */
+            std::uint32_t activeKeys[keyLength / 4];
+
+            /**
+             * The cipher text word chained into the first key when cipher text chaining is selected.
+             */
+            std::uint32_t chainValue;
+
+            /**
+             * Flag indicating that cipher text chaining is selected.
+             */
+            bool cipherTextChaining;
+    };
+}
+
+#endif
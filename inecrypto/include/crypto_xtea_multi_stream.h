@@ -0,0 +1,198 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::XteaMultiStream class.
+***********************************************************************************************************************/
+
+/* .. sphinx-project inecrypto */
+
+#ifndef CRYPTO_XTEA_MULTI_STREAM_H
+#define CRYPTO_XTEA_MULTI_STREAM_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QList>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Crypto {
+    /** \rst:leading-asterisk
+     *
+     * Class that encrypts or decrypts many independent XTEA streams at once.  Each stream has its own keys and is
+     * processed exactly as ``Crypto::XteaEncryptor::encrypt`` or ``Crypto::XteaDecryptor::decrypt`` would process it,
+     * so the results are bit-identical.  The key roll makes each stream serial so, rather than splitting a stream,
+     * the class runs one stream in each SIMD lane: 8 lanes with AVX2, 4 lanes with SSE2.  The class is intended for
+     * batches of small records such as license or configuration data.
+     *
+     * Typical use of this class is shown in listing :num:`crypto-xtea-multi-stream-example-listing-1` below.
+     *
+     * .. _crypto-xtea-multi-stream-example-listing-1:
+     * .. code-block:: c++
+     *    :caption: Example use of the ``Crypto::XteaMultiStream`` class
+     *
+     *    QList<QByteArray> keys;    // One 16 byte key per record.
+     *    QList<QByteArray> records;
+     *
+     *    . . . .
+     *
+     *    QList<QByteArray> encrypted = Crypto::XteaMultiStream::encrypt(keys, records);
+     *
+     * \endrst
+     */
+    class XteaMultiStream {
+        public:
+            /**
+             * The encryption key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 16;
+
+            /**
+             * The XTEA block size, in bytes.
+             */
+            static constexpr unsigned blockLength = 8;
+
+            /**
+             * The largest number of streams processed side by side.
+             */
+            static constexpr unsigned maximumLanes = 8;
+
+            /**
+             * Structure describing one stream to be processed.
+             */
+            struct Stream {
+                /**
+                 * Pointer to the \ref Crypto::XteaMultiStream::keyLength byte key for this stream.
+                 */
+                const std::uint8_t* keys;
+
+                /**
+                 * Pointer to the input data.
+                 */
+                const std::uint8_t* inputData;
+
+                /**
+                 * The number of input bytes.
+                 */
+                std::size_t inputLength;
+
+                /**
+                 * Pointer to the buffer to receive the output.  Use \ref Crypto::XteaMultiStream::encryptedSize or
+                 * \ref Crypto::XteaMultiStream::decryptedSize to determine the required size.  The output may be the
+                 * same buffer as the input but must not otherwise overlap it.
+                 */
+                std::uint8_t* outputData;
+            };
+
+            /**
+             * Method you can use to encrypt a batch of streams.  Partial final blocks are padded in the same way as
+             * \ref Crypto::Encryptor::encrypt.
+             *
+             * \param[in] streams       Array of streams to be encrypted.
+             *
+             * \param[in] numberStreams The number of streams.
+             */
+            static void encrypt(const Stream* streams, std::size_t numberStreams);
+
+            /**
+             * Method you can use to decrypt a batch of streams.  Any partial final block is ignored, as with
+             * \ref Crypto::Decryptor::decrypt.
+             *
+             * \param[in] streams       Array of streams to be decrypted.
+             *
+             * \param[in] numberStreams The number of streams.
+             */
+            static void decrypt(const Stream* streams, std::size_t numberStreams);
+
+            /**
+             * Method you can use to encrypt a batch of streams that all have the same length.  The streams are
+             * grouped in order, skipping the sort and allocation used by \ref Crypto::XteaMultiStream::encrypt.
+             *
+             * \param[in] streams       Array of streams to be encrypted.  Every stream must occupy the same number of
+             *                          blocks.
+             *
+             * \param[in] numberStreams The number of streams.
+             */
+            static void encryptEqualLength(const Stream* streams, std::size_t numberStreams);
+
+            /**
+             * Method you can use to decrypt a batch of streams that all have the same length.  The streams are
+             * grouped in order, skipping the sort and allocation used by \ref Crypto::XteaMultiStream::decrypt.
+             *
+             * \param[in] streams       Array of streams to be decrypted.  Every stream must occupy the same number of
+             *                          blocks.
+             *
+             * \param[in] numberStreams The number of streams.
+             */
+            static void decryptEqualLength(const Stream* streams, std::size_t numberStreams);
+
+            /**
+             * Convenience method you can use to encrypt a list of records.
+             *
+             * \param[in] keys       The keys for each record.  Each entry must be
+             *                       \ref Crypto::XteaMultiStream::keyLength bytes in length.
+             *
+             * \param[in] plainTexts The records to be encrypted.
+             *
+             * \return Returns the encrypted records.  An empty list is returned if the number of keys does not match
+             *         the number of records or a key has the wrong length.
+             */
+            static QList<QByteArray> encrypt(const QList<QByteArray>& keys, const QList<QByteArray>& plainTexts);
+
+            /**
+             * Convenience method you can use to decrypt a list of records.
+             *
+             * \param[in] keys        The keys for each record.  Each entry must be
+             *                        \ref Crypto::XteaMultiStream::keyLength bytes in length.
+             *
+             * \param[in] cipherTexts The records to be decrypted.
+             *
+             * \return Returns the decrypted records.  An empty list is returned if the number of keys does not match
+             *         the number of records or a key has the wrong length.
+             */
+            static QList<QByteArray> decrypt(const QList<QByteArray>& keys, const QList<QByteArray>& cipherTexts);
+
+            /**
+             * Method you can use to determine the encrypted size of a stream.
+             *
+             * \param[in] inputLength The number of bytes to be encrypted.
+             *
+             * \return Returns the encrypted size, in bytes.
+             */
+            static std::size_t encryptedSize(std::size_t inputLength);
+
+            /**
+             * Method you can use to determine the decrypted size of a stream.
+             *
+             * \param[in] inputLength The number of bytes to be decrypted.
+             *
+             * \return Returns the decrypted size, in bytes.
+             */
+            static std::size_t decryptedSize(std::size_t inputLength);
+
+            /**
+             * Method you can use to determine how many streams this processor will handle side by side.
+             *
+             * \return Returns 8 if AVX2 is available, 4 if SSE2 is available and 1 otherwise.
+             */
+            static unsigned lanes();
+    };
+}
+
+#endif
@@ -40,30 +40,96 @@ win32 {
 INCLUDEPATH += include
 HEADERS = include/crypto_trng.h \
           include/crypto_hmac.h \
+          include/crypto_poly1305.h \
           include/crypto_helpers.h \
           include/crypto_cipher_base.h \
           include/crypto_encryptor.h \
           include/crypto_xtea_encryptor.h \
           include/crypto_aes_cbc_encryptor.h \
+          include/crypto_aes_ctr_encryptor.h \
+          include/crypto_aes_gcm_encryptor.h \
+          include/crypto_chacha20_poly1305_encryptor.h \
           include/crypto_decryptor.h \
           include/crypto_xtea_decryptor.h \
+          include/crypto_xtea_multi_stream.h \
+          include/crypto_block_cipher.h \
+          include/crypto_xtea_engine.h \
           include/crypto_aes_cbc_decryptor.h \
+          include/crypto_aes_ctr_decryptor.h \
+          include/crypto_aes_gcm_decryptor.h \
+          include/crypto_chacha20_poly1305_decryptor.h \
           include/crypto_crc_generator.h \
+          include/crypto_crc.h \
+          include/crypto_sha256.h \
+          include/crypto_hmac_sha256.h \
+          include/crypto_aes.h \
+          include/crypto_const_buffer.h \
+          include/crypto_segmented_encryptor.h \
+          include/crypto_segmented_decryptor.h \
+          include/crypto_decrypted_view.h \
+          include/crypto_encrypted_log.h \
+          include/crypto_compressor.h \
+          include/crypto_decompressor.h \
+          include/crypto_encrypted_channel.h \
+          include/crypto_kdf.h \
+          include/crypto_derived_key_cache.h \
+          source/crypto_cpu_features.h \
+          source/crypto_aes_ctr_engine.h \
+          source/crypto_ghash.h \
+          source/crypto_aes_gcm_engine.h \
+          source/crypto_chacha20_engine.h \
+          source/crypto_poly1305_engine.h \
+          source/crypto_chacha20_poly1305_engine.h \
+          source/crypto_aes_cbc_engine.h \
+          source/crypto_aes_cbc_key_roller.h \
+          source/crypto_pbkdf2_engine.h \
+          source/crypto_buffer_cursor.h \
+          source/crypto_segment_engine.h \
 
 ########################################################################################################################
 # Source files
 #
 
 SOURCES = source/crypto_trng.cpp \
+          source/crypto_sha256.cpp \
+          source/crypto_hmac_sha256.cpp \
+          source/crypto_pbkdf2_engine.cpp \
+          source/crypto_kdf.cpp \
+          source/crypto_aes.cpp \
           source/crypto_hmac.cpp \
           source/crypto_helpers.cpp \
           source/crypto_cipher_base.cpp \
           source/crypto_encryptor.cpp \
           source/crypto_xtea_encryptor.cpp \
           source/crypto_aes_cbc_encryptor.cpp \
+          source/crypto_aes_cbc_key_roller.cpp \
+          source/crypto_cpu_features.cpp \
+          source/crypto_aes_ctr_engine.cpp \
+          source/crypto_aes_ctr_encryptor.cpp \
+          source/crypto_ghash.cpp \
+          source/crypto_aes_gcm_engine.cpp \
+          source/crypto_aes_gcm_encryptor.cpp \
+          source/crypto_chacha20_engine.cpp \
+          source/crypto_poly1305_engine.cpp \
+          source/crypto_poly1305.cpp \
+          source/crypto_chacha20_poly1305_engine.cpp \
+          source/crypto_chacha20_poly1305_encryptor.cpp \
           source/crypto_decryptor.cpp \
           source/crypto_xtea_decryptor.cpp \
+          source/crypto_xtea_multi_stream.cpp \
           source/crypto_aes_cbc_decryptor.cpp \
+          source/crypto_aes_ctr_decryptor.cpp \
+          source/crypto_aes_gcm_decryptor.cpp \
+          source/crypto_chacha20_poly1305_decryptor.cpp \
+          source/crypto_segment_engine.cpp \
+          source/crypto_segmented_encryptor.cpp \
+          source/crypto_segmented_decryptor.cpp \
+          source/crypto_decrypted_view.cpp \
+          source/crypto_encrypted_log.cpp \
+          source/crypto_compressor.cpp \
+          source/crypto_decompressor.cpp \
+          source/crypto_encrypted_channel.cpp \
+          source/crypto_derived_key_cache.cpp \
 
 ########################################################################################################################
 # Add local version of Tiny-AES
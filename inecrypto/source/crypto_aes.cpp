@@ -0,0 +1,91 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the pointer and length based AES-256 functions.
+***********************************************************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+extern "C" {
+    #include <aes.h>
+}
+
+#include "crypto_aes_cbc_engine.h"
+#include "crypto_aes_ctr_engine.h"
+#include "crypto_aes.h"
+
+static_assert(Crypto::aesKeyLength == AES_KEYLEN, "Unexpected AES key length.");
+static_assert(Crypto::aesBlockLength == AES_BLOCKLEN, "Unexpected AES block length.");
+
+namespace Crypto {
+    std::size_t aesCbcEncrypt(
+            const std::uint8_t* keys,
+            const std::uint8_t* iv,
+            const std::uint8_t* inputData,
+            std::size_t         inputLength,
+            std::uint8_t*       outputData,
+            std::size_t         outputCapacity
+        ) {
+        AES_ctx context;
+        AES_init_ctx_iv(&context, keys, iv);
+
+        AesCbcEncryptEngine engine(&context);
+        std::size_t         result = engine.encrypt(inputData, inputLength, outputData, outputCapacity);
+
+        std::memset(&context, 0, sizeof(context));
+        return result;
+    }
+
+
+    std::size_t aesCbcDecrypt(
+            const std::uint8_t* keys,
+            const std::uint8_t* iv,
+            const std::uint8_t* inputData,
+            std::size_t         inputLength,
+            std::uint8_t*       outputData,
+            std::size_t         outputCapacity
+        ) {
+        AES_ctx context;
+        AES_init_ctx_iv(&context, keys, iv);
+
+        AesCbcDecryptEngine engine(&context);
+        std::size_t         result = engine.decrypt(inputData, inputLength, outputData, outputCapacity);
+
+        std::memset(&context, 0, sizeof(context));
+        return result;
+    }
+
+
+    void aesCtrApply(
+            const std::uint8_t* keys,
+            const std::uint8_t* initialCounter,
+            unsigned long long  byteOffset,
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         length
+        ) {
+        AesCtrEngine engine;
+        engine.setKeys(keys);
+        engine.setCounter(initialCounter, byteOffset);
+        engine.apply(inputData, outputData, length);
+        engine.scrub();
+    }
+}
@@ -23,12 +23,15 @@
 #include <QObject>
 #include <QIODevice>
 
+#include <algorithm>
 #include <cstring>
 
 extern "C" {
     #include <aes.h>
 }
 
+#include "crypto_aes_cbc_engine.h"
+#include "crypto_aes_cbc_key_roller.h"
 #include "crypto_decryptor.h"
 #include "crypto_aes_cbc_decryptor.h"
 
@@ -37,7 +40,10 @@ namespace Crypto {
         std::memset(initialKeys, 0, keyLength);
         initializeIV();
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -45,7 +51,10 @@ namespace Crypto {
         std::memset(initialKeys, 0, keyLength);
         initializeIV();
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -53,7 +62,10 @@ namespace Crypto {
         std::memcpy(initialKeys, keys, keyLength);
         initializeIV();
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -61,7 +73,10 @@ namespace Crypto {
         std::memcpy(initialKeys, keys, keyLength);
         initializeIV();
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -75,7 +90,10 @@ namespace Crypto {
         std::memcpy(initialKeys, keys, keyLength);
         std::memcpy(initialIV, iv, ivLength);
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -89,7 +107,10 @@ namespace Crypto {
         std::memcpy(initialKeys, keys, keyLength);
         std::memcpy(initialIV, iv, ivLength);
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -97,10 +118,8 @@ namespace Crypto {
         std::memset(initialKeys, 0, keyLength);
         std::memset(initialIV, 0, ivLength);
 
-        if (context != Q_NULLPTR) {
-            memset(context, 0, sizeof(AES_ctx));
-            delete context;
-        }
+        std::memset(contextStorage, 0, contextStorageSize);
+        std::memset(keyRollerStorage, 0, keyRollerStorageSize);
     }
 
 
@@ -111,6 +130,7 @@ namespace Crypto {
 
     void AesCbcDecryptor::setKeys(const AesCbcDecryptor::Keys& keys) {
         std::memcpy(initialKeys, keys, keyLength);
+        keysExpanded = false;
     }
 
 
@@ -124,18 +144,150 @@ namespace Crypto {
     }
 
 
+    void AesCbcDecryptor::setIVHeaderEnabled(bool nowEnabled) {
+        includeIVHeader = nowEnabled;
+    }
+
+
+    bool AesCbcDecryptor::ivHeaderEnabled() const {
+        return includeIVHeader;
+    }
+
+
+    void AesCbcDecryptor::setRekeyInterval(unsigned long long newRekeyInterval) {
+        rekeyBlocks = (newRekeyInterval + AES_BLOCKLEN - 1) / AES_BLOCKLEN;
+    }
+
+
+    unsigned long long AesCbcDecryptor::rekeyInterval() const {
+        return rekeyBlocks * AES_BLOCKLEN;
+    }
+
+
+    unsigned AesCbcDecryptor::headerSize() const {
+        return includeIVHeader ? ivLength : 0;
+    }
+
+
+    bool AesCbcDecryptor::supportsRandomAccess() const {
+        return true;
+    }
+
+
+    bool AesCbcDecryptor::supportsParallelDecryption() const {
+        // Runs are decrypted from a copy of the context so they can not follow a key rotation.
+        return rekeyBlocks == 0 && activeRekeyBlocks == 0;
+    }
+
+
     void AesCbcDecryptor::resetEngine() {
-        if (context == Q_NULLPTR) {
-            context = new AES_ctx;
+        static_assert(sizeof(AES_ctx) <= contextStorageSize, "Insufficient AES context storage.");
+        static_assert(sizeof(AesCbcKeyRoller) <= keyRollerStorageSize, "Insufficient key roller storage.");
+
+        // Key expansion is far more expensive than loading the IV so we only expand the keys when they change or
+        // when the last stream rotated them.  Note that decryption runs the same expanded keys in reverse so there is
+        // no separate decryption schedule.
+        if (!keysExpanded || (activeRekeyBlocks != 0 && keyRoller()->rotated())) {
+            AES_init_ctx(context(), initialKeys);
+            keysExpanded = true;
+        }
+
+        activeRekeyBlocks = rekeyBlocks;
+        if (activeRekeyBlocks != 0) {
+            keyRoller()->start(initialKeys, activeRekeyBlocks);
         }
 
-        AES_init_ctx_iv(context, initialKeys, initialIV);
+        AES_ctx_set_iv(context(), initialIV);
+    }
+
+
+    void AesCbcDecryptor::finishEngine() {
+        if (activeRekeyBlocks != 0) {
+            // The rotated schedule and the derived keys only apply to the stream just finished.
+            if (keyRoller()->rotated()) {
+                std::memset(contextStorage, 0, contextStorageSize);
+                keysExpanded = false;
+            }
+
+            keyRoller()->scrub();
+        }
+    }
+
+
+    void AesCbcDecryptor::processHeader(const std::uint8_t* headerData) {
+        AES_ctx_set_iv(context(), headerData);
+    }
+
+
+    bool AesCbcDecryptor::seekEngine(unsigned long long chunkIndex, const std::uint8_t* previousChunk) {
+        // Each block is chained to the ciphertext block ahead of it so that block acts as the IV.  The first block
+        // keeps the IV loaded by the reset or the header.
+        if (previousChunk != Q_NULLPTR) {
+            AES_ctx_set_iv(context(), previousChunk);
+        }
+
+        if (activeRekeyBlocks != 0) {
+            keyRoller()->seek(chunkIndex, context());
+        }
+
+        return true;
+    }
+
+
+    void AesCbcDecryptor::decryptChunkRange(
+            unsigned long long  /* chunkIndex */,
+            const std::uint8_t* previousChunk,
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        // Each run works on its own copy of the context so the shared key schedule is only ever read.
+        AES_ctx segmentContext = *context();
+        if (previousChunk != Q_NULLPTR) {
+            AES_ctx_set_iv(&segmentContext, previousChunk);
+        }
+
+        AesCbcDecryptEngine(&segmentContext).decryptBlocks(inputData, outputData, numberChunks);
+        std::memset(&segmentContext, 0, sizeof(AES_ctx));
     }
 
 
     void AesCbcDecryptor::decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
-        std::memcpy(outputData, inputData, AES_BLOCKLEN);
-        AES_CBC_decrypt_buffer(context, outputData, AES_BLOCKLEN);
+        if (activeRekeyBlocks == 0) {
+            AesCbcDecryptEngine(context()).decryptBlock(inputData, outputData);
+        } else {
+            decryptChunks(inputData, outputData, 1);
+        }
+    }
+
+
+    void AesCbcDecryptor::decryptChunks(
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        if (activeRekeyBlocks == 0) {
+            AesCbcDecryptEngine(context()).decryptBlocks(inputData, outputData, numberChunks);
+        } else {
+            // Runs are split where the keys rotate.
+            AesCbcKeyRoller* roller = keyRoller();
+            while (numberChunks > 0) {
+                std::size_t runLength = static_cast<std::size_t>(
+                    std::min(static_cast<unsigned long long>(numberChunks), roller->blocksBeforeStep())
+                );
+
+                if (runLength == 0) {
+                    roller->step(context());
+                } else {
+                    AesCbcDecryptEngine(context()).decryptBlocks(inputData, outputData, runLength);
+                    roller->advance(runLength);
+
+                    inputData    += runLength * AES_BLOCKLEN;
+                    outputData   += runLength * AES_BLOCKLEN;
+                    numberChunks -= runLength;
+                }
+            }
+        }
     }
 
 
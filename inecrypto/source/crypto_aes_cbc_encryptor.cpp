@@ -23,12 +23,15 @@
 #include <QObject>
 #include <QIODevice>
 
+#include <algorithm>
 #include <cstring>
 
 extern "C" {
     #include <aes.h>
 }
 
+#include "crypto_aes_cbc_engine.h"
+#include "crypto_aes_cbc_key_roller.h"
 #include "crypto_encryptor.h"
 #include "crypto_aes_cbc_encryptor.h"
 
@@ -36,7 +39,10 @@ namespace Crypto {
     AesCbcEncryptor::AesCbcEncryptor(QIODevice* parent):Encryptor(parent) {
         std::memset(initialKeys, 0, keyLength);
         initializeIV();
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -44,7 +50,10 @@ namespace Crypto {
         std::memset(initialKeys, 0, keyLength);
         initializeIV();
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -52,7 +61,10 @@ namespace Crypto {
         std::memcpy(initialKeys, keys, keyLength);
         initializeIV();
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -60,7 +72,10 @@ namespace Crypto {
         std::memcpy(initialKeys, keys, keyLength);
         initializeIV();
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -74,7 +89,10 @@ namespace Crypto {
         std::memcpy(initialKeys, keys, keyLength);
         std::memcpy(initialIV, iv, ivLength);
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -88,7 +106,10 @@ namespace Crypto {
         std::memcpy(initialKeys, keys, keyLength);
         std::memcpy(initialIV, iv, ivLength);
 
-        context = Q_NULLPTR;
+        keysExpanded      = false;
+        includeIVHeader   = false;
+        rekeyBlocks       = 0;
+        activeRekeyBlocks = 0;
     }
 
 
@@ -96,10 +117,8 @@ namespace Crypto {
         std::memset(initialKeys, 0, keyLength);
         std::memset(initialIV, 0, ivLength);
 
-        if (context != Q_NULLPTR) {
-            memset(context, 0, sizeof(AES_ctx));
-            delete context;
-        }
+        std::memset(contextStorage, 0, contextStorageSize);
+        std::memset(keyRollerStorage, 0, keyRollerStorageSize);
     }
 
 
@@ -110,6 +129,7 @@ namespace Crypto {
 
     void AesCbcEncryptor::setKeys(const Keys& keys) {
         std::memcpy(initialKeys, keys, keyLength);
+        keysExpanded = false;
     }
 
 
@@ -123,18 +143,113 @@ namespace Crypto {
     }
 
 
+    void AesCbcEncryptor::setIVHeaderEnabled(bool nowEnabled) {
+        includeIVHeader = nowEnabled;
+    }
+
+
+    bool AesCbcEncryptor::ivHeaderEnabled() const {
+        return includeIVHeader;
+    }
+
+
+    void AesCbcEncryptor::setRekeyInterval(unsigned long long newRekeyInterval) {
+        rekeyBlocks = (newRekeyInterval + AES_BLOCKLEN - 1) / AES_BLOCKLEN;
+    }
+
+
+    unsigned long long AesCbcEncryptor::rekeyInterval() const {
+        return rekeyBlocks * AES_BLOCKLEN;
+    }
+
+
+    unsigned AesCbcEncryptor::headerSize() const {
+        return includeIVHeader ? ivLength : 0;
+    }
+
+
     void AesCbcEncryptor::resetEngine() {
-        if (context == Q_NULLPTR) {
-            context = new AES_ctx;
+        static_assert(sizeof(AES_ctx) <= contextStorageSize, "Insufficient AES context storage.");
+        static_assert(sizeof(AesCbcKeyRoller) <= keyRollerStorageSize, "Insufficient key roller storage.");
+
+        // Key expansion is far more expensive than loading the IV so we only expand the keys when they change or
+        // when the last stream rotated them.
+        if (!keysExpanded || (activeRekeyBlocks != 0 && keyRoller()->rotated())) {
+            AES_init_ctx(context(), initialKeys);
+            keysExpanded = true;
+        }
+
+        activeRekeyBlocks = rekeyBlocks;
+        if (activeRekeyBlocks != 0) {
+            keyRoller()->start(initialKeys, activeRekeyBlocks);
         }
 
-        AES_init_ctx_iv(context, initialKeys, initialIV);
+        if (includeIVHeader) {
+            std::uint8_t randomIV[ivLength];
+            generateRandomIV(randomIV, ivLength);
+
+            AES_ctx_set_iv(context(), randomIV);
+            std::memset(randomIV, 0, ivLength);
+        } else {
+            AES_ctx_set_iv(context(), initialIV);
+        }
+    }
+
+
+    void AesCbcEncryptor::finishEngine() {
+        if (activeRekeyBlocks != 0) {
+            // The rotated schedule and the derived keys only apply to the stream just finished.
+            if (keyRoller()->rotated()) {
+                std::memset(contextStorage, 0, contextStorageSize);
+                keysExpanded = false;
+            }
+
+            keyRoller()->scrub();
+        }
+    }
+
+
+    void AesCbcEncryptor::generateHeader(std::uint8_t* headerData) {
+        std::memcpy(headerData, context()->Iv, ivLength);
     }
 
 
     void AesCbcEncryptor::encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
-        std::memcpy(outputData, inputData, AES_BLOCKLEN);
-        AES_CBC_encrypt_buffer(context, outputData, AES_BLOCKLEN);
+        if (activeRekeyBlocks == 0) {
+            AesCbcEncryptEngine(context()).encryptBlock(inputData, outputData);
+        } else {
+            encryptChunks(inputData, outputData, 1);
+        }
+    }
+
+
+    void AesCbcEncryptor::encryptChunks(
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        if (activeRekeyBlocks == 0) {
+            AesCbcEncryptEngine(context()).encryptBlocks(inputData, outputData, numberChunks);
+        } else {
+            // Runs are split where the keys rotate.
+            AesCbcKeyRoller* roller = keyRoller();
+            while (numberChunks > 0) {
+                std::size_t runLength = static_cast<std::size_t>(
+                    std::min(static_cast<unsigned long long>(numberChunks), roller->blocksBeforeStep())
+                );
+
+                if (runLength == 0) {
+                    roller->step(context());
+                } else {
+                    AesCbcEncryptEngine(context()).encryptBlocks(inputData, outputData, runLength);
+                    roller->advance(runLength);
+
+                    inputData    += runLength * AES_BLOCKLEN;
+                    outputData   += runLength * AES_BLOCKLEN;
+                    numberChunks -= runLength;
+                }
+            }
+        }
     }
 
 
@@ -0,0 +1,167 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::AesCbcEncryptEngine and \ref Crypto::AesCbcDecryptEngine classes.  The
+* classes are private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_AES_CBC_ENGINE_H
+#define CRYPTO_AES_CBC_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+extern "C" {
+    #include <aes.h>
+}
+
+#include "crypto_block_cipher.h"
+
+namespace Crypto {
+    /**
+     * Compile-time bound AES-256 CBC encryption engine operating on a context owned by the caller.  The caller
+     * expands the keys and loads the IV so \ref Crypto::AesCbcEncryptEngine::reset does nothing.  Runs of blocks are
+     * handed to tiny-aes in a single call.
+     */
+    class AesCbcEncryptEngine:public BlockEncryptor<AesCbcEncryptEngine> {
+        public:
+            /**
+             * The block size, in bytes.
+             */
+            static constexpr unsigned blockSize = AES_BLOCKLEN;
+
+            /**
+             * Constructor
+             *
+             * \param[in] context The AES context to operate on.
+             */
+            explicit inline AesCbcEncryptEngine(AES_ctx* context):currentContext(context) {}
+
+            /**
+             * Method that returns the engine to its initial state.  The context is managed by the caller.
+             */
+            inline void reset() {}
+
+            /**
+             * Method that encrypts a single block.
+             *
+             * \param[in]  inputData  Pointer to the block to be encrypted.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the encrypted block.
+             */
+            inline void encryptBlock(const std::uint8_t* inputData, std::uint8_t* outputData) {
+                encryptBlocks(inputData, outputData, 1);
+            }
+
+            /**
+             * Method that encrypts a run of blocks.
+             *
+             * \param[in]  inputData    Pointer to the blocks to be encrypted.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the encrypted blocks.
+             *
+             * \param[in]  numberBlocks The number of blocks.
+             */
+            inline void encryptBlocks(
+                    const std::uint8_t* inputData,
+                    std::uint8_t*       outputData,
+                    std::size_t         numberBlocks
+                ) {
+                std::size_t length = numberBlocks * blockSize;
+                if (outputData != inputData) {
+                    std::memcpy(outputData, inputData, length);
+                }
+
+                AES_CBC_encrypt_buffer(currentContext, outputData, static_cast<std::uint32_t>(length));
+            }
+
+        private:
+            /**
+             * The AES context.
+             */
+            AES_ctx* currentContext;
+    };
+
+    /**
+     * Compile-time bound AES-256 CBC decryption engine operating on a context owned by the caller.  The caller
+     * expands the keys and loads the IV so \ref Crypto::AesCbcDecryptEngine::reset does nothing.  Runs of blocks are
+     * handed to tiny-aes in a single call.
+     */
+    class AesCbcDecryptEngine:public BlockDecryptor<AesCbcDecryptEngine> {
+        public:
+            /**
+             * The block size, in bytes.
+             */
+            static constexpr unsigned blockSize = AES_BLOCKLEN;
+
+            /**
+             * Constructor
+             *
+             * \param[in] context The AES context to operate on.
+             */
+            explicit inline AesCbcDecryptEngine(AES_ctx* context):currentContext(context) {}
+
+            /**
+             * Method that returns the engine to its initial state.  The context is managed by the caller.
+             */
+            inline void reset() {}
+
+            /**
+             * Method that decrypts a single block.
+             *
+             * \param[in]  inputData  Pointer to the block to be decrypted.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the decrypted block.
+             */
+            inline void decryptBlock(const std::uint8_t* inputData, std::uint8_t* outputData) {
+                decryptBlocks(inputData, outputData, 1);
+            }
+
+            /**
+             * Method that decrypts a run of blocks.
+             *
+             * \param[in]  inputData    Pointer to the blocks to be decrypted.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the decrypted blocks.
+             *
+             * \param[in]  numberBlocks The number of blocks.
+             */
+            inline void decryptBlocks(
+                    const std::uint8_t* inputData,
+                    std::uint8_t*       outputData,
+                    std::size_t         numberBlocks
+                ) {
+                std::size_t length = numberBlocks * blockSize;
+                if (outputData != inputData) {
+                    std::memcpy(outputData, inputData, length);
+                }
+
+                AES_CBC_decrypt_buffer(currentContext, outputData, static_cast<std::uint32_t>(length));
+            }
+
+        private:
+            /**
+             * The AES context.
+             */
+            AES_ctx* currentContext;
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::AesCbcKeyRoller class.
+***********************************************************************************************************************/
+
+#include <cstring>
+
+extern "C" {
+    #include <aes.h>
+}
+
+#include "crypto_kdf.h"
+#include "crypto_aes_cbc_key_roller.h"
+
+namespace Crypto {
+    /**
+     * The HKDF info string used to derive the keys for each segment.
+     */
+    static const std::uint8_t rekeyInfo[] = {
+        'i', 'n', 'e', 'c', 'r', 'y', 'p', 't', 'o', ' ', 'a', 'e', 's', '-', 'c', 'b', 'c', ' ',
+        'r', 'e', 'k', 'e', 'y'
+    };
+
+    void AesCbcKeyRoller::start(const std::uint8_t* keys, unsigned long long intervalBlocks) {
+        std::memcpy(initialKeys, keys, keyLength);
+
+        interval        = intervalBlocks;
+        remainingBlocks = intervalBlocks;
+        currentSegment  = 0;
+
+        prepareNext();
+    }
+
+
+    void AesCbcKeyRoller::seek(unsigned long long blockIndex, AES_ctx* context) {
+        unsigned long long segment = blockIndex / interval;
+
+        if (segment != currentSegment) {
+            if (segment == 0) {
+                AES_init_ctx(context, initialKeys);
+            } else {
+                std::uint8_t segmentKeys[keyLength];
+                deriveSegmentKeys(initialKeys, segment, segmentKeys);
+
+                AES_init_ctx(context, segmentKeys);
+                std::memset(segmentKeys, 0, keyLength);
+            }
+
+            currentSegment = segment;
+            prepareNext();
+        }
+
+        remainingBlocks = interval - blockIndex % interval;
+    }
+
+
+    void AesCbcKeyRoller::step(AES_ctx* context) {
+        // Only the round keys change.  The IV holds the CBC chaining value which carries across the rotation.
+        std::memcpy(context->RoundKey, nextContext.RoundKey, sizeof(nextContext.RoundKey));
+
+        remainingBlocks = interval;
+        ++currentSegment;
+
+        prepareNext();
+    }
+
+
+    void AesCbcKeyRoller::scrub() {
+        std::memset(initialKeys, 0, keyLength);
+        std::memset(&nextContext, 0, sizeof(nextContext));
+
+        remainingBlocks = 0;
+        currentSegment  = 0;
+    }
+
+
+    void AesCbcKeyRoller::deriveSegmentKeys(
+            const std::uint8_t* keys,
+            unsigned long long  segmentIndex,
+            std::uint8_t*       segmentKeys
+        ) {
+        // The info string is followed by the 64-bit big endian segment index.
+        std::uint8_t info[sizeof(rekeyInfo) + 8];
+        std::memcpy(info, rekeyInfo, sizeof(rekeyInfo));
+        for (unsigned i=0 ; i<8 ; ++i) {
+            info[sizeof(rekeyInfo) + i] = static_cast<std::uint8_t>(segmentIndex >> (56 - 8 * i));
+        }
+
+        Kdf::hkdfExpand(keys, keyLength, info, sizeof(info), segmentKeys, keyLength);
+    }
+
+
+    void AesCbcKeyRoller::prepareNext() {
+        std::uint8_t nextKeys[keyLength];
+        deriveSegmentKeys(initialKeys, currentSegment + 1, nextKeys);
+
+        AES_init_ctx(&nextContext, nextKeys);
+        std::memset(nextKeys, 0, keyLength);
+    }
+}
@@ -0,0 +1,163 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::AesCbcKeyRoller class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_AES_CBC_KEY_ROLLER_H
+#define CRYPTO_AES_CBC_KEY_ROLLER_H
+
+#include <cstdint>
+#include <cstddef>
+
+extern "C" {
+    #include <aes.h>
+}
+
+namespace Crypto {
+    /**
+     * Class that rotates the AES-256 keys of a CBC stream at fixed block intervals.  The keys for each segment after
+     * the first are derived from the initial keys using HKDF-Expand with HMAC-SHA256, with the segment index appended
+     * to the info string.  Any segment's keys can therefore be derived directly, so a seek costs one derivation
+     * regardless of the position.  Both ends of a stream derive the same keys so no key material is sent in the
+     * stream.
+     *
+     * The schedule for the following segment is expanded into a private context as each segment starts.  The
+     * rotation itself only copies the round keys into the caller's context, carrying the CBC chaining value across.
+     */
+    class AesCbcKeyRoller {
+        public:
+            /**
+             * The key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * Method that starts a new stream at the first segment.  The caller's context must already hold the
+             * expanded initial keys.  The schedule for the second segment is prepared.
+             *
+             * \param[in] keys           The keys for the first segment.
+             *
+             * \param[in] intervalBlocks The number of blocks in each segment.  Must be non-zero.
+             */
+            void start(const std::uint8_t* keys, unsigned long long intervalBlocks);
+
+            /**
+             * Method that moves to the segment holding a block.  The keys for the segment are derived from the
+             * initial keys supplied to \ref Crypto::AesCbcKeyRoller::start and expanded into the caller's context.
+             * The context IV is not changed.
+             *
+             * \param[in] blockIndex The zero based index of the block.
+             *
+             * \param[in] context    The caller's context.
+             */
+            void seek(unsigned long long blockIndex, AES_ctx* context);
+
+            /**
+             * Method that determines how many blocks can be processed before
+             * \ref Crypto::AesCbcKeyRoller::step must be called.
+             *
+             * \return Returns the number of blocks.
+             */
+            inline unsigned long long blocksBeforeStep() const {
+                return remainingBlocks;
+            }
+
+            /**
+             * Method that records blocks processed with the current keys.
+             *
+             * \param[in] numberBlocks The number of blocks processed.  Must not exceed the value reported by
+             *                         \ref Crypto::AesCbcKeyRoller::blocksBeforeStep.
+             */
+            inline void advance(unsigned long long numberBlocks) {
+                remainingBlocks -= numberBlocks;
+            }
+
+            /**
+             * Method that rotates the keys by copying the prepared schedule for the next segment into the caller's
+             * context.  The schedule for the segment after it is then prepared.
+             *
+             * \param[in] context The caller's context.
+             */
+            void step(AES_ctx* context);
+
+            /**
+             * Method you can use to determine if the current keys differ from the initial keys.
+             *
+             * \return Returns true if the keys have been rotated.
+             */
+            inline bool rotated() const {
+                return currentSegment != 0;
+            }
+
+            /**
+             * Method that clears all key material.
+             */
+            void scrub();
+
+            /**
+             * Method that derives the keys for a segment other than the first.
+             *
+             * \param[in]  keys         The keys for the first segment.
+             *
+             * \param[in]  segmentIndex The zero based index of the segment.  Must be non-zero.
+             *
+             * \param[out] segmentKeys  Buffer to receive the keys for the segment.
+             */
+            static void deriveSegmentKeys(
+                const std::uint8_t* keys,
+                unsigned long long  segmentIndex,
+                std::uint8_t*       segmentKeys
+            );
+
+        private:
+            /**
+             * Method that expands the keys for the segment following the current segment into
+             * \ref Crypto::AesCbcKeyRoller::nextContext.
+             */
+            void prepareNext();
+
+            /**
+             * The keys for the first segment.
+             */
+            std::uint8_t initialKeys[keyLength];
+
+            /**
+             * The expanded keys for the segment following the current segment.
+             */
+            AES_ctx nextContext;
+
+            /**
+             * The number of blocks in each segment.
+             */
+            unsigned long long interval;
+
+            /**
+             * The number of blocks left in the current segment.
+             */
+            unsigned long long remainingBlocks;
+
+            /**
+             * The zero based index of the current segment.
+             */
+            unsigned long long currentSegment;
+    };
+}
+
+#endif
@@ -0,0 +1,210 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::AesCtrEncryptor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+
+#include <cstring>
+
+#include "crypto_encryptor.h"
+#include "crypto_aes_ctr_encryptor.h"
+#include "crypto_aes_ctr_engine.h"
+
+namespace Crypto {
+    AesCtrEncryptor::AesCtrEncryptor(QIODevice* parent):Encryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+        keysExpanded    = false;
+        includeIVHeader = true;
+        initialOffset   = 0;
+    }
+
+
+    AesCtrEncryptor::AesCtrEncryptor(QObject* parent):Encryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+        initialOffset   = 0;
+    }
+
+
+    AesCtrEncryptor::AesCtrEncryptor(const AesCtrEncryptor::Keys& keys, QIODevice* parent):Encryptor(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+        initialOffset   = 0;
+    }
+
+
+    AesCtrEncryptor::AesCtrEncryptor(const AesCtrEncryptor::Keys& keys, QObject* parent):Encryptor(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+        initialOffset   = 0;
+    }
+
+
+    AesCtrEncryptor::AesCtrEncryptor(
+            const AesCtrEncryptor::Keys& keys,
+            const AesCtrEncryptor::IV&   iv,
+            QIODevice*                   parent
+        ):Encryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        keysExpanded    = false;
+        includeIVHeader = false;
+        initialOffset   = 0;
+    }
+
+
+    AesCtrEncryptor::AesCtrEncryptor(
+            const AesCtrEncryptor::Keys& keys,
+            const AesCtrEncryptor::IV&   iv,
+            QObject*                     parent
+        ):Encryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        keysExpanded    = false;
+        includeIVHeader = false;
+        initialOffset   = 0;
+    }
+
+
+    AesCtrEncryptor::~AesCtrEncryptor() {
+        std::memset(initialKeys, 0, keyLength);
+        std::memset(initialIV, 0, ivLength);
+        std::memset(currentIV, 0, ivLength);
+
+        engine()->scrub();
+    }
+
+
+    unsigned AesCtrEncryptor::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void AesCtrEncryptor::setKeys(const Keys& keys) {
+        std::memcpy(initialKeys, keys, keyLength);
+        keysExpanded = false;
+    }
+
+
+    void AesCtrEncryptor::setIV(const IV& newIV) {
+        std::memcpy(initialIV, newIV, ivLength);
+    }
+
+
+    unsigned AesCtrEncryptor::inputChunkSize() const {
+        return 1;
+    }
+
+
+    void AesCtrEncryptor::setStreamOffset(unsigned long long newOffset) {
+        initialOffset = newOffset;
+    }
+
+
+    unsigned long long AesCtrEncryptor::streamOffset() const {
+        return initialOffset;
+    }
+
+
+    void AesCtrEncryptor::setIVHeaderEnabled(bool nowEnabled) {
+        includeIVHeader = nowEnabled;
+    }
+
+
+    bool AesCtrEncryptor::ivHeaderEnabled() const {
+        return includeIVHeader;
+    }
+
+
+    unsigned AesCtrEncryptor::headerSize() const {
+        return includeIVHeader ? ivLength : 0;
+    }
+
+
+    void AesCtrEncryptor::resetEngine() {
+        static_assert(sizeof(AesCtrEngine) <= engineStorageSize, "Insufficient AES-CTR engine storage.");
+
+        // Key expansion is far more expensive than loading the counter so we only expand the keys when they change.
+        if (!keysExpanded) {
+            engine()->setKeys(initialKeys);
+            keysExpanded = true;
+        }
+
+        if (includeIVHeader) {
+            generateRandomIV(currentIV, ivLength);
+        } else {
+            std::memcpy(currentIV, initialIV, ivLength);
+        }
+
+        engine()->setCounter(currentIV, initialOffset);
+    }
+
+
+    void AesCtrEncryptor::generateHeader(std::uint8_t* headerData) {
+        std::memcpy(headerData, currentIV, ivLength);
+    }
+
+
+    void AesCtrEncryptor::encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
+        engine()->apply(inputData, outputData, 1);
+    }
+
+
+    void AesCtrEncryptor::encryptChunks(
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        engine()->apply(inputData, outputData, numberChunks);
+    }
+
+
+    void AesCtrEncryptor::initializeIV() {
+        // We just want a little entropy in our IV so we use a super-simple PRNG
+        std::uint8_t seeds[4] = { 251, 241, 239, 233 };
+        for (unsigned i=0 ; i<ivLength ; ++i) {
+            std::uint8_t newSeed = seeds[0] + seeds[1] + seeds[2] + seeds[3] + 1;
+            seeds[3] = seeds[2];
+            seeds[2] = seeds[1];
+            seeds[1] = seeds[0];
+            seeds[0] = newSeed;
+
+            initialIV[i] = newSeed;
+        }
+    }
+}
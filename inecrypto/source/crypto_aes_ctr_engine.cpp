@@ -0,0 +1,232 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::AesCtrEngine class.
+***********************************************************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_cpu_features.h"
+
+#if (CRYPTO_X86)
+    #include <emmintrin.h>
+    #include <wmmintrin.h>
+#endif
+
+extern "C" {
+    #include <aes.h>
+}
+
+#include "crypto_aes_ctr_engine.h"
+
+namespace Crypto {
+    /**
+     * The number of AES-256 rounds.
+     */
+    static constexpr unsigned numberAesRounds = 14;
+
+    /**
+     * Function that increments a 128-bit big-endian counter block by one.
+     *
+     * \param[in,out] counter The counter to be incremented.
+     */
+    static inline void incrementCounter(std::uint8_t* counter) {
+        int i = AES_BLOCKLEN - 1;
+        while (i >= 0 && ++counter[i] == 0) {
+            --i;
+        }
+    }
+
+    /**
+     * Function that generates keystream blocks using the portable tiny-aes block cipher.
+     *
+     * \param[in]     context      The AES context holding the expanded keys.
+     *
+     * \param[in,out] counter      The counter block.
+     *
+     * \param[out]    keystream    Buffer to receive the keystream.
+     *
+     * \param[in]     numberBlocks The number of blocks to generate.
+     */
+    static void generateKeystreamPortable(
+            const AES_ctx* context,
+            std::uint8_t*  counter,
+            std::uint8_t*  keystream,
+            std::size_t    numberBlocks
+        ) {
+        for (std::size_t i=0 ; i<numberBlocks ; ++i) {
+            std::memcpy(keystream, counter, AES_BLOCKLEN);
+            AES_ECB_encrypt(context, keystream);
+            incrementCounter(counter);
+
+            keystream += AES_BLOCKLEN;
+        }
+    }
+
+    #if (CRYPTO_X86)
+
+        /**
+         * Function that generates keystream blocks using the AES instructions.  Blocks are encrypted eight at a time
+         * so the latency of each round is hidden behind the other seven blocks.
+         *
+         * \param[in]     roundKeys    The expanded AES-256 round keys in FIPS-197 byte order.
+         *
+         * \param[in,out] counter      The counter block.
+         *
+         * \param[out]    keystream    Buffer to receive the keystream.
+         *
+         * \param[in]     numberBlocks The number of blocks to generate.
+         */
+        CRYPTO_TARGET("aes,sse2") static void generateKeystreamAesNi(
+                const std::uint8_t* roundKeys,
+                std::uint8_t*       counter,
+                std::uint8_t*       keystream,
+                std::size_t         numberBlocks
+            ) {
+            __m128i keys[numberAesRounds + 1];
+            for (unsigned round=0 ; round<=numberAesRounds ; ++round) {
+                keys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys + AES_BLOCKLEN * round));
+            }
+
+            while (numberBlocks >= 8) {
+                __m128i b[8];
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    b[i] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counter)), keys[0]);
+                    incrementCounter(counter);
+                }
+
+                for (unsigned round=1 ; round<numberAesRounds ; ++round) {
+                    for (unsigned i=0 ; i<8 ; ++i) {
+                        b[i] = _mm_aesenc_si128(b[i], keys[round]);
+                    }
+                }
+
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    b[i] = _mm_aesenclast_si128(b[i], keys[numberAesRounds]);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(keystream + AES_BLOCKLEN * i), b[i]);
+                }
+
+                keystream    += 8 * AES_BLOCKLEN;
+                numberBlocks -= 8;
+            }
+
+            while (numberBlocks > 0) {
+                __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counter)), keys[0]);
+                incrementCounter(counter);
+
+                for (unsigned round=1 ; round<numberAesRounds ; ++round) {
+                    b = _mm_aesenc_si128(b, keys[round]);
+                }
+
+                b = _mm_aesenclast_si128(b, keys[numberAesRounds]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(keystream), b);
+
+                keystream += AES_BLOCKLEN;
+                --numberBlocks;
+            }
+
+            std::memset(keys, 0, sizeof(keys));
+        }
+
+    #endif
+
+    void AesCtrEngine::setKeys(const std::uint8_t* keys) {
+        AES_init_ctx(&context, keys);
+    }
+
+
+    void AesCtrEngine::setCounter(const std::uint8_t* initialCounter, unsigned long long byteOffset) {
+        std::memcpy(counter, initialCounter, blockLength);
+        addToCounter(counter, byteOffset / blockLength);
+
+        unsigned blockOffset = static_cast<unsigned>(byteOffset % blockLength);
+        if (blockOffset != 0) {
+            generateKeystream(&context, counter, keystream, keystreamBlocks);
+            keystreamIndex = blockOffset;
+        } else {
+            keystreamIndex = keystreamLength;
+        }
+    }
+
+
+    void AesCtrEngine::apply(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length) {
+        while (length > 0) {
+            if (keystreamIndex == keystreamLength) {
+                generateKeystream(&context, counter, keystream, keystreamBlocks);
+                keystreamIndex = 0;
+            }
+
+            std::size_t         bytesInKeystream = keystreamLength - keystreamIndex;
+            std::size_t         bytesThisPass    = std::min(length, bytesInKeystream);
+            const std::uint8_t* k                = keystream + keystreamIndex;
+
+            for (std::size_t i=0 ; i<bytesThisPass ; ++i) {
+                outputData[i] = inputData[i] ^ k[i];
+            }
+
+            inputData      += bytesThisPass;
+            outputData     += bytesThisPass;
+            length         -= bytesThisPass;
+            keystreamIndex += static_cast<unsigned>(bytesThisPass);
+        }
+    }
+
+
+    void AesCtrEngine::scrub() {
+        std::memset(&context, 0, sizeof(context));
+        std::memset(counter, 0, blockLength);
+        std::memset(keystream, 0, keystreamLength);
+        keystreamIndex = keystreamLength;
+    }
+
+
+    void AesCtrEngine::generateKeystream(
+            const AES_ctx* context,
+            std::uint8_t*  counter,
+            std::uint8_t*  keystream,
+            std::size_t    numberBlocks
+        ) {
+        #if (CRYPTO_X86)
+            if (hardwareAccelerated()) {
+                generateKeystreamAesNi(context->RoundKey, counter, keystream, numberBlocks);
+            } else {
+                generateKeystreamPortable(context, counter, keystream, numberBlocks);
+            }
+        #else
+            generateKeystreamPortable(context, counter, keystream, numberBlocks);
+        #endif
+    }
+
+
+    void AesCtrEngine::addToCounter(std::uint8_t* counter, unsigned long long value) {
+        unsigned carry = 0;
+        for (int i=blockLength-1 ; i>=0 ; --i) {
+            unsigned sum = counter[i] + static_cast<unsigned>(value & 0xFF) + carry;
+            counter[i] = static_cast<std::uint8_t>(sum);
+            carry = sum >> 8;
+            value >>= 8;
+        }
+    }
+
+
+    bool AesCtrEngine::hardwareAccelerated() {
+        return cpuHasAes();
+    }
+}
@@ -0,0 +1,161 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::AesCtrEngine class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_AES_CTR_ENGINE_H
+#define CRYPTO_AES_CTR_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+
+extern "C" {
+    #include <aes.h>
+}
+
+namespace Crypto {
+    /**
+     * Class that generates an AES-256 counter mode keystream and applies it to data.  The keystream is generated
+     * several blocks at a time so that, where the processor supports the AES instructions, the block cipher rounds
+     * can be pipelined.  The counter is treated as a single 128-bit big-endian value, matching tiny-aes.
+     *
+     * The class holds no pointers and requires no construction or destruction so it can be held in-line in raw
+     * storage.  The other engines, the GHASH and Poly1305 authenticators and the AES-CBC key roller follow the same
+     * rule, which lets the Qt classes embed them without a heap allocation per instance.
+     */
+    class AesCtrEngine {
+        public:
+            /**
+             * The AES block length, in bytes.
+             */
+            static constexpr unsigned blockLength = AES_BLOCKLEN;
+
+            /**
+             * The number of keystream blocks generated per pass.
+             */
+            static constexpr unsigned keystreamBlocks = 8;
+
+            /**
+             * The keystream buffer length, in bytes.
+             */
+            static constexpr unsigned keystreamLength = keystreamBlocks * blockLength;
+
+            /**
+             * Method you can use to expand a new set of AES-256 keys.
+             *
+             * \param[in] keys The 32 byte AES key.
+             */
+            void setKeys(const std::uint8_t* keys);
+
+            /**
+             * Method you can use to position the keystream.
+             *
+             * \param[in] initialCounter The 16 byte counter block used for the first byte of the stream.
+             *
+             * \param[in] byteOffset     The byte offset into the stream to position the keystream at.
+             */
+            void setCounter(const std::uint8_t* initialCounter, unsigned long long byteOffset = 0);
+
+            /**
+             * Method you can use to apply the keystream to a buffer.  Encryption and decryption are identical.
+             *
+             * \param[in]  inputData  Pointer to the data to be processed.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the processed data.  The input and output
+             *                        pointers may be identical.
+             *
+             * \param[in]  length     The number of bytes to be processed.
+             */
+            void apply(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length);
+
+            /**
+             * Method you can use to scrub the engine state.
+             */
+            void scrub();
+
+            /**
+             * Method you can use to obtain the AES context holding the expanded keys.
+             *
+             * \return Returns a pointer to the AES context.
+             */
+            inline const AES_ctx* aesContext() const {
+                return &context;
+            }
+
+            /**
+             * Method that generates consecutive keystream blocks, advancing the counter.
+             *
+             * \param[in]     context      The AES context holding the expanded keys.
+             *
+             * \param[in,out] counter      The 16 byte counter block.  The counter is advanced by the number of
+             *                             blocks generated.
+             *
+             * \param[out]    keystream    Buffer to receive the keystream.
+             *
+             * \param[in]     numberBlocks The number of blocks to generate.
+             */
+            static void generateKeystream(
+                const AES_ctx* context,
+                std::uint8_t*  counter,
+                std::uint8_t*  keystream,
+                std::size_t    numberBlocks
+            );
+
+            /**
+             * Method that adds a value to a 128-bit big-endian counter block.
+             *
+             * \param[in,out] counter The 16 byte counter block.
+             *
+             * \param[in]     value   The value to add to the counter.
+             */
+            static void addToCounter(std::uint8_t* counter, unsigned long long value);
+
+            /**
+             * Method you can use to determine if the processor AES instructions are used.
+             *
+             * \return Returns true if the AES instructions are used.  Returns false if the portable implementation
+             *         is used.
+             */
+            static bool hardwareAccelerated();
+
+        private:
+            /**
+             * The AES context holding the expanded keys.
+             */
+            AES_ctx context;
+
+            /**
+             * The counter block for the next keystream block to be generated.
+             */
+            alignas(16) std::uint8_t counter[blockLength];
+
+            /**
+             * Buffered keystream.
+             */
+            alignas(16) std::uint8_t keystream[keystreamLength];
+
+            /**
+             * Index of the next unused byte in the keystream buffer.
+             */
+            unsigned keystreamIndex;
+    };
+}
+
+#endif
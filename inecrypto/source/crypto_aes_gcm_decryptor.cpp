@@ -0,0 +1,218 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::AesGcmDecryptor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+
+#include <cstring>
+
+#include "crypto_decryptor.h"
+#include "crypto_aes_gcm_decryptor.h"
+#include "crypto_aes_gcm_engine.h"
+
+namespace Crypto {
+    AesGcmDecryptor::AesGcmDecryptor(QIODevice* parent):Decryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+    }
+
+
+    AesGcmDecryptor::AesGcmDecryptor(QObject* parent):Decryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+    }
+
+
+    AesGcmDecryptor::AesGcmDecryptor(const AesGcmDecryptor::Keys& keys, QIODevice* parent):Decryptor(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+    }
+
+
+    AesGcmDecryptor::AesGcmDecryptor(const AesGcmDecryptor::Keys& keys, QObject* parent):Decryptor(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+    }
+
+
+    AesGcmDecryptor::AesGcmDecryptor(
+            const AesGcmDecryptor::Keys& keys,
+            const AesGcmDecryptor::IV&   iv,
+            QIODevice*                   parent
+        ):Decryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        keysExpanded    = false;
+        includeIVHeader = false;
+    }
+
+
+    AesGcmDecryptor::AesGcmDecryptor(
+            const AesGcmDecryptor::Keys& keys,
+            const AesGcmDecryptor::IV&   iv,
+            QObject*                     parent
+        ):Decryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        keysExpanded    = false;
+        includeIVHeader = false;
+    }
+
+
+    AesGcmDecryptor::~AesGcmDecryptor() {
+        std::memset(initialKeys, 0, keyLength);
+        std::memset(initialIV, 0, ivLength);
+
+        engine()->scrub();
+    }
+
+
+    unsigned AesGcmDecryptor::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void AesGcmDecryptor::setKeys(const AesGcmDecryptor::Keys& keys) {
+        std::memcpy(initialKeys, keys, keyLength);
+        keysExpanded = false;
+    }
+
+
+    void AesGcmDecryptor::setIV(const AesGcmDecryptor::IV& newIV) {
+        std::memcpy(initialIV, newIV, ivLength);
+    }
+
+
+    unsigned AesGcmDecryptor::outputChunkSize() const {
+        return 1;
+    }
+
+
+    void AesGcmDecryptor::setAssociatedData(const QByteArray& newAssociatedData) {
+        currentAssociatedData = newAssociatedData;
+    }
+
+
+    QByteArray AesGcmDecryptor::associatedData() const {
+        return currentAssociatedData;
+    }
+
+
+    void AesGcmDecryptor::setIVHeaderEnabled(bool nowEnabled) {
+        includeIVHeader = nowEnabled;
+    }
+
+
+    bool AesGcmDecryptor::ivHeaderEnabled() const {
+        return includeIVHeader;
+    }
+
+
+    unsigned AesGcmDecryptor::headerSize() const {
+        return includeIVHeader ? ivLength : 0;
+    }
+
+
+    unsigned AesGcmDecryptor::trailerSize() const {
+        return tagLength;
+    }
+
+
+    void AesGcmDecryptor::resetEngine() {
+        static_assert(sizeof(AesGcmEngine) <= engineStorageSize, "Insufficient AES-GCM engine storage.");
+
+        // Key expansion and building the GHASH tables are far more expensive than loading the counter so we only
+        // expand the keys when they change.  Counter mode only ever runs the cipher forward so there is no separate
+        // decryption schedule.
+        if (!keysExpanded) {
+            engine()->setKeys(initialKeys);
+            keysExpanded = true;
+        }
+
+        engine()->start(
+            initialIV,
+            reinterpret_cast<const std::uint8_t*>(currentAssociatedData.constData()),
+            static_cast<std::size_t>(currentAssociatedData.size())
+        );
+    }
+
+
+    void AesGcmDecryptor::processHeader(const std::uint8_t* headerData) {
+        engine()->start(
+            headerData,
+            reinterpret_cast<const std::uint8_t*>(currentAssociatedData.constData()),
+            static_cast<std::size_t>(currentAssociatedData.size())
+        );
+    }
+
+
+    bool AesGcmDecryptor::processTrailer(const std::uint8_t* trailerData) {
+        return engine()->verify(trailerData);
+    }
+
+
+    void AesGcmDecryptor::decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
+        engine()->decrypt(inputData, outputData, 1);
+    }
+
+
+    void AesGcmDecryptor::decryptChunks(
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        engine()->decrypt(inputData, outputData, numberChunks);
+    }
+
+
+    void AesGcmDecryptor::initializeIV() {
+        // We just want a little entropy in our IV so we use a super-simple PRNG
+        std::uint8_t seeds[4] = { 251, 241, 239, 233 };
+        for (unsigned i=0 ; i<ivLength ; ++i) {
+            std::uint8_t newSeed = seeds[0] + seeds[1] + seeds[2] + seeds[3] + 1;
+            seeds[3] = seeds[2];
+            seeds[2] = seeds[1];
+            seeds[1] = seeds[0];
+            seeds[0] = newSeed;
+
+            initialIV[i] = newSeed;
+        }
+    }
+}
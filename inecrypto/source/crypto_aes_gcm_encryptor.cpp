@@ -0,0 +1,233 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::AesGcmEncryptor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+
+#include <cstring>
+
+#include "crypto_encryptor.h"
+#include "crypto_aes_gcm_encryptor.h"
+#include "crypto_aes_gcm_engine.h"
+
+namespace Crypto {
+    AesGcmEncryptor::AesGcmEncryptor(QIODevice* parent):Encryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+        keysExpanded    = false;
+        includeIVHeader = true;
+        ivUsed          = false;
+    }
+
+
+    AesGcmEncryptor::AesGcmEncryptor(QObject* parent):Encryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+        ivUsed          = false;
+    }
+
+
+    AesGcmEncryptor::AesGcmEncryptor(const AesGcmEncryptor::Keys& keys, QIODevice* parent):Encryptor(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+        ivUsed          = false;
+    }
+
+
+    AesGcmEncryptor::AesGcmEncryptor(const AesGcmEncryptor::Keys& keys, QObject* parent):Encryptor(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        keysExpanded    = false;
+        includeIVHeader = true;
+        ivUsed          = false;
+    }
+
+
+    AesGcmEncryptor::AesGcmEncryptor(
+            const AesGcmEncryptor::Keys& keys,
+            const AesGcmEncryptor::IV&   iv,
+            QIODevice*                   parent
+        ):Encryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        keysExpanded    = false;
+        includeIVHeader = false;
+        ivUsed          = false;
+    }
+
+
+    AesGcmEncryptor::AesGcmEncryptor(
+            const AesGcmEncryptor::Keys& keys,
+            const AesGcmEncryptor::IV&   iv,
+            QObject*                     parent
+        ):Encryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        keysExpanded    = false;
+        includeIVHeader = false;
+        ivUsed          = false;
+    }
+
+
+    AesGcmEncryptor::~AesGcmEncryptor() {
+        std::memset(initialKeys, 0, keyLength);
+        std::memset(initialIV, 0, ivLength);
+        std::memset(currentIV, 0, ivLength);
+
+        engine()->scrub();
+    }
+
+
+    unsigned AesGcmEncryptor::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void AesGcmEncryptor::setKeys(const Keys& keys) {
+        std::memcpy(initialKeys, keys, keyLength);
+        keysExpanded = false;
+        ivUsed       = false;
+    }
+
+
+    void AesGcmEncryptor::setIV(const IV& newIV) {
+        std::memcpy(initialIV, newIV, ivLength);
+        ivUsed = false;
+    }
+
+
+    unsigned AesGcmEncryptor::inputChunkSize() const {
+        return 1;
+    }
+
+
+    void AesGcmEncryptor::setAssociatedData(const QByteArray& newAssociatedData) {
+        currentAssociatedData = newAssociatedData;
+    }
+
+
+    QByteArray AesGcmEncryptor::associatedData() const {
+        return currentAssociatedData;
+    }
+
+
+    void AesGcmEncryptor::setIVHeaderEnabled(bool nowEnabled) {
+        includeIVHeader = nowEnabled;
+    }
+
+
+    bool AesGcmEncryptor::ivHeaderEnabled() const {
+        return includeIVHeader;
+    }
+
+
+    unsigned AesGcmEncryptor::headerSize() const {
+        return includeIVHeader ? ivLength : 0;
+    }
+
+
+    unsigned AesGcmEncryptor::trailerSize() const {
+        return tagLength;
+    }
+
+
+    void AesGcmEncryptor::resetEngine() {
+        static_assert(sizeof(AesGcmEngine) <= engineStorageSize, "Insufficient AES-GCM engine storage.");
+
+        // Key expansion and building the GHASH tables are far more expensive than loading the counter so we only
+        // expand the keys when they change.
+        if (!keysExpanded) {
+            engine()->setKeys(initialKeys);
+            keysExpanded = true;
+        }
+
+        if (includeIVHeader) {
+            generateRandomIV(currentIV, ivLength);
+        } else {
+            std::memcpy(currentIV, initialIV, ivLength);
+            ivUsed = true;
+        }
+
+        engine()->start(
+            currentIV,
+            reinterpret_cast<const std::uint8_t*>(currentAssociatedData.constData()),
+            static_cast<std::size_t>(currentAssociatedData.size())
+        );
+    }
+
+
+    bool AesGcmEncryptor::streamAllowed() const {
+        return includeIVHeader || !ivUsed;
+    }
+
+
+    void AesGcmEncryptor::generateHeader(std::uint8_t* headerData) {
+        std::memcpy(headerData, currentIV, ivLength);
+    }
+
+
+    void AesGcmEncryptor::generateTrailer(std::uint8_t* trailerData) {
+        engine()->finish(trailerData);
+    }
+
+
+    void AesGcmEncryptor::encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
+        engine()->encrypt(inputData, outputData, 1);
+    }
+
+
+    void AesGcmEncryptor::encryptChunks(
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        engine()->encrypt(inputData, outputData, numberChunks);
+    }
+
+
+    void AesGcmEncryptor::initializeIV() {
+        // We just want a little entropy in our IV so we use a super-simple PRNG
+        std::uint8_t seeds[4] = { 251, 241, 239, 233 };
+        for (unsigned i=0 ; i<ivLength ; ++i) {
+            std::uint8_t newSeed = seeds[0] + seeds[1] + seeds[2] + seeds[3] + 1;
+            seeds[3] = seeds[2];
+            seeds[2] = seeds[1];
+            seeds[1] = seeds[0];
+            seeds[0] = newSeed;
+
+            initialIV[i] = newSeed;
+        }
+    }
+}
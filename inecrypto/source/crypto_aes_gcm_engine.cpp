@@ -0,0 +1,138 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::AesGcmEngine class.
+***********************************************************************************************************************/
+
+#include <cstring>
+
+extern "C" {
+    #include <aes.h>
+}
+
+#include "crypto_aes_ctr_engine.h"
+#include "crypto_ghash.h"
+#include "crypto_aes_gcm_engine.h"
+
+namespace Crypto {
+    void AesGcmEngine::setKeys(const std::uint8_t* keys) {
+        ctr.setKeys(keys);
+
+        std::uint8_t hashKey[Ghash::blockLength] = { 0 };
+        AES_ECB_encrypt(ctr.aesContext(), hashKey);
+
+        ghash.setKey(hashKey);
+        std::memset(hashKey, 0, sizeof(hashKey));
+    }
+
+
+    void AesGcmEngine::start(
+            const std::uint8_t* iv,
+            const std::uint8_t* associatedData,
+            std::size_t         associatedDataSize
+        ) {
+        // With a 96-bit IV, the initial counter block is the IV followed by a 32-bit block count of 1.  The tag is
+        // masked with the encryption of that block and the data is encrypted starting with the block after it.
+        std::uint8_t initialCounter[AesCtrEngine::blockLength];
+        std::memcpy(initialCounter, iv, ivLength);
+        initialCounter[12] = 0;
+        initialCounter[13] = 0;
+        initialCounter[14] = 0;
+        initialCounter[15] = 1;
+
+        std::uint8_t counter[AesCtrEngine::blockLength];
+        std::memcpy(counter, initialCounter, AesCtrEngine::blockLength);
+        AesCtrEngine::generateKeystream(ctr.aesContext(), counter, tagMask, 1);
+
+        ctr.setCounter(initialCounter, AesCtrEngine::blockLength);
+
+        ghash.reset();
+        if (associatedDataSize > 0) {
+            ghash.update(associatedData, associatedDataSize);
+            ghash.padBlock();
+        }
+
+        associatedDataLength = associatedDataSize;
+        textLength           = 0;
+    }
+
+
+    void AesGcmEngine::encrypt(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length) {
+        ctr.apply(inputData, outputData, length);
+        ghash.update(outputData, length);
+
+        textLength += length;
+    }
+
+
+    void AesGcmEngine::decrypt(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length) {
+        // Hash first as the input is overwritten when decrypting in place.
+        ghash.update(inputData, length);
+        ctr.apply(inputData, outputData, length);
+
+        textLength += length;
+    }
+
+
+    void AesGcmEngine::finish(std::uint8_t* tag) {
+        std::uint8_t lengths[Ghash::blockLength];
+        unsigned long long associatedDataBits = associatedDataLength * 8;
+        unsigned long long textBits           = textLength * 8;
+
+        for (int i=7 ; i>=0 ; --i) {
+            lengths[i]     = static_cast<std::uint8_t>(associatedDataBits);
+            lengths[i + 8] = static_cast<std::uint8_t>(textBits);
+
+            associatedDataBits >>= 8;
+            textBits           >>= 8;
+        }
+
+        ghash.padBlock();
+        ghash.update(lengths, Ghash::blockLength);
+        ghash.digest(tag);
+
+        for (unsigned i=0 ; i<tagLength ; ++i) {
+            tag[i] ^= tagMask[i];
+        }
+    }
+
+
+    bool AesGcmEngine::verify(const std::uint8_t* tag) {
+        std::uint8_t expected[tagLength];
+        finish(expected);
+
+        std::uint8_t difference = 0;
+        for (unsigned i=0 ; i<tagLength ; ++i) {
+            difference |= expected[i] ^ tag[i];
+        }
+
+        std::memset(expected, 0, tagLength);
+        return difference == 0;
+    }
+
+
+    void AesGcmEngine::scrub() {
+        ctr.scrub();
+        ghash.scrub();
+        std::memset(tagMask, 0, tagLength);
+
+        associatedDataLength = 0;
+        textLength           = 0;
+    }
+}
@@ -0,0 +1,142 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::AesGcmEngine class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_AES_GCM_ENGINE_H
+#define CRYPTO_AES_GCM_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "crypto_aes_ctr_engine.h"
+#include "crypto_ghash.h"
+
+namespace Crypto {
+    /**
+     * Class that implements AES-256 in Galois/Counter mode (GCM) as described in NIST SP 800-38D.  The class
+     * combines the counter mode engine with GHASH so data is encrypted and authenticated in a single pass.  Only
+     * 96-bit IVs are supported.
+     */
+    class AesGcmEngine {
+        public:
+            /**
+             * The IV length, in bytes.
+             */
+            static constexpr unsigned ivLength = 12;
+
+            /**
+             * The authentication tag length, in bytes.
+             */
+            static constexpr unsigned tagLength = 16;
+
+            /**
+             * Method you can use to expand a new set of AES-256 keys.
+             *
+             * \param[in] keys The 32 byte AES key.
+             */
+            void setKeys(const std::uint8_t* keys);
+
+            /**
+             * Method you can use to start a new message.
+             *
+             * \param[in] iv                 The 12 byte IV.
+             *
+             * \param[in] associatedData     Pointer to data that is authenticated but not encrypted.
+             *
+             * \param[in] associatedDataSize The length of the associated data, in bytes.
+             */
+            void start(const std::uint8_t* iv, const std::uint8_t* associatedData, std::size_t associatedDataSize);
+
+            /**
+             * Method you can use to encrypt part of the message.
+             *
+             * \param[in]  inputData  Pointer to the data to be encrypted.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the encrypted data.  The input and output
+             *                        pointers may be identical.
+             *
+             * \param[in]  length     The number of bytes to be encrypted.
+             */
+            void encrypt(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length);
+
+            /**
+             * Method you can use to decrypt part of the message.
+             *
+             * \param[in]  inputData  Pointer to the data to be decrypted.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the decrypted data.  The input and output
+             *                        pointers may be identical.
+             *
+             * \param[in]  length     The number of bytes to be decrypted.
+             */
+            void decrypt(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length);
+
+            /**
+             * Method you can use to calculate the authentication tag once the entire message has been processed.
+             *
+             * \param[out] tag Buffer to receive the 16 byte tag.
+             */
+            void finish(std::uint8_t* tag);
+
+            /**
+             * Method you can use to check a received authentication tag once the entire message has been processed.
+             * The comparison takes the same time regardless of where the tags differ.
+             *
+             * \param[in] tag The received 16 byte tag.
+             *
+             * \return Returns true if the tag is valid.  Returns false if the tag is invalid.
+             */
+            bool verify(const std::uint8_t* tag);
+
+            /**
+             * Method you can use to scrub the engine state.
+             */
+            void scrub();
+
+        private:
+            /**
+             * The counter mode engine.
+             */
+            AesCtrEngine ctr;
+
+            /**
+             * The GHASH engine.
+             */
+            Ghash ghash;
+
+            /**
+             * The encrypted initial counter block, used to mask the tag.
+             */
+            std::uint8_t tagMask[tagLength];
+
+            /**
+             * The length of the associated data, in bytes.
+             */
+            unsigned long long associatedDataLength;
+
+            /**
+             * The length of the processed text, in bytes.
+             */
+            unsigned long long textLength;
+    };
+}
+
+#endif
@@ -0,0 +1,149 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::BufferCursor class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_BUFFER_CURSOR_H
+#define CRYPTO_BUFFER_CURSOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "crypto_const_buffer.h"
+
+namespace Crypto {
+    /**
+     * Class that walks a list of buffers as one logical stream.  Data that lies within a single buffer can be used
+     * in place while data that straddles two or more buffers can be gathered into a small scratch buffer.
+     */
+    class BufferCursor {
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in] buffers       Pointer to the first buffer.
+             *
+             * \param[in] numberBuffers The number of buffers.
+             */
+            inline BufferCursor(const ConstBuffer* buffers, std::size_t numberBuffers) {
+                currentBuffer = buffers;
+                endBuffer     = buffers + numberBuffers;
+                currentOffset = 0;
+
+                skipEmptyBuffers();
+            }
+
+            /**
+             * Method you can use to obtain a pointer to the data at the cursor.
+             *
+             * \return Returns a pointer to the next unread byte.  The value is undefined once all of the data has
+             *         been read.
+             */
+            inline const std::uint8_t* position() const {
+                return currentBuffer->data + currentOffset;
+            }
+
+            /**
+             * Method you can use to determine how many bytes can be read in place from the current buffer.
+             *
+             * \return Returns the number of bytes remaining in the current buffer.
+             */
+            inline std::size_t contiguousLength() const {
+                return currentBuffer != endBuffer ? currentBuffer->length - currentOffset : 0;
+            }
+
+            /**
+             * Method you can use to move the cursor forward.
+             *
+             * \param[in] length The number of bytes to skip.  The cursor stops at the end of the data.
+             */
+            inline void advance(std::size_t length) {
+                while (length > 0 && currentBuffer != endBuffer) {
+                    std::size_t bytesThisBuffer = currentBuffer->length - currentOffset;
+                    if (length < bytesThisBuffer) {
+                        currentOffset += length;
+                        length         = 0;
+                    } else {
+                        length -= bytesThisBuffer;
+                        ++currentBuffer;
+                        currentOffset = 0;
+                    }
+                }
+
+                skipEmptyBuffers();
+            }
+
+            /**
+             * Method you can use to copy data from the cursor, crossing buffer boundaries as needed, and move the
+             * cursor past it.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the data.
+             *
+             * \param[in]  length     The number of bytes to copy.
+             *
+             * \return Returns the number of bytes copied.  The value will be less than the requested length only if
+             *         the end of the data was reached.
+             */
+            inline std::size_t gather(std::uint8_t* outputData, std::size_t length) {
+                std::size_t result = 0;
+
+                while (result < length && currentBuffer != endBuffer) {
+                    std::size_t bytesThisBuffer = currentBuffer->length - currentOffset;
+                    std::size_t bytesToCopy     = length - result < bytesThisBuffer ? length - result : bytesThisBuffer;
+
+                    std::memcpy(outputData + result, currentBuffer->data + currentOffset, bytesToCopy);
+                    result += bytesToCopy;
+
+                    advance(bytesToCopy);
+                }
+
+                return result;
+            }
+
+        private:
+            /**
+             * Method that moves the cursor past any exhausted or empty buffers.
+             */
+            inline void skipEmptyBuffers() {
+                while (currentBuffer != endBuffer && currentOffset == currentBuffer->length) {
+                    ++currentBuffer;
+                    currentOffset = 0;
+                }
+            }
+
+            /**
+             * The buffer holding the cursor.
+             */
+            const ConstBuffer* currentBuffer;
+
+            /**
+             * Pointer just past the last buffer.
+             */
+            const ConstBuffer* endBuffer;
+
+            /**
+             * The offset of the cursor within the current buffer.
+             */
+            std::size_t currentOffset;
+    };
+}
+
+#endif
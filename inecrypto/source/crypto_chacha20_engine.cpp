@@ -0,0 +1,451 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::ChaCha20Engine class.
+***********************************************************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_cpu_features.h"
+
+#if (CRYPTO_X86)
+    #include <emmintrin.h>
+    #include <immintrin.h>
+#endif
+
+#include "crypto_chacha20_engine.h"
+
+namespace Crypto {
+    /**
+     * The number of ChaCha20 double rounds.
+     */
+    static constexpr unsigned numberDoubleRounds = 10;
+
+    /**
+     * Function that reads a little-endian 32-bit value.
+     *
+     * \param[in] data Pointer to the four bytes to be read.
+     *
+     * \return Returns the value.
+     */
+    static inline std::uint32_t readLittleEndian(const std::uint8_t* data) {
+        return (
+              static_cast<std::uint32_t>(data[0])
+            | (static_cast<std::uint32_t>(data[1]) <<  8)
+            | (static_cast<std::uint32_t>(data[2]) << 16)
+            | (static_cast<std::uint32_t>(data[3]) << 24)
+        );
+    }
+
+    /**
+     * Function that rotates a 32-bit value left.
+     *
+     * \param[in] value The value to be rotated.
+     *
+     * \param[in] count The number of bits to rotate by.
+     *
+     * \return Returns the rotated value.
+     */
+    static inline std::uint32_t rotateLeft(std::uint32_t value, unsigned count) {
+        return (value << count) | (value >> (32 - count));
+    }
+
+    /**
+     * Function that performs a single ChaCha20 quarter round.
+     *
+     * \param[in,out] a The first word.
+     *
+     * \param[in,out] b The second word.
+     *
+     * \param[in,out] c The third word.
+     *
+     * \param[in,out] d The fourth word.
+     */
+    static inline void quarterRound(std::uint32_t& a, std::uint32_t& b, std::uint32_t& c, std::uint32_t& d) {
+        a += b; d ^= a; d = rotateLeft(d, 16);
+        c += d; b ^= c; b = rotateLeft(b, 12);
+        a += b; d ^= a; d = rotateLeft(d,  8);
+        c += d; b ^= c; b = rotateLeft(b,  7);
+    }
+
+    /**
+     * Function that generates keystream blocks one at a time.
+     *
+     * \param[in]  state        The ChaCha20 input state.  Word 12 holds the counter of the first block.
+     *
+     * \param[out] keystream    Buffer to receive the keystream.
+     *
+     * \param[in]  numberBlocks The number of blocks to generate.
+     */
+    static void generateKeystreamPortable(
+            const std::uint32_t* state,
+            std::uint8_t*        keystream,
+            std::size_t          numberBlocks
+        ) {
+        std::uint32_t x[16];
+        std::uint32_t counter = state[12];
+
+        for (std::size_t block=0 ; block<numberBlocks ; ++block) {
+            std::memcpy(x, state, sizeof(x));
+            x[12] = counter;
+
+            for (unsigned round=0 ; round<numberDoubleRounds ; ++round) {
+                quarterRound(x[0], x[4], x[ 8], x[12]);
+                quarterRound(x[1], x[5], x[ 9], x[13]);
+                quarterRound(x[2], x[6], x[10], x[14]);
+                quarterRound(x[3], x[7], x[11], x[15]);
+                quarterRound(x[0], x[5], x[10], x[15]);
+                quarterRound(x[1], x[6], x[11], x[12]);
+                quarterRound(x[2], x[7], x[ 8], x[13]);
+                quarterRound(x[3], x[4], x[ 9], x[14]);
+            }
+
+            for (unsigned i=0 ; i<16 ; ++i) {
+                std::uint32_t word = x[i] + (i == 12 ? counter : state[i]);
+                keystream[4 * i + 0] = static_cast<std::uint8_t>(word);
+                keystream[4 * i + 1] = static_cast<std::uint8_t>(word >>  8);
+                keystream[4 * i + 2] = static_cast<std::uint8_t>(word >> 16);
+                keystream[4 * i + 3] = static_cast<std::uint8_t>(word >> 24);
+            }
+
+            keystream += ChaCha20Engine::blockLength;
+            ++counter;
+        }
+
+        std::memset(x, 0, sizeof(x));
+    }
+
+    #if (CRYPTO_X86)
+
+        /**
+         * Function that rotates each 32-bit lane of an SSE2 vector left.
+         *
+         * \param[in] value The value to be rotated.
+         *
+         * \return Returns the rotated value.
+         */
+        template<int count> CRYPTO_TARGET("sse2") static inline __m128i rotateLeftSse2(__m128i value) {
+            return _mm_or_si128(_mm_slli_epi32(value, count), _mm_srli_epi32(value, 32 - count));
+        }
+
+        /**
+         * Function that performs a ChaCha20 quarter round on four blocks at once.
+         *
+         * \param[in,out] a The first word of each block.
+         *
+         * \param[in,out] b The second word of each block.
+         *
+         * \param[in,out] c The third word of each block.
+         *
+         * \param[in,out] d The fourth word of each block.
+         */
+        CRYPTO_TARGET("sse2") static inline void quarterRoundSse2(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+            a = _mm_add_epi32(a, b); d = rotateLeftSse2<16>(_mm_xor_si128(d, a));
+            c = _mm_add_epi32(c, d); b = rotateLeftSse2<12>(_mm_xor_si128(b, c));
+            a = _mm_add_epi32(a, b); d = rotateLeftSse2< 8>(_mm_xor_si128(d, a));
+            c = _mm_add_epi32(c, d); b = rotateLeftSse2< 7>(_mm_xor_si128(b, c));
+        }
+
+        /**
+         * Function that generates keystream blocks using SSE2.  Each vector holds the same state word for four
+         * consecutive blocks so the rounds need no shuffles.  The words are transposed back into block order on
+         * output.
+         *
+         * \param[in]  state        The ChaCha20 input state.  Word 12 holds the counter of the first block.
+         *
+         * \param[out] keystream    Buffer to receive the keystream.
+         *
+         * \param[in]  numberBlocks The number of blocks to generate.
+         */
+        CRYPTO_TARGET("sse2") static void generateKeystreamSse2(
+                const std::uint32_t* state,
+                std::uint8_t*        keystream,
+                std::size_t          numberBlocks
+            ) {
+            std::uint32_t counter = state[12];
+
+            while (numberBlocks >= 4) {
+                __m128i input[16];
+                for (unsigned i=0 ; i<16 ; ++i) {
+                    input[i] = _mm_set1_epi32(static_cast<int>(state[i]));
+                }
+
+                input[12] = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter)), _mm_set_epi32(3, 2, 1, 0));
+
+                __m128i x[16];
+                for (unsigned i=0 ; i<16 ; ++i) {
+                    x[i] = input[i];
+                }
+
+                for (unsigned round=0 ; round<numberDoubleRounds ; ++round) {
+                    quarterRoundSse2(x[0], x[4], x[ 8], x[12]);
+                    quarterRoundSse2(x[1], x[5], x[ 9], x[13]);
+                    quarterRoundSse2(x[2], x[6], x[10], x[14]);
+                    quarterRoundSse2(x[3], x[7], x[11], x[15]);
+                    quarterRoundSse2(x[0], x[5], x[10], x[15]);
+                    quarterRoundSse2(x[1], x[6], x[11], x[12]);
+                    quarterRoundSse2(x[2], x[7], x[ 8], x[13]);
+                    quarterRoundSse2(x[3], x[4], x[ 9], x[14]);
+                }
+
+                for (unsigned i=0 ; i<16 ; i+=4) {
+                    __m128i a = _mm_add_epi32(x[i + 0], input[i + 0]);
+                    __m128i b = _mm_add_epi32(x[i + 1], input[i + 1]);
+                    __m128i c = _mm_add_epi32(x[i + 2], input[i + 2]);
+                    __m128i d = _mm_add_epi32(x[i + 3], input[i + 3]);
+
+                    __m128i ab0 = _mm_unpacklo_epi32(a, b);
+                    __m128i cd0 = _mm_unpacklo_epi32(c, d);
+                    __m128i ab1 = _mm_unpackhi_epi32(a, b);
+                    __m128i cd1 = _mm_unpackhi_epi32(c, d);
+
+                    std::uint8_t* out = keystream + 4 * i;
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out +   0), _mm_unpacklo_epi64(ab0, cd0));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out +  64), _mm_unpackhi_epi64(ab0, cd0));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 128), _mm_unpacklo_epi64(ab1, cd1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 192), _mm_unpackhi_epi64(ab1, cd1));
+                }
+
+                keystream    += 4 * ChaCha20Engine::blockLength;
+                numberBlocks -= 4;
+                counter      += 4;
+            }
+
+            if (numberBlocks > 0) {
+                std::uint32_t remaining[16];
+                std::memcpy(remaining, state, sizeof(remaining));
+                remaining[12] = counter;
+
+                generateKeystreamPortable(remaining, keystream, numberBlocks);
+                std::memset(remaining, 0, sizeof(remaining));
+            }
+        }
+
+        /**
+         * Function that rotates each 32-bit lane of an AVX2 vector left.
+         *
+         * \param[in] value The value to be rotated.
+         *
+         * \return Returns the rotated value.
+         */
+        template<int count> CRYPTO_TARGET("avx2") static inline __m256i rotateLeftAvx2(__m256i value) {
+            return _mm256_or_si256(_mm256_slli_epi32(value, count), _mm256_srli_epi32(value, 32 - count));
+        }
+
+        /**
+         * Function that performs a ChaCha20 quarter round on eight blocks at once.
+         *
+         * \param[in,out] a The first word of each block.
+         *
+         * \param[in,out] b The second word of each block.
+         *
+         * \param[in,out] c The third word of each block.
+         *
+         * \param[in,out] d The fourth word of each block.
+         */
+        CRYPTO_TARGET("avx2") static inline void quarterRoundAvx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d) {
+            a = _mm256_add_epi32(a, b); d = rotateLeftAvx2<16>(_mm256_xor_si256(d, a));
+            c = _mm256_add_epi32(c, d); b = rotateLeftAvx2<12>(_mm256_xor_si256(b, c));
+            a = _mm256_add_epi32(a, b); d = rotateLeftAvx2< 8>(_mm256_xor_si256(d, a));
+            c = _mm256_add_epi32(c, d); b = rotateLeftAvx2< 7>(_mm256_xor_si256(b, c));
+        }
+
+        /**
+         * Function that generates keystream blocks using AVX2.  Each vector holds the same state word for eight
+         * consecutive blocks.  The transpose back into block order works within each 128-bit half so the low half
+         * yields blocks 0 through 3 and the high half yields blocks 4 through 7.
+         *
+         * \param[in]  state        The ChaCha20 input state.  Word 12 holds the counter of the first block.
+         *
+         * \param[out] keystream    Buffer to receive the keystream.
+         *
+         * \param[in]  numberBlocks The number of blocks to generate.
+         */
+        CRYPTO_TARGET("avx2") static void generateKeystreamAvx2(
+                const std::uint32_t* state,
+                std::uint8_t*        keystream,
+                std::size_t          numberBlocks
+            ) {
+            std::uint32_t counter = state[12];
+
+            while (numberBlocks >= 8) {
+                __m256i input[16];
+                for (unsigned i=0 ; i<16 ; ++i) {
+                    input[i] = _mm256_set1_epi32(static_cast<int>(state[i]));
+                }
+
+                input[12] = _mm256_add_epi32(
+                    _mm256_set1_epi32(static_cast<int>(counter)),
+                    _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0)
+                );
+
+                __m256i x[16];
+                for (unsigned i=0 ; i<16 ; ++i) {
+                    x[i] = input[i];
+                }
+
+                for (unsigned round=0 ; round<numberDoubleRounds ; ++round) {
+                    quarterRoundAvx2(x[0], x[4], x[ 8], x[12]);
+                    quarterRoundAvx2(x[1], x[5], x[ 9], x[13]);
+                    quarterRoundAvx2(x[2], x[6], x[10], x[14]);
+                    quarterRoundAvx2(x[3], x[7], x[11], x[15]);
+                    quarterRoundAvx2(x[0], x[5], x[10], x[15]);
+                    quarterRoundAvx2(x[1], x[6], x[11], x[12]);
+                    quarterRoundAvx2(x[2], x[7], x[ 8], x[13]);
+                    quarterRoundAvx2(x[3], x[4], x[ 9], x[14]);
+                }
+
+                for (unsigned i=0 ; i<16 ; i+=4) {
+                    __m256i a = _mm256_add_epi32(x[i + 0], input[i + 0]);
+                    __m256i b = _mm256_add_epi32(x[i + 1], input[i + 1]);
+                    __m256i c = _mm256_add_epi32(x[i + 2], input[i + 2]);
+                    __m256i d = _mm256_add_epi32(x[i + 3], input[i + 3]);
+
+                    __m256i ab0 = _mm256_unpacklo_epi32(a, b);
+                    __m256i cd0 = _mm256_unpacklo_epi32(c, d);
+                    __m256i ab1 = _mm256_unpackhi_epi32(a, b);
+                    __m256i cd1 = _mm256_unpackhi_epi32(c, d);
+
+                    __m256i rows[4] = {
+                        _mm256_unpacklo_epi64(ab0, cd0),
+                        _mm256_unpackhi_epi64(ab0, cd0),
+                        _mm256_unpacklo_epi64(ab1, cd1),
+                        _mm256_unpackhi_epi64(ab1, cd1)
+                    };
+
+                    std::uint8_t* out = keystream + 4 * i;
+                    for (unsigned block=0 ; block<4 ; ++block) {
+                        _mm_storeu_si128(
+                            reinterpret_cast<__m128i*>(out + ChaCha20Engine::blockLength * block),
+                            _mm256_castsi256_si128(rows[block])
+                        );
+                        _mm_storeu_si128(
+                            reinterpret_cast<__m128i*>(out + ChaCha20Engine::blockLength * (block + 4)),
+                            _mm256_extracti128_si256(rows[block], 1)
+                        );
+                    }
+                }
+
+                keystream    += 8 * ChaCha20Engine::blockLength;
+                numberBlocks -= 8;
+                counter      += 8;
+            }
+
+            if (numberBlocks > 0) {
+                std::uint32_t remaining[16];
+                std::memcpy(remaining, state, sizeof(remaining));
+                remaining[12] = counter;
+
+                generateKeystreamSse2(remaining, keystream, numberBlocks);
+                std::memset(remaining, 0, sizeof(remaining));
+            }
+        }
+
+    #endif
+
+    void ChaCha20Engine::setKeys(const std::uint8_t* keys) {
+        // "expand 32-byte k"
+        state[0] = 0x61707865;
+        state[1] = 0x3320646E;
+        state[2] = 0x79622D32;
+        state[3] = 0x6B206574;
+
+        for (unsigned i=0 ; i<8 ; ++i) {
+            state[4 + i] = readLittleEndian(keys + 4 * i);
+        }
+
+        keystreamIndex = keystreamLength;
+    }
+
+
+    void ChaCha20Engine::setNonce(const std::uint8_t* nonce, std::uint32_t blockCounter) {
+        state[12] = blockCounter;
+        state[13] = readLittleEndian(nonce + 0);
+        state[14] = readLittleEndian(nonce + 4);
+        state[15] = readLittleEndian(nonce + 8);
+
+        keystreamIndex = keystreamLength;
+    }
+
+
+    void ChaCha20Engine::apply(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length) {
+        while (length > 0) {
+            if (keystreamIndex == keystreamLength) {
+                generateKeystream(state, keystream, keystreamBlocks);
+                state[12]      += keystreamBlocks;
+                keystreamIndex  = 0;
+            }
+
+            std::size_t         bytesInKeystream = keystreamLength - keystreamIndex;
+            std::size_t         bytesThisPass    = std::min(length, bytesInKeystream);
+            const std::uint8_t* k                = keystream + keystreamIndex;
+
+            for (std::size_t i=0 ; i<bytesThisPass ; ++i) {
+                outputData[i] = inputData[i] ^ k[i];
+            }
+
+            inputData      += bytesThisPass;
+            outputData     += bytesThisPass;
+            length         -= bytesThisPass;
+            keystreamIndex += static_cast<unsigned>(bytesThisPass);
+        }
+    }
+
+
+    void ChaCha20Engine::scrub() {
+        std::memset(state, 0, sizeof(state));
+        std::memset(keystream, 0, keystreamLength);
+        keystreamIndex = keystreamLength;
+    }
+
+
+    void ChaCha20Engine::generateKeystream(
+            const std::uint32_t* state,
+            std::uint8_t*        keystream,
+            std::size_t          numberBlocks
+        ) {
+        #if (CRYPTO_X86)
+            if (cpuHasAvx2()) {
+                generateKeystreamAvx2(state, keystream, numberBlocks);
+            } else if (cpuHasSse2()) {
+                generateKeystreamSse2(state, keystream, numberBlocks);
+            } else {
+                generateKeystreamPortable(state, keystream, numberBlocks);
+            }
+        #else
+            generateKeystreamPortable(state, keystream, numberBlocks);
+        #endif
+    }
+
+
+    unsigned ChaCha20Engine::parallelBlocks() {
+        unsigned result;
+
+        if (cpuHasAvx2()) {
+            result = 8;
+        } else if (cpuHasSse2()) {
+            result = 4;
+        } else {
+            result = 1;
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,137 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::ChaCha20Engine class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_CHACHA20_ENGINE_H
+#define CRYPTO_CHACHA20_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Crypto {
+    /**
+     * Class that generates the ChaCha20 keystream described in RFC 8439 and applies it to data.  The keystream is
+     * generated eight blocks at a time.  Where the processor supports AVX2, all eight blocks are computed in
+     * parallel, one block per vector lane.  SSE2 computes four blocks per pass.  A portable implementation is used
+     * otherwise.
+     */
+    class ChaCha20Engine {
+        public:
+            /**
+             * The key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The nonce length, in bytes.
+             */
+            static constexpr unsigned nonceLength = 12;
+
+            /**
+             * The ChaCha20 block length, in bytes.
+             */
+            static constexpr unsigned blockLength = 64;
+
+            /**
+             * The number of keystream blocks generated per pass.
+             */
+            static constexpr unsigned keystreamBlocks = 8;
+
+            /**
+             * The keystream buffer length, in bytes.
+             */
+            static constexpr unsigned keystreamLength = keystreamBlocks * blockLength;
+
+            /**
+             * Method you can use to load a new key.
+             *
+             * \param[in] keys The 32 byte key.
+             */
+            void setKeys(const std::uint8_t* keys);
+
+            /**
+             * Method you can use to position the keystream at the start of a block.
+             *
+             * \param[in] nonce        The 12 byte nonce.
+             *
+             * \param[in] blockCounter The block counter used for the first byte of the stream.
+             */
+            void setNonce(const std::uint8_t* nonce, std::uint32_t blockCounter);
+
+            /**
+             * Method you can use to apply the keystream to a buffer.  Encryption and decryption are identical.
+             *
+             * \param[in]  inputData  Pointer to the data to be processed.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the processed data.  The input and output
+             *                        pointers may be identical.
+             *
+             * \param[in]  length     The number of bytes to be processed.
+             */
+            void apply(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length);
+
+            /**
+             * Method you can use to scrub the engine state.
+             */
+            void scrub();
+
+            /**
+             * Method that generates consecutive keystream blocks.
+             *
+             * \param[in]  state        The 16 word ChaCha20 input state.  Word 12 holds the counter of the first
+             *                          block.
+             *
+             * \param[out] keystream    Buffer to receive the keystream.
+             *
+             * \param[in]  numberBlocks The number of blocks to generate.
+             */
+            static void generateKeystream(
+                const std::uint32_t* state,
+                std::uint8_t*        keystream,
+                std::size_t          numberBlocks
+            );
+
+            /**
+             * Method you can use to determine how many blocks the vectorized implementation computes at once.
+             *
+             * \return Returns 8 if AVX2 is used, 4 if SSE2 is used and 1 if the portable implementation is used.
+             */
+            static unsigned parallelBlocks();
+
+        private:
+            /**
+             * The ChaCha20 input state for the next keystream block to be generated.
+             */
+            std::uint32_t state[16];
+
+            /**
+             * Buffered keystream.
+             */
+            alignas(16) std::uint8_t keystream[keystreamLength];
+
+            /**
+             * Index of the next unused byte in the keystream buffer.
+             */
+            unsigned keystreamIndex;
+    };
+}
+
+#endif
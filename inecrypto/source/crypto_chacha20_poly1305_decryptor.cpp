@@ -0,0 +1,218 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::ChaCha20Poly1305Decryptor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+
+#include <cstring>
+
+#include "crypto_decryptor.h"
+#include "crypto_chacha20_poly1305_decryptor.h"
+#include "crypto_chacha20_poly1305_engine.h"
+
+namespace Crypto {
+    ChaCha20Poly1305Decryptor::ChaCha20Poly1305Decryptor(QIODevice* parent):Decryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+
+        includeIVHeader = true;
+    }
+
+
+    ChaCha20Poly1305Decryptor::ChaCha20Poly1305Decryptor(QObject* parent):Decryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+
+        includeIVHeader = true;
+    }
+
+
+    ChaCha20Poly1305Decryptor::ChaCha20Poly1305Decryptor(
+            const ChaCha20Poly1305Decryptor::Keys& keys,
+            QIODevice*                             parent
+        ):Decryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        includeIVHeader = true;
+    }
+
+
+    ChaCha20Poly1305Decryptor::ChaCha20Poly1305Decryptor(
+            const ChaCha20Poly1305Decryptor::Keys& keys,
+            QObject*                               parent
+        ):Decryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        includeIVHeader = true;
+    }
+
+
+    ChaCha20Poly1305Decryptor::ChaCha20Poly1305Decryptor(
+            const ChaCha20Poly1305Decryptor::Keys& keys,
+            const ChaCha20Poly1305Decryptor::IV&   iv,
+            QIODevice*                             parent
+        ):Decryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        includeIVHeader = false;
+    }
+
+
+    ChaCha20Poly1305Decryptor::ChaCha20Poly1305Decryptor(
+            const ChaCha20Poly1305Decryptor::Keys& keys,
+            const ChaCha20Poly1305Decryptor::IV&   iv,
+            QObject*                               parent
+        ):Decryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        includeIVHeader = false;
+    }
+
+
+    ChaCha20Poly1305Decryptor::~ChaCha20Poly1305Decryptor() {
+        std::memset(initialKeys, 0, keyLength);
+        std::memset(initialIV, 0, ivLength);
+
+        engine()->scrub();
+    }
+
+
+    unsigned ChaCha20Poly1305Decryptor::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void ChaCha20Poly1305Decryptor::setKeys(const ChaCha20Poly1305Decryptor::Keys& keys) {
+        std::memcpy(initialKeys, keys, keyLength);
+    }
+
+
+    void ChaCha20Poly1305Decryptor::setIV(const ChaCha20Poly1305Decryptor::IV& newIV) {
+        std::memcpy(initialIV, newIV, ivLength);
+    }
+
+
+    unsigned ChaCha20Poly1305Decryptor::outputChunkSize() const {
+        return 1;
+    }
+
+
+    void ChaCha20Poly1305Decryptor::setAssociatedData(const QByteArray& newAssociatedData) {
+        currentAssociatedData = newAssociatedData;
+    }
+
+
+    QByteArray ChaCha20Poly1305Decryptor::associatedData() const {
+        return currentAssociatedData;
+    }
+
+
+    void ChaCha20Poly1305Decryptor::setIVHeaderEnabled(bool nowEnabled) {
+        includeIVHeader = nowEnabled;
+    }
+
+
+    bool ChaCha20Poly1305Decryptor::ivHeaderEnabled() const {
+        return includeIVHeader;
+    }
+
+
+    unsigned ChaCha20Poly1305Decryptor::headerSize() const {
+        return includeIVHeader ? ivLength : 0;
+    }
+
+
+    unsigned ChaCha20Poly1305Decryptor::trailerSize() const {
+        return tagLength;
+    }
+
+
+    void ChaCha20Poly1305Decryptor::resetEngine() {
+        static_assert(
+            sizeof(ChaCha20Poly1305Engine) <= engineStorageSize,
+            "Insufficient ChaCha20-Poly1305 engine storage."
+        );
+
+        engine()->setKeys(initialKeys);
+
+        engine()->start(
+            initialIV,
+            reinterpret_cast<const std::uint8_t*>(currentAssociatedData.constData()),
+            static_cast<std::size_t>(currentAssociatedData.size())
+        );
+    }
+
+
+    void ChaCha20Poly1305Decryptor::processHeader(const std::uint8_t* headerData) {
+        engine()->start(
+            headerData,
+            reinterpret_cast<const std::uint8_t*>(currentAssociatedData.constData()),
+            static_cast<std::size_t>(currentAssociatedData.size())
+        );
+    }
+
+
+    bool ChaCha20Poly1305Decryptor::processTrailer(const std::uint8_t* trailerData) {
+        return engine()->verify(trailerData);
+    }
+
+
+    void ChaCha20Poly1305Decryptor::decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
+        engine()->decrypt(inputData, outputData, 1);
+    }
+
+
+    void ChaCha20Poly1305Decryptor::decryptChunks(
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        engine()->decrypt(inputData, outputData, numberChunks);
+    }
+
+
+    void ChaCha20Poly1305Decryptor::initializeIV() {
+        // We just want a little entropy in our IV so we use a super-simple PRNG
+        std::uint8_t seeds[4] = { 251, 241, 239, 233 };
+        for (unsigned i=0 ; i<ivLength ; ++i) {
+            std::uint8_t newSeed = seeds[0] + seeds[1] + seeds[2] + seeds[3] + 1;
+            seeds[3] = seeds[2];
+            seeds[2] = seeds[1];
+            seeds[1] = seeds[0];
+            seeds[0] = newSeed;
+
+            initialIV[i] = newSeed;
+        }
+    }
+}
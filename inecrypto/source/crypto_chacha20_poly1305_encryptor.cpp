@@ -0,0 +1,234 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::ChaCha20Poly1305Encryptor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+
+#include <cstring>
+
+#include "crypto_encryptor.h"
+#include "crypto_chacha20_poly1305_encryptor.h"
+#include "crypto_chacha20_poly1305_engine.h"
+
+namespace Crypto {
+    ChaCha20Poly1305Encryptor::ChaCha20Poly1305Encryptor(QIODevice* parent):Encryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+        includeIVHeader = true;
+        ivUsed          = false;
+    }
+
+
+    ChaCha20Poly1305Encryptor::ChaCha20Poly1305Encryptor(QObject* parent):Encryptor(parent) {
+        std::memset(initialKeys, 0, keyLength);
+        initializeIV();
+
+        includeIVHeader = true;
+        ivUsed          = false;
+    }
+
+
+    ChaCha20Poly1305Encryptor::ChaCha20Poly1305Encryptor(
+            const ChaCha20Poly1305Encryptor::Keys& keys,
+            QIODevice*                             parent
+        ):Encryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        includeIVHeader = true;
+        ivUsed          = false;
+    }
+
+
+    ChaCha20Poly1305Encryptor::ChaCha20Poly1305Encryptor(
+            const ChaCha20Poly1305Encryptor::Keys& keys,
+            QObject*                               parent
+        ):Encryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        initializeIV();
+
+        includeIVHeader = true;
+        ivUsed          = false;
+    }
+
+
+    ChaCha20Poly1305Encryptor::ChaCha20Poly1305Encryptor(
+            const ChaCha20Poly1305Encryptor::Keys& keys,
+            const ChaCha20Poly1305Encryptor::IV&   iv,
+            QIODevice*                             parent
+        ):Encryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        includeIVHeader = false;
+        ivUsed          = false;
+    }
+
+
+    ChaCha20Poly1305Encryptor::ChaCha20Poly1305Encryptor(
+            const ChaCha20Poly1305Encryptor::Keys& keys,
+            const ChaCha20Poly1305Encryptor::IV&   iv,
+            QObject*                               parent
+        ):Encryptor(
+            parent
+        ) {
+        std::memcpy(initialKeys, keys, keyLength);
+        std::memcpy(initialIV, iv, ivLength);
+
+        includeIVHeader = false;
+        ivUsed          = false;
+    }
+
+
+    ChaCha20Poly1305Encryptor::~ChaCha20Poly1305Encryptor() {
+        std::memset(initialKeys, 0, keyLength);
+        std::memset(initialIV, 0, ivLength);
+        std::memset(currentIV, 0, ivLength);
+
+        engine()->scrub();
+    }
+
+
+    unsigned ChaCha20Poly1305Encryptor::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void ChaCha20Poly1305Encryptor::setKeys(const Keys& keys) {
+        std::memcpy(initialKeys, keys, keyLength);
+        ivUsed = false;
+    }
+
+
+    void ChaCha20Poly1305Encryptor::setIV(const IV& newIV) {
+        std::memcpy(initialIV, newIV, ivLength);
+        ivUsed = false;
+    }
+
+
+    unsigned ChaCha20Poly1305Encryptor::inputChunkSize() const {
+        return 1;
+    }
+
+
+    void ChaCha20Poly1305Encryptor::setAssociatedData(const QByteArray& newAssociatedData) {
+        currentAssociatedData = newAssociatedData;
+    }
+
+
+    QByteArray ChaCha20Poly1305Encryptor::associatedData() const {
+        return currentAssociatedData;
+    }
+
+
+    void ChaCha20Poly1305Encryptor::setIVHeaderEnabled(bool nowEnabled) {
+        includeIVHeader = nowEnabled;
+    }
+
+
+    bool ChaCha20Poly1305Encryptor::ivHeaderEnabled() const {
+        return includeIVHeader;
+    }
+
+
+    unsigned ChaCha20Poly1305Encryptor::headerSize() const {
+        return includeIVHeader ? ivLength : 0;
+    }
+
+
+    unsigned ChaCha20Poly1305Encryptor::trailerSize() const {
+        return tagLength;
+    }
+
+
+    void ChaCha20Poly1305Encryptor::resetEngine() {
+        static_assert(
+            sizeof(ChaCha20Poly1305Engine) <= engineStorageSize,
+            "Insufficient ChaCha20-Poly1305 engine storage."
+        );
+
+        engine()->setKeys(initialKeys);
+
+        if (includeIVHeader) {
+            generateRandomIV(currentIV, ivLength);
+        } else {
+            std::memcpy(currentIV, initialIV, ivLength);
+            ivUsed = true;
+        }
+
+        engine()->start(
+            currentIV,
+            reinterpret_cast<const std::uint8_t*>(currentAssociatedData.constData()),
+            static_cast<std::size_t>(currentAssociatedData.size())
+        );
+    }
+
+
+    bool ChaCha20Poly1305Encryptor::streamAllowed() const {
+        return includeIVHeader || !ivUsed;
+    }
+
+
+    void ChaCha20Poly1305Encryptor::generateHeader(std::uint8_t* headerData) {
+        std::memcpy(headerData, currentIV, ivLength);
+    }
+
+
+    void ChaCha20Poly1305Encryptor::generateTrailer(std::uint8_t* trailerData) {
+        engine()->finish(trailerData);
+    }
+
+
+    void ChaCha20Poly1305Encryptor::encryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
+        engine()->encrypt(inputData, outputData, 1);
+    }
+
+
+    void ChaCha20Poly1305Encryptor::encryptChunks(
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        engine()->encrypt(inputData, outputData, numberChunks);
+    }
+
+
+    void ChaCha20Poly1305Encryptor::initializeIV() {
+        // We just want a little entropy in our IV so we use a super-simple PRNG
+        std::uint8_t seeds[4] = { 251, 241, 239, 233 };
+        for (unsigned i=0 ; i<ivLength ; ++i) {
+            std::uint8_t newSeed = seeds[0] + seeds[1] + seeds[2] + seeds[3] + 1;
+            seeds[3] = seeds[2];
+            seeds[2] = seeds[1];
+            seeds[1] = seeds[0];
+            seeds[0] = newSeed;
+
+            initialIV[i] = newSeed;
+        }
+    }
+}
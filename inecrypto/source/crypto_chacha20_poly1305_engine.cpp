@@ -0,0 +1,116 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::ChaCha20Poly1305Engine class.
+***********************************************************************************************************************/
+
+#include <cstring>
+
+#include "crypto_chacha20_engine.h"
+#include "crypto_poly1305_engine.h"
+#include "crypto_chacha20_poly1305_engine.h"
+
+namespace Crypto {
+    void ChaCha20Poly1305Engine::setKeys(const std::uint8_t* keys) {
+        chacha.setKeys(keys);
+    }
+
+
+    void ChaCha20Poly1305Engine::start(
+            const std::uint8_t* iv,
+            const std::uint8_t* associatedData,
+            std::size_t         associatedDataSize
+        ) {
+        // The Poly1305 key is the first half of block 0.  Consuming the whole of block 0 leaves the keystream
+        // positioned at block 1, where the data starts, and keeps the rest of the generated blocks for the data.
+        std::uint8_t firstBlock[ChaCha20Engine::blockLength] = { 0 };
+        chacha.setNonce(iv, 0);
+        chacha.apply(firstBlock, firstBlock, ChaCha20Engine::blockLength);
+
+        poly1305.setKey(firstBlock);
+        std::memset(firstBlock, 0, sizeof(firstBlock));
+
+        if (associatedDataSize > 0) {
+            poly1305.update(associatedData, associatedDataSize);
+            poly1305.padBlock();
+        }
+
+        associatedDataLength = associatedDataSize;
+        textLength           = 0;
+    }
+
+
+    void ChaCha20Poly1305Engine::encrypt(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length) {
+        chacha.apply(inputData, outputData, length);
+        poly1305.update(outputData, length);
+
+        textLength += length;
+    }
+
+
+    void ChaCha20Poly1305Engine::decrypt(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length) {
+        // Authenticate first as the input is overwritten when decrypting in place.
+        poly1305.update(inputData, length);
+        chacha.apply(inputData, outputData, length);
+
+        textLength += length;
+    }
+
+
+    void ChaCha20Poly1305Engine::finish(std::uint8_t* tag) {
+        std::uint8_t lengths[Poly1305Engine::blockLength];
+        unsigned long long associatedDataBytes = associatedDataLength;
+        unsigned long long textBytes           = textLength;
+
+        for (unsigned i=0 ; i<8 ; ++i) {
+            lengths[i]     = static_cast<std::uint8_t>(associatedDataBytes);
+            lengths[i + 8] = static_cast<std::uint8_t>(textBytes);
+
+            associatedDataBytes >>= 8;
+            textBytes           >>= 8;
+        }
+
+        poly1305.padBlock();
+        poly1305.update(lengths, Poly1305Engine::blockLength);
+        poly1305.finish(tag);
+    }
+
+
+    bool ChaCha20Poly1305Engine::verify(const std::uint8_t* tag) {
+        std::uint8_t expected[tagLength];
+        finish(expected);
+
+        std::uint8_t difference = 0;
+        for (unsigned i=0 ; i<tagLength ; ++i) {
+            difference |= expected[i] ^ tag[i];
+        }
+
+        std::memset(expected, 0, tagLength);
+        return difference == 0;
+    }
+
+
+    void ChaCha20Poly1305Engine::scrub() {
+        chacha.scrub();
+        poly1305.scrub();
+
+        associatedDataLength = 0;
+        textLength           = 0;
+    }
+}
@@ -0,0 +1,136 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::ChaCha20Poly1305Engine class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_CHACHA20_POLY1305_ENGINE_H
+#define CRYPTO_CHACHA20_POLY1305_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "crypto_chacha20_engine.h"
+#include "crypto_poly1305_engine.h"
+
+namespace Crypto {
+    /**
+     * Class that implements the ChaCha20-Poly1305 AEAD construction described in RFC 8439.  The one-time Poly1305
+     * key is taken from the first keystream block and the data is encrypted starting with the second block.
+     */
+    class ChaCha20Poly1305Engine {
+        public:
+            /**
+             * The nonce length, in bytes.
+             */
+            static constexpr unsigned ivLength = ChaCha20Engine::nonceLength;
+
+            /**
+             * The authentication tag length, in bytes.
+             */
+            static constexpr unsigned tagLength = Poly1305Engine::tagLength;
+
+            /**
+             * Method you can use to load a new key.
+             *
+             * \param[in] keys The 32 byte key.
+             */
+            void setKeys(const std::uint8_t* keys);
+
+            /**
+             * Method you can use to start a new message.
+             *
+             * \param[in] iv                 The 12 byte nonce.
+             *
+             * \param[in] associatedData     Pointer to data that is authenticated but not encrypted.
+             *
+             * \param[in] associatedDataSize The length of the associated data, in bytes.
+             */
+            void start(const std::uint8_t* iv, const std::uint8_t* associatedData, std::size_t associatedDataSize);
+
+            /**
+             * Method you can use to encrypt part of the message.
+             *
+             * \param[in]  inputData  Pointer to the data to be encrypted.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the encrypted data.  The input and output
+             *                        pointers may be identical.
+             *
+             * \param[in]  length     The number of bytes to be encrypted.
+             */
+            void encrypt(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length);
+
+            /**
+             * Method you can use to decrypt part of the message.
+             *
+             * \param[in]  inputData  Pointer to the data to be decrypted.
+             *
+             * \param[out] outputData Pointer to the buffer to receive the decrypted data.  The input and output
+             *                        pointers may be identical.
+             *
+             * \param[in]  length     The number of bytes to be decrypted.
+             */
+            void decrypt(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t length);
+
+            /**
+             * Method you can use to calculate the authentication tag once the entire message has been processed.
+             *
+             * \param[out] tag Buffer to receive the 16 byte tag.
+             */
+            void finish(std::uint8_t* tag);
+
+            /**
+             * Method you can use to check a received authentication tag once the entire message has been processed.
+             * The comparison takes the same time regardless of where the tags differ.
+             *
+             * \param[in] tag The received 16 byte tag.
+             *
+             * \return Returns true if the tag is valid.  Returns false if the tag is invalid.
+             */
+            bool verify(const std::uint8_t* tag);
+
+            /**
+             * Method you can use to scrub the engine state.
+             */
+            void scrub();
+
+        private:
+            /**
+             * The ChaCha20 keystream engine.
+             */
+            ChaCha20Engine chacha;
+
+            /**
+             * The Poly1305 engine.
+             */
+            Poly1305Engine poly1305;
+
+            /**
+             * The length of the associated data, in bytes.
+             */
+            unsigned long long associatedDataLength;
+
+            /**
+             * The length of the processed text, in bytes.
+             */
+            unsigned long long textLength;
+    };
+}
+
+#endif
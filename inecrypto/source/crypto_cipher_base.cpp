@@ -22,9 +22,13 @@
 
 #include <QString>
 #include <QByteArray>
+#include <QRandomGenerator>
 
+#include <algorithm>
 #include <cstring>
 
+#include "crypto_helpers.h"
+#include "crypto_kdf.h"
 #include "crypto_cipher_base.h"
 
 namespace Crypto {
@@ -44,6 +48,52 @@ namespace Crypto {
     void CipherBase::generateKey(std::uint8_t* keyArray, const QString& str) const {
         generateKey(keyArray, str.toUtf8());
     };
-}
 
 
+    bool CipherBase::deriveKey(
+            std::uint8_t*     keyArray,
+            const QByteArray& password,
+            const QByteArray& salt,
+            unsigned long     iterations
+        ) const {
+        return Kdf::pbkdf2(
+            reinterpret_cast<const std::uint8_t*>(password.constData()),
+            static_cast<std::size_t>(password.size()),
+            reinterpret_cast<const std::uint8_t*>(salt.constData()),
+            static_cast<std::size_t>(salt.size()),
+            iterations,
+            keyArray,
+            keyLengthInBytes()
+        );
+    }
+
+
+    bool CipherBase::deriveKey(
+            std::uint8_t*     keyArray,
+            const QString&    password,
+            const QByteArray& salt,
+            unsigned long     iterations
+        ) const {
+        QByteArray passwordBytes = password.toUtf8();
+        bool       result        = deriveKey(keyArray, passwordBytes, salt, iterations);
+
+        Crypto::scrub(passwordBytes);
+        return result;
+    }
+
+
+    void CipherBase::generateRandomIV(std::uint8_t* ivData, unsigned ivLength) {
+        // The IV is sent in the clear so it must not be predictable.  We use the system generator rather than the
+        // global generator for that reason.
+        QRandomGenerator* generator = QRandomGenerator::system();
+
+        unsigned index = 0;
+        while (index < ivLength) {
+            std::uint32_t word      = generator->generate();
+            unsigned      wordBytes = std::min(ivLength - index, static_cast<unsigned>(sizeof(word)));
+
+            std::memcpy(ivData + index, &word, wordBytes);
+            index += wordBytes;
+        }
+    }
+}
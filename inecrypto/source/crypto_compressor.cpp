@@ -0,0 +1,226 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::Compressor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+#include <QByteArray>
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_compressor.h"
+
+namespace Crypto {
+    Compressor::Compressor(QIODevice* parent):QIODevice(parent) {
+        currentBlockSize        = defaultBlockSize;
+        currentCompressionLevel = -1;
+        currentOutputDevice     = parent;
+    }
+
+
+    Compressor::Compressor(QObject* parent):QIODevice(parent) {
+        currentBlockSize        = defaultBlockSize;
+        currentCompressionLevel = -1;
+        currentOutputDevice     = Q_NULLPTR;
+    }
+
+
+    Compressor::~Compressor() {
+        if (isOpen()) {
+            close();
+        }
+    }
+
+
+    void Compressor::setBlockSize(unsigned newBlockSize) {
+        if (!isOpen()) {
+            currentBlockSize = std::min(std::max(newBlockSize, 1U), maximumBlockSize);
+        }
+    }
+
+
+    unsigned Compressor::blockSize() const {
+        return currentBlockSize;
+    }
+
+
+    void Compressor::setCompressionLevel(int newCompressionLevel) {
+        currentCompressionLevel = std::min(std::max(newCompressionLevel, -1), 9);
+    }
+
+
+    int Compressor::compressionLevel() const {
+        return currentCompressionLevel;
+    }
+
+
+    QByteArray Compressor::compress(const QByteArray& inputBuffer) const {
+        QByteArray result;
+
+        unsigned inputLength = static_cast<unsigned>(inputBuffer.size());
+        unsigned offset      = 0;
+        while (offset < inputLength) {
+            unsigned length = std::min(currentBlockSize, inputLength - offset);
+            appendBlock(inputBuffer.constData() + offset, length, result);
+
+            offset += length;
+        }
+
+        return result;
+    }
+
+
+    void Compressor::setOutputDevice(QIODevice* outputDevice) {
+        currentOutputDevice = outputDevice;
+    }
+
+
+    QIODevice* Compressor::outputDevice() const {
+        return currentOutputDevice;
+    }
+
+
+    bool Compressor::open(Compressor::OpenMode openMode) {
+        bool result;
+
+        if (openMode != OpenModeFlag::WriteOnly) {
+            result = false;
+        } else if (currentOutputDevice == Q_NULLPTR) {
+            setErrorString(tr("No output device."));
+            result = false;
+        } else {
+            pendingData.clear();
+            pendingData.reserve(static_cast<int>(currentBlockSize));
+
+            result = QIODevice::open(openMode | OpenModeFlag::Unbuffered);
+        }
+
+        return result;
+    }
+
+
+    void Compressor::close() {
+        if (isOpen()) {
+            writePendingBlock();
+        }
+
+        pendingData.fill('\x00');
+        pendingData.clear();
+
+        QIODevice::close();
+    }
+
+
+    bool Compressor::flush() {
+        return isOpen() && writePendingBlock();
+    }
+
+
+    bool Compressor::isSequential() const {
+        return true;
+    }
+
+
+    qint64 Compressor::readData(char* /* data */, qint64 /* maxSize */) {
+        return -1;
+    }
+
+
+    qint64 Compressor::writeData(const char* data, qint64 maxSize) {
+        qint64 result = 0;
+        bool   ok     = true;
+
+        while (ok && result < maxSize) {
+            qint64 bytesToCopy = std::min(
+                maxSize - result,
+                static_cast<qint64>(currentBlockSize) - static_cast<qint64>(pendingData.size())
+            );
+
+            pendingData.append(data + result, static_cast<int>(bytesToCopy));
+            result += bytesToCopy;
+
+            if (static_cast<unsigned>(pendingData.size()) >= currentBlockSize) {
+                ok = writePendingBlock();
+            }
+        }
+
+        if (!ok) {
+            result = -1;
+        }
+
+        return result;
+    }
+
+
+    void Compressor::appendBlock(const char* data, unsigned length, QByteArray& output) const {
+        QByteArray compressed = qCompress(
+            reinterpret_cast<const uchar*>(data),
+            static_cast<int>(length),
+            currentCompressionLevel
+        );
+
+        bool          stored        = (static_cast<unsigned>(compressed.size()) >= length);
+        std::uint32_t payloadLength = stored ? length : static_cast<std::uint32_t>(compressed.size());
+        std::uint32_t header        = stored ? (payloadLength | storedFlag) : payloadLength;
+
+        char headerBytes[blockHeaderLength] = {
+            static_cast<char>(header >> 24),
+            static_cast<char>(header >> 16),
+            static_cast<char>(header >>  8),
+            static_cast<char>(header      )
+        };
+
+        output.append(headerBytes, blockHeaderLength);
+        if (stored) {
+            output.append(data, static_cast<int>(length));
+        } else {
+            output.append(compressed);
+        }
+
+        compressed.fill('\x00');
+    }
+
+
+    bool Compressor::writePendingBlock() {
+        bool result;
+
+        if (pendingData.isEmpty()) {
+            result = true;
+        } else {
+            frameData.clear();
+            appendBlock(pendingData.constData(), static_cast<unsigned>(pendingData.size()), frameData);
+
+            // Resizing rather than clearing keeps the reserved block allocation.
+            pendingData.fill('\x00');
+            pendingData.resize(0);
+
+            result = (currentOutputDevice->write(frameData) == frameData.size());
+            if (!result) {
+                setErrorString(tr("Could not write block: %1").arg(currentOutputDevice->errorString()));
+            }
+
+            frameData.fill('\x00');
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,139 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements functions used to detect processor features at run time.
+***********************************************************************************************************************/
+
+#include "crypto_cpu_features.h"
+
+#if (CRYPTO_X86 && defined(_MSC_VER) && !defined(__clang__))
+    #include <intrin.h>
+#endif
+
+namespace Crypto {
+    #if (CRYPTO_X86)
+
+        /**
+         * Class that captures the processor features once, the first time they're needed.
+         */
+        class CpuFeatures {
+            public:
+                /**
+                 * Constructor.  Queries the processor.
+                 */
+                CpuFeatures() {
+                    #if (defined(_MSC_VER) && !defined(__clang__))
+                        int registers[4];
+
+                        __cpuid(registers, 1);
+                        sse2   = (registers[3] & (1 << 26)) != 0;
+                        aes    = (registers[2] & (1 << 25)) != 0;
+                        pclmul = (registers[2] & (1 <<  1)) != 0;
+
+                        bool osSavesYmm = false;
+                        if ((registers[2] & (1 << 27)) != 0) {
+                            osSavesYmm = (_xgetbv(0) & 0x6) == 0x6;
+                        }
+
+                        __cpuidex(registers, 7, 0);
+                        avx2 = osSavesYmm && (registers[1] & (1 << 5)) != 0;
+                    #else
+                        __builtin_cpu_init();
+
+                        sse2   = __builtin_cpu_supports("sse2") != 0;
+                        aes    = __builtin_cpu_supports("aes") != 0;
+                        pclmul = __builtin_cpu_supports("pclmul") != 0;
+                        avx2   = __builtin_cpu_supports("avx2") != 0;
+                    #endif
+                }
+
+                /**
+                 * Flag indicating if SSE2 is supported.
+                 */
+                bool sse2;
+
+                /**
+                 * Flag indicating if the AES instructions are supported.
+                 */
+                bool aes;
+
+                /**
+                 * Flag indicating if the carry-less multiply instruction is supported.
+                 */
+                bool pclmul;
+
+                /**
+                 * Flag indicating if AVX2 is supported.
+                 */
+                bool avx2;
+        };
+
+        /**
+         * Function that provides the processor features.
+         *
+         * \return Returns the processor features.
+         */
+        static const CpuFeatures& cpuFeatures() {
+            static const CpuFeatures features;
+            return features;
+        }
+
+
+        bool cpuHasSse2() {
+            return cpuFeatures().sse2;
+        }
+
+
+        bool cpuHasAes() {
+            return cpuFeatures().aes;
+        }
+
+
+        bool cpuHasPclmul() {
+            return cpuFeatures().pclmul;
+        }
+
+
+        bool cpuHasAvx2() {
+            return cpuFeatures().avx2;
+        }
+
+    #else
+
+        bool cpuHasSse2() {
+            return false;
+        }
+
+
+        bool cpuHasAes() {
+            return false;
+        }
+
+
+        bool cpuHasPclmul() {
+            return false;
+        }
+
+
+        bool cpuHasAvx2() {
+            return false;
+        }
+
+    #endif
+}
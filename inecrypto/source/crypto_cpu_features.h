@@ -0,0 +1,70 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header provides functions used to detect processor features at run time.  The header is private to the
+* library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_CPU_FEATURES_H
+#define CRYPTO_CPU_FEATURES_H
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+    #define CRYPTO_X86 1
+
+    #if (defined(_MSC_VER) && !defined(__clang__))
+        #define CRYPTO_TARGET(_features)
+    #else
+        #define CRYPTO_TARGET(_features) __attribute__((target(_features)))
+    #endif
+#else
+    #define CRYPTO_X86 0
+    #define CRYPTO_TARGET(_features)
+#endif
+
+namespace Crypto {
+    /**
+     * Function that determines if the processor supports SSE2.
+     *
+     * \return Returns true if SSE2 instructions can be used.
+     */
+    bool cpuHasSse2();
+
+    /**
+     * Function that determines if the processor supports the AES instructions.
+     *
+     * \return Returns true if the AES instructions are supported.
+     */
+    bool cpuHasAes();
+
+    /**
+     * Function that determines if the processor supports the carry-less multiply instruction.
+     *
+     * \return Returns true if the PCLMULQDQ instruction is supported.
+     */
+    bool cpuHasPclmul();
+
+    /**
+     * Function that determines if the processor and operating system support AVX2.
+     *
+     * \return Returns true if AVX2 instructions can be used.
+     */
+    bool cpuHasAvx2();
+}
+
+#endif
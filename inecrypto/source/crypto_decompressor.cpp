@@ -0,0 +1,288 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::Decompressor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+#include <QByteArray>
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_compressor.h"
+#include "crypto_decompressor.h"
+
+namespace Crypto {
+    static_assert(Decompressor::blockHeaderLength == Compressor::blockHeaderLength, "Block header length mismatch.");
+    static_assert(Decompressor::maximumBlockSize == Compressor::maximumBlockSize, "Maximum block size mismatch.");
+
+    /**
+     * The length of the uncompressed size prefix qCompress places before the zlib stream.
+     */
+    static constexpr unsigned sizePrefixLength = 4;
+
+    static inline std::uint32_t fromBigEndian32(const std::uint8_t* data) {
+        return (
+              (static_cast<std::uint32_t>(data[0]) << 24)
+            | (static_cast<std::uint32_t>(data[1]) << 16)
+            | (static_cast<std::uint32_t>(data[2]) <<  8)
+            | (static_cast<std::uint32_t>(data[3])      )
+        );
+    }
+
+
+    Decompressor::Decompressor(QIODevice* parent):QIODevice(parent) {
+        currentBlockSizeLimit = maximumBlockSize;
+        currentInputDevice    = parent;
+        blockOffset           = 0;
+    }
+
+
+    Decompressor::Decompressor(QObject* parent):QIODevice(parent) {
+        currentBlockSizeLimit = maximumBlockSize;
+        currentInputDevice    = Q_NULLPTR;
+        blockOffset           = 0;
+    }
+
+
+    Decompressor::~Decompressor() {
+        close();
+    }
+
+
+    void Decompressor::setBlockSizeLimit(unsigned newBlockSizeLimit) {
+        currentBlockSizeLimit = std::min(std::max(newBlockSizeLimit, 1U), maximumBlockSize);
+    }
+
+
+    unsigned Decompressor::blockSizeLimit() const {
+        return currentBlockSizeLimit;
+    }
+
+
+    QByteArray Decompressor::decompress(const QByteArray& inputBuffer) {
+        const std::uint8_t* inputData   = reinterpret_cast<const std::uint8_t*>(inputBuffer.constData());
+        unsigned            inputLength = static_cast<unsigned>(inputBuffer.size());
+        unsigned            offset      = 0;
+        bool                ok          = true;
+        QByteArray          result;
+        QByteArray          block;
+
+        while (ok && offset < inputLength) {
+            unsigned payloadLength;
+            ok = (
+                   inputLength - offset >= blockHeaderLength
+                && decodeHeader(inputData + offset, payloadLength)
+                && payloadLength <= inputLength - offset - blockHeaderLength
+                && decodeBlock(inputData + offset, block)
+            );
+
+            if (ok) {
+                result.append(block);
+                offset += blockHeaderLength + payloadLength;
+            }
+        }
+
+        if (!ok) {
+            result.fill('\x00');
+            result.clear();
+
+            setErrorString(tr("Invalid compressed data."));
+        }
+
+        block.fill('\x00');
+        return result;
+    }
+
+
+    void Decompressor::setInputDevice(QIODevice* inputDevice) {
+        currentInputDevice = inputDevice;
+    }
+
+
+    QIODevice* Decompressor::inputDevice() const {
+        return currentInputDevice;
+    }
+
+
+    bool Decompressor::open(Decompressor::OpenMode openMode) {
+        bool result;
+
+        if (openMode != OpenModeFlag::ReadOnly) {
+            result = false;
+        } else if (currentInputDevice == Q_NULLPTR) {
+            setErrorString(tr("No input device."));
+            result = false;
+        } else {
+            frameData.clear();
+            currentBlock.clear();
+            blockOffset = 0;
+
+            result = QIODevice::open(openMode | OpenModeFlag::Unbuffered);
+        }
+
+        return result;
+    }
+
+
+    void Decompressor::close() {
+        frameData.fill('\x00');
+        frameData.clear();
+
+        currentBlock.fill('\x00');
+        currentBlock.clear();
+
+        blockOffset = 0;
+
+        QIODevice::close();
+    }
+
+
+    bool Decompressor::isSequential() const {
+        return true;
+    }
+
+
+    qint64 Decompressor::bytesAvailable() const {
+        return currentBlock.size() - blockOffset + QIODevice::bytesAvailable();
+    }
+
+
+    qint64 Decompressor::readData(char* data, qint64 maxSize) {
+        qint64 result    = 0;
+        bool   ok        = true;
+        bool   blockRead = true;
+
+        while (ok && blockRead && result < maxSize) {
+            if (blockOffset < currentBlock.size()) {
+                qint64 bytesToCopy = std::min(
+                    maxSize - result,
+                    static_cast<qint64>(currentBlock.size() - blockOffset)
+                );
+
+                std::memcpy(
+                    data + result,
+                    currentBlock.constData() + blockOffset,
+                    static_cast<std::size_t>(bytesToCopy)
+                );
+
+                result      += bytesToCopy;
+                blockOffset += static_cast<int>(bytesToCopy);
+            } else {
+                ok = readBlock(blockRead);
+            }
+        }
+
+        if (!ok && result == 0) {
+            result = -1;
+        }
+
+        return result;
+    }
+
+
+    qint64 Decompressor::writeData(const char* /* data */, qint64 /* maxSize */) {
+        return -1;
+    }
+
+
+    bool Decompressor::decodeHeader(const std::uint8_t* header, unsigned& payloadLength) const {
+        std::uint32_t headerValue = fromBigEndian32(header);
+        bool          stored      = (headerValue & Compressor::storedFlag) != 0;
+
+        payloadLength = headerValue & ~Compressor::storedFlag;
+
+        // The compressor only keeps compressed blocks that are smaller than the data they hold.
+        return (
+               payloadLength <= currentBlockSizeLimit
+            && (stored ? payloadLength > 0 : payloadLength > sizePrefixLength)
+        );
+    }
+
+
+    bool Decompressor::decodeBlock(const std::uint8_t* frame, QByteArray& output) const {
+        std::uint32_t       headerValue   = fromBigEndian32(frame);
+        unsigned            payloadLength = headerValue & ~Compressor::storedFlag;
+        const std::uint8_t* payload       = frame + blockHeaderLength;
+        bool                result;
+
+        if ((headerValue & Compressor::storedFlag) != 0) {
+            output = QByteArray(reinterpret_cast<const char*>(payload), static_cast<int>(payloadLength));
+            result = true;
+        } else {
+            // Check the decompressed size claimed by the block before qUncompress allocates space for it.
+            std::uint32_t decompressedLength = fromBigEndian32(payload);
+            if (decompressedLength > 0 && decompressedLength <= currentBlockSizeLimit) {
+                output = qUncompress(payload, static_cast<int>(payloadLength));
+                result = (static_cast<std::uint32_t>(output.size()) == decompressedLength);
+            } else {
+                result = false;
+            }
+        }
+
+        return result;
+    }
+
+
+    bool Decompressor::readBlock(bool& blockRead) {
+        bool     result        = true;
+        bool     dataReceived  = true;
+        unsigned payloadLength = 0;
+
+        blockRead = false;
+        while (result && !blockRead && dataReceived) {
+            unsigned frameBytes  = static_cast<unsigned>(frameData.size());
+            unsigned frameLength = blockHeaderLength;
+
+            const std::uint8_t* frame = reinterpret_cast<const std::uint8_t*>(frameData.constData());
+            if (frameBytes >= blockHeaderLength) {
+                result       = decodeHeader(frame, payloadLength);
+                frameLength += payloadLength;
+            }
+
+            if (result) {
+                if (frameBytes < frameLength) {
+                    QByteArray received = currentInputDevice->read(frameLength - frameBytes);
+
+                    dataReceived = !received.isEmpty();
+                    frameData.append(received);
+                } else {
+                    currentBlock.fill('\x00');
+
+                    result = decodeBlock(frame, currentBlock);
+                    if (result) {
+                        frameData.fill('\x00');
+                        frameData.resize(0);
+
+                        blockOffset = 0;
+                        blockRead   = true;
+                    }
+                }
+            }
+        }
+
+        if (!result) {
+            setErrorString(tr("Invalid compressed data."));
+        }
+
+        return result;
+    }
+}
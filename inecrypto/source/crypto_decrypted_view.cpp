@@ -0,0 +1,536 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::DecryptedView class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+#include <QByteArray>
+#include <QHash>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "crypto_segment_engine.h"
+#include "crypto_decrypted_view.h"
+
+namespace Crypto {
+    DecryptedView::DecryptedView(QIODevice* parent):QIODevice(parent) {
+        std::memset(initialKeys, 0, keyLength);
+
+        keysExpanded          = false;
+        currentCacheCapacity  = defaultCacheCapacity;
+        currentThreadPool     = Q_NULLPTR;
+        currentInputDevice    = parent;
+        currentInputData      = Q_NULLPTR;
+        currentInputLength    = 0;
+        currentPageSize       = 0;
+        currentDataLength     = 0;
+        currentNumberPages    = 0;
+        currentPosition       = 0;
+        currentPagesDecrypted = 0;
+        useCounter            = 0;
+    }
+
+
+    DecryptedView::DecryptedView(QObject* parent):QIODevice(parent) {
+        std::memset(initialKeys, 0, keyLength);
+
+        keysExpanded          = false;
+        currentCacheCapacity  = defaultCacheCapacity;
+        currentThreadPool     = Q_NULLPTR;
+        currentInputDevice    = Q_NULLPTR;
+        currentInputData      = Q_NULLPTR;
+        currentInputLength    = 0;
+        currentPageSize       = 0;
+        currentDataLength     = 0;
+        currentNumberPages    = 0;
+        currentPosition       = 0;
+        currentPagesDecrypted = 0;
+        useCounter            = 0;
+    }
+
+
+    DecryptedView::DecryptedView(const Keys& keys, QIODevice* parent):QIODevice(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+
+        keysExpanded          = false;
+        currentCacheCapacity  = defaultCacheCapacity;
+        currentThreadPool     = Q_NULLPTR;
+        currentInputDevice    = parent;
+        currentInputData      = Q_NULLPTR;
+        currentInputLength    = 0;
+        currentPageSize       = 0;
+        currentDataLength     = 0;
+        currentNumberPages    = 0;
+        currentPosition       = 0;
+        currentPagesDecrypted = 0;
+        useCounter            = 0;
+    }
+
+
+    DecryptedView::DecryptedView(const Keys& keys, QObject* parent):QIODevice(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+
+        keysExpanded          = false;
+        currentCacheCapacity  = defaultCacheCapacity;
+        currentThreadPool     = Q_NULLPTR;
+        currentInputDevice    = Q_NULLPTR;
+        currentInputData      = Q_NULLPTR;
+        currentInputLength    = 0;
+        currentPageSize       = 0;
+        currentDataLength     = 0;
+        currentNumberPages    = 0;
+        currentPosition       = 0;
+        currentPagesDecrypted = 0;
+        useCounter            = 0;
+    }
+
+
+    DecryptedView::~DecryptedView() {
+        std::memset(initialKeys, 0, keyLength);
+        clearCache();
+
+        engine()->scrub();
+    }
+
+
+    unsigned DecryptedView::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void DecryptedView::setKeys(const Keys& newKeys) {
+        std::memcpy(initialKeys, newKeys, keyLength);
+        keysExpanded = false;
+    }
+
+
+    void DecryptedView::setCacheCapacity(unsigned newCacheCapacity) {
+        unsigned newCapacity = std::max(newCacheCapacity, 1U);
+        if (newCapacity < pages.size()) {
+            clearCache();
+        }
+
+        currentCacheCapacity = newCapacity;
+    }
+
+
+    unsigned DecryptedView::cacheCapacity() const {
+        return currentCacheCapacity;
+    }
+
+
+    void DecryptedView::setThreadPool(QThreadPool* newThreadPool) {
+        currentThreadPool = newThreadPool;
+    }
+
+
+    QThreadPool* DecryptedView::threadPool() const {
+        return currentThreadPool;
+    }
+
+
+    unsigned DecryptedView::pageSize() const {
+        return currentPageSize;
+    }
+
+
+    unsigned long long DecryptedView::pagesDecrypted() const {
+        return currentPagesDecrypted;
+    }
+
+
+    void DecryptedView::setInputDevice(QIODevice* inputDevice) {
+        currentInputDevice = inputDevice;
+        currentInputData   = Q_NULLPTR;
+        currentInputLength = 0;
+    }
+
+
+    QIODevice* DecryptedView::inputDevice() const {
+        return currentInputDevice;
+    }
+
+
+    void DecryptedView::setInputData(const std::uint8_t* inputData, unsigned long long inputLength) {
+        currentInputDevice = Q_NULLPTR;
+        currentInputData   = inputData;
+        currentInputLength = inputLength;
+    }
+
+
+    qint64 DecryptedView::readAt(qint64 offset, char* data, qint64 length) {
+        qint64 result;
+
+        if (!isOpen() || offset < 0 || length < 0) {
+            result = -1;
+        } else {
+            unsigned long long startOffset = std::min(static_cast<unsigned long long>(offset), currentDataLength);
+            unsigned long long endOffset   = std::min(startOffset + static_cast<unsigned long long>(length),
+                                                      currentDataLength);
+            unsigned long long lastPage    = endOffset > 0 ? (endOffset - 1) / currentPageSize : 0;
+            unsigned long long position    = startOffset;
+            bool               ok          = true;
+
+            while (ok && position < endOffset) {
+                unsigned long long pageIndex = position / currentPageSize;
+                const Page*        page      = fetchPage(pageIndex, lastPage);
+
+                if (page != Q_NULLPTR) {
+                    unsigned long long pageOffset  = position - pageIndex * currentPageSize;
+                    unsigned long long bytesToCopy = std::min(
+                        static_cast<unsigned long long>(page->data.size()) - pageOffset,
+                        endOffset - position
+                    );
+
+                    std::memcpy(data + (position - startOffset), page->data.constData() + pageOffset, bytesToCopy);
+                    position += bytesToCopy;
+                } else {
+                    ok = false;
+                }
+            }
+
+            result = ok ? static_cast<qint64>(endOffset - startOffset) : -1;
+        }
+
+        return result;
+    }
+
+
+    QByteArray DecryptedView::readAt(qint64 offset, qint64 length) {
+        QByteArray result;
+
+        if (isOpen() && offset >= 0 && length > 0) {
+            unsigned long long available = currentDataLength - std::min(
+                static_cast<unsigned long long>(offset),
+                currentDataLength
+            );
+
+            result.resize(static_cast<int>(std::min(static_cast<unsigned long long>(length), available)));
+
+            qint64 bytesRead = readAt(offset, result.data(), result.size());
+            if (bytesRead < 0) {
+                result.fill('\x00');
+                result.clear();
+            }
+        }
+
+        return result;
+    }
+
+
+    bool DecryptedView::open(DecryptedView::OpenMode openMode) {
+        bool result;
+
+        clearCache();
+
+        if (openMode != OpenModeFlag::ReadOnly) {
+            result = false;
+        } else if (currentInputDevice == Q_NULLPTR && currentInputData == Q_NULLPTR) {
+            setErrorString(tr("No input device."));
+            result = false;
+        } else if (currentInputDevice != Q_NULLPTR                                            &&
+                   (currentInputDevice->isSequential() || !currentInputDevice->isReadable())    ) {
+            setErrorString(tr("The input device must be a readable, random access device."));
+            result = false;
+        } else {
+            unsigned long long containerLength = (
+                  currentInputData != Q_NULLPTR
+                ? currentInputLength
+                : static_cast<unsigned long long>(currentInputDevice->size())
+            );
+
+            const std::uint8_t* header = (
+                  containerLength >= SegmentEngine::headerLength
+                ? containerData(0, SegmentEngine::headerLength)
+                : Q_NULLPTR
+            );
+
+            expandKeys();
+
+            result = (
+                   header != Q_NULLPTR
+                && engine()->startDecryption(header)
+                && engine()->dataLength(containerLength, currentDataLength)
+            );
+
+            if (result) {
+                // Pages are decrypted lazily so a wrong key or a damaged page is reported by the read that touches
+                // it rather than by open.
+                currentPageSize       = engine()->segmentSize();
+                currentNumberPages    = engine()->numberSegments(currentDataLength, true);
+                currentPosition       = 0;
+                currentPagesDecrypted = 0;
+
+                result = QIODevice::open(openMode | OpenModeFlag::Unbuffered);
+            } else {
+                setErrorString(tr("Invalid container."));
+            }
+
+            if (!result) {
+                currentPageSize    = 0;
+                currentDataLength  = 0;
+                currentNumberPages = 0;
+            }
+        }
+
+        return result;
+    }
+
+
+    void DecryptedView::close() {
+        clearCache();
+        QIODevice::close();
+
+        encryptedData.clear();
+
+        currentPageSize    = 0;
+        currentDataLength  = 0;
+        currentNumberPages = 0;
+        currentPosition    = 0;
+    }
+
+
+    bool DecryptedView::isSequential() const {
+        return false;
+    }
+
+
+    qint64 DecryptedView::size() const {
+        return static_cast<qint64>(currentDataLength);
+    }
+
+
+    bool DecryptedView::seek(qint64 position) {
+        bool result = (
+               isOpen()
+            && position >= 0
+            && static_cast<unsigned long long>(position) <= currentDataLength
+            && QIODevice::seek(position)
+        );
+
+        if (result) {
+            currentPosition = static_cast<unsigned long long>(position);
+        }
+
+        return result;
+    }
+
+
+    qint64 DecryptedView::readData(char* data, qint64 maxSize) {
+        qint64 result = readAt(static_cast<qint64>(currentPosition), data, maxSize);
+        if (result > 0) {
+            currentPosition += static_cast<unsigned long long>(result);
+        }
+
+        return result;
+    }
+
+
+    qint64 DecryptedView::writeData(const char* /* data */, qint64 /* maxSize */) {
+        return -1;
+    }
+
+
+    const DecryptedView::Page* DecryptedView::fetchPage(unsigned long long pageIndex, unsigned long long lastPage) {
+        const Page* result = Q_NULLPTR;
+
+        if (!slotsByPage.contains(pageIndex)) {
+            // Gather the run of cold pages starting here so they are read and decrypted in a single pass.  The run
+            // is limited to the cache capacity so that no page in the run evicts another.
+            unsigned long long numberPages = 1;
+            while (numberPages < currentCacheCapacity                  &&
+                   pageIndex + numberPages <= lastPage                 &&
+                   !slotsByPage.contains(pageIndex + numberPages)         ) {
+                ++numberPages;
+            }
+
+            loadPages(pageIndex, numberPages);
+        }
+
+        if (slotsByPage.contains(pageIndex)) {
+            Page& page = pages[slotsByPage.value(pageIndex)];
+
+            page.lastUsed = ++useCounter;
+            result        = &page;
+        }
+
+        return result;
+    }
+
+
+    bool DecryptedView::loadPages(unsigned long long firstPage, unsigned long long numberPages) {
+        unsigned long long  pageSize        = currentPageSize;
+        bool                includesLast    = (firstPage + numberPages == currentNumberPages);
+        std::size_t         dataLength      = static_cast<std::size_t>(
+            std::min(numberPages * pageSize, currentDataLength - firstPage * pageSize)
+        );
+        std::size_t         encryptedLength = (
+            dataLength + static_cast<std::size_t>(numberPages) * SegmentEngine::tagLength
+        );
+        const std::uint8_t* encrypted       = containerData(
+            SegmentEngine::headerLength + firstPage * (pageSize + SegmentEngine::tagLength),
+            encryptedLength
+        );
+
+        bool result;
+        if (encrypted != Q_NULLPTR) {
+            // Slots are claimed before decrypting so that each page is decrypted straight into its cache slot.
+            runSlots.resize(static_cast<std::size_t>(numberPages));
+            runOutputs.resize(static_cast<std::size_t>(numberPages));
+
+            for (unsigned long long i=0 ; i<numberPages ; ++i) {
+                std::size_t pageOffset = static_cast<std::size_t>(i * pageSize);
+                std::size_t pageLength = std::min(static_cast<std::size_t>(pageSize), dataLength - pageOffset);
+                unsigned    slot       = allocateSlot();
+                Page&       page       = pages[slot];
+
+                page.index    = firstPage + i;
+                page.lastUsed = ++useCounter;
+                page.data.resize(static_cast<int>(pageLength));
+
+                runSlots[static_cast<std::size_t>(i)] = slot;
+            }
+
+            // Pointers are taken once every slot is claimed since claiming a slot can grow the slot vector.
+            for (unsigned long long i=0 ; i<numberPages ; ++i) {
+                Page& page = pages[runSlots[static_cast<std::size_t>(i)]];
+                runOutputs[static_cast<std::size_t>(i)] = reinterpret_cast<std::uint8_t*>(page.data.data());
+            }
+
+            result = engine()->decryptScattered(
+                currentThreadPool,
+                firstPage,
+                encrypted,
+                runOutputs.data(),
+                dataLength,
+                includesLast
+            );
+
+            for (unsigned long long i=0 ; i<numberPages ; ++i) {
+                unsigned slot = runSlots[static_cast<std::size_t>(i)];
+                Page&    page = pages[slot];
+
+                if (result) {
+                    slotsByPage.insert(page.index, slot);
+                } else {
+                    // Unverified plaintext is never cached.  The slot is left to be reused first.
+                    page.data.fill('\x00');
+                    page.data.clear();
+                    page.lastUsed = 0;
+                }
+            }
+
+            if (result) {
+                currentPagesDecrypted += numberPages;
+            } else {
+                setErrorString(tr("Authentication failed."));
+            }
+        } else {
+            setErrorString(tr("Could not read page."));
+            result = false;
+        }
+
+        return result;
+    }
+
+
+    unsigned DecryptedView::allocateSlot() {
+        unsigned result;
+
+        if (pages.size() < currentCacheCapacity) {
+            result = static_cast<unsigned>(pages.size());
+            pages.emplace_back();
+        } else {
+            // A linear scan for the least recently used page is cheap next to decrypting a page.
+            result = 0;
+            for (unsigned slot=1 ; slot<pages.size() ; ++slot) {
+                if (pages[slot].lastUsed < pages[result].lastUsed) {
+                    result = slot;
+                }
+            }
+
+            // A slot released by a failed run holds no page so its stale index must not drop another slot's entry.
+            Page& evicted = pages[result];
+
+            QHash<unsigned long long, unsigned>::iterator it = slotsByPage.find(evicted.index);
+            if (it != slotsByPage.end() && it.value() == result) {
+                slotsByPage.erase(it);
+            }
+
+            evicted.data.fill('\x00');
+        }
+
+        return result;
+    }
+
+
+    void DecryptedView::clearCache() {
+        for (Page& page : pages) {
+            page.data.fill('\x00');
+        }
+
+        pages.clear();
+        slotsByPage.clear();
+        runSlots.clear();
+        runOutputs.clear();
+
+        useCounter = 0;
+    }
+
+
+    const std::uint8_t* DecryptedView::containerData(unsigned long long offset, std::size_t length) {
+        const std::uint8_t* result = Q_NULLPTR;
+
+        if (currentInputData != Q_NULLPTR) {
+            if (offset <= currentInputLength && length <= currentInputLength - offset) {
+                result = currentInputData + offset;
+            }
+        } else {
+            encryptedData.resize(static_cast<int>(length));
+
+            bool ok = (
+                   currentInputDevice->seek(static_cast<qint64>(offset))
+                && currentInputDevice->read(encryptedData.data(), length) == static_cast<qint64>(length)
+            );
+
+            if (ok) {
+                result = reinterpret_cast<const std::uint8_t*>(encryptedData.constData());
+            }
+        }
+
+        return result;
+    }
+
+
+    void DecryptedView::expandKeys() {
+        static_assert(sizeof(SegmentEngine) <= engineStorageSize, "Insufficient segment engine storage.");
+
+        // The engine derives the container keys when it reads the header.  Passing in the supplied keys only when
+        // they change lets the engine skip the derivation and key expansion when the same container is reopened.
+        if (!keysExpanded) {
+            engine()->setKeys(initialKeys);
+            keysExpanded = true;
+        }
+    }
+}
@@ -24,12 +24,95 @@
 #include <QIODevice>
 #include <QObject>
 #include <QString>
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
+#include "crypto_helpers.h"
+#include "crypto_buffer_cursor.h"
 #include "crypto_decryptor.h"
 
 namespace Crypto {
+    /**
+     * Runnable that decrypts one segment of a buffer on a thread pool thread.
+     */
+    class Decryptor::SegmentTask:public QRunnable {
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]  decryptor        The decryptor holding the engine.
+             *
+             * \param[in]  chunkIndex       The index of the first chunk in the segment.
+             *
+             * \param[in]  previousChunk    Pointer to a copy of the encrypted chunk ahead of the segment.
+             *
+             * \param[in]  inputData        Pointer to the encrypted segment.
+             *
+             * \param[out] outputData       Pointer to the buffer to receive the decrypted segment.
+             *
+             * \param[in]  numberChunks     The number of chunks in the segment.
+             *
+             * \param[in]  segmentsFinished Semaphore released once the segment has been decrypted.
+             */
+            SegmentTask(
+                    Decryptor*          decryptor,
+                    unsigned long long  chunkIndex,
+                    const std::uint8_t* previousChunk,
+                    const std::uint8_t* inputData,
+                    std::uint8_t*       outputData,
+                    std::size_t         numberChunks,
+                    QSemaphore*         segmentsFinished
+                ):currentDecryptor(
+                    decryptor
+                ),currentChunkIndex(
+                    chunkIndex
+                ),currentPreviousChunk(
+                    previousChunk
+                ),currentInputData(
+                    inputData
+                ),currentOutputData(
+                    outputData
+                ),currentNumberChunks(
+                    numberChunks
+                ),currentSegmentsFinished(
+                    segmentsFinished
+                ) {}
+
+            ~SegmentTask() override {}
+
+            /**
+             * Method that is called on the thread pool thread to decrypt the segment.
+             */
+            void run() override {
+                currentDecryptor->decryptChunkRange(
+                    currentChunkIndex,
+                    currentPreviousChunk,
+                    currentInputData,
+                    currentOutputData,
+                    currentNumberChunks
+                );
+
+                currentSegmentsFinished->release();
+            }
+
+        private:
+            Decryptor*          currentDecryptor;
+            unsigned long long  currentChunkIndex;
+            const std::uint8_t* currentPreviousChunk;
+            const std::uint8_t* currentInputData;
+            std::uint8_t*       currentOutputData;
+            std::size_t         currentNumberChunks;
+            QSemaphore*         currentSegmentsFinished;
+    };
+
+
     Decryptor ::Decryptor(QIODevice* parent):QIODevice(parent) {
         configure(parent);
     }
@@ -44,34 +127,257 @@ namespace Crypto {
 
 
     QByteArray Decryptor::decrypt(const QByteArray& inputBuffer) {
-        unsigned long long  numberInputBytes = static_cast<unsigned long long>(inputBuffer.size());
-        const std::uint8_t* inputData        = reinterpret_cast<const std::uint8_t*>(inputBuffer.data());
+        std::size_t numberInputBytes = static_cast<std::size_t>(inputBuffer.size());
+        QByteArray  result;
+
+        if (numberInputBytes >= headerSize() + trailerSize()) {
+            result.resize(static_cast<int>(decryptedSize(numberInputBytes)));
+            std::size_t numberOutputBytes = decrypt(
+                reinterpret_cast<const std::uint8_t*>(inputBuffer.constData()),
+                numberInputBytes,
+                reinterpret_cast<std::uint8_t*>(result.data()),
+                static_cast<std::size_t>(result.size())
+            );
+
+            if (numberOutputBytes != static_cast<std::size_t>(result.size())) {
+                result.clear();
+            }
+        }
 
-        unsigned inputBufferAllocation  = inputChunkSize();
-        unsigned outputBufferAllocation = outputChunkSize();
+        return result;
+    }
 
-        unsigned long long  numberChunks      = numberInputBytes / inputBufferAllocation;
-        unsigned long long  numberOutputBytes = numberChunks * outputBufferAllocation;
 
-        QByteArray result(numberOutputBytes, '\x00');
+    std::size_t Decryptor::decrypt(
+            const std::uint8_t* inputData,
+            std::size_t         inputLength,
+            std::uint8_t*       outputData,
+            std::size_t         outputCapacity
+        ) {
+        unsigned    headerBytes       = headerSize();
+        unsigned    trailerBytes      = trailerSize();
+        std::size_t numberOutputBytes = decryptedSize(inputLength);
+        std::size_t result;
 
-        std::uint8_t*      outputData          = reinterpret_cast<std::uint8_t*>(result.data());
-        unsigned long long inputBytesRemaining = numberInputBytes;
+        if (inputLength >= headerBytes + trailerBytes && outputCapacity >= numberOutputBytes) {
+            unsigned    inChunkSize  = inputChunkSize();
+            std::size_t numberChunks = (inputLength - headerBytes - trailerBytes) / inChunkSize;
 
-        resetEngine();
-        while (inputBytesRemaining >= inputBufferAllocation) {
-            decryptChunk(inputData, outputData);
+            resetEngine();
+
+            if (headerBytes > 0) {
+                processHeader(inputData);
+                inputData += headerBytes;
+            }
+
+            decryptBuffer(inputData, outputData, numberChunks);
+
+            if (trailerBytes == 0 || processTrailer(inputData + numberChunks * inChunkSize)) {
+                result = numberOutputBytes;
+            } else {
+                std::memset(outputData, 0, numberOutputBytes);
+                setErrorString(tr("Authentication failed."));
+
+                result = 0;
+            }
+
+            finishEngine();
+        } else {
+            result = 0;
+        }
+
+        return result;
+    }
+
+
+    QByteArray Decryptor::decrypt(const QByteArrayList& inputBuffers) {
+        std::vector<ConstBuffer> buffers;
+        buffers.reserve(static_cast<std::size_t>(inputBuffers.size()));
+
+        for (const QByteArray& inputBuffer : inputBuffers) {
+            buffers.push_back(
+                ConstBuffer {
+                    reinterpret_cast<const std::uint8_t*>(inputBuffer.constData()),
+                    static_cast<std::size_t>(inputBuffer.size())
+                }
+            );
+        }
+
+        std::size_t numberInputBytes = totalLength(buffers.data(), buffers.size());
+        QByteArray  result;
+
+        if (numberInputBytes >= headerSize() + trailerSize()) {
+            result.resize(static_cast<int>(decryptedSize(numberInputBytes)));
+            std::size_t numberOutputBytes = decrypt(
+                buffers.data(),
+                buffers.size(),
+                reinterpret_cast<std::uint8_t*>(result.data()),
+                static_cast<std::size_t>(result.size())
+            );
+
+            if (numberOutputBytes != static_cast<std::size_t>(result.size())) {
+                result.clear();
+            }
+        }
+
+        return result;
+    }
+
+
+    std::size_t Decryptor::decrypt(
+            const ConstBuffer* inputBuffers,
+            std::size_t        numberInputBuffers,
+            std::uint8_t*      outputData,
+            std::size_t        outputCapacity
+        ) {
+        unsigned    headerBytes       = headerSize();
+        unsigned    trailerBytes      = trailerSize();
+        std::size_t inputLength       = totalLength(inputBuffers, numberInputBuffers);
+        std::size_t numberOutputBytes = decryptedSize(inputLength);
+        std::size_t result;
+
+        if (numberInputBuffers == 1) {
+            result = decrypt(inputBuffers[0].data, inputBuffers[0].length, outputData, outputCapacity);
+        } else if (inputLength >= headerBytes + trailerBytes && outputCapacity >= numberOutputBytes) {
+            unsigned      inChunkSize     = inputChunkSize();
+            unsigned      outChunkSize    = outputChunkSize();
+            std::size_t   numberChunks    = (inputLength - headerBytes - trailerBytes) / inChunkSize;
+            std::uint8_t* chunkOutputData = outputData;
+
+            // The header, the trailer and any chunk that straddles two buffers are gathered here.
+            QByteArray    scratch(static_cast<int>(std::max(std::max(headerBytes, trailerBytes), inChunkSize)), '\0');
+            std::uint8_t* scratchData = reinterpret_cast<std::uint8_t*>(scratch.data());
+
+            BufferCursor cursor(inputBuffers, numberInputBuffers);
+
+            resetEngine();
+
+            if (headerBytes > 0) {
+                cursor.gather(scratchData, headerBytes);
+                processHeader(scratchData);
+            }
+
+            std::size_t chunksRemaining = numberChunks;
+            while (chunksRemaining > 0) {
+                std::size_t contiguousChunks = std::min(cursor.contiguousLength() / inChunkSize, chunksRemaining);
+                if (contiguousChunks > 0) {
+                    decryptChunks(cursor.position(), chunkOutputData, contiguousChunks);
+                    cursor.advance(contiguousChunks * inChunkSize);
+
+                    chunkOutputData += contiguousChunks * outChunkSize;
+                    chunksRemaining -= contiguousChunks;
+                } else {
+                    cursor.gather(scratchData, inChunkSize);
+                    decryptChunk(scratchData, chunkOutputData);
+
+                    chunkOutputData += outChunkSize;
+                    --chunksRemaining;
+                }
+            }
+
+            bool trailerValid = true;
+            if (trailerBytes > 0) {
+                cursor.gather(scratchData, trailerBytes);
+                trailerValid = processTrailer(scratchData);
+            }
+
+            if (trailerValid) {
+                result = numberOutputBytes;
+            } else {
+                std::memset(outputData, 0, numberOutputBytes);
+                setErrorString(tr("Authentication failed."));
+
+                result = 0;
+            }
+
+            finishEngine();
+        } else {
+            result = 0;
+        }
+
+        return result;
+    }
+
+
+    std::size_t Decryptor::decryptInPlace(std::uint8_t* buffer, std::size_t inputLength) {
+        std::size_t result;
+
+        if (inputChunkSize() == outputChunkSize() && inputLength >= headerSize() + trailerSize()) {
+            unsigned    headerBytes       = headerSize();
+            unsigned    trailerBytes      = trailerSize();
+            std::size_t numberOutputBytes = decryptedSize(inputLength);
+
+            resetEngine();
+
+            if (headerBytes > 0) {
+                processHeader(buffer);
+            }
+
+            // Decrypt each chunk over itself and then slide the result down over the header.
+            std::size_t numberChunks = numberOutputBytes / inputChunkSize();
+            decryptBuffer(buffer + headerBytes, buffer + headerBytes, numberChunks);
+
+            if (trailerBytes == 0 || processTrailer(buffer + headerBytes + numberOutputBytes)) {
+                if (headerBytes > 0) {
+                    std::memmove(buffer, buffer + headerBytes, numberOutputBytes);
+                }
+
+                result = numberOutputBytes;
+            } else {
+                std::memset(buffer, 0, inputLength);
+                setErrorString(tr("Authentication failed."));
+
+                result = 0;
+            }
+
+            finishEngine();
+        } else {
+            result = 0;
+        }
+
+        return result;
+    }
 
-            inputData += inputBufferAllocation;
-            outputData += outputBufferAllocation;
 
-            inputBytesRemaining -= inputBufferAllocation;
+    std::size_t Decryptor::decryptedSize(std::size_t inputLength) const {
+        unsigned    overheadBytes = headerSize() + trailerSize();
+        std::size_t result;
+
+        if (inputLength >= overheadBytes) {
+            result = ((inputLength - overheadBytes) / inputChunkSize()) * outputChunkSize();
+        } else {
+            result = 0;
         }
 
         return result;
     }
 
 
+    void Decryptor::setThreadPool(QThreadPool* newThreadPool) {
+        currentThreadPool = newThreadPool;
+    }
+
+
+    QThreadPool* Decryptor::threadPool() const {
+        return currentThreadPool;
+    }
+
+
+    bool Decryptor::supportsParallelDecryption() const {
+        return false;
+    }
+
+
+    void Decryptor::setMaximumBufferedInput(qint64 newMaximumBufferedInput) {
+        currentMaximumBufferedInput = std::max(newMaximumBufferedInput, qint64(0));
+    }
+
+
+    qint64 Decryptor::maximumBufferedInput() const {
+        return currentMaximumBufferedInput;
+    }
+
+
     void Decryptor::setInputDevice(QIODevice* inputDevice) {
         if (currentInputDevice != Q_NULLPTR) {
             disconnect(currentInputDevice, &QIODevice::readyRead, this, &Decryptor::inputDataAvailable);
@@ -99,22 +405,33 @@ namespace Crypto {
 
 
     qint64 Decryptor::bytesAvailable() const {
-        unsigned long long inputBytesAvailable = static_cast<unsigned long long>(inputBuffer.size());
-        if (currentInputDevice != Q_NULLPTR) {
-            inputBytesAvailable += currentInputDevice->bytesAvailable();
-        }
+        qint64 result;
 
-        unsigned           inChunkSize       = inputChunkSize();
-        unsigned           outChunkSize      = outputChunkSize();
-        unsigned long long numberInputChunks = inputBytesAvailable / inChunkSize;
-        unsigned long long outputBufferBytes = outputBuffer.size() + outChunkSize * numberInputChunks;
+        if (isOpen() && randomAccessAvailable()) {
+            result = QIODevice::bytesAvailable();
+        } else {
+            unsigned long long inputBytesAvailable = static_cast<unsigned long long>(inputBuffer.size());
+            if (currentInputDevice != Q_NULLPTR) {
+                inputBytesAvailable += currentInputDevice->bytesAvailable();
+            }
+
+            unsigned pendingBytes = (headerPending ? headerSize() : 0) + (trailerPending ? trailerSize() : 0);
+            inputBytesAvailable = inputBytesAvailable > pendingBytes ? inputBytesAvailable - pendingBytes : 0;
 
-        return outputBufferBytes + QIODevice::bytesAvailable();
+            unsigned           inChunkSize       = inputChunkSize();
+            unsigned           outChunkSize      = outputChunkSize();
+            unsigned long long numberInputChunks = inputBytesAvailable / inChunkSize;
+            unsigned long long outputBufferBytes = outputBytesBuffered() + outChunkSize * numberInputChunks;
+
+            result = outputBufferBytes + QIODevice::bytesAvailable();
+        }
+
+        return result;
     }
 
 
     bool Decryptor::canReadLine() const {
-        return QIODevice::canReadLine() || outputBuffer.contains('\n');
+        return QIODevice::canReadLine() || newlineIndex >= 0;
     }
 
 
@@ -123,22 +440,179 @@ namespace Crypto {
 
         if (openMode == OpenModeFlag::ReadOnly) {
             resetEngine();
-            result = QIODevice::open(openMode);
+
+            if (randomAccessAvailable()) {
+                // We buffer decrypted data ourselves.  Leaving the QIODevice buffer out keeps the position of the
+                // input device in step with our position across seeks.
+                result = currentInputDevice->seek(0) && QIODevice::open(openMode | OpenModeFlag::Unbuffered);
+            } else {
+                result = QIODevice::open(openMode);
+            }
         } else {
             result = false;
         }
 
         if (result) {
+            // Output left from an earlier session belongs to a different position in the stream.  Input is only
+            // stale when we rewind the input device.  A sequential source may have delivered data ahead of the open.
+            if (randomAccessAvailable()) {
+                inputBuffer.clear();
+            }
+
+            discardOutput();
+
             currentNumberInputBytesProcessed  = 0;
             currentNumberOutputBytesProcessed = 0;
+            headerPending                     = (headerSize() > 0);
+            trailerPending                    = (trailerSize() > 0);
+            trailerValid                      = false;
+            dataFinished                      = false;
         }
 
         return result;
     }
 
 
+    void Decryptor::close() {
+        if (isOpen()) {
+            finishEngine();
+        }
+
+        inputBuffer.clear();
+        discardOutput();
+
+        QIODevice::close();
+    }
+
+
     bool Decryptor::isSequential() const {
-        return true;
+        return !randomAccessAvailable();
+    }
+
+
+    qint64 Decryptor::size() const {
+        qint64 result;
+
+        if (randomAccessAvailable()) {
+            result = static_cast<qint64>(decryptedSize(static_cast<std::size_t>(currentInputDevice->size())));
+        } else {
+            result = QIODevice::size();
+        }
+
+        return result;
+    }
+
+
+    bool Decryptor::seek(qint64 pos) {
+        bool result;
+
+        if (isOpen() && randomAccessAvailable()) {
+            if (pos >= 0 && pos <= size()) {
+                unsigned long long position     = static_cast<unsigned long long>(pos);
+                unsigned           headerBytes  = headerSize();
+                unsigned           inChunkSize  = inputChunkSize();
+                unsigned           outChunkSize = outputChunkSize();
+                unsigned long long chunkIndex   = position / outChunkSize;
+                unsigned           chunkOffset  = static_cast<unsigned>(position % outChunkSize);
+                unsigned long long chunkStart   = headerBytes + chunkIndex * inChunkSize;
+
+                // The header and the chunk ahead of the requested chunk are all the engine needs to pick up the stream.
+                QByteArray context(static_cast<int>(std::max(headerBytes, inChunkSize)), '\0');
+                std::uint8_t* contextData = reinterpret_cast<std::uint8_t*>(context.data());
+
+                resetEngine();
+
+                result = true;
+                if (headerBytes > 0) {
+                    result = readInputAt(0, contextData, headerBytes);
+                    if (result) {
+                        processHeader(contextData);
+                    }
+                }
+
+                if (result) {
+                    if (chunkIndex > 0) {
+                        result = (
+                               readInputAt(chunkStart - inChunkSize, contextData, inChunkSize)
+                            && seekEngine(chunkIndex, contextData)
+                        );
+                    } else {
+                        result = seekEngine(0, Q_NULLPTR);
+                    }
+                }
+
+                Crypto::scrub(context);
+                inputBuffer.clear();
+                discardOutput();
+
+                if (result) {
+                    result = currentInputDevice->seek(chunkStart);
+                }
+
+                if (result) {
+                    headerPending                     = false;
+                    dataFinished                      = false;
+                    sourceReportedError               = false;
+                    currentNumberInputBytesProcessed  = chunkStart;
+                    currentNumberOutputBytesProcessed = chunkIndex * outChunkSize;
+
+                    if (chunkOffset > 0) {
+                        // Decrypt the chunk holding the new position and drop the bytes ahead of it.
+                        QByteArray chunk(static_cast<int>(inChunkSize), '\0');
+                        outputBuffer.resize(static_cast<int>(outChunkSize));
+
+                        result = (
+                            currentInputDevice->read(chunk.data(), inChunkSize) == static_cast<qint64>(inChunkSize)
+                        );
+
+                        if (result) {
+                            decryptChunk(
+                                reinterpret_cast<const std::uint8_t*>(chunk.constData()),
+                                reinterpret_cast<std::uint8_t*>(outputBuffer.data())
+                            );
+
+                            outputBufferOffset = static_cast<int>(chunkOffset);
+                            newlineScanEnd     = outputBufferOffset;
+                            scanForNewline();
+
+                            currentNumberInputBytesProcessed  += inChunkSize;
+                            currentNumberOutputBytesProcessed += outChunkSize;
+                        } else {
+                            discardOutput();
+                        }
+                    }
+                }
+
+                if (result) {
+                    result = QIODevice::seek(pos);
+                }
+            } else {
+                result = false;
+            }
+
+            if (!result) {
+                setErrorString(tr("Could not seek to %1.").arg(pos));
+            }
+        } else {
+            result = QIODevice::seek(pos);
+        }
+
+        return result;
+    }
+
+
+    void Decryptor::setRandomAccessEnabled(bool nowEnabled) {
+        randomAccess = nowEnabled;
+    }
+
+
+    bool Decryptor::randomAccessEnabled() const {
+        return randomAccess;
+    }
+
+
+    bool Decryptor::supportsRandomAccess() const {
+        return false;
     }
 
 
@@ -147,6 +621,21 @@ namespace Crypto {
     }
 
 
+    unsigned Decryptor::headerSize() const {
+        return 0;
+    }
+
+
+    unsigned Decryptor::trailerSize() const {
+        return 0;
+    }
+
+
+    bool Decryptor::trailerVerified() const {
+        return trailerValid;
+    }
+
+
     unsigned long long Decryptor::numberInputBytesProcessed() const {
         return currentNumberInputBytesProcessed;
     }
@@ -160,6 +649,10 @@ namespace Crypto {
     void Decryptor::processData(const QByteArray& data) {
         if (!data.isEmpty()) {
             inputBuffer.append(data);
+            if (currentMaximumBufferedInput > 0 && isOpen()) {
+                decryptPendingInput();
+            }
+
             emit readyRead();
         }
     }
@@ -170,12 +663,68 @@ namespace Crypto {
 
         if (!sourceReportedError) {
             unsigned long long bytesRead;
-            readAvailableData(bytesRead);
+            bool               success;
+
+            if (currentMaximumBufferedInput > 0 && !randomAccessAvailable()) {
+                success = fillToLimit();
+            } else if (randomAccessAvailable()) {
+                // Only pull in enough input to satisfy this request so reads cost O(requested bytes).
+                unsigned long long inChunkSize    = inputChunkSize();
+                unsigned long long outChunkSize   = outputChunkSize();
+                unsigned long long bufferedOutput = static_cast<unsigned long long>(outputBytesBuffered());
+                unsigned long long bufferedInput  = static_cast<unsigned long long>(inputBuffer.size());
+                unsigned long long requested      = static_cast<unsigned long long>(maxSize);
+                unsigned long long neededOutput   = requested > bufferedOutput ? requested - bufferedOutput : 0;
+                unsigned long long neededInput    = (
+                      ((neededOutput + outChunkSize - 1) / outChunkSize) * inChunkSize
+                    + (headerPending ? headerSize() : 0)
+                );
+
+                readAvailableData(bytesRead, neededInput > bufferedInput ? neededInput - bufferedInput : 0);
+                success = decryptPendingInput();
+            } else {
+                readAvailableData(bytesRead);
+                success = decryptPendingInput();
+            }
+
+            if (success) {
+                result = std::min(maxSize, static_cast<qint64>(outputBytesBuffered()));
+                consumeOutput(data, static_cast<int>(result));
+            } else {
+                result = -1;
+            }
+        } else {
+            result = -1;
+        }
+
+        return result;
+    }
 
+
+    bool Decryptor::decryptPendingInput() {
+        bool success = true;
+
+        if (!sourceReportedError) {
+            if (headerPending) {
+                unsigned headerBytes = headerSize();
+                if (static_cast<unsigned>(inputBuffer.size()) >= headerBytes) {
+                    processHeader(reinterpret_cast<const std::uint8_t*>(inputBuffer.constData()));
+                    inputBuffer.remove(0, headerBytes);
+
+                    currentNumberInputBytesProcessed += headerBytes;
+                    headerPending = false;
+                }
+            }
+
+            // Any trailer is held back until we know where the input ends.
+            unsigned           trailerBytes      = trailerPending ? trailerSize() : 0;
             unsigned long long numberInputBytes  = static_cast<unsigned long long>(inputBuffer.size());
+            unsigned long long availableBytes    = (
+                numberInputBytes > trailerBytes ? numberInputBytes - trailerBytes : 0
+            );
             unsigned           inChunkSize       = inputChunkSize();
             unsigned           outChunkSize      = outputChunkSize();
-            unsigned long long numberChunks      = numberInputBytes / inChunkSize;
+            unsigned long long numberChunks      = headerPending ? 0 : availableBytes / inChunkSize;
             unsigned long long numberNewBytes    = numberChunks * outChunkSize;
             unsigned long long currentOutputSize = static_cast<unsigned long long>(outputBuffer.size());
 
@@ -183,25 +732,76 @@ namespace Crypto {
             std::uint8_t*       d = reinterpret_cast<std::uint8_t*>(outputBuffer.data() + currentOutputSize);
             const std::uint8_t* s = reinterpret_cast<std::uint8_t*>(inputBuffer.data());
 
-            for (unsigned chunk=0 ; chunk<numberChunks ; ++chunk) {
-                decryptChunk(s, d);
-                s += inChunkSize;
-                d += outChunkSize;
+            if (numberChunks > 0) {
+                decryptChunks(s, d, numberChunks);
+                scanForNewline();
 
-                currentNumberInputBytesProcessed  += inChunkSize;
-                currentNumberOutputBytesProcessed += outChunkSize;
+                currentNumberInputBytesProcessed  += numberChunks * inChunkSize;
+                currentNumberOutputBytesProcessed += numberNewBytes;
             }
 
-            result = std::min(maxSize, static_cast<qint64>(outputBuffer.size()));
-            std::memcpy(data, outputBuffer.data(), result);
+            inputBuffer = inputBuffer.mid(numberChunks * inChunkSize);
+
+            if (!headerPending && !trailerValid && inputFinished()) {
+                unsigned long long remainingBytes = static_cast<unsigned long long>(inputBuffer.size());
+                if (remainingBytes < trailerBytes + inChunkSize) {
+                    const std::uint8_t* trailer = reinterpret_cast<const std::uint8_t*>(inputBuffer.constData());
+                    if (trailerBytes == 0) {
+                        trailerValid = true;
+                    } else if (remainingBytes == trailerBytes && processTrailer(trailer)) {
+                        currentNumberInputBytesProcessed += trailerBytes;
+                        inputBuffer.clear();
+
+                        trailerPending = false;
+                        trailerValid   = true;
+                    } else {
+                        setErrorString(tr("Authentication failed."));
+                        sourceReportedError = true;
+                        success             = false;
+                    }
+                }
+            }
 
-            inputBuffer  = inputBuffer.mid(numberChunks * inChunkSize);
-            outputBuffer = outputBuffer.mid(result);
+            if (!success) {
+                discardOutput();
+            }
         } else {
-            result = -1;
+            success = false;
         }
 
-        return result;
+        return success;
+    }
+
+
+    bool Decryptor::fillToLimit() {
+        bool               success       = decryptPendingInput();
+        unsigned long long bytesRead     = 1;
+        unsigned long long limit         = static_cast<unsigned long long>(currentMaximumBufferedInput);
+        unsigned long long bufferedBytes = static_cast<unsigned long long>(inputBuffer.size() + outputBytesBuffered());
+
+        // Reading in batches and decrypting each batch right away keeps the ciphertext buffer small.  Whatever we do
+        // not read stays with the input device.
+        while (success && bytesRead > 0 && bufferedBytes < limit) {
+            unsigned long long batchSize = std::min(
+                static_cast<unsigned long long>(decryptionBatchSize),
+                limit - bufferedBytes
+            );
+
+            success = readAvailableData(bytesRead, batchSize) || bytesRead == 0;
+            if (success && bytesRead > 0) {
+                success = decryptPendingInput();
+            }
+
+            bufferedBytes = static_cast<unsigned long long>(inputBuffer.size() + outputBytesBuffered());
+        }
+
+        return success && !sourceReportedError;
+    }
+
+
+    void Decryptor::finishData() {
+        dataFinished = true;
+        emit readyRead();
     }
 
 
@@ -211,14 +811,66 @@ namespace Crypto {
 
 
     void Decryptor::inputDataAvailable() {
-        unsigned long long bytesRead = 0;
-        readAvailableData(bytesRead);
+        if (currentMaximumBufferedInput > 0 && isOpen() && !randomAccessAvailable()) {
+            int  previousOutputSize = outputBytesBuffered();
+            bool success            = fillToLimit();
 
-        if (bytesRead > 0) {
-            unsigned long long inputBufferSize = static_cast<unsigned long long>(inputBuffer.size());
-            if (inputBufferSize >= inputChunkSize()) {
+            if (!success || outputBytesBuffered() > previousOutputSize) {
                 emit readyRead();
             }
+        } else {
+            unsigned long long bytesRead = 0;
+            readAvailableData(bytesRead);
+
+            if (bytesRead > 0) {
+                unsigned long long inputBufferSize = static_cast<unsigned long long>(inputBuffer.size());
+                unsigned long long minimumSize     = (
+                      inputChunkSize()
+                    + (headerPending ? headerSize() : 0)
+                    + (trailerPending ? trailerSize() : 0)
+                );
+                if (inputBufferSize >= minimumSize) {
+                    emit readyRead();
+                }
+            }
+        }
+    }
+
+
+    void Decryptor::processHeader(const std::uint8_t* /* headerData */) {}
+
+
+    bool Decryptor::processTrailer(const std::uint8_t* /* trailerData */) {
+        return true;
+    }
+
+
+    void Decryptor::finishEngine() {}
+
+
+    bool Decryptor::seekEngine(unsigned long long /* chunkIndex */, const std::uint8_t* /* previousChunk */) {
+        return false;
+    }
+
+
+    void Decryptor::decryptChunkRange(
+            unsigned long long  /* chunkIndex */,
+            const std::uint8_t* /* previousChunk */,
+            const std::uint8_t* /* inputData */,
+            std::uint8_t*       /* outputData */,
+            std::size_t         /* numberChunks */
+        ) {}
+
+
+    void Decryptor::decryptChunks(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t numberChunks) {
+        unsigned inChunkSize  = inputChunkSize();
+        unsigned outChunkSize = outputChunkSize();
+
+        for (std::size_t chunk=0 ; chunk<numberChunks ; ++chunk) {
+            decryptChunk(inputData, outputData);
+
+            inputData  += inChunkSize;
+            outputData += outChunkSize;
         }
     }
 
@@ -226,16 +878,181 @@ namespace Crypto {
     void Decryptor::configure(QIODevice* inputDevice) {
         currentInputDevice                = inputDevice;
         sourceReportedError               = false;
+        headerPending                     = false;
+        trailerPending                    = false;
+        trailerValid                      = false;
+        dataFinished                      = false;
+        randomAccess                      = false;
+        currentThreadPool                 = Q_NULLPTR;
+        currentMaximumBufferedInput       = 0;
+        outputBufferOffset                = 0;
+        newlineIndex                      = -1;
+        newlineScanEnd                    = 0;
         currentNumberInputBytesProcessed  = static_cast<unsigned long long>(-1);
         currentNumberOutputBytesProcessed = static_cast<unsigned long long>(-1);
     }
 
 
-    bool Decryptor::readAvailableData(unsigned long long& bytesRead) {
+    int Decryptor::outputBytesBuffered() const {
+        return outputBuffer.size() - outputBufferOffset;
+    }
+
+
+    void Decryptor::consumeOutput(char* data, int length) {
+        std::memcpy(data, outputBuffer.constData() + outputBufferOffset, static_cast<std::size_t>(length));
+        outputBufferOffset += length;
+
+        if (outputBufferOffset == outputBuffer.size()) {
+            outputBuffer.clear();
+            outputBufferOffset = 0;
+            newlineIndex       = -1;
+            newlineScanEnd     = 0;
+        } else {
+            if (newlineIndex >= 0 && newlineIndex < outputBufferOffset) {
+                newlineIndex   = -1;
+                newlineScanEnd = std::max(newlineScanEnd, outputBufferOffset);
+                scanForNewline();
+            }
+
+            // Dropping the consumed bytes only once they make up half the buffer keeps the cost of each move
+            // proportional to the data already read.
+            if (outputBufferOffset >= minimumCompactionSize && outputBufferOffset * 2 >= outputBuffer.size()) {
+                outputBuffer.remove(0, outputBufferOffset);
+
+                if (newlineIndex >= 0) {
+                    newlineIndex -= outputBufferOffset;
+                }
+
+                newlineScanEnd     -= outputBufferOffset;
+                outputBufferOffset  = 0;
+            }
+        }
+    }
+
+
+    void Decryptor::discardOutput() {
+        Crypto::scrub(outputBuffer);
+        outputBuffer.clear();
+
+        outputBufferOffset = 0;
+        newlineIndex       = -1;
+        newlineScanEnd     = 0;
+    }
+
+
+    void Decryptor::scanForNewline() {
+        if (newlineIndex < 0 && newlineScanEnd < outputBuffer.size()) {
+            const char* start   = outputBuffer.constData() + newlineScanEnd;
+            std::size_t length  = static_cast<std::size_t>(outputBuffer.size() - newlineScanEnd);
+            const void* newline = std::memchr(start, '\n', length);
+
+            if (newline != Q_NULLPTR) {
+                newlineIndex   = newlineScanEnd + static_cast<int>(static_cast<const char*>(newline) - start);
+                newlineScanEnd = newlineIndex + 1;
+            } else {
+                newlineScanEnd = outputBuffer.size();
+            }
+        }
+    }
+
+
+    bool Decryptor::inputFinished() const {
+        bool result;
+
+        if (dataFinished) {
+            result = true;
+        } else if (currentInputDevice != Q_NULLPTR) {
+            result = (
+                   !currentInputDevice->isOpen()
+                || (!currentInputDevice->isSequential() && currentInputDevice->atEnd())
+            );
+        } else {
+            result = false;
+        }
+
+        return result;
+    }
+
+
+    void Decryptor::decryptBuffer(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t numberChunks) {
+        unsigned    inChunkSize    = inputChunkSize();
+        unsigned    outChunkSize   = outputChunkSize();
+        std::size_t numberSegments = 1;
+
+        if (currentThreadPool != Q_NULLPTR && supportsParallelDecryption()) {
+            // The calling thread decrypts the first segment so we can use one more segment than there are threads.
+            int         maximumThreads  = std::max(currentThreadPool->maxThreadCount(), 0);
+            std::size_t maximumSegments = static_cast<std::size_t>(maximumThreads) + 1;
+            numberSegments = std::min(maximumSegments, numberChunks * inChunkSize / minimumParallelSegmentSize);
+        }
+
+        if (numberSegments > 1) {
+            // The chunk ahead of each segment is copied up front.  When decrypting in place, the neighbouring segment
+            // would otherwise overwrite it before it is used.
+            QByteArray    previousChunks(static_cast<int>((numberSegments - 1) * inChunkSize), '\0');
+            std::uint8_t* previousChunk = reinterpret_cast<std::uint8_t*>(previousChunks.data());
+
+            for (std::size_t segment=1 ; segment<numberSegments ; ++segment) {
+                std::size_t firstChunk = segment * numberChunks / numberSegments;
+                std::memcpy(
+                    previousChunk + (segment - 1) * inChunkSize,
+                    inputData + (firstChunk - 1) * inChunkSize,
+                    inChunkSize
+                );
+            }
+
+            QSemaphore segmentsFinished;
+            for (std::size_t segment=1 ; segment<numberSegments ; ++segment) {
+                std::size_t firstChunk = segment * numberChunks / numberSegments;
+                std::size_t lastChunk  = (segment + 1) * numberChunks / numberSegments;
+
+                currentThreadPool->start(
+                    new SegmentTask(
+                        this,
+                        firstChunk,
+                        previousChunk + (segment - 1) * inChunkSize,
+                        inputData + firstChunk * inChunkSize,
+                        outputData + firstChunk * outChunkSize,
+                        lastChunk - firstChunk,
+                        &segmentsFinished
+                    )
+                );
+            }
+
+            decryptChunkRange(0, Q_NULLPTR, inputData, outputData, numberChunks / numberSegments);
+            segmentsFinished.acquire(static_cast<int>(numberSegments - 1));
+        } else if (numberChunks > 0) {
+            decryptChunks(inputData, outputData, numberChunks);
+        }
+    }
+
+
+    bool Decryptor::readInputAt(unsigned long long offset, std::uint8_t* buffer, unsigned length) {
+        return (
+               currentInputDevice->seek(static_cast<qint64>(offset))
+            && currentInputDevice->read(reinterpret_cast<char*>(buffer), length) == static_cast<qint64>(length)
+        );
+    }
+
+
+    bool Decryptor::randomAccessAvailable() const {
+        return (
+               randomAccess
+            && currentInputDevice != Q_NULLPTR
+            && !currentInputDevice->isSequential()
+            && supportsRandomAccess()
+        );
+    }
+
+
+    bool Decryptor::readAvailableData(unsigned long long& bytesRead, unsigned long long maximumBytes) {
         bool success = false;
 
         if (currentInputDevice != Q_NULLPTR) {
-            unsigned long long bytesToRead = static_cast<unsigned long long>(currentInputDevice->bytesAvailable());
+            unsigned long long bytesToRead = std::min(
+                static_cast<unsigned long long>(currentInputDevice->bytesAvailable()),
+                maximumBytes
+            );
             if (bytesToRead > 0) {
                 unsigned long long receiveBufferSize = static_cast<unsigned long long>(inputBuffer.size());
 
@@ -0,0 +1,260 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::DerivedKeyCache class.
+***********************************************************************************************************************/
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+
+#include <cstring>
+
+#include "crypto_helpers.h"
+#include "crypto_hmac_sha256.h"
+#include "crypto_kdf.h"
+#include "crypto_derived_key_cache.h"
+
+namespace Crypto {
+    /**
+     * Value identifying PBKDF2 in a lookup key.
+     */
+    static constexpr std::uint8_t pbkdf2Function = 1;
+
+    /**
+     * Value identifying HKDF in a lookup key.
+     */
+    static constexpr std::uint8_t hkdfFunction = 2;
+
+    /**
+     * Function that appends a 64-bit big endian value to a byte array.
+     *
+     * \param[in,out] array The array to append to.
+     *
+     * \param[in]     value The value to be appended.
+     */
+    static void appendValue(QByteArray& array, unsigned long long value) {
+        for (unsigned i=0 ; i<8 ; ++i) {
+            array.append(static_cast<char>(value >> (56 - 8 * i)));
+        }
+    }
+
+    /**
+     * Function that adds a length prefixed buffer to an HMAC so adjacent fields can not be confused.
+     *
+     * \param[in,out] hmac The HMAC to add the buffer to.
+     *
+     * \param[in]     data The buffer to be added.
+     */
+    static void addField(HmacSha256& hmac, const QByteArray& data) {
+        QByteArray length;
+        appendValue(length, static_cast<unsigned long long>(data.size()));
+
+        hmac.addData(
+            reinterpret_cast<const std::uint8_t*>(length.constData()),
+            static_cast<std::size_t>(length.size())
+        );
+
+        hmac.addData(
+            reinterpret_cast<const std::uint8_t*>(data.constData()),
+            static_cast<std::size_t>(data.size())
+        );
+    }
+
+
+    DerivedKeyCache::DerivedKeyCache(unsigned capacity) {
+        std::uint32_t randomSecret[secretLength / sizeof(std::uint32_t)];
+        QRandomGenerator::system()->fillRange(randomSecret);
+
+        std::memcpy(secret, randomSecret, secretLength);
+        std::memset(randomSecret, 0, secretLength);
+
+        currentCapacity = capacity;
+        useCounter      = 0;
+    }
+
+
+    DerivedKeyCache::~DerivedKeyCache() {
+        clear();
+        std::memset(secret, 0, secretLength);
+    }
+
+
+    void DerivedKeyCache::setCapacity(unsigned newCapacity) {
+        QMutexLocker locker(&mutex);
+
+        currentCapacity = newCapacity;
+        evict(currentCapacity);
+    }
+
+
+    unsigned DerivedKeyCache::capacity() const {
+        QMutexLocker locker(&mutex);
+        return currentCapacity;
+    }
+
+
+    unsigned DerivedKeyCache::size() const {
+        QMutexLocker locker(&mutex);
+        return static_cast<unsigned>(entries.size());
+    }
+
+
+    void DerivedKeyCache::clear() {
+        QMutexLocker locker(&mutex);
+        evict(0);
+    }
+
+
+    QByteArray DerivedKeyCache::pbkdf2(
+            const QByteArray& password,
+            const QByteArray& salt,
+            unsigned long     iterations,
+            unsigned          keyLength
+        ) {
+        QByteArray result;
+
+        if (iterations > 0) {
+            QByteArray parameters;
+            appendValue(parameters, iterations);
+            appendValue(parameters, keyLength);
+
+            QByteArray lookup = lookupKey(pbkdf2Function, password, salt, parameters);
+            if (!find(lookup, result)) {
+                // The key is derived without holding the lock so other threads are not held up by a slow derivation.
+                result.resize(static_cast<int>(keyLength));
+                Kdf::pbkdf2(
+                    reinterpret_cast<const std::uint8_t*>(password.constData()),
+                    static_cast<std::size_t>(password.size()),
+                    reinterpret_cast<const std::uint8_t*>(salt.constData()),
+                    static_cast<std::size_t>(salt.size()),
+                    iterations,
+                    reinterpret_cast<std::uint8_t*>(result.data()),
+                    keyLength
+                );
+
+                insert(lookup, result);
+            }
+        }
+
+        return result;
+    }
+
+
+    QByteArray DerivedKeyCache::hkdf(
+            const QByteArray& inputKey,
+            const QByteArray& salt,
+            const QByteArray& info,
+            unsigned          keyLength
+        ) {
+        QByteArray result;
+
+        if (keyLength <= Kdf::maximumHkdfLength) {
+            QByteArray parameters;
+            appendValue(parameters, keyLength);
+            parameters.append(info);
+
+            QByteArray lookup = lookupKey(hkdfFunction, inputKey, salt, parameters);
+            if (!find(lookup, result)) {
+                result.resize(static_cast<int>(keyLength));
+                Kdf::hkdf(
+                    reinterpret_cast<const std::uint8_t*>(salt.constData()),
+                    static_cast<std::size_t>(salt.size()),
+                    reinterpret_cast<const std::uint8_t*>(inputKey.constData()),
+                    static_cast<std::size_t>(inputKey.size()),
+                    reinterpret_cast<const std::uint8_t*>(info.constData()),
+                    static_cast<std::size_t>(info.size()),
+                    reinterpret_cast<std::uint8_t*>(result.data()),
+                    keyLength
+                );
+
+                insert(lookup, result);
+            }
+        }
+
+        return result;
+    }
+
+
+    QByteArray DerivedKeyCache::lookupKey(
+            std::uint8_t      function,
+            const QByteArray& secretInput,
+            const QByteArray& salt,
+            const QByteArray& parameters
+        ) const {
+        HmacSha256 hmac(secret, secretLength);
+        hmac.addData(&function, 1);
+
+        addField(hmac, secretInput);
+        addField(hmac, salt);
+        addField(hmac, parameters);
+
+        QByteArray result(static_cast<int>(HmacSha256::digestSize), '\0');
+        hmac.result(reinterpret_cast<std::uint8_t*>(result.data()));
+
+        return result;
+    }
+
+
+    bool DerivedKeyCache::find(const QByteArray& lookup, QByteArray& key) {
+        QMutexLocker locker(&mutex);
+
+        bool                               result   = false;
+        QHash<QByteArray, Entry>::iterator position = entries.find(lookup);
+        if (position != entries.end()) {
+            position->lastUsed = ++useCounter;
+            key                = position->key;
+            result             = true;
+        }
+
+        return result;
+    }
+
+
+    void DerivedKeyCache::insert(const QByteArray& lookup, const QByteArray& key) {
+        QMutexLocker locker(&mutex);
+
+        if (currentCapacity > 0 && !entries.contains(lookup)) {
+            evict(currentCapacity - 1);
+
+            Entry entry;
+            entry.key      = key;
+            entry.lastUsed = ++useCounter;
+
+            entries.insert(lookup, entry);
+        }
+    }
+
+
+    void DerivedKeyCache::evict(unsigned maximumEntries) {
+        while (static_cast<unsigned>(entries.size()) > maximumEntries) {
+            QHash<QByteArray, Entry>::iterator oldest = entries.begin();
+            for (QHash<QByteArray, Entry>::iterator it=entries.begin() ; it!=entries.end() ; ++it) {
+                if (it->lastUsed < oldest->lastUsed) {
+                    oldest = it;
+                }
+            }
+
+            Crypto::scrub(oldest->key);
+            entries.erase(oldest);
+        }
+    }
+}
@@ -0,0 +1,614 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::EncryptedChannel class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_aes_gcm_engine.h"
+#include "crypto_encrypted_channel.h"
+
+namespace Crypto {
+    /**
+     * The magic value at the start of the hello.
+     */
+    static const char channelMagic[] = { 'I', 'E', 'C', '\x01' };
+
+    EncryptedChannel::EncryptedChannel(QIODevice* parent):QIODevice(parent) {
+        std::memset(initialSendKeys, 0, keyLength);
+        std::memset(initialReceiveKeys, 0, keyLength);
+        std::memset(sendIV, 0, ivLength);
+        std::memset(receiveIV, 0, ivLength);
+
+        keysExpanded        = false;
+        currentDevice       = parent;
+        currentRecordSize   = defaultRecordSize;
+        sendRecordNumber    = 0;
+        receiveRecordNumber = 0;
+        helloReceived       = false;
+        flushPosted         = false;
+        failed              = false;
+        readOffset          = 0;
+        readEnd             = 0;
+        recordOffset        = 0;
+        decryptedEnd        = 0;
+        availablePlaintext  = 0;
+    }
+
+
+    EncryptedChannel::EncryptedChannel(QObject* parent):QIODevice(parent) {
+        std::memset(initialSendKeys, 0, keyLength);
+        std::memset(initialReceiveKeys, 0, keyLength);
+        std::memset(sendIV, 0, ivLength);
+        std::memset(receiveIV, 0, ivLength);
+
+        keysExpanded        = false;
+        currentDevice       = Q_NULLPTR;
+        currentRecordSize   = defaultRecordSize;
+        sendRecordNumber    = 0;
+        receiveRecordNumber = 0;
+        helloReceived       = false;
+        flushPosted         = false;
+        failed              = false;
+        readOffset          = 0;
+        readEnd             = 0;
+        recordOffset        = 0;
+        decryptedEnd        = 0;
+        availablePlaintext  = 0;
+    }
+
+
+    EncryptedChannel::EncryptedChannel(
+            const EncryptedChannel::Keys& sendKeys,
+            const EncryptedChannel::Keys& receiveKeys,
+            QIODevice*                    parent
+        ):QIODevice(
+            parent
+        ) {
+        std::memcpy(initialSendKeys, sendKeys, keyLength);
+        std::memcpy(initialReceiveKeys, receiveKeys, keyLength);
+        std::memset(sendIV, 0, ivLength);
+        std::memset(receiveIV, 0, ivLength);
+
+        keysExpanded        = false;
+        currentDevice       = parent;
+        currentRecordSize   = defaultRecordSize;
+        sendRecordNumber    = 0;
+        receiveRecordNumber = 0;
+        helloReceived       = false;
+        flushPosted         = false;
+        failed              = false;
+        readOffset          = 0;
+        readEnd             = 0;
+        recordOffset        = 0;
+        decryptedEnd        = 0;
+        availablePlaintext  = 0;
+    }
+
+
+    EncryptedChannel::EncryptedChannel(
+            const EncryptedChannel::Keys& sendKeys,
+            const EncryptedChannel::Keys& receiveKeys,
+            QObject*                      parent
+        ):QIODevice(
+            parent
+        ) {
+        std::memcpy(initialSendKeys, sendKeys, keyLength);
+        std::memcpy(initialReceiveKeys, receiveKeys, keyLength);
+        std::memset(sendIV, 0, ivLength);
+        std::memset(receiveIV, 0, ivLength);
+
+        keysExpanded        = false;
+        currentDevice       = Q_NULLPTR;
+        currentRecordSize   = defaultRecordSize;
+        sendRecordNumber    = 0;
+        receiveRecordNumber = 0;
+        helloReceived       = false;
+        flushPosted         = false;
+        failed              = false;
+        readOffset          = 0;
+        readEnd             = 0;
+        recordOffset        = 0;
+        decryptedEnd        = 0;
+        availablePlaintext  = 0;
+    }
+
+
+    EncryptedChannel::~EncryptedChannel() {
+        if (isOpen()) {
+            close();
+        }
+
+        std::memset(initialSendKeys, 0, keyLength);
+        std::memset(initialReceiveKeys, 0, keyLength);
+
+        sendEngine()->scrub();
+        receiveEngine()->scrub();
+    }
+
+
+    unsigned EncryptedChannel::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void EncryptedChannel::setKeys(const Keys& newSendKeys, const Keys& newReceiveKeys) {
+        std::memcpy(initialSendKeys, newSendKeys, keyLength);
+        std::memcpy(initialReceiveKeys, newReceiveKeys, keyLength);
+        keysExpanded = false;
+    }
+
+
+    void EncryptedChannel::setDevice(QIODevice* device) {
+        if (!isOpen()) {
+            currentDevice = device;
+        }
+    }
+
+
+    QIODevice* EncryptedChannel::device() const {
+        return currentDevice;
+    }
+
+
+    void EncryptedChannel::setRecordSize(unsigned newRecordSize) {
+        if (!isOpen()) {
+            currentRecordSize = std::min(std::max(newRecordSize, 1U), maximumRecordSize);
+        }
+    }
+
+
+    unsigned EncryptedChannel::recordSize() const {
+        return currentRecordSize;
+    }
+
+
+    bool EncryptedChannel::open(EncryptedChannel::OpenMode openMode) {
+        static_assert(sizeof(AesGcmEngine) <= engineStorageSize, "Insufficient AES-GCM engine storage.");
+
+        bool result;
+
+        if ((openMode & OpenModeFlag::ReadWrite) == OpenModeFlag::NotOpen) {
+            result = false;
+        } else if (currentDevice == Q_NULLPTR || !currentDevice->isOpen()) {
+            setErrorString(tr("No open device."));
+            result = false;
+        } else {
+            // Key expansion and building the GHASH tables are done once per key pair, not once per record.
+            if (!keysExpanded) {
+                sendEngine()->setKeys(initialSendKeys);
+                receiveEngine()->setKeys(initialReceiveKeys);
+                keysExpanded = true;
+            }
+
+            sendRecordNumber    = 0;
+            receiveRecordNumber = 0;
+            helloReceived       = false;
+            flushPosted         = false;
+            failed              = false;
+            readOffset          = 0;
+            readEnd             = 0;
+            recordOffset        = 0;
+            decryptedEnd        = 0;
+            availablePlaintext  = 0;
+
+            pendingData.clear();
+            pendingData.reserve(static_cast<int>(currentRecordSize));
+
+            sendBuffer.clear();
+            receiveBuffer.clear();
+
+            result = true;
+            if (openMode & OpenModeFlag::WriteOnly) {
+                generateRandomIV(sendIV, ivLength);
+
+                sendBuffer.append(channelMagic, sizeof(channelMagic));
+                sendBuffer.append(reinterpret_cast<const char*>(sendIV), ivLength);
+
+                result = writeSendBuffer();
+            }
+
+            if (result) {
+                result = QIODevice::open(openMode | OpenModeFlag::Unbuffered);
+            }
+
+            if (result && (openMode & OpenModeFlag::ReadOnly)) {
+                connect(currentDevice, &QIODevice::readyRead, this, &EncryptedChannel::deviceDataAvailable);
+                if (currentDevice->bytesAvailable() > 0) {
+                    deviceDataAvailable();
+                }
+            }
+        }
+
+        return result;
+    }
+
+
+    void EncryptedChannel::close() {
+        if (isOpen()) {
+            if (isWritable()) {
+                flush();
+            }
+
+            if (isReadable()) {
+                disconnect(currentDevice, &QIODevice::readyRead, this, &EncryptedChannel::deviceDataAvailable);
+            }
+        }
+
+        pendingData.fill('\x00');
+        pendingData.clear();
+
+        receiveBuffer.fill('\x00');
+        receiveBuffer.clear();
+
+        sendBuffer.clear();
+
+        std::memset(sendIV, 0, ivLength);
+        std::memset(receiveIV, 0, ivLength);
+
+        availablePlaintext = 0;
+
+        QIODevice::close();
+    }
+
+
+    bool EncryptedChannel::flush() {
+        bool result;
+
+        flushPosted = false;
+
+        if (!isOpen() || !isWritable() || failed) {
+            result = false;
+        } else {
+            if (!pendingData.isEmpty()) {
+                sealRecord(pendingData.constData(), static_cast<unsigned>(pendingData.size()));
+
+                // Resizing rather than clearing keeps the reserved record allocation.
+                pendingData.fill('\x00');
+                pendingData.resize(0);
+            }
+
+            result = writeSendBuffer();
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedChannel::isSequential() const {
+        return true;
+    }
+
+
+    qint64 EncryptedChannel::bytesAvailable() const {
+        return availablePlaintext + QIODevice::bytesAvailable();
+    }
+
+
+    qint64 EncryptedChannel::bytesToWrite() const {
+        qint64 result = pendingData.size() + sendBuffer.size();
+
+        if (currentDevice != Q_NULLPTR) {
+            result += currentDevice->bytesToWrite();
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedChannel::waitForReadyRead(int msecs) {
+        bool result = (availablePlaintext > 0);
+
+        if (!result && isOpen() && isReadable() && !failed) {
+            QElapsedTimer timer;
+            timer.start();
+
+            bool waiting = true;
+            while (waiting) {
+                int remaining = msecs < 0 ? -1 : std::max(0, msecs - static_cast<int>(timer.elapsed()));
+
+                // The device normally reports new data through its readyRead signal.  We also check directly in case
+                // the signal is delivered to a different thread.
+                waiting = currentDevice->waitForReadyRead(remaining);
+                if (waiting) {
+                    deviceDataAvailable();
+                }
+
+                result  = (availablePlaintext > 0);
+                waiting = waiting && !result && !failed && (msecs < 0 || timer.elapsed() < msecs);
+            }
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedChannel::waitForBytesWritten(int msecs) {
+        return (
+               flush()
+            && (currentDevice->bytesToWrite() == 0 || currentDevice->waitForBytesWritten(msecs))
+        );
+    }
+
+
+    qint64 EncryptedChannel::readData(char* data, qint64 maxSize) {
+        qint64 result = 0;
+
+        while (result < maxSize && advanceRecord()) {
+            qint64 bytesToCopy = std::min(maxSize - result, static_cast<qint64>(readEnd - readOffset));
+            std::memcpy(data + result, receiveBuffer.constData() + readOffset, static_cast<std::size_t>(bytesToCopy));
+
+            readOffset         += static_cast<int>(bytesToCopy);
+            availablePlaintext -= bytesToCopy;
+            result             += bytesToCopy;
+        }
+
+        if (result == 0 && failed) {
+            result = -1;
+        }
+
+        return result;
+    }
+
+
+    qint64 EncryptedChannel::writeData(const char* data, qint64 maxSize) {
+        qint64 result;
+
+        if (failed) {
+            result = -1;
+        } else {
+            qint64 offset = 0;
+            while (offset < maxSize) {
+                qint64 remaining = maxSize - offset;
+                if (pendingData.isEmpty() && remaining >= currentRecordSize) {
+                    // Full records are encrypted straight from the caller's buffer.
+                    sealRecord(data + offset, currentRecordSize);
+                    offset += currentRecordSize;
+                } else {
+                    qint64 bytesToCopy = std::min(
+                        remaining,
+                        static_cast<qint64>(currentRecordSize) - static_cast<qint64>(pendingData.size())
+                    );
+
+                    pendingData.append(data + offset, static_cast<int>(bytesToCopy));
+                    offset += bytesToCopy;
+
+                    if (static_cast<unsigned>(pendingData.size()) >= currentRecordSize) {
+                        sealRecord(pendingData.constData(), currentRecordSize);
+
+                        pendingData.fill('\x00');
+                        pendingData.resize(0);
+                    }
+                }
+            }
+
+            if (writeSendBuffer()) {
+                result = maxSize;
+
+                if (!pendingData.isEmpty() && !flushPosted) {
+                    // Further writes made before control returns to the event loop join the same record.
+                    flushPosted = true;
+                    QMetaObject::invokeMethod(
+                        this,
+                        [this]() {
+                            flush();
+                        },
+                        Qt::QueuedConnection
+                    );
+                }
+            } else {
+                result = -1;
+            }
+        }
+
+        return result;
+    }
+
+
+    void EncryptedChannel::deviceDataAvailable() {
+        if (isOpen() && !failed) {
+            compactReceiveBuffer();
+
+            qint64 bytesToRead = currentDevice->bytesAvailable();
+            if (bytesToRead > 0) {
+                // We read straight into the receive buffer so the records can be decrypted where they land.
+                int oldSize = receiveBuffer.size();
+                receiveBuffer.resize(oldSize + static_cast<int>(bytesToRead));
+
+                qint64 bytesRead = currentDevice->read(receiveBuffer.data() + oldSize, bytesToRead);
+                receiveBuffer.resize(oldSize + static_cast<int>(std::max(bytesRead, qint64(0))));
+
+                if (bytesRead < 0) {
+                    fail(tr("Could not read from device: %1").arg(currentDevice->errorString()));
+                }
+            }
+
+            if (!helloReceived && receiveBuffer.size() >= static_cast<int>(helloLength)) {
+                if (std::memcmp(receiveBuffer.constData(), channelMagic, sizeof(channelMagic)) != 0) {
+                    fail(tr("Invalid channel hello."));
+                } else {
+                    std::memcpy(receiveIV, receiveBuffer.constData() + sizeof(channelMagic), ivLength);
+                    helloReceived = true;
+
+                    readOffset   = helloLength;
+                    readEnd      = helloLength;
+                    recordOffset = helloLength;
+                    decryptedEnd = helloLength;
+                }
+            }
+
+            if (helloReceived && !failed && openRecords() > 0) {
+                emit readyRead();
+            }
+        }
+    }
+
+
+    void EncryptedChannel::sealRecord(const char* data, unsigned length) {
+        int offset = sendBuffer.size();
+        sendBuffer.resize(offset + static_cast<int>(recordHeaderLength + length + tagLength));
+
+        std::uint8_t* record = reinterpret_cast<std::uint8_t*>(sendBuffer.data() + offset);
+        record[0] = static_cast<std::uint8_t>(length >> 24);
+        record[1] = static_cast<std::uint8_t>(length >> 16);
+        record[2] = static_cast<std::uint8_t>(length >>  8);
+        record[3] = static_cast<std::uint8_t>(length      );
+
+        std::uint8_t nonce[ivLength];
+        calculateNonce(sendIV, sendRecordNumber, nonce);
+        ++sendRecordNumber;
+
+        sendEngine()->start(nonce, record, recordHeaderLength);
+        sendEngine()->encrypt(reinterpret_cast<const std::uint8_t*>(data), record + recordHeaderLength, length);
+        sendEngine()->finish(record + recordHeaderLength + length);
+    }
+
+
+    bool EncryptedChannel::writeSendBuffer() {
+        bool result;
+
+        if (sendBuffer.isEmpty()) {
+            result = true;
+        } else {
+            result = (currentDevice->write(sendBuffer) == sendBuffer.size());
+            if (!result) {
+                fail(tr("Could not write to device: %1").arg(currentDevice->errorString()));
+            }
+
+            // Resizing rather than clearing keeps the allocation for the next batch.
+            sendBuffer.resize(0);
+        }
+
+        return result;
+    }
+
+
+    qint64 EncryptedChannel::openRecords() {
+        qint64 result       = 0;
+        int    bufferLength = receiveBuffer.size();
+        bool   complete     = true;
+
+        while (complete && !failed && bufferLength - decryptedEnd >= static_cast<int>(recordHeaderLength)) {
+            std::uint8_t* record = reinterpret_cast<std::uint8_t*>(receiveBuffer.data() + decryptedEnd);
+            std::uint32_t length = (
+                  (static_cast<std::uint32_t>(record[0]) << 24)
+                | (static_cast<std::uint32_t>(record[1]) << 16)
+                | (static_cast<std::uint32_t>(record[2]) <<  8)
+                | (static_cast<std::uint32_t>(record[3])      )
+            );
+
+            if (length == 0 || length > maximumRecordSize) {
+                fail(tr("Invalid record length."));
+            } else if (bufferLength - decryptedEnd < static_cast<int>(recordHeaderLength + length + tagLength)) {
+                complete = false;
+            } else {
+                std::uint8_t nonce[ivLength];
+                calculateNonce(receiveIV, receiveRecordNumber, nonce);
+
+                std::uint8_t* payload = record + recordHeaderLength;
+                receiveEngine()->start(nonce, record, recordHeaderLength);
+                receiveEngine()->decrypt(payload, payload, length);
+
+                if (receiveEngine()->verify(payload + length)) {
+                    ++receiveRecordNumber;
+
+                    decryptedEnd       += static_cast<int>(recordHeaderLength + length + tagLength);
+                    availablePlaintext += length;
+                    result             += length;
+                } else {
+                    std::memset(payload, 0, length);
+                    fail(tr("Record failed authentication."));
+                }
+            }
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedChannel::advanceRecord() {
+        if (readOffset == readEnd && recordOffset < decryptedEnd) {
+            const std::uint8_t* record = reinterpret_cast<const std::uint8_t*>(
+                receiveBuffer.constData() + recordOffset
+            );
+
+            std::uint32_t length = (
+                  (static_cast<std::uint32_t>(record[0]) << 24)
+                | (static_cast<std::uint32_t>(record[1]) << 16)
+                | (static_cast<std::uint32_t>(record[2]) <<  8)
+                | (static_cast<std::uint32_t>(record[3])      )
+            );
+
+            readOffset    = recordOffset + static_cast<int>(recordHeaderLength);
+            readEnd       = readOffset + static_cast<int>(length);
+            recordOffset  = readEnd + static_cast<int>(tagLength);
+        }
+
+        return readOffset < readEnd;
+    }
+
+
+    void EncryptedChannel::compactReceiveBuffer() {
+        // Data is only moved once at least half of the buffer has been consumed so each byte is moved at most a
+        // constant number of times.
+        int consumed = readOffset < readEnd ? readOffset : recordOffset;
+        if (consumed > 0 && consumed >= receiveBuffer.size() / 2) {
+            int remaining = receiveBuffer.size() - consumed;
+            if (remaining > 0) {
+                std::memmove(
+                    receiveBuffer.data(),
+                    receiveBuffer.constData() + consumed,
+                    static_cast<std::size_t>(remaining)
+                );
+            }
+
+            std::memset(receiveBuffer.data() + remaining, 0, static_cast<std::size_t>(consumed));
+            receiveBuffer.resize(remaining);
+
+            readOffset   -= consumed;
+            readEnd      -= consumed;
+            recordOffset -= consumed;
+            decryptedEnd -= consumed;
+        }
+    }
+
+
+    void EncryptedChannel::fail(const QString& reason) {
+        if (!failed) {
+            failed = true;
+            setErrorString(reason);
+        }
+    }
+
+
+    void EncryptedChannel::calculateNonce(const std::uint8_t* iv, std::uint64_t recordNumber, std::uint8_t* nonce) {
+        std::memcpy(nonce, iv, ivLength);
+        for (unsigned i=0 ; i<8 ; ++i) {
+            nonce[ivLength - 1 - i] ^= static_cast<std::uint8_t>(recordNumber >> (8 * i));
+        }
+    }
+}
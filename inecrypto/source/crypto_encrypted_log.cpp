@@ -0,0 +1,644 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::EncryptedLog class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+#include <QFileDevice>
+#include <QBuffer>
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QString>
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_const_buffer.h"
+#include "crypto_encryptor.h"
+#include "crypto_decryptor.h"
+#include "crypto_encrypted_log.h"
+
+/**
+ * The index header.  The first four bytes identify the file and the fifth holds the format version.
+ */
+static const std::uint8_t indexHeader[Crypto::EncryptedLog::indexHeaderLength] = {
+    'I', 'E', 'L', 'I', 2, 0, 0, 0
+};
+
+static inline std::uint32_t fromBigEndian32(const std::uint8_t* data) {
+    return (
+          (static_cast<std::uint32_t>(data[0]) << 24)
+        | (static_cast<std::uint32_t>(data[1]) << 16)
+        | (static_cast<std::uint32_t>(data[2]) <<  8)
+        | (static_cast<std::uint32_t>(data[3])      )
+    );
+}
+
+
+static inline void toBigEndian32(std::uint32_t value, std::uint8_t* data) {
+    data[0] = static_cast<std::uint8_t>(value >> 24);
+    data[1] = static_cast<std::uint8_t>(value >> 16);
+    data[2] = static_cast<std::uint8_t>(value >>  8);
+    data[3] = static_cast<std::uint8_t>(value      );
+}
+
+
+static inline unsigned long long fromBigEndian64(const std::uint8_t* data) {
+    return (
+          (static_cast<unsigned long long>(fromBigEndian32(data)) << 32)
+        | static_cast<unsigned long long>(fromBigEndian32(data + 4))
+    );
+}
+
+
+static inline void toBigEndian64(unsigned long long value, std::uint8_t* data) {
+    toBigEndian32(static_cast<std::uint32_t>(value >> 32), data);
+    toBigEndian32(static_cast<std::uint32_t>(value), data + 4);
+}
+
+
+/**
+ * Function that shortens a device.  Files and buffers are supported.
+ *
+ * \param[in] device  The device to shorten.
+ *
+ * \param[in] newSize The new size, in bytes.
+ *
+ * \return Returns true on success.  Returns false if the device could not be shortened.
+ */
+static bool truncateDevice(QIODevice* device, unsigned long long newSize) {
+    bool         result;
+    QFileDevice* fileDevice = qobject_cast<QFileDevice*>(device);
+    QBuffer*     buffer     = qobject_cast<QBuffer*>(device);
+
+    if (fileDevice != Q_NULLPTR) {
+        result = fileDevice->resize(static_cast<qint64>(newSize));
+    } else if (buffer != Q_NULLPTR) {
+        buffer->buffer().resize(static_cast<int>(newSize));
+        result = true;
+    } else {
+        result = false;
+    }
+
+    return result;
+}
+
+namespace Crypto {
+    EncryptedLog::EncryptedLog(
+            Encryptor* encryptor,
+            Decryptor* decryptor,
+            QIODevice* logDevice,
+            QIODevice* indexDevice
+        ) {
+        currentEncryptor     = encryptor;
+        currentDecryptor     = decryptor;
+        currentLogDevice     = logDevice;
+        currentIndexDevice   = indexDevice;
+        currentlyOpen        = false;
+        currentNumberRecords = 0;
+        logEndOffset         = 0;
+        mappedIndex          = Q_NULLPTR;
+        numberMappedEntries  = 0;
+    }
+
+
+    EncryptedLog::~EncryptedLog() {
+        close();
+    }
+
+
+    void EncryptedLog::setEncryptor(Encryptor* newEncryptor) {
+        currentEncryptor = newEncryptor;
+    }
+
+
+    Encryptor* EncryptedLog::encryptor() const {
+        return currentEncryptor;
+    }
+
+
+    void EncryptedLog::setDecryptor(Decryptor* newDecryptor) {
+        currentDecryptor = newDecryptor;
+    }
+
+
+    Decryptor* EncryptedLog::decryptor() const {
+        return currentDecryptor;
+    }
+
+
+    void EncryptedLog::setLogDevice(QIODevice* newLogDevice) {
+        close();
+        currentLogDevice = newLogDevice;
+    }
+
+
+    QIODevice* EncryptedLog::logDevice() const {
+        return currentLogDevice;
+    }
+
+
+    void EncryptedLog::setIndexDevice(QIODevice* newIndexDevice) {
+        close();
+        currentIndexDevice = newIndexDevice;
+    }
+
+
+    QIODevice* EncryptedLog::indexDevice() const {
+        return currentIndexDevice;
+    }
+
+
+    bool EncryptedLog::open() {
+        bool result;
+
+        close();
+
+        if (currentEncryptor == Q_NULLPTR || currentDecryptor == Q_NULLPTR) {
+            currentErrorString = QObject::tr("No encryptor or decryptor.");
+            result = false;
+        } else if (currentLogDevice == Q_NULLPTR || currentIndexDevice == Q_NULLPTR) {
+            currentErrorString = QObject::tr("No log or index device.");
+            result = false;
+        } else if (currentLogDevice->isSequential()    ||
+                   !currentLogDevice->isReadable()     ||
+                   !currentLogDevice->isWritable()     ||
+                   currentIndexDevice->isSequential()  ||
+                   !currentIndexDevice->isReadable()   ||
+                   !currentIndexDevice->isWritable()      ) {
+            currentErrorString = QObject::tr("The log and index devices must be open, random access devices.");
+            result = false;
+        } else {
+            result = loadIndex() && recoverIndex();
+            if (result) {
+                mapIndex();
+                currentlyOpen = true;
+            } else {
+                currentNumberRecords = 0;
+                logEndOffset         = 0;
+            }
+        }
+
+        return result;
+    }
+
+
+    void EncryptedLog::close() {
+        unmapIndex();
+
+        currentlyOpen        = false;
+        currentNumberRecords = 0;
+        logEndOffset         = 0;
+    }
+
+
+    bool EncryptedLog::isOpen() const {
+        return currentlyOpen;
+    }
+
+
+    unsigned long long EncryptedLog::numberRecords() const {
+        return currentNumberRecords;
+    }
+
+
+    bool EncryptedLog::append(const QByteArray& record) {
+        bool result;
+
+        if (!currentlyOpen) {
+            currentErrorString = QObject::tr("Log is not open.");
+            result = false;
+        } else {
+            // The record number and plaintext length are encrypted with the record so that they are authenticated
+            // along with the data.  The record number binds each record to its position in the log.
+            std::uint8_t recordHeader[recordHeaderLength];
+            toBigEndian64(currentNumberRecords, recordHeader);
+            toBigEndian32(static_cast<std::uint32_t>(record.size()), recordHeader + 8);
+
+            ConstBuffer inputBuffers[2] = {
+                { recordHeader, sizeof(recordHeader) },
+                { reinterpret_cast<const std::uint8_t*>(record.constData()), static_cast<std::size_t>(record.size()) }
+            };
+
+            std::size_t encryptedLength = currentEncryptor->encryptedSize(totalLength(inputBuffers, 2));
+            QByteArray  frame(static_cast<int>(frameHeaderLength + encryptedLength), '\x00');
+            std::uint8_t* frameData = reinterpret_cast<std::uint8_t*>(frame.data());
+
+            toBigEndian32(static_cast<std::uint32_t>(encryptedLength), frameData);
+            std::size_t numberEncryptedBytes = currentEncryptor->encrypt(
+                inputBuffers,
+                2,
+                frameData + frameHeaderLength,
+                encryptedLength
+            );
+
+            if (numberEncryptedBytes != encryptedLength) {
+                currentErrorString = QObject::tr("Could not encrypt record.");
+                result = false;
+            } else {
+                // The record is written before its index entry.  If we are interrupted between the two writes, the
+                // record is indexed the next time the log is opened.
+                result = (
+                       currentLogDevice->seek(static_cast<qint64>(logEndOffset))
+                    && currentLogDevice->write(frame) == frame.size()
+                );
+
+                if (result) {
+                    result = writeIndexEntry(currentNumberRecords, logEndOffset);
+                    if (result) {
+                        ++currentNumberRecords;
+                        logEndOffset += static_cast<unsigned long long>(frame.size());
+                    }
+                } else {
+                    currentErrorString = QObject::tr("Could not append record: %1").arg(
+                        currentLogDevice->errorString()
+                    );
+                }
+            }
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::readRecord(unsigned long long recordIndex, QByteArray& record) {
+        bool result;
+
+        if (!currentlyOpen) {
+            currentErrorString = QObject::tr("Log is not open.");
+            result = false;
+        } else if (recordIndex >= currentNumberRecords) {
+            currentErrorString = QObject::tr("No such record.");
+            result = false;
+        } else {
+            unsigned long long startOffset;
+            unsigned long long endOffset;
+            QByteArray         frame;
+
+            result = (
+                   readIndexEntry(recordIndex, startOffset)
+                && readRecordEnd(recordIndex, endOffset)
+                && readLog(startOffset, endOffset, frame)
+                && decryptFrame(
+                       recordIndex,
+                       reinterpret_cast<const std::uint8_t*>(frame.constData()),
+                       static_cast<unsigned long long>(frame.size()),
+                       record
+                   )
+            );
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::readRecords(
+            unsigned long long firstRecord,
+            unsigned long long numberToRead,
+            QByteArrayList&    records
+        ) {
+        bool result;
+
+        records.clear();
+
+        if (!currentlyOpen) {
+            currentErrorString = QObject::tr("Log is not open.");
+            result = false;
+        } else if (firstRecord >= currentNumberRecords) {
+            currentErrorString = QObject::tr("No such record.");
+            result = false;
+        } else {
+            unsigned long long numberRecordsInRun = std::min(numberToRead, currentNumberRecords - firstRecord);
+            unsigned long long startOffset;
+            unsigned long long endOffset;
+            QByteArray         run;
+
+            result = (
+                   numberRecordsInRun == 0
+                || (   readIndexEntry(firstRecord, startOffset)
+                    && readRecordEnd(firstRecord + numberRecordsInRun - 1, endOffset)
+                    && readLog(startOffset, endOffset, run)
+                   )
+            );
+
+            // Walk the frames in the run rather than consulting the index for each record.
+            const std::uint8_t* runData      = reinterpret_cast<const std::uint8_t*>(run.constData());
+            unsigned long long  runLength    = static_cast<unsigned long long>(run.size());
+            unsigned long long  frameOffset  = 0;
+            unsigned long long  recordNumber = 0;
+
+            while (result && recordNumber < numberRecordsInRun) {
+                bool               hasHeader   = (runLength - frameOffset >= frameHeaderLength);
+                unsigned long long frameLength = (
+                    hasHeader ? frameHeaderLength + fromBigEndian32(runData + frameOffset) : 0
+                );
+
+                if (hasHeader && frameLength <= runLength - frameOffset) {
+                    QByteArray record;
+                    result = decryptFrame(firstRecord + recordNumber, runData + frameOffset, frameLength, record);
+
+                    if (result) {
+                        records.append(record);
+                        frameOffset += frameLength;
+                        ++recordNumber;
+                    }
+                } else {
+                    currentErrorString = QObject::tr("Invalid record.");
+                    result = false;
+                }
+            }
+
+            if (result && frameOffset != runLength) {
+                currentErrorString = QObject::tr("Invalid record.");
+                result = false;
+            }
+
+            if (!result) {
+                records.clear();
+            }
+        }
+
+        return result;
+    }
+
+
+    QString EncryptedLog::errorString() const {
+        return currentErrorString;
+    }
+
+
+    bool EncryptedLog::loadIndex() {
+        bool               result;
+        unsigned long long indexSize = static_cast<unsigned long long>(currentIndexDevice->size());
+
+        if (indexSize == 0) {
+            result = (
+                   currentIndexDevice->seek(0)
+                && currentIndexDevice->write(reinterpret_cast<const char*>(indexHeader), indexHeaderLength)
+                   == static_cast<qint64>(indexHeaderLength)
+            );
+
+            currentNumberRecords = 0;
+        } else {
+            std::uint8_t header[indexHeaderLength];
+
+            result = (
+                   indexSize >= indexHeaderLength
+                && currentIndexDevice->seek(0)
+                && currentIndexDevice->read(reinterpret_cast<char*>(header), indexHeaderLength)
+                   == static_cast<qint64>(indexHeaderLength)
+                && std::memcmp(header, indexHeader, indexHeaderLength) == 0
+            );
+
+            currentNumberRecords = result ? (indexSize - indexHeaderLength) / indexEntryLength : 0;
+        }
+
+        if (!result) {
+            currentErrorString = QObject::tr("Invalid index.");
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::recoverIndex() {
+        bool               result     = true;
+        bool               found      = false;
+        unsigned long long logSize    = static_cast<unsigned long long>(currentLogDevice->size());
+        unsigned long long frameLength;
+
+        // Discard index entries for records that never made it to the log.
+        logEndOffset = 0;
+        while (result && !found && currentNumberRecords > 0) {
+            unsigned long long offset;
+            result = readIndexEntry(currentNumberRecords - 1, offset);
+            if (result) {
+                if (readFrameLength(offset, frameLength)) {
+                    logEndOffset = offset + frameLength;
+                    found        = true;
+                } else {
+                    --currentNumberRecords;
+                }
+            }
+        }
+
+        // Index complete records appended after the last index entry.
+        while (result && logEndOffset < logSize && readFrameLength(logEndOffset, frameLength)) {
+            result = writeIndexEntry(currentNumberRecords, logEndOffset);
+            if (result) {
+                ++currentNumberRecords;
+                logEndOffset += frameLength;
+            }
+        }
+
+        if (result && logEndOffset < logSize) {
+            result = truncateDevice(currentLogDevice, logEndOffset);
+            if (!result) {
+                currentErrorString = QObject::tr("Could not discard partial record.");
+            }
+        }
+
+        unsigned long long indexSize = indexHeaderLength + currentNumberRecords * indexEntryLength;
+        if (result && static_cast<unsigned long long>(currentIndexDevice->size()) != indexSize) {
+            result = truncateDevice(currentIndexDevice, indexSize);
+            if (!result) {
+                currentErrorString = QObject::tr("Could not discard stale index entries.");
+            }
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::readFrameLength(unsigned long long offset, unsigned long long& frameLength) {
+        unsigned long long logSize = static_cast<unsigned long long>(currentLogDevice->size());
+        std::uint8_t       frameHeader[frameHeaderLength];
+
+        bool result = (
+               offset <= logSize
+            && logSize - offset >= frameHeaderLength
+            && currentLogDevice->seek(static_cast<qint64>(offset))
+            && currentLogDevice->read(reinterpret_cast<char*>(frameHeader), frameHeaderLength)
+               == static_cast<qint64>(frameHeaderLength)
+        );
+
+        if (result) {
+            unsigned long long encryptedLength = fromBigEndian32(frameHeader);
+
+            frameLength = frameHeaderLength + encryptedLength;
+            result      = (encryptedLength > 0 && frameLength <= logSize - offset);
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::readIndexEntry(unsigned long long recordIndex, unsigned long long& offset) {
+        bool result;
+
+        if (recordIndex < numberMappedEntries) {
+            offset = fromBigEndian64(mappedIndex + indexHeaderLength + recordIndex * indexEntryLength);
+            result = true;
+        } else {
+            std::uint8_t entry[indexEntryLength];
+
+            result = (
+                   currentIndexDevice->seek(static_cast<qint64>(indexHeaderLength + recordIndex * indexEntryLength))
+                && currentIndexDevice->read(reinterpret_cast<char*>(entry), indexEntryLength)
+                   == static_cast<qint64>(indexEntryLength)
+            );
+
+            if (result) {
+                offset = fromBigEndian64(entry);
+            } else {
+                currentErrorString = QObject::tr("Could not read index: %1").arg(currentIndexDevice->errorString());
+            }
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::readRecordEnd(unsigned long long recordIndex, unsigned long long& offset) {
+        bool result;
+
+        if (recordIndex + 1 < currentNumberRecords) {
+            result = readIndexEntry(recordIndex + 1, offset);
+        } else {
+            offset = logEndOffset;
+            result = true;
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::readLog(unsigned long long startOffset, unsigned long long endOffset, QByteArray& data) {
+        bool result = (startOffset <= endOffset && endOffset <= logEndOffset);
+
+        if (result) {
+            qint64 length = static_cast<qint64>(endOffset - startOffset);
+
+            data.resize(static_cast<int>(length));
+            result = (
+                   currentLogDevice->seek(static_cast<qint64>(startOffset))
+                && currentLogDevice->read(data.data(), length) == length
+            );
+
+            if (!result) {
+                currentErrorString = QObject::tr("Could not read log: %1").arg(currentLogDevice->errorString());
+            }
+        } else {
+            currentErrorString = QObject::tr("Invalid index.");
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::writeIndexEntry(unsigned long long recordIndex, unsigned long long offset) {
+        std::uint8_t entry[indexEntryLength];
+        toBigEndian64(offset, entry);
+
+        bool result = (
+               currentIndexDevice->seek(static_cast<qint64>(indexHeaderLength + recordIndex * indexEntryLength))
+            && currentIndexDevice->write(reinterpret_cast<const char*>(entry), indexEntryLength)
+               == static_cast<qint64>(indexEntryLength)
+        );
+
+        if (!result) {
+            currentErrorString = QObject::tr("Could not write index: %1").arg(currentIndexDevice->errorString());
+        }
+
+        return result;
+    }
+
+
+    bool EncryptedLog::decryptFrame(
+            unsigned long long  recordIndex,
+            const std::uint8_t* frameData,
+            unsigned long long  frameLength,
+            QByteArray&         record
+        ) {
+        bool result = false;
+
+        if (frameLength > frameHeaderLength && fromBigEndian32(frameData) == frameLength - frameHeaderLength) {
+            std::size_t encryptedLength = static_cast<std::size_t>(frameLength - frameHeaderLength);
+            std::size_t decryptedLength = currentDecryptor->decryptedSize(encryptedLength);
+            QByteArray  decrypted(static_cast<int>(decryptedLength), '\x00');
+            std::size_t bytesDecrypted  = currentDecryptor->decrypt(
+                frameData + frameHeaderLength,
+                encryptedLength,
+                reinterpret_cast<std::uint8_t*>(decrypted.data()),
+                decryptedLength
+            );
+
+            if (bytesDecrypted >= recordHeaderLength && bytesDecrypted == decryptedLength) {
+                const std::uint8_t* recordHeader = reinterpret_cast<const std::uint8_t*>(decrypted.constData());
+                unsigned long long  recordNumber = fromBigEndian64(recordHeader);
+                unsigned long long  recordLength = fromBigEndian32(recordHeader + 8);
+
+                if (recordNumber == recordIndex && recordLength <= bytesDecrypted - recordHeaderLength) {
+                    record = decrypted.mid(static_cast<int>(recordHeaderLength), static_cast<int>(recordLength));
+                    result = true;
+                }
+            }
+
+            decrypted.fill('\x00');
+        }
+
+        if (!result) {
+            currentErrorString = QObject::tr("Could not decrypt record.");
+        }
+
+        return result;
+    }
+
+
+    void EncryptedLog::mapIndex() {
+        QFileDevice* fileDevice = qobject_cast<QFileDevice*>(currentIndexDevice);
+
+        if (fileDevice != Q_NULLPTR) {
+            // Entries appended after the index is mapped are read from the device.
+            qint64 indexSize = fileDevice->size();
+            uchar* mapped    = fileDevice->map(0, indexSize);
+            if (mapped != Q_NULLPTR) {
+                mappedIndex         = mapped;
+                numberMappedEntries = (
+                    (static_cast<unsigned long long>(indexSize) - indexHeaderLength) / indexEntryLength
+                );
+            }
+        }
+    }
+
+
+    void EncryptedLog::unmapIndex() {
+        if (mappedIndex != Q_NULLPTR) {
+            QFileDevice* fileDevice = qobject_cast<QFileDevice*>(currentIndexDevice);
+            if (fileDevice != Q_NULLPTR) {
+                fileDevice->unmap(const_cast<uchar*>(mappedIndex));
+            }
+
+            mappedIndex         = Q_NULLPTR;
+            numberMappedEntries = 0;
+        }
+    }
+}
@@ -24,13 +24,173 @@
 #include <QIODevice>
 #include <QObject>
 #include <QString>
-
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QBuffer>
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <climits>
 #include <cstring>
+#include <vector>
 
 #include "crypto_trng.h"
 #include "crypto_encryptor.h"
 
 namespace Crypto {
+    /**
+     * Thread that encrypts data queued by \ref Crypto::Encryptor::writeData.  Encrypted data is handed back to the
+     * thread that owns the encryptor to be written to the output device.
+     */
+    class Encryptor::Worker:public QThread {
+        public:
+            /**
+             * The number of bytes encrypted per pass.  Encrypted data is handed back after each pass so the output
+             * device sees a steady stream rather than one large write per queue swap.
+             */
+            static constexpr int batchSize = 64 * 1024;
+
+            /**
+             * Constructor
+             *
+             * \param[in] encryptor The encryptor that owns this worker.
+             */
+            explicit Worker(Encryptor* encryptor):currentEncryptor(encryptor) {
+                numberQueuedBytes       = 0;
+                numberPendingInputBytes = 0;
+                busy                    = false;
+                stopRequested           = false;
+                writePosted             = false;
+                failed                  = false;
+            }
+
+            ~Worker() override {}
+
+            /**
+             * Mutex protecting the queues and flags below.
+             */
+            QMutex queueMutex;
+
+            /**
+             * Mutex held while the worker uses the encryption engine.  The engine state and counters belong to the
+             * worker while it holds this mutex.
+             */
+            QMutex engineMutex;
+
+            /**
+             * Condition signalled when data is added to the input queue or a stop is requested.
+             */
+            QWaitCondition inputQueued;
+
+            /**
+             * Condition signalled when encrypted data is ready or the worker goes idle.
+             */
+            QWaitCondition outputReady;
+
+            /**
+             * Data waiting to be encrypted.
+             */
+            QByteArray pendingInput;
+
+            /**
+             * Encrypted data waiting to be written to the output device.
+             */
+            QByteArray pendingOutput;
+
+            /**
+             * The number of written bytes that have not yet reached the output device in encrypted form.
+             */
+            qint64 numberQueuedBytes;
+
+            /**
+             * The number of written bytes represented by the pending output.
+             */
+            qint64 numberPendingInputBytes;
+
+            /**
+             * Flag indicating that the worker is encrypting data taken from the input queue.
+             */
+            bool busy;
+
+            /**
+             * Flag indicating that the worker should exit.
+             */
+            bool stopRequested;
+
+            /**
+             * Flag indicating that a write to the output device has already been posted to the encryptor's thread.
+             */
+            bool writePosted;
+
+            /**
+             * Flag indicating that the output device reported an error.
+             */
+            bool failed;
+
+        protected:
+            /**
+             * Method that is run on the worker thread.
+             */
+            void run() override {
+                QMutexLocker locker(&queueMutex);
+
+                while (!stopRequested) {
+                    if (pendingInput.isEmpty()) {
+                        inputQueued.wait(&queueMutex);
+                    } else {
+                        QByteArray input;
+                        input.swap(pendingInput);
+                        busy = true;
+
+                        int offset = 0;
+                        while (offset < input.size() && !stopRequested) {
+                            int        length = std::min(batchSize, input.size() - offset);
+                            QByteArray encrypted;
+                            QBuffer    encryptedBuffer(&encrypted);
+                            encryptedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+                            locker.unlock();
+
+                            engineMutex.lock();
+                            currentEncryptor->encryptToDevice(input.constData() + offset, length, &encryptedBuffer);
+                            engineMutex.unlock();
+
+                            locker.relock();
+
+                            pendingOutput.append(encrypted);
+                            numberPendingInputBytes += length;
+                            offset                  += length;
+
+                            if (!writePosted) {
+                                writePosted = true;
+
+                                Encryptor* encryptor = currentEncryptor;
+                                QMetaObject::invokeMethod(
+                                    encryptor,
+                                    [encryptor]() {
+                                        encryptor->writeEncryptedData();
+                                    },
+                                    Qt::QueuedConnection
+                                );
+                            }
+
+                            outputReady.wakeAll();
+                        }
+
+                        busy = false;
+                        outputReady.wakeAll();
+                    }
+                }
+            }
+
+        private:
+            Encryptor* currentEncryptor;
+    };
+
+
     Encryptor::Encryptor(QIODevice* parent):QIODevice(parent) {
         configure(parent);
     }
@@ -41,50 +201,189 @@ namespace Crypto {
     }
 
 
-    Encryptor::~Encryptor() {}
+    Encryptor::~Encryptor() {
+        stopWorker();
+    }
 
 
     QByteArray Encryptor::encrypt(const QByteArray& inputBuffer) {
-        unsigned long long  numberInputBytes = static_cast<unsigned long long>(inputBuffer.size());
-        const std::uint8_t* inputData        = reinterpret_cast<const std::uint8_t*>(inputBuffer.data());
+        std::size_t numberInputBytes = static_cast<std::size_t>(inputBuffer.size());
+        QByteArray  result(static_cast<int>(encryptedSize(numberInputBytes)), '\x00');
+
+        std::size_t numberOutputBytes = encrypt(
+            reinterpret_cast<const std::uint8_t*>(inputBuffer.constData()),
+            numberInputBytes,
+            reinterpret_cast<std::uint8_t*>(result.data()),
+            static_cast<std::size_t>(result.size())
+        );
+
+        if (numberOutputBytes == 0) {
+            result.clear();
+        }
+
+        return result;
+    }
 
-        unsigned inputBufferAllocation  = inputChunkSize();
-        unsigned outputBufferAllocation = outputChunkSize();
 
-        unsigned long long  numberChunks      = (numberInputBytes + inputBufferAllocation - 1) / inputBufferAllocation;
-        unsigned long long  numberOutputBytes = numberChunks * outputBufferAllocation;
+    std::size_t Encryptor::encrypt(
+            const std::uint8_t* inputData,
+            std::size_t         inputLength,
+            std::uint8_t*       outputData,
+            std::size_t         outputCapacity
+        ) {
+        ConstBuffer inputBuffer = { inputData, inputLength };
+        return encrypt(&inputBuffer, 1, outputData, outputCapacity);
+    }
 
-        QByteArray result(numberOutputBytes, '\x00');
 
-        std::uint8_t*      outputData          = reinterpret_cast<std::uint8_t*>(result.data());
-        unsigned long long inputBytesRemaining = numberInputBytes;
+    QByteArray Encryptor::encrypt(const QByteArrayList& inputBuffers) {
+        std::vector<ConstBuffer> buffers;
+        buffers.reserve(static_cast<std::size_t>(inputBuffers.size()));
+
+        for (const QByteArray& inputBuffer : inputBuffers) {
+            buffers.push_back(
+                ConstBuffer {
+                    reinterpret_cast<const std::uint8_t*>(inputBuffer.constData()),
+                    static_cast<std::size_t>(inputBuffer.size())
+                }
+            );
+        }
+
+        std::size_t numberInputBytes = totalLength(buffers.data(), buffers.size());
+        QByteArray  result(static_cast<int>(encryptedSize(numberInputBytes)), '\x00');
+
+        std::size_t numberOutputBytes = encrypt(
+            buffers.data(),
+            buffers.size(),
+            reinterpret_cast<std::uint8_t*>(result.data()),
+            static_cast<std::size_t>(result.size())
+        );
+
+        if (numberOutputBytes == 0) {
+            result.clear();
+        }
+
+        return result;
+    }
 
-        resetEngine();
-        while (inputBytesRemaining >= inputBufferAllocation) {
-            encryptChunk(inputData, outputData);
 
-            inputData += inputBufferAllocation;
-            outputData += outputBufferAllocation;
+    std::size_t Encryptor::encrypt(
+            const ConstBuffer* inputBuffers,
+            std::size_t        numberInputBuffers,
+            std::uint8_t*      outputData,
+            std::size_t        outputCapacity
+        ) {
+        std::size_t numberOutputBytes = encryptedSize(totalLength(inputBuffers, numberInputBuffers));
+        std::size_t result;
 
-            inputBytesRemaining -= inputBufferAllocation;
+        if (outputCapacity >= numberOutputBytes && streamAllowed()) {
+            unsigned inputBufferAllocation  = inputChunkSize();
+            unsigned outputBufferAllocation = outputChunkSize();
+            unsigned headerBytes            = headerSize();
+
+            Q_ASSERT(inputBufferAllocation <= maximumInputChunkSize);
+
+            // Chunks that straddle two input buffers, and the final partial chunk, are gathered here.  All other
+            // chunks are encrypted directly from the caller's buffers.
+            std::uint8_t pending[maximumInputChunkSize];
+            std::size_t  pendingBytes = 0;
+
+            resetEngine();
+
+            if (headerBytes > 0) {
+                generateHeader(outputData);
+                outputData += headerBytes;
+            }
+
+            for (std::size_t bufferIndex=0 ; bufferIndex<numberInputBuffers ; ++bufferIndex) {
+                const std::uint8_t* inputData           = inputBuffers[bufferIndex].data;
+                std::size_t         inputBytesRemaining = inputBuffers[bufferIndex].length;
+
+                if (pendingBytes > 0) {
+                    std::size_t bytesToCopy = std::min(inputBufferAllocation - pendingBytes, inputBytesRemaining);
+                    std::memcpy(pending + pendingBytes, inputData, bytesToCopy);
+
+                    pendingBytes        += bytesToCopy;
+                    inputData           += bytesToCopy;
+                    inputBytesRemaining -= bytesToCopy;
+
+                    if (pendingBytes == inputBufferAllocation) {
+                        encryptChunk(pending, outputData);
+                        outputData += outputBufferAllocation;
+
+                        pendingBytes = 0;
+                    }
+                }
+
+                std::size_t numberChunks = inputBytesRemaining / inputBufferAllocation;
+                if (numberChunks > 0) {
+                    encryptChunks(inputData, outputData, numberChunks);
+
+                    inputData += numberChunks * inputBufferAllocation;
+                    outputData += numberChunks * outputBufferAllocation;
+
+                    inputBytesRemaining -= numberChunks * inputBufferAllocation;
+                }
+
+                if (inputBytesRemaining > 0) {
+                    std::memcpy(pending + pendingBytes, inputData, inputBytesRemaining);
+                    pendingBytes += inputBytesRemaining;
+                }
+            }
+
+            if (pendingBytes > 0) {
+                unsigned bytesToAppend = static_cast<unsigned>(inputBufferAllocation - pendingBytes);
+                for (unsigned i=0 ; i<bytesToAppend ; ++i) {
+                    pending[pendingBytes + i] = static_cast<std::uint8_t>(bytesToAppend);
+                }
+
+                encryptChunk(pending, outputData);
+                std::memset(pending, 0, inputBufferAllocation);
+
+                outputData += outputBufferAllocation;
+            }
+
+            if (trailerSize() > 0) {
+                generateTrailer(outputData);
+            }
+
+            finishEngine();
+            result = numberOutputBytes;
+        } else {
+            result = 0;
         }
 
-        if (inputBytesRemaining > 0) {
-            std::uint8_t* tail = new std::uint8_t[inputBufferAllocation];
-            std::memcpy(tail, inputData, inputBytesRemaining);
-            unsigned bytesToAppend = inputBufferAllocation - inputBytesRemaining;
-            for (unsigned i=0 ; i<bytesToAppend ; ++i) {
-                tail[inputBytesRemaining + i] = static_cast<std::uint8_t>(bytesToAppend);
+        return result;
+    }
+
+
+    std::size_t Encryptor::encryptInPlace(std::uint8_t* buffer, std::size_t inputLength, std::size_t capacity) {
+        std::size_t result;
+
+        if (inputChunkSize() == outputChunkSize() && capacity >= encryptedSize(inputLength) && streamAllowed()) {
+            // Shift the data past the header so each chunk is encrypted over itself.
+            unsigned headerBytes = headerSize();
+            if (headerBytes > 0) {
+                std::memmove(buffer + headerBytes, buffer, inputLength);
             }
 
-            encryptChunk(tail, outputData);
-            delete[] tail;
+            result = encrypt(buffer + headerBytes, inputLength, buffer, capacity);
+        } else {
+            result = 0;
         }
 
         return result;
     }
 
 
+    std::size_t Encryptor::encryptedSize(std::size_t inputLength) const {
+        unsigned    inChunkSize  = inputChunkSize();
+        std::size_t numberChunks = (inputLength + inChunkSize - 1) / inChunkSize;
+
+        return headerSize() + numberChunks * outputChunkSize() + trailerSize();
+    }
+
+
     void Encryptor::setOutputDevice(QIODevice* outputDevice) {
         currentOutputDevice = outputDevice;
     }
@@ -99,7 +398,12 @@ namespace Crypto {
         bool result;
 
         if (openMode == OpenModeFlag::WriteOnly || openMode == OpenModeFlag::Append) {
-            result = QIODevice::open(openMode);
+            if (streamAllowed()) {
+                result = QIODevice::open(openMode);
+            } else {
+                setErrorString(tr("A new stream can not be started with the current IV."));
+                result = false;
+            }
         } else {
             result = false;
         }
@@ -107,17 +411,93 @@ namespace Crypto {
         if (result) {
             currentNumberInputBytesProcessed  = 0;
             currentNumberOutputBytesProcessed = 0;
+
+            if (inputBufferAllocation == 0) {
+                inputBufferAllocation  = inputChunkSize();
+                outputBufferAllocation = outputChunkSize();
+
+                chunksPerPass = std::max(1U, writeBatchSize / inputBufferAllocation);
+
+                inputBuffer.resize(inputBufferAllocation);
+                outputBuffer.resize(chunksPerPass * outputBufferAllocation);
+
+                inputData = reinterpret_cast<std::uint8_t*>(inputBuffer.data());
+            }
+
+            inputBufferIndex = 0;
+            resetEngine();
+
+            unsigned headerBytes = headerSize();
+            if (headerBytes > 0) {
+                if (currentOutputDevice != Q_NULLPTR) {
+                    QByteArray header(headerBytes, '\x00');
+                    generateHeader(reinterpret_cast<std::uint8_t*>(header.data()));
+
+                    qint64 bytesWritten = currentOutputDevice->write(header);
+                    if (bytesWritten == static_cast<qint64>(headerBytes)) {
+                        currentNumberOutputBytesProcessed += headerBytes;
+                    } else {
+                        setErrorString(tr("Could not write header: %1").arg(currentOutputDevice->errorString()));
+                        result = false;
+                    }
+                } else {
+                    setErrorString(tr("No output device."));
+                    result = false;
+                }
+
+                if (!result) {
+                    QIODevice::close();
+                }
+            }
+
+            if (result && asynchronous) {
+                stopWorker();
+
+                currentWorker = new Worker(this);
+                currentWorker->start();
+            }
         }
 
         return result;
     }
 
 
+    void Encryptor::close() {
+        if (currentWorker != Q_NULLPTR) {
+            drainWorker();
+            stopWorker();
+        }
+
+        unsigned trailerBytes = trailerSize();
+        if (isOpen() && trailerBytes > 0) {
+            if (flush()) {
+                QByteArray trailer(trailerBytes, '\x00');
+                generateTrailer(reinterpret_cast<std::uint8_t*>(trailer.data()));
+
+                qint64 bytesWritten = currentOutputDevice->write(trailer);
+                if (bytesWritten == static_cast<qint64>(trailerBytes)) {
+                    currentNumberOutputBytesProcessed += trailerBytes;
+                } else {
+                    setErrorString(tr("Could not write trailer: %1").arg(currentOutputDevice->errorString()));
+                }
+            }
+        }
+
+        if (isOpen()) {
+            finishEngine();
+        }
+
+        QIODevice::close();
+    }
+
+
     bool Encryptor::flush() {
         bool success;
 
         if (currentOutputDevice != Q_NULLPTR) {
-            if (inputBufferIndex == 0) {
+            if (currentWorker != Q_NULLPTR && !drainWorker()) {
+                success = false;
+            } else if (inputBufferIndex == 0) {
                 success = true;
             } else {
                 char bytesRemaining = static_cast<char>(inputBufferAllocation - inputBufferIndex);
@@ -130,8 +510,8 @@ namespace Crypto {
                 encryptChunk(inputData, reinterpret_cast<std::uint8_t*>(outputBuffer.data()));
                 inputBufferIndex = 0;
 
-                qint64 bytesWritten = currentOutputDevice->write(outputBuffer);
-                success = (bytesWritten == outputBuffer.size());
+                qint64 bytesWritten = currentOutputDevice->write(outputBuffer.constData(), outputBufferAllocation);
+                success = (bytesWritten == static_cast<qint64>(outputBufferAllocation));
 
                 if (success) {
                     currentNumberInputBytesProcessed  += bytesRemaining;
@@ -182,6 +562,64 @@ namespace Crypto {
     }
 
 
+    void Encryptor::setAsynchronousEnabled(bool nowEnabled) {
+        asynchronous = nowEnabled;
+    }
+
+
+    bool Encryptor::asynchronousEnabled() const {
+        return asynchronous;
+    }
+
+
+    void Encryptor::setMaximumQueuedBytes(qint64 newMaximumQueuedBytes) {
+        currentMaximumQueuedBytes = newMaximumQueuedBytes;
+    }
+
+
+    qint64 Encryptor::maximumQueuedBytes() const {
+        return currentMaximumQueuedBytes;
+    }
+
+
+    qint64 Encryptor::bytesToWrite() const {
+        qint64 result;
+
+        if (currentWorker != Q_NULLPTR) {
+            QMutexLocker locker(&currentWorker->queueMutex);
+            result = currentWorker->numberQueuedBytes;
+        } else {
+            result = QIODevice::bytesToWrite();
+        }
+
+        return result;
+    }
+
+
+    bool Encryptor::waitForBytesWritten(int msecs) {
+        bool result;
+
+        if (currentWorker != Q_NULLPTR) {
+            currentWorker->queueMutex.lock();
+
+            bool working = currentWorker->busy || !currentWorker->pendingInput.isEmpty();
+            if (working && currentWorker->pendingOutput.isEmpty()) {
+                unsigned long timeout = msecs < 0 ? ULONG_MAX : static_cast<unsigned long>(msecs);
+                currentWorker->outputReady.wait(&currentWorker->queueMutex, timeout);
+            }
+
+            bool outputPending = !currentWorker->pendingOutput.isEmpty();
+            currentWorker->queueMutex.unlock();
+
+            result = outputPending && writeEncryptedData();
+        } else {
+            result = QIODevice::waitForBytesWritten(msecs);
+        }
+
+        return result;
+    }
+
+
     bool Encryptor::isSequential() const {
         return true;
     }
@@ -192,13 +630,41 @@ namespace Crypto {
     }
 
 
+    unsigned Encryptor::headerSize() const {
+        return 0;
+    }
+
+
+    unsigned Encryptor::trailerSize() const {
+        return 0;
+    }
+
+
     unsigned long long Encryptor::numberInputBytesProcessed() const {
-        return currentNumberInputBytesProcessed;
+        unsigned long long result;
+
+        if (currentWorker != Q_NULLPTR) {
+            QMutexLocker locker(&currentWorker->engineMutex);
+            result = currentNumberInputBytesProcessed;
+        } else {
+            result = currentNumberInputBytesProcessed;
+        }
+
+        return result;
     }
 
 
     unsigned long long Encryptor::numberOutputBytesProcessed() const {
-        return currentNumberOutputBytesProcessed;
+        unsigned long long result;
+
+        if (currentWorker != Q_NULLPTR) {
+            QMutexLocker locker(&currentWorker->engineMutex);
+            result = currentNumberOutputBytesProcessed;
+        } else {
+            result = currentNumberOutputBytesProcessed;
+        }
+
+        return result;
     }
 
 
@@ -208,22 +674,35 @@ namespace Crypto {
 
 
     qint64 Encryptor::writeData(const char* data, qint64 maxSize) {
-        qint64 result = 0;
+        qint64 result;
 
-        if (currentOutputDevice != Q_NULLPTR) {
-            if (inputBufferAllocation == 0) {
-                inputBufferAllocation  = inputChunkSize();
-                outputBufferAllocation = outputChunkSize();
+        if (currentWorker != Q_NULLPTR && currentOutputDevice != Q_NULLPTR) {
+            QMutexLocker locker(&currentWorker->queueMutex);
 
-                inputBuffer.resize(inputBufferAllocation);
-                outputBuffer.resize(outputBufferAllocation);
-
-                inputBufferIndex = 0;
-                inputData = reinterpret_cast<std::uint8_t*>(inputBuffer.data());
+            if (currentWorker->failed) {
+                result = -1;
+            } else {
+                qint64 available = std::max(currentMaximumQueuedBytes - currentWorker->numberQueuedBytes, qint64(0));
+                result = std::min(maxSize, available);
 
-                resetEngine();
+                if (result > 0) {
+                    currentWorker->pendingInput.append(data, static_cast<int>(result));
+                    currentWorker->numberQueuedBytes += result;
+                    currentWorker->inputQueued.wakeOne();
+                }
             }
+        } else {
+            result = encryptToDevice(data, maxSize, currentOutputDevice);
+        }
+
+        return result;
+    }
+
+
+    qint64 Encryptor::encryptToDevice(const char* data, qint64 maxSize, QIODevice* device) {
+        qint64 result = 0;
 
+        if (device != Q_NULLPTR) {
             unsigned long long  bytesRemaining         = static_cast<unsigned long long>(maxSize);
             const std::uint8_t* source                 = reinterpret_cast<const std::uint8_t*>(data);
             unsigned            bytesRemainingInBuffer = inputBufferAllocation - inputBufferIndex;
@@ -237,7 +716,7 @@ namespace Crypto {
             bool success;
             if (inputBufferIndex >= inputBufferAllocation) {
                 encryptChunk(inputData, reinterpret_cast<std::uint8_t*>(outputBuffer.data()));
-                qint64 bytesSent = currentOutputDevice->write(outputBuffer);
+                qint64 bytesSent = device->write(outputBuffer.constData(), outputBufferAllocation);
 
                 if (bytesSent == static_cast<qint64>(outputBufferAllocation)) {
                     result         += bytesToWriteThisPass;
@@ -253,19 +732,23 @@ namespace Crypto {
                 }
 
                 while (success && bytesRemaining >= inputBufferAllocation) {
-                    encryptChunk(
-                        reinterpret_cast<const std::uint8_t*>(source),
-                        reinterpret_cast<std::uint8_t*>(outputBuffer.data())
+                    unsigned numberChunks = static_cast<unsigned>(
+                        std::min(bytesRemaining / inputBufferAllocation, static_cast<unsigned long long>(chunksPerPass))
                     );
-                    qint64 bytesSent = currentOutputDevice->write(outputBuffer);
 
-                    if (bytesSent == static_cast<qint64>(outputBufferAllocation)) {
-                        result         += inputBufferAllocation;
-                        source         += inputBufferAllocation;
-                        bytesRemaining -= inputBufferAllocation;
+                    unsigned inputBytes  = numberChunks * inputBufferAllocation;
+                    unsigned outputBytes = numberChunks * outputBufferAllocation;
 
-                        currentNumberInputBytesProcessed  += inputBufferAllocation;
-                        currentNumberOutputBytesProcessed += outputBufferAllocation;
+                    encryptChunks(source, reinterpret_cast<std::uint8_t*>(outputBuffer.data()), numberChunks);
+                    qint64 bytesSent = device->write(outputBuffer.constData(), outputBytes);
+
+                    if (bytesSent == static_cast<qint64>(outputBytes)) {
+                        result         += inputBytes;
+                        source         += inputBytes;
+                        bytesRemaining -= inputBytes;
+
+                        currentNumberInputBytesProcessed  += inputBytes;
+                        currentNumberOutputBytesProcessed += outputBytes;
                     } else {
                         success = false;
                     }
@@ -280,7 +763,7 @@ namespace Crypto {
                         inputBufferIndex = 0;
                     }
                 } else {
-                    setErrorString(tr("Output device reported error: %1").arg(currentOutputDevice->errorString()));
+                    setErrorString(tr("Output device reported error: %1").arg(device->errorString()));
                     result = -1;
                 }
             } else {
@@ -296,14 +779,115 @@ namespace Crypto {
     }
 
 
+    void Encryptor::generateHeader(std::uint8_t* /* headerData */) {}
+
+
+    void Encryptor::generateTrailer(std::uint8_t* /* trailerData */) {}
+
+
+    void Encryptor::finishEngine() {}
+
+
+    bool Encryptor::streamAllowed() const {
+        return true;
+    }
+
+
+    void Encryptor::encryptChunks(const std::uint8_t* inputData, std::uint8_t* outputData, std::size_t numberChunks) {
+        unsigned inChunkSize  = inputChunkSize();
+        unsigned outChunkSize = outputChunkSize();
+
+        for (std::size_t chunk=0 ; chunk<numberChunks ; ++chunk) {
+            encryptChunk(inputData, outputData);
+
+            inputData  += inChunkSize;
+            outputData += outChunkSize;
+        }
+    }
+
+
+    bool Encryptor::writeEncryptedData() {
+        bool result;
+
+        if (currentWorker != Q_NULLPTR && currentOutputDevice != Q_NULLPTR) {
+            QByteArray encrypted;
+            qint64     numberInputBytes;
+
+            currentWorker->queueMutex.lock();
+            encrypted.swap(currentWorker->pendingOutput);
+            numberInputBytes = currentWorker->numberPendingInputBytes;
+            currentWorker->numberPendingInputBytes = 0;
+            currentWorker->writePosted             = false;
+            currentWorker->queueMutex.unlock();
+
+            if (encrypted.isEmpty()) {
+                result = true;
+            } else {
+                qint64 bytesSent = currentOutputDevice->write(encrypted);
+                result = (bytesSent == encrypted.size());
+
+                currentWorker->queueMutex.lock();
+                if (result) {
+                    currentWorker->numberQueuedBytes -= numberInputBytes;
+                } else {
+                    currentWorker->failed = true;
+                }
+                currentWorker->queueMutex.unlock();
+
+                if (result) {
+                    emit bytesWritten(numberInputBytes);
+                } else {
+                    setErrorString(tr("Output device reported error: %1").arg(currentOutputDevice->errorString()));
+                }
+            }
+        } else {
+            result = true;
+        }
+
+        return result;
+    }
+
+
+    bool Encryptor::drainWorker() {
+        currentWorker->queueMutex.lock();
+        while (currentWorker->busy || !currentWorker->pendingInput.isEmpty()) {
+            currentWorker->outputReady.wait(&currentWorker->queueMutex);
+        }
+
+        bool failed = currentWorker->failed;
+        currentWorker->queueMutex.unlock();
+
+        return !failed && writeEncryptedData();
+    }
+
+
+    void Encryptor::stopWorker() {
+        if (currentWorker != Q_NULLPTR) {
+            currentWorker->queueMutex.lock();
+            currentWorker->stopRequested = true;
+            currentWorker->inputQueued.wakeAll();
+            currentWorker->queueMutex.unlock();
+
+            currentWorker->wait();
+
+            delete currentWorker;
+            currentWorker = Q_NULLPTR;
+        }
+    }
+
+
     void Encryptor::configure(QIODevice* outputDevice) {
         currentOutputDevice               = outputDevice;
         inputBufferAllocation             = 0;
         outputBufferAllocation            = 0;
+        chunksPerPass                     = 0;
         inputBufferIndex                  = 0;
         inputData                         = Q_NULLPTR;
         currentNumberInputBytesProcessed  = static_cast<unsigned long long>(-1);
         currentNumberOutputBytesProcessed = static_cast<unsigned long long>(-1);
+        asynchronous                      = false;
+        currentMaximumQueuedBytes         = defaultMaximumQueuedBytes;
+        currentWorker                     = Q_NULLPTR;
     }
 }
 
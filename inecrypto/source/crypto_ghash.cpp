@@ -0,0 +1,325 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::Ghash class.
+***********************************************************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_cpu_features.h"
+
+#if (CRYPTO_X86)
+    #include <emmintrin.h>
+    #include <tmmintrin.h>
+    #include <wmmintrin.h>
+#endif
+
+#include "crypto_ghash.h"
+
+namespace Crypto {
+    /**
+     * Reduction constants used by the table driven multiplier, indexed by the four bits shifted out.
+     */
+    static const std::uint64_t reductionTable[16] = {
+        0x0000, 0x1C20, 0x3840, 0x2460, 0x7080, 0x6CA0, 0x48C0, 0x54E0,
+        0xE100, 0xFD20, 0xD940, 0xC560, 0x9180, 0x8DA0, 0xA9C0, 0xB5E0
+    };
+
+    /**
+     * Function that loads a big-endian 64-bit value.
+     *
+     * \param[in] data Pointer to the value.
+     *
+     * \return Returns the loaded value.
+     */
+    static inline std::uint64_t loadBigEndian64(const std::uint8_t* data) {
+        std::uint64_t result = 0;
+        for (unsigned i=0 ; i<8 ; ++i) {
+            result = (result << 8) | data[i];
+        }
+
+        return result;
+    }
+
+
+    /**
+     * Function that stores a big-endian 64-bit value.
+     *
+     * \param[in]  value The value to be stored.
+     *
+     * \param[out] data  Pointer to the location to receive the value.
+     */
+    static inline void storeBigEndian64(std::uint64_t value, std::uint8_t* data) {
+        for (int i=7 ; i>=0 ; --i) {
+            data[i] = static_cast<std::uint8_t>(value);
+            value >>= 8;
+        }
+    }
+
+    #if (CRYPTO_X86)
+
+        /**
+         * Function that multiplies two byte reversed values in GF(2^128) using the carry-less multiply instruction.
+         * The algorithm follows the Intel carry-less multiplication white paper.
+         *
+         * \param[in] a The first operand.
+         *
+         * \param[in] b The second operand.
+         *
+         * \return Returns the byte reversed product.
+         */
+        CRYPTO_TARGET("pclmul,sse2") static inline __m128i multiplyPclmul(__m128i a, __m128i b) {
+            __m128i t3 = _mm_clmulepi64_si128(a, b, 0x00);
+            __m128i t4 = _mm_clmulepi64_si128(a, b, 0x10);
+            __m128i t5 = _mm_clmulepi64_si128(a, b, 0x01);
+            __m128i t6 = _mm_clmulepi64_si128(a, b, 0x11);
+
+            t4 = _mm_xor_si128(t4, t5);
+            t5 = _mm_slli_si128(t4, 8);
+            t4 = _mm_srli_si128(t4, 8);
+            t3 = _mm_xor_si128(t3, t5);
+            t6 = _mm_xor_si128(t6, t4);
+
+            // Shift the 256-bit product left by one bit to account for the reflected bit order.
+            __m128i t7 = _mm_srli_epi32(t3, 31);
+            __m128i t8 = _mm_srli_epi32(t6, 31);
+            t3 = _mm_slli_epi32(t3, 1);
+            t6 = _mm_slli_epi32(t6, 1);
+
+            __m128i t9 = _mm_srli_si128(t7, 12);
+            t8 = _mm_slli_si128(t8, 4);
+            t7 = _mm_slli_si128(t7, 4);
+            t3 = _mm_or_si128(t3, t7);
+            t6 = _mm_or_si128(t6, t8);
+            t6 = _mm_or_si128(t6, t9);
+
+            // Reduce modulo x^128 + x^7 + x^2 + x + 1.
+            t7 = _mm_slli_epi32(t3, 31);
+            t8 = _mm_slli_epi32(t3, 30);
+            t9 = _mm_slli_epi32(t3, 25);
+            t7 = _mm_xor_si128(t7, t8);
+            t7 = _mm_xor_si128(t7, t9);
+            t8 = _mm_srli_si128(t7, 4);
+            t7 = _mm_slli_si128(t7, 12);
+            t3 = _mm_xor_si128(t3, t7);
+
+            __m128i t2 = _mm_srli_epi32(t3, 1);
+            t4 = _mm_srli_epi32(t3, 2);
+            t5 = _mm_srli_epi32(t3, 7);
+            t2 = _mm_xor_si128(t2, t4);
+            t2 = _mm_xor_si128(t2, t5);
+            t2 = _mm_xor_si128(t2, t8);
+            t3 = _mm_xor_si128(t3, t2);
+            t6 = _mm_xor_si128(t6, t3);
+
+            return t6;
+        }
+
+
+        /**
+         * Function that folds whole blocks into the accumulator using the carry-less multiply instruction.  The
+         * accumulator is held in registers across the blocks.
+         *
+         * \param[in]     reflectedKey The byte reversed hash key.
+         *
+         * \param[in,out] accumulator  The accumulator.
+         *
+         * \param[in]     data         The blocks to be hashed.
+         *
+         * \param[in]     numberBlocks The number of blocks to be hashed.
+         */
+        CRYPTO_TARGET("pclmul,ssse3,sse2") static void processBlocksPclmul(
+                const std::uint8_t* reflectedKey,
+                std::uint8_t*       accumulator,
+                const std::uint8_t* data,
+                std::size_t         numberBlocks
+            ) {
+            const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+            const __m128i h       = _mm_load_si128(reinterpret_cast<const __m128i*>(reflectedKey));
+
+            __m128i y = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(accumulator)), reverse);
+            for (std::size_t i=0 ; i<numberBlocks ; ++i) {
+                __m128i x = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), reverse);
+                y = multiplyPclmul(_mm_xor_si128(y, x), h);
+                data += Ghash::blockLength;
+            }
+
+            _mm_store_si128(reinterpret_cast<__m128i*>(accumulator), _mm_shuffle_epi8(y, reverse));
+        }
+
+    #endif
+
+    void Ghash::setKey(const std::uint8_t* hashKey) {
+        for (unsigned i=0 ; i<blockLength ; ++i) {
+            reflectedKey[i] = hashKey[blockLength - 1 - i];
+        }
+
+        // Build the table of multiples of the key used by the 4-bit table driven multiplier.  Entry 8 holds the key,
+        // entries 4, 2 and 1 hold the key times x, x^2 and x^3 and the remaining entries are sums of those.
+        std::uint64_t vh = loadBigEndian64(hashKey);
+        std::uint64_t vl = loadBigEndian64(hashKey + 8);
+
+        tableHigh[0] = 0;
+        tableLow[0]  = 0;
+        tableHigh[8] = vh;
+        tableLow[8]  = vl;
+
+        for (unsigned i=4 ; i>0 ; i>>=1) {
+            std::uint64_t t = (vl & 1) ? 0xE100000000000000ULL : 0;
+            vl = (vh << 63) | (vl >> 1);
+            vh = (vh >> 1) ^ t;
+
+            tableHigh[i] = vh;
+            tableLow[i]  = vl;
+        }
+
+        for (unsigned i=2 ; i<=8 ; i<<=1) {
+            for (unsigned j=1 ; j<i ; ++j) {
+                tableHigh[i + j] = tableHigh[i] ^ tableHigh[j];
+                tableLow[i + j]  = tableLow[i] ^ tableLow[j];
+            }
+        }
+
+        reset();
+    }
+
+
+    void Ghash::reset() {
+        std::memset(accumulator, 0, blockLength);
+        partialLength = 0;
+    }
+
+
+    void Ghash::update(const std::uint8_t* data, std::size_t length) {
+        if (partialLength > 0) {
+            unsigned bytesToCopy = static_cast<unsigned>(
+                std::min(length, static_cast<std::size_t>(blockLength - partialLength))
+            );
+
+            std::memcpy(partialBlock + partialLength, data, bytesToCopy);
+            partialLength += bytesToCopy;
+            data          += bytesToCopy;
+            length        -= bytesToCopy;
+
+            if (partialLength == blockLength) {
+                processBlocks(partialBlock, 1);
+                partialLength = 0;
+            }
+        }
+
+        std::size_t numberBlocks = length / blockLength;
+        if (numberBlocks > 0) {
+            processBlocks(data, numberBlocks);
+
+            data   += numberBlocks * blockLength;
+            length -= numberBlocks * blockLength;
+        }
+
+        if (length > 0) {
+            std::memcpy(partialBlock, data, length);
+            partialLength = static_cast<unsigned>(length);
+        }
+    }
+
+
+    void Ghash::padBlock() {
+        if (partialLength > 0) {
+            std::memset(partialBlock + partialLength, 0, blockLength - partialLength);
+            processBlocks(partialBlock, 1);
+            partialLength = 0;
+        }
+    }
+
+
+    void Ghash::digest(std::uint8_t* digest) {
+        padBlock();
+        std::memcpy(digest, accumulator, blockLength);
+    }
+
+
+    void Ghash::scrub() {
+        std::memset(reflectedKey, 0, blockLength);
+        std::memset(accumulator, 0, blockLength);
+        std::memset(partialBlock, 0, blockLength);
+        std::memset(tableHigh, 0, sizeof(tableHigh));
+        std::memset(tableLow, 0, sizeof(tableLow));
+
+        partialLength = 0;
+    }
+
+
+    bool Ghash::hardwareAccelerated() {
+        return cpuHasPclmul();
+    }
+
+
+    void Ghash::multiplyAccumulator() {
+        std::uint8_t  nibble = accumulator[15] & 0x0F;
+        std::uint64_t zh     = tableHigh[nibble];
+        std::uint64_t zl     = tableLow[nibble];
+
+        for (int i=15 ; i>=0 ; --i) {
+            std::uint8_t low  = accumulator[i] & 0x0F;
+            std::uint8_t high = accumulator[i] >> 4;
+
+            if (i != 15) {
+                unsigned remainder = static_cast<unsigned>(zl & 0x0F);
+                zl = (zh << 60) | (zl >> 4);
+                zh = (zh >> 4) ^ (reductionTable[remainder] << 48);
+                zh ^= tableHigh[low];
+                zl ^= tableLow[low];
+            }
+
+            unsigned remainder = static_cast<unsigned>(zl & 0x0F);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (reductionTable[remainder] << 48);
+            zh ^= tableHigh[high];
+            zl ^= tableLow[high];
+        }
+
+        storeBigEndian64(zh, accumulator);
+        storeBigEndian64(zl, accumulator + 8);
+    }
+
+
+    void Ghash::processBlocks(const std::uint8_t* data, std::size_t numberBlocks) {
+        #if (CRYPTO_X86)
+            if (hardwareAccelerated()) {
+                processBlocksPclmul(reflectedKey, accumulator, data, numberBlocks);
+            } else {
+                processBlocksTable(data, numberBlocks);
+            }
+        #else
+            processBlocksTable(data, numberBlocks);
+        #endif
+    }
+
+
+    void Ghash::processBlocksTable(const std::uint8_t* data, std::size_t numberBlocks) {
+        for (std::size_t block=0 ; block<numberBlocks ; ++block) {
+            for (unsigned i=0 ; i<blockLength ; ++i) {
+                accumulator[i] ^= data[i];
+            }
+
+            multiplyAccumulator();
+            data += blockLength;
+        }
+    }
+}
@@ -0,0 +1,145 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::Ghash class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_GHASH_H
+#define CRYPTO_GHASH_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Crypto {
+    /**
+     * Class that calculates the GHASH universal hash used by AES-GCM.  Data can be supplied in pieces of any size.
+     * Where the processor supports carry-less multiplication, the PCLMULQDQ instruction is used.  Otherwise a
+     * 4-bit table driven multiplier is used.
+     */
+    class Ghash {
+        public:
+            /**
+             * The GHASH block and digest length, in bytes.
+             */
+            static constexpr unsigned blockLength = 16;
+
+            /**
+             * Method you can use to set the hash key.  The accumulator is also reset.
+             *
+             * \param[in] hashKey The 16 byte hash key.  For AES-GCM this is the encryption of the zero block.
+             */
+            void setKey(const std::uint8_t* hashKey);
+
+            /**
+             * Method you can use to reset the accumulator without changing the hash key.
+             */
+            void reset();
+
+            /**
+             * Method you can use to add data to the hash.
+             *
+             * \param[in] data   Pointer to the data to be hashed.
+             *
+             * \param[in] length The number of bytes to be hashed.
+             */
+            void update(const std::uint8_t* data, std::size_t length);
+
+            /**
+             * Method you can use to zero pad any partial block held by the hash.  AES-GCM pads the associated data
+             * and the ciphertext independently.
+             */
+            void padBlock();
+
+            /**
+             * Method you can use to obtain the current hash value.  Any partial block is zero padded first.
+             *
+             * \param[out] digest Buffer to receive the 16 byte hash value.
+             */
+            void digest(std::uint8_t* digest);
+
+            /**
+             * Method you can use to scrub the hash state.
+             */
+            void scrub();
+
+            /**
+             * Method you can use to determine if the carry-less multiply instruction is used.
+             *
+             * \return Returns true if the carry-less multiply instruction is used.  Returns false if the table
+             *         driven implementation is used.
+             */
+            static bool hardwareAccelerated();
+
+        private:
+            /**
+             * Method that multiplies the accumulator by the hash key using the table driven multiplier.
+             */
+            void multiplyAccumulator();
+
+            /**
+             * Method that folds whole blocks into the accumulator.
+             *
+             * \param[in] data         Pointer to the blocks to be hashed.
+             *
+             * \param[in] numberBlocks The number of blocks to be hashed.
+             */
+            void processBlocks(const std::uint8_t* data, std::size_t numberBlocks);
+
+            /**
+             * Method that folds whole blocks into the accumulator using the table driven multiplier.
+             *
+             * \param[in] data         Pointer to the blocks to be hashed.
+             *
+             * \param[in] numberBlocks The number of blocks to be hashed.
+             */
+            void processBlocksTable(const std::uint8_t* data, std::size_t numberBlocks);
+
+            /**
+             * The hash key, byte reversed for the carry-less multiply implementation.
+             */
+            alignas(16) std::uint8_t reflectedKey[blockLength];
+
+            /**
+             * The accumulator.
+             */
+            alignas(16) std::uint8_t accumulator[blockLength];
+
+            /**
+             * Buffered partial block.
+             */
+            std::uint8_t partialBlock[blockLength];
+
+            /**
+             * The number of bytes held in the partial block.
+             */
+            unsigned partialLength;
+
+            /**
+             * High 64 bits of the multiples of the hash key used by the table driven implementation.
+             */
+            std::uint64_t tableHigh[16];
+
+            /**
+             * Low 64 bits of the multiples of the hash key used by the table driven implementation.
+             */
+            std::uint64_t tableLow[16];
+    };
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::HmacSha256 class.
+***********************************************************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "crypto_sha256.h"
+#include "crypto_hmac_sha256.h"
+
+namespace Crypto {
+    HmacSha256::HmacSha256(const std::uint8_t* key, std::size_t keyLength) {
+        std::uint8_t paddedKey[blockSize];
+        std::memset(paddedKey, 0, blockSize);
+
+        if (keyLength > blockSize) {
+            Sha256::hash(key, keyLength, paddedKey);
+        } else {
+            std::memcpy(paddedKey, key, keyLength);
+        }
+
+        for (unsigned i=0 ; i<blockSize ; ++i) {
+            paddedKey[i] ^= 0x36;
+        }
+
+        innerKeyed.addData(paddedKey, blockSize);
+
+        for (unsigned i=0 ; i<blockSize ; ++i) {
+            paddedKey[i] ^= 0x36 ^ 0x5C;
+        }
+
+        outerKeyed.addData(paddedKey, blockSize);
+        std::memset(paddedKey, 0, blockSize);
+
+        inner = innerKeyed;
+    }
+
+
+    void HmacSha256::reset() {
+        inner = innerKeyed;
+    }
+
+
+    void HmacSha256::addData(const std::uint8_t* data, std::size_t length) {
+        inner.addData(data, length);
+    }
+
+
+    void HmacSha256::addData(const ConstBuffer* buffers, std::size_t numberBuffers) {
+        for (std::size_t i=0 ; i<numberBuffers ; ++i) {
+            inner.addData(buffers[i].data, buffers[i].length);
+        }
+    }
+
+
+    void HmacSha256::result(std::uint8_t* digest) const {
+        std::uint8_t innerDigest[digestSize];
+        inner.result(innerDigest);
+
+        Sha256 outer = outerKeyed;
+        outer.addData(innerDigest, digestSize);
+        outer.result(digest);
+
+        std::memset(innerDigest, 0, digestSize);
+    }
+
+
+    void HmacSha256::hmac(
+            const std::uint8_t* key,
+            std::size_t         keyLength,
+            const std::uint8_t* data,
+            std::size_t         length,
+            std::uint8_t*       digest
+        ) {
+        HmacSha256 hmacSha256(key, keyLength);
+        hmacSha256.addData(data, length);
+        hmacSha256.result(digest);
+    }
+}
@@ -0,0 +1,199 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::Kdf class.
+***********************************************************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_hmac_sha256.h"
+#include "crypto_pbkdf2_engine.h"
+#include "crypto_kdf.h"
+
+namespace Crypto {
+    static_assert(Kdf::digestSize == HmacSha256::digestSize, "Unexpected HMAC digest size.");
+    static_assert(Kdf::digestSize == Pbkdf2Engine::blockLength, "Unexpected PBKDF2 block length.");
+
+    void Kdf::hkdfExtract(
+            const std::uint8_t* salt,
+            std::size_t         saltLength,
+            const std::uint8_t* inputKey,
+            std::size_t         inputKeyLength,
+            std::uint8_t*       pseudoRandomKey
+        ) {
+        // HMAC pads short keys with zeros so an empty salt already behaves as digestSize zero bytes.
+        static const std::uint8_t emptySalt[1] = { 0 };
+        HmacSha256::hmac(saltLength > 0 ? salt : emptySalt, saltLength, inputKey, inputKeyLength, pseudoRandomKey);
+    }
+
+
+    bool Kdf::hkdfExpand(
+            const std::uint8_t* pseudoRandomKey,
+            std::size_t         pseudoRandomKeyLength,
+            const std::uint8_t* info,
+            std::size_t         infoLength,
+            std::uint8_t*       outputKey,
+            std::size_t         outputKeyLength
+        ) {
+        bool result;
+
+        if (outputKeyLength > maximumHkdfLength) {
+            result = false;
+        } else {
+            HmacSha256   hmac(pseudoRandomKey, pseudoRandomKeyLength);
+            std::uint8_t block[digestSize];
+            std::uint8_t counter = 0;
+
+            std::size_t offset = 0;
+            while (offset < outputKeyLength) {
+                ++counter;
+
+                hmac.reset();
+                if (counter > 1) {
+                    hmac.addData(block, digestSize);
+                }
+
+                if (infoLength > 0) {
+                    hmac.addData(info, infoLength);
+                }
+
+                hmac.addData(&counter, 1);
+                hmac.result(block);
+
+                std::size_t bytesToCopy = std::min(static_cast<std::size_t>(digestSize), outputKeyLength - offset);
+                std::memcpy(outputKey + offset, block, bytesToCopy);
+                offset += bytesToCopy;
+            }
+
+            std::memset(block, 0, digestSize);
+            result = true;
+        }
+
+        return result;
+    }
+
+
+    bool Kdf::hkdf(
+            const std::uint8_t* salt,
+            std::size_t         saltLength,
+            const std::uint8_t* inputKey,
+            std::size_t         inputKeyLength,
+            const std::uint8_t* info,
+            std::size_t         infoLength,
+            std::uint8_t*       outputKey,
+            std::size_t         outputKeyLength
+        ) {
+        std::uint8_t pseudoRandomKey[digestSize];
+        hkdfExtract(salt, saltLength, inputKey, inputKeyLength, pseudoRandomKey);
+
+        bool result = hkdfExpand(pseudoRandomKey, digestSize, info, infoLength, outputKey, outputKeyLength);
+        std::memset(pseudoRandomKey, 0, digestSize);
+
+        return result;
+    }
+
+
+    bool Kdf::pbkdf2(
+            const std::uint8_t* password,
+            std::size_t         passwordLength,
+            const std::uint8_t* salt,
+            std::size_t         saltLength,
+            unsigned long       iterations,
+            std::uint8_t*       derivedKey,
+            std::size_t         derivedKeyLength
+        ) {
+        ConstBuffer passwordBuffer = { password, passwordLength };
+        return pbkdf2(&passwordBuffer, 1, salt, saltLength, iterations, derivedKey, derivedKeyLength);
+    }
+
+
+    bool Kdf::pbkdf2(
+            const ConstBuffer*  passwords,
+            std::size_t         numberPasswords,
+            const std::uint8_t* salt,
+            std::size_t         saltLength,
+            unsigned long       iterations,
+            std::uint8_t*       derivedKeys,
+            std::size_t         derivedKeyLength
+        ) {
+        bool result;
+
+        if (iterations == 0) {
+            result = false;
+        } else {
+            static const std::uint8_t emptyBuffer[1] = { 0 };
+            const std::uint8_t* saltData = saltLength > 0 ? salt : emptyBuffer;
+
+            // Every output block of every password is an independent lane.  Lanes are filled in order so a single
+            // long key and a batch of short keys both keep the SIMD lanes busy.
+            std::size_t blocksPerKey = (derivedKeyLength + digestSize - 1) / digestSize;
+            std::size_t numberLanes  = blocksPerKey * numberPasswords;
+
+            Pbkdf2Engine engine;
+            std::uint8_t block[digestSize];
+
+            std::size_t firstLane = 0;
+            while (firstLane < numberLanes) {
+                unsigned lanesInGroup = static_cast<unsigned>(
+                    std::min(numberLanes - firstLane, static_cast<std::size_t>(Pbkdf2Engine::maximumLanes))
+                );
+
+                engine.scrub();
+                for (unsigned lane=0 ; lane<lanesInGroup ; ++lane) {
+                    std::size_t        passwordIndex = (firstLane + lane) / blocksPerKey;
+                    std::size_t        blockIndex    = (firstLane + lane) % blocksPerKey;
+                    const ConstBuffer& password      = passwords[passwordIndex];
+
+                    engine.setLane(
+                        lane,
+                        password.length > 0 ? password.data : emptyBuffer,
+                        password.length,
+                        saltData,
+                        saltLength,
+                        static_cast<std::uint32_t>(blockIndex + 1)
+                    );
+                }
+
+                engine.iterate(lanesInGroup, iterations - 1);
+
+                for (unsigned lane=0 ; lane<lanesInGroup ; ++lane) {
+                    std::size_t passwordIndex = (firstLane + lane) / blocksPerKey;
+                    std::size_t blockOffset   = ((firstLane + lane) % blocksPerKey) * digestSize;
+                    std::size_t bytesToCopy   = std::min(
+                        static_cast<std::size_t>(digestSize),
+                        derivedKeyLength - blockOffset
+                    );
+
+                    engine.result(lane, block);
+                    std::memcpy(derivedKeys + passwordIndex * derivedKeyLength + blockOffset, block, bytesToCopy);
+                }
+
+                firstLane += lanesInGroup;
+            }
+
+            engine.scrub();
+            std::memset(block, 0, digestSize);
+
+            result = true;
+        }
+
+        return result;
+    }
+}
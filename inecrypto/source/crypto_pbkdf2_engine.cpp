@@ -0,0 +1,702 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::Pbkdf2Engine class.
+***********************************************************************************************************************/
+
+#include <cstring>
+
+#include "crypto_cpu_features.h"
+
+#if (CRYPTO_X86)
+    #include <emmintrin.h>
+    #include <immintrin.h>
+#endif
+
+#include "crypto_sha256.h"
+#include "crypto_hmac_sha256.h"
+#include "crypto_pbkdf2_engine.h"
+
+namespace Crypto {
+    /**
+     * The SHA-256 round constants.  The iteration loop runs its own compression function on words so the constants
+     * are repeated here rather than exposed by \ref Crypto::Sha256.
+     */
+    static const std::uint32_t roundConstants[64] = {
+        0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+        0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+        0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+        0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+        0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+        0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+        0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+        0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+    };
+
+    /**
+     * The SHA-256 initial hash state.
+     */
+    static const std::uint32_t initialState[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+    };
+
+    /**
+     * The first padding word of a 32 byte message following a keyed block.
+     */
+    static constexpr std::uint32_t paddingWord = 0x80000000;
+
+    /**
+     * The length, in bits, of the keyed block plus a 32 byte message.  This is the final word of the padded block.
+     */
+    static constexpr std::uint32_t messageBits = 8 * (Sha256::blockSize + Pbkdf2Engine::blockLength);
+
+    /**
+     * Function that rotates a 32-bit value right.
+     *
+     * \param[in] value The value to be rotated.
+     *
+     * \param[in] count The number of bits to rotate by.  The value must be between 1 and 31.
+     *
+     * \return Returns the rotated value.
+     */
+    static inline std::uint32_t rotateRight(std::uint32_t value, unsigned count) {
+        return (value >> count) | (value << (32 - count));
+    }
+
+    /**
+     * Function that applies the SHA-256 compression function to a block held as words.
+     *
+     * \param[in,out] state   The eight word hash state.
+     *
+     * \param[in]     message The sixteen word block.
+     */
+    static void compressWords(std::uint32_t* state, const std::uint32_t* message) {
+        std::uint32_t w[64];
+        std::memcpy(w, message, 16 * sizeof(std::uint32_t));
+
+        for (unsigned i=16 ; i<64 ; ++i) {
+            std::uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            std::uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        std::uint32_t a = state[0];
+        std::uint32_t b = state[1];
+        std::uint32_t c = state[2];
+        std::uint32_t d = state[3];
+        std::uint32_t e = state[4];
+        std::uint32_t f = state[5];
+        std::uint32_t g = state[6];
+        std::uint32_t h = state[7];
+
+        for (unsigned i=0 ; i<64 ; ++i) {
+            std::uint32_t s1    = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+            std::uint32_t ch    = (e & f) ^ (~e & g);
+            std::uint32_t temp1 = h + s1 + ch + roundConstants[i] + w[i];
+            std::uint32_t s0    = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+            std::uint32_t maj   = (a & b) ^ (a & c) ^ (b & c);
+            std::uint32_t temp2 = s0 + maj;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+
+        std::memset(w, 0, sizeof(w));
+    }
+
+    /**
+     * Function that calculates the hash state after absorbing a padded HMAC key XORed with a pad byte.
+     *
+     * \param[in]  paddedKey The key padded to the SHA-256 block size.
+     *
+     * \param[in]  pad       The pad byte.
+     *
+     * \param[out] state     The eight word hash state.
+     */
+    static void keyState(const std::uint8_t* paddedKey, std::uint8_t pad, std::uint32_t* state) {
+        std::uint32_t message[16];
+        for (unsigned i=0 ; i<16 ; ++i) {
+            message[i] = (
+                  (static_cast<std::uint32_t>(paddedKey[4 * i + 0] ^ pad) << 24)
+                | (static_cast<std::uint32_t>(paddedKey[4 * i + 1] ^ pad) << 16)
+                | (static_cast<std::uint32_t>(paddedKey[4 * i + 2] ^ pad) <<  8)
+                | (static_cast<std::uint32_t>(paddedKey[4 * i + 3] ^ pad)      )
+            );
+        }
+
+        std::memcpy(state, initialState, sizeof(initialState));
+        compressWords(state, message);
+
+        std::memset(message, 0, sizeof(message));
+    }
+
+    /**
+     * Function that runs the iteration loop on one lane at a time.
+     *
+     * \param[in]     innerState       The inner keyed state of the first lane.  Words are maximumLanes apart.
+     *
+     * \param[in]     outerState       The outer keyed state of the first lane.  Words are maximumLanes apart.
+     *
+     * \param[in,out] chain            The chaining value of the first lane.  Words are maximumLanes apart.
+     *
+     * \param[in,out] accumulator      The accumulator of the first lane.  Words are maximumLanes apart.
+     *
+     * \param[in]     numberLanes      The number of lanes to run.
+     *
+     * \param[in]     numberIterations The number of iterations.
+     */
+    static void iteratePortable(
+            const std::uint32_t* innerState,
+            const std::uint32_t* outerState,
+            std::uint32_t*       chain,
+            std::uint32_t*       accumulator,
+            unsigned             numberLanes,
+            unsigned long        numberIterations
+        ) {
+        constexpr unsigned stride = Pbkdf2Engine::maximumLanes;
+
+        std::uint32_t message[16];
+        std::uint32_t state[8];
+
+        std::memset(message, 0, sizeof(message));
+        message[8]  = paddingWord;
+        message[15] = messageBits;
+
+        for (unsigned lane=0 ; lane<numberLanes ; ++lane) {
+            std::uint32_t u[8];
+            std::uint32_t t[8];
+            for (unsigned i=0 ; i<8 ; ++i) {
+                u[i] = chain[i * stride + lane];
+                t[i] = accumulator[i * stride + lane];
+            }
+
+            for (unsigned long iteration=0 ; iteration<numberIterations ; ++iteration) {
+                std::memcpy(message, u, sizeof(u));
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    state[i] = innerState[i * stride + lane];
+                }
+
+                compressWords(state, message);
+
+                std::memcpy(message, state, sizeof(state));
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    state[i] = outerState[i * stride + lane];
+                }
+
+                compressWords(state, message);
+
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    u[i]  = state[i];
+                    t[i] ^= state[i];
+                }
+            }
+
+            for (unsigned i=0 ; i<8 ; ++i) {
+                chain[i * stride + lane]       = u[i];
+                accumulator[i * stride + lane] = t[i];
+            }
+
+            std::memset(u, 0, sizeof(u));
+            std::memset(t, 0, sizeof(t));
+        }
+
+        std::memset(message, 0, sizeof(message));
+        std::memset(state, 0, sizeof(state));
+    }
+
+    #if (CRYPTO_X86)
+
+        /**
+         * Function that rotates each 32-bit lane of an SSE2 vector right.
+         *
+         * \param[in] value The value to be rotated.
+         *
+         * \return Returns the rotated value.
+         */
+        template<int count> CRYPTO_TARGET("sse2") static inline __m128i rotateRightSse2(__m128i value) {
+            return _mm_or_si128(_mm_srli_epi32(value, count), _mm_slli_epi32(value, 32 - count));
+        }
+
+        /**
+         * Function that applies the SHA-256 compression function to four lanes at once.
+         *
+         * \param[in,out] state   The eight word hash state of each lane.
+         *
+         * \param[in]     message The sixteen word block of each lane.
+         */
+        CRYPTO_TARGET("sse2") static void compressSse2(__m128i* state, const __m128i* message) {
+            __m128i w[64];
+            for (unsigned i=0 ; i<16 ; ++i) {
+                w[i] = message[i];
+            }
+
+            for (unsigned i=16 ; i<64 ; ++i) {
+                __m128i s0 = _mm_xor_si128(
+                    _mm_xor_si128(rotateRightSse2<7>(w[i - 15]), rotateRightSse2<18>(w[i - 15])),
+                    _mm_srli_epi32(w[i - 15], 3)
+                );
+
+                __m128i s1 = _mm_xor_si128(
+                    _mm_xor_si128(rotateRightSse2<17>(w[i - 2]), rotateRightSse2<19>(w[i - 2])),
+                    _mm_srli_epi32(w[i - 2], 10)
+                );
+
+                w[i] = _mm_add_epi32(_mm_add_epi32(w[i - 16], s0), _mm_add_epi32(w[i - 7], s1));
+            }
+
+            __m128i a = state[0];
+            __m128i b = state[1];
+            __m128i c = state[2];
+            __m128i d = state[3];
+            __m128i e = state[4];
+            __m128i f = state[5];
+            __m128i g = state[6];
+            __m128i h = state[7];
+
+            for (unsigned i=0 ; i<64 ; ++i) {
+                __m128i s1 = _mm_xor_si128(
+                    _mm_xor_si128(rotateRightSse2<6>(e), rotateRightSse2<11>(e)),
+                    rotateRightSse2<25>(e)
+                );
+
+                __m128i ch    = _mm_xor_si128(_mm_and_si128(e, f), _mm_andnot_si128(e, g));
+                __m128i temp1 = _mm_add_epi32(
+                    _mm_add_epi32(_mm_add_epi32(h, s1), _mm_add_epi32(ch, w[i])),
+                    _mm_set1_epi32(static_cast<int>(roundConstants[i]))
+                );
+
+                __m128i s0 = _mm_xor_si128(
+                    _mm_xor_si128(rotateRightSse2<2>(a), rotateRightSse2<13>(a)),
+                    rotateRightSse2<22>(a)
+                );
+
+                __m128i maj = _mm_xor_si128(
+                    _mm_xor_si128(_mm_and_si128(a, b), _mm_and_si128(a, c)),
+                    _mm_and_si128(b, c)
+                );
+
+                __m128i temp2 = _mm_add_epi32(s0, maj);
+
+                h = g;
+                g = f;
+                f = e;
+                e = _mm_add_epi32(d, temp1);
+                d = c;
+                c = b;
+                b = a;
+                a = _mm_add_epi32(temp1, temp2);
+            }
+
+            state[0] = _mm_add_epi32(state[0], a);
+            state[1] = _mm_add_epi32(state[1], b);
+            state[2] = _mm_add_epi32(state[2], c);
+            state[3] = _mm_add_epi32(state[3], d);
+            state[4] = _mm_add_epi32(state[4], e);
+            state[5] = _mm_add_epi32(state[5], f);
+            state[6] = _mm_add_epi32(state[6], g);
+            state[7] = _mm_add_epi32(state[7], h);
+
+            std::memset(w, 0, sizeof(w));
+        }
+
+        /**
+         * Function that runs the iteration loop on four lanes at once using SSE2.
+         *
+         * \param[in]     innerState       The inner keyed state of the first lane.  Words are maximumLanes apart.
+         *
+         * \param[in]     outerState       The outer keyed state of the first lane.  Words are maximumLanes apart.
+         *
+         * \param[in,out] chain            The chaining value of the first lane.  Words are maximumLanes apart.
+         *
+         * \param[in,out] accumulator      The accumulator of the first lane.  Words are maximumLanes apart.
+         *
+         * \param[in]     numberIterations The number of iterations.
+         */
+        CRYPTO_TARGET("sse2") static void iterateSse2(
+                const std::uint32_t* innerState,
+                const std::uint32_t* outerState,
+                std::uint32_t*       chain,
+                std::uint32_t*       accumulator,
+                unsigned long        numberIterations
+            ) {
+            constexpr unsigned stride = Pbkdf2Engine::maximumLanes;
+
+            __m128i inner[8];
+            __m128i outer[8];
+            __m128i u[8];
+            __m128i t[8];
+            for (unsigned i=0 ; i<8 ; ++i) {
+                inner[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(innerState + i * stride));
+                outer[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(outerState + i * stride));
+                u[i]     = _mm_load_si128(reinterpret_cast<const __m128i*>(chain + i * stride));
+                t[i]     = _mm_load_si128(reinterpret_cast<const __m128i*>(accumulator + i * stride));
+            }
+
+            __m128i message[16];
+            for (unsigned i=8 ; i<15 ; ++i) {
+                message[i] = _mm_setzero_si128();
+            }
+
+            message[8]  = _mm_set1_epi32(static_cast<int>(paddingWord));
+            message[15] = _mm_set1_epi32(static_cast<int>(messageBits));
+
+            __m128i state[8];
+            for (unsigned long iteration=0 ; iteration<numberIterations ; ++iteration) {
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    message[i] = u[i];
+                    state[i]   = inner[i];
+                }
+
+                compressSse2(state, message);
+
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    message[i] = state[i];
+                    state[i]   = outer[i];
+                }
+
+                compressSse2(state, message);
+
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    u[i] = state[i];
+                    t[i] = _mm_xor_si128(t[i], state[i]);
+                }
+            }
+
+            for (unsigned i=0 ; i<8 ; ++i) {
+                _mm_store_si128(reinterpret_cast<__m128i*>(chain + i * stride), u[i]);
+                _mm_store_si128(reinterpret_cast<__m128i*>(accumulator + i * stride), t[i]);
+            }
+
+            std::memset(inner, 0, sizeof(inner));
+            std::memset(outer, 0, sizeof(outer));
+            std::memset(u, 0, sizeof(u));
+            std::memset(t, 0, sizeof(t));
+            std::memset(message, 0, sizeof(message));
+            std::memset(state, 0, sizeof(state));
+        }
+
+        /**
+         * Function that rotates each 32-bit lane of an AVX2 vector right.
+         *
+         * \param[in] value The value to be rotated.
+         *
+         * \return Returns the rotated value.
+         */
+        template<int count> CRYPTO_TARGET("avx2") static inline __m256i rotateRightAvx2(__m256i value) {
+            return _mm256_or_si256(_mm256_srli_epi32(value, count), _mm256_slli_epi32(value, 32 - count));
+        }
+
+        /**
+         * Function that applies the SHA-256 compression function to eight lanes at once.
+         *
+         * \param[in,out] state   The eight word hash state of each lane.
+         *
+         * \param[in]     message The sixteen word block of each lane.
+         */
+        CRYPTO_TARGET("avx2") static void compressAvx2(__m256i* state, const __m256i* message) {
+            __m256i w[64];
+            for (unsigned i=0 ; i<16 ; ++i) {
+                w[i] = message[i];
+            }
+
+            for (unsigned i=16 ; i<64 ; ++i) {
+                __m256i s0 = _mm256_xor_si256(
+                    _mm256_xor_si256(rotateRightAvx2<7>(w[i - 15]), rotateRightAvx2<18>(w[i - 15])),
+                    _mm256_srli_epi32(w[i - 15], 3)
+                );
+
+                __m256i s1 = _mm256_xor_si256(
+                    _mm256_xor_si256(rotateRightAvx2<17>(w[i - 2]), rotateRightAvx2<19>(w[i - 2])),
+                    _mm256_srli_epi32(w[i - 2], 10)
+                );
+
+                w[i] = _mm256_add_epi32(_mm256_add_epi32(w[i - 16], s0), _mm256_add_epi32(w[i - 7], s1));
+            }
+
+            __m256i a = state[0];
+            __m256i b = state[1];
+            __m256i c = state[2];
+            __m256i d = state[3];
+            __m256i e = state[4];
+            __m256i f = state[5];
+            __m256i g = state[6];
+            __m256i h = state[7];
+
+            for (unsigned i=0 ; i<64 ; ++i) {
+                __m256i s1 = _mm256_xor_si256(
+                    _mm256_xor_si256(rotateRightAvx2<6>(e), rotateRightAvx2<11>(e)),
+                    rotateRightAvx2<25>(e)
+                );
+
+                __m256i ch    = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+                __m256i temp1 = _mm256_add_epi32(
+                    _mm256_add_epi32(_mm256_add_epi32(h, s1), _mm256_add_epi32(ch, w[i])),
+                    _mm256_set1_epi32(static_cast<int>(roundConstants[i]))
+                );
+
+                __m256i s0 = _mm256_xor_si256(
+                    _mm256_xor_si256(rotateRightAvx2<2>(a), rotateRightAvx2<13>(a)),
+                    rotateRightAvx2<22>(a)
+                );
+
+                __m256i maj = _mm256_xor_si256(
+                    _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+                    _mm256_and_si256(b, c)
+                );
+
+                __m256i temp2 = _mm256_add_epi32(s0, maj);
+
+                h = g;
+                g = f;
+                f = e;
+                e = _mm256_add_epi32(d, temp1);
+                d = c;
+                c = b;
+                b = a;
+                a = _mm256_add_epi32(temp1, temp2);
+            }
+
+            state[0] = _mm256_add_epi32(state[0], a);
+            state[1] = _mm256_add_epi32(state[1], b);
+            state[2] = _mm256_add_epi32(state[2], c);
+            state[3] = _mm256_add_epi32(state[3], d);
+            state[4] = _mm256_add_epi32(state[4], e);
+            state[5] = _mm256_add_epi32(state[5], f);
+            state[6] = _mm256_add_epi32(state[6], g);
+            state[7] = _mm256_add_epi32(state[7], h);
+
+            std::memset(w, 0, sizeof(w));
+        }
+
+        /**
+         * Function that runs the iteration loop on eight lanes at once using AVX2.
+         *
+         * \param[in]     innerState       The inner keyed state of the first lane.  Words are maximumLanes apart.
+         *
+         * \param[in]     outerState       The outer keyed state of the first lane.  Words are maximumLanes apart.
+         *
+         * \param[in,out] chain            The chaining value of the first lane.  Words are maximumLanes apart.
+         *
+         * \param[in,out] accumulator      The accumulator of the first lane.  Words are maximumLanes apart.
+         *
+         * \param[in]     numberIterations The number of iterations.
+         */
+        CRYPTO_TARGET("avx2") static void iterateAvx2(
+                const std::uint32_t* innerState,
+                const std::uint32_t* outerState,
+                std::uint32_t*       chain,
+                std::uint32_t*       accumulator,
+                unsigned long        numberIterations
+            ) {
+            constexpr unsigned stride = Pbkdf2Engine::maximumLanes;
+
+            __m256i inner[8];
+            __m256i outer[8];
+            __m256i u[8];
+            __m256i t[8];
+            for (unsigned i=0 ; i<8 ; ++i) {
+                inner[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(innerState + i * stride));
+                outer[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(outerState + i * stride));
+                u[i]     = _mm256_load_si256(reinterpret_cast<const __m256i*>(chain + i * stride));
+                t[i]     = _mm256_load_si256(reinterpret_cast<const __m256i*>(accumulator + i * stride));
+            }
+
+            __m256i message[16];
+            for (unsigned i=8 ; i<15 ; ++i) {
+                message[i] = _mm256_setzero_si256();
+            }
+
+            message[8]  = _mm256_set1_epi32(static_cast<int>(paddingWord));
+            message[15] = _mm256_set1_epi32(static_cast<int>(messageBits));
+
+            __m256i state[8];
+            for (unsigned long iteration=0 ; iteration<numberIterations ; ++iteration) {
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    message[i] = u[i];
+                    state[i]   = inner[i];
+                }
+
+                compressAvx2(state, message);
+
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    message[i] = state[i];
+                    state[i]   = outer[i];
+                }
+
+                compressAvx2(state, message);
+
+                for (unsigned i=0 ; i<8 ; ++i) {
+                    u[i] = state[i];
+                    t[i] = _mm256_xor_si256(t[i], state[i]);
+                }
+            }
+
+            for (unsigned i=0 ; i<8 ; ++i) {
+                _mm256_store_si256(reinterpret_cast<__m256i*>(chain + i * stride), u[i]);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(accumulator + i * stride), t[i]);
+            }
+
+            std::memset(inner, 0, sizeof(inner));
+            std::memset(outer, 0, sizeof(outer));
+            std::memset(u, 0, sizeof(u));
+            std::memset(t, 0, sizeof(t));
+            std::memset(message, 0, sizeof(message));
+            std::memset(state, 0, sizeof(state));
+        }
+
+    #endif
+
+    void Pbkdf2Engine::setLane(
+            unsigned            lane,
+            const std::uint8_t* password,
+            std::size_t         passwordLength,
+            const std::uint8_t* salt,
+            std::size_t         saltLength,
+            std::uint32_t       blockIndex
+        ) {
+        std::uint8_t paddedKey[Sha256::blockSize];
+        std::memset(paddedKey, 0, Sha256::blockSize);
+
+        if (passwordLength > Sha256::blockSize) {
+            Sha256::hash(password, passwordLength, paddedKey);
+        } else {
+            std::memcpy(paddedKey, password, passwordLength);
+        }
+
+        std::uint32_t state[8];
+        keyState(paddedKey, 0x36, state);
+        for (unsigned i=0 ; i<8 ; ++i) {
+            innerState[i][lane] = state[i];
+        }
+
+        keyState(paddedKey, 0x5C, state);
+        for (unsigned i=0 ; i<8 ; ++i) {
+            outerState[i][lane] = state[i];
+        }
+
+        std::uint8_t index[4] = {
+            static_cast<std::uint8_t>(blockIndex >> 24),
+            static_cast<std::uint8_t>(blockIndex >> 16),
+            static_cast<std::uint8_t>(blockIndex >>  8),
+            static_cast<std::uint8_t>(blockIndex      )
+        };
+
+        // The first HMAC covers the salt which has no fixed length so it runs through the general HMAC.
+        std::uint8_t first[HmacSha256::digestSize];
+        HmacSha256   hmac(password, passwordLength);
+        hmac.addData(salt, saltLength);
+        hmac.addData(index, sizeof(index));
+        hmac.result(first);
+
+        for (unsigned i=0 ; i<8 ; ++i) {
+            std::uint32_t word = (
+                  (static_cast<std::uint32_t>(first[4 * i + 0]) << 24)
+                | (static_cast<std::uint32_t>(first[4 * i + 1]) << 16)
+                | (static_cast<std::uint32_t>(first[4 * i + 2]) <<  8)
+                | (static_cast<std::uint32_t>(first[4 * i + 3])      )
+            );
+
+            chain[i][lane]       = word;
+            accumulator[i][lane] = word;
+        }
+
+        std::memset(paddedKey, 0, sizeof(paddedKey));
+        std::memset(state, 0, sizeof(state));
+        std::memset(first, 0, sizeof(first));
+    }
+
+
+    void Pbkdf2Engine::iterate(unsigned numberLanes, unsigned long numberIterations) {
+        if (numberIterations > 0) {
+            #if (CRYPTO_X86)
+                if (numberLanes > 4 && cpuHasAvx2()) {
+                    iterateAvx2(
+                        &innerState[0][0],
+                        &outerState[0][0],
+                        &chain[0][0],
+                        &accumulator[0][0],
+                        numberIterations
+                    );
+                } else if (numberLanes > 1 && cpuHasSse2()) {
+                    for (unsigned lane=0 ; lane<numberLanes ; lane+=4) {
+                        iterateSse2(
+                            &innerState[0][lane],
+                            &outerState[0][lane],
+                            &chain[0][lane],
+                            &accumulator[0][lane],
+                            numberIterations
+                        );
+                    }
+                } else {
+                    iteratePortable(
+                        &innerState[0][0],
+                        &outerState[0][0],
+                        &chain[0][0],
+                        &accumulator[0][0],
+                        numberLanes,
+                        numberIterations
+                    );
+                }
+            #else
+                iteratePortable(
+                    &innerState[0][0],
+                    &outerState[0][0],
+                    &chain[0][0],
+                    &accumulator[0][0],
+                    numberLanes,
+                    numberIterations
+                );
+            #endif
+        }
+    }
+
+
+    void Pbkdf2Engine::result(unsigned lane, std::uint8_t* block) const {
+        for (unsigned i=0 ; i<8 ; ++i) {
+            std::uint32_t word = accumulator[i][lane];
+            block[4 * i + 0] = static_cast<std::uint8_t>(word >> 24);
+            block[4 * i + 1] = static_cast<std::uint8_t>(word >> 16);
+            block[4 * i + 2] = static_cast<std::uint8_t>(word >>  8);
+            block[4 * i + 3] = static_cast<std::uint8_t>(word      );
+        }
+    }
+
+
+    void Pbkdf2Engine::scrub() {
+        std::memset(innerState, 0, sizeof(innerState));
+        std::memset(outerState, 0, sizeof(outerState));
+        std::memset(chain, 0, sizeof(chain));
+        std::memset(accumulator, 0, sizeof(accumulator));
+    }
+}
@@ -0,0 +1,121 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::Pbkdf2Engine class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_PBKDF2_ENGINE_H
+#define CRYPTO_PBKDF2_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Crypto {
+    /**
+     * Class that runs the PBKDF2-HMAC-SHA256 iteration loop for several independent lanes at once.  Each lane is one
+     * output block of one password.  The inner and outer HMAC hash states are keyed once per lane so each iteration
+     * costs exactly two SHA-256 compressions.  The chaining values are held as words so no byte conversions are
+     * needed between iterations.
+     *
+     * Lanes are stored as structure-of-arrays so eight lanes are processed with AVX2 and four lanes with SSE2.  A
+     * single lane runs on the portable path.
+     */
+    class Pbkdf2Engine {
+        public:
+            /**
+             * The maximum number of lanes.
+             */
+            static constexpr unsigned maximumLanes = 8;
+
+            /**
+             * The length of each output block, in bytes.
+             */
+            static constexpr unsigned blockLength = 32;
+
+            /**
+             * Method that starts a lane.  The first HMAC of the lane is calculated here.
+             *
+             * \param[in] lane           The zero based lane index.
+             *
+             * \param[in] password       Pointer to the password.
+             *
+             * \param[in] passwordLength The password length, in bytes.
+             *
+             * \param[in] salt           Pointer to the salt.
+             *
+             * \param[in] saltLength     The salt length, in bytes.
+             *
+             * \param[in] blockIndex     The one based PBKDF2 block index.
+             */
+            void setLane(
+                unsigned            lane,
+                const std::uint8_t* password,
+                std::size_t         passwordLength,
+                const std::uint8_t* salt,
+                std::size_t         saltLength,
+                std::uint32_t       blockIndex
+            );
+
+            /**
+             * Method that runs the remaining iterations on every started lane.
+             *
+             * \param[in] numberLanes      The number of lanes started.
+             *
+             * \param[in] numberIterations The number of iterations to run after the first.
+             */
+            void iterate(unsigned numberLanes, unsigned long numberIterations);
+
+            /**
+             * Method that obtains the output block of a lane.
+             *
+             * \param[in]  lane  The zero based lane index.
+             *
+             * \param[out] block Buffer to receive the 32 byte block.
+             */
+            void result(unsigned lane, std::uint8_t* block) const;
+
+            /**
+             * Method that clears every lane.  Unused lanes must be cleared before they are run alongside used lanes.
+             */
+            void scrub();
+
+        private:
+            /**
+             * The inner keyed hash state of each lane, indexed by word and then by lane.
+             */
+            alignas(32) std::uint32_t innerState[8][maximumLanes];
+
+            /**
+             * The outer keyed hash state of each lane, indexed by word and then by lane.
+             */
+            alignas(32) std::uint32_t outerState[8][maximumLanes];
+
+            /**
+             * The most recent HMAC of each lane, indexed by word and then by lane.
+             */
+            alignas(32) std::uint32_t chain[8][maximumLanes];
+
+            /**
+             * The XOR of every HMAC of each lane, indexed by word and then by lane.
+             */
+            alignas(32) std::uint32_t accumulator[8][maximumLanes];
+    };
+}
+
+#endif
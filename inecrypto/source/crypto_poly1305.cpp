@@ -0,0 +1,76 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Poly1305 class.
+***********************************************************************************************************************/
+
+#include <QtGlobal>
+#include <QByteArray>
+
+#include <cstring>
+
+#include "crypto_poly1305_engine.h"
+#include "crypto_poly1305.h"
+
+Crypto::Poly1305::Poly1305(QByteArray const& newKey) {
+    reset(newKey);
+}
+
+
+Crypto::Poly1305::Poly1305(QByteArray const& key, QByteArray const& data) {
+    reset(key);
+    addData(data);
+}
+
+
+Crypto::Poly1305::~Poly1305() {
+    engine()->scrub();
+}
+
+
+void Crypto::Poly1305::addData(char const* newData, int const dataLength) {
+    Q_ASSERT(!instanceSpent);
+    engine()->update(reinterpret_cast<std::uint8_t const*>(newData), static_cast<std::size_t>(dataLength));
+}
+
+
+void Crypto::Poly1305::reset(QByteArray const& newKey) {
+    static_assert(sizeof(Poly1305Engine) <= engineStorageSize, "Insufficient Poly1305 engine storage.");
+    Q_ASSERT(static_cast<unsigned>(newKey.size()) == keyLength);
+
+    // Short keys are zero extended so that we never read past the end of the supplied key.
+    std::uint8_t key[keyLength] = { 0 };
+    std::memcpy(key, newKey.constData(), qMin(static_cast<unsigned>(newKey.size()), keyLength));
+
+    engine()->setKey(key);
+    std::memset(key, 0, keyLength);
+
+    instanceSpent = false;
+}
+
+
+QByteArray Crypto::Poly1305::digest() {
+    Q_ASSERT(!instanceSpent);
+    instanceSpent = true;
+
+    QByteArray result(static_cast<int>(digestLength), '\0');
+    engine()->finish(reinterpret_cast<std::uint8_t*>(result.data()));
+
+    return result;
+}
@@ -0,0 +1,279 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::Poly1305Engine class.
+***********************************************************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_poly1305_engine.h"
+
+namespace Crypto {
+    /**
+     * Mask for a single 26-bit limb.
+     */
+    static constexpr std::uint32_t limbMask = 0x3FFFFFF;
+
+    /**
+     * Function that reads a little-endian 32-bit value.
+     *
+     * \param[in] data Pointer to the four bytes to be read.
+     *
+     * \return Returns the value.
+     */
+    static inline std::uint32_t readLittleEndian(const std::uint8_t* data) {
+        return (
+              static_cast<std::uint32_t>(data[0])
+            | (static_cast<std::uint32_t>(data[1]) <<  8)
+            | (static_cast<std::uint32_t>(data[2]) << 16)
+            | (static_cast<std::uint32_t>(data[3]) << 24)
+        );
+    }
+
+    /**
+     * Function that writes a little-endian 32-bit value.
+     *
+     * \param[out] data  Pointer to the four bytes to be written.
+     *
+     * \param[in]  value The value to be written.
+     */
+    static inline void writeLittleEndian(std::uint8_t* data, std::uint32_t value) {
+        data[0] = static_cast<std::uint8_t>(value);
+        data[1] = static_cast<std::uint8_t>(value >>  8);
+        data[2] = static_cast<std::uint8_t>(value >> 16);
+        data[3] = static_cast<std::uint8_t>(value >> 24);
+    }
+
+
+    void Poly1305Engine::setKey(const std::uint8_t* key) {
+        // Clamp r as required by the specification, splitting it into 26-bit limbs as we go.
+        r[0] = readLittleEndian(key +  0)        & 0x3FFFFFF;
+        r[1] = (readLittleEndian(key +  3) >> 2) & 0x3FFFF03;
+        r[2] = (readLittleEndian(key +  6) >> 4) & 0x3FFC0FF;
+        r[3] = (readLittleEndian(key +  9) >> 6) & 0x3F03FFF;
+        r[4] = (readLittleEndian(key + 12) >> 8) & 0x00FFFFF;
+
+        for (unsigned i=0 ; i<5 ; ++i) {
+            h[i] = 0;
+        }
+
+        for (unsigned i=0 ; i<4 ; ++i) {
+            pad[i] = readLittleEndian(key + 16 + 4 * i);
+        }
+
+        bufferedBytes = 0;
+    }
+
+
+    void Poly1305Engine::update(const std::uint8_t* data, std::size_t length) {
+        if (bufferedBytes > 0) {
+            std::size_t bytesToCopy = std::min(length, static_cast<std::size_t>(blockLength - bufferedBytes));
+            std::memcpy(buffer + bufferedBytes, data, bytesToCopy);
+
+            bufferedBytes += static_cast<unsigned>(bytesToCopy);
+            data          += bytesToCopy;
+            length        -= bytesToCopy;
+
+            if (bufferedBytes == blockLength) {
+                processBlocks(buffer, 1, 1UL << 24);
+                bufferedBytes = 0;
+            }
+        }
+
+        std::size_t numberBlocks = length / blockLength;
+        if (numberBlocks > 0) {
+            processBlocks(data, numberBlocks, 1UL << 24);
+
+            data   += numberBlocks * blockLength;
+            length -= numberBlocks * blockLength;
+        }
+
+        if (length > 0) {
+            std::memcpy(buffer, data, length);
+            bufferedBytes = static_cast<unsigned>(length);
+        }
+    }
+
+
+    void Poly1305Engine::padBlock() {
+        if (bufferedBytes > 0) {
+            std::memset(buffer + bufferedBytes, 0, blockLength - bufferedBytes);
+            processBlocks(buffer, 1, 1UL << 24);
+            bufferedBytes = 0;
+        }
+    }
+
+
+    void Poly1305Engine::finish(std::uint8_t* tag) {
+        if (bufferedBytes > 0) {
+            buffer[bufferedBytes] = 1;
+            std::memset(buffer + bufferedBytes + 1, 0, blockLength - bufferedBytes - 1);
+            processBlocks(buffer, 1, 0);
+            bufferedBytes = 0;
+        }
+
+        // Fully carry h.
+        std::uint32_t h0 = h[0];
+        std::uint32_t h1 = h[1];
+        std::uint32_t h2 = h[2];
+        std::uint32_t h3 = h[3];
+        std::uint32_t h4 = h[4];
+        std::uint32_t c;
+
+        c = h1 >> 26; h1 &= limbMask;
+        h2 += c; c = h2 >> 26; h2 &= limbMask;
+        h3 += c; c = h3 >> 26; h3 &= limbMask;
+        h4 += c; c = h4 >> 26; h4 &= limbMask;
+        h0 += c * 5; c = h0 >> 26; h0 &= limbMask;
+        h1 += c;
+
+        // Compute h - p = h + 5 - 2^130 and select it, without branching, if it did not go negative.
+        std::uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= limbMask;
+        std::uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= limbMask;
+        std::uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= limbMask;
+        std::uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= limbMask;
+        std::uint32_t g4 = h4 + c - (1UL << 26);
+
+        std::uint32_t mask = (g4 >> 31) - 1;
+        g0 &= mask;
+        g1 &= mask;
+        g2 &= mask;
+        g3 &= mask;
+        g4 &= mask;
+
+        mask = ~mask;
+        h0 = (h0 & mask) | g0;
+        h1 = (h1 & mask) | g1;
+        h2 = (h2 & mask) | g2;
+        h3 = (h3 & mask) | g3;
+        h4 = (h4 & mask) | g4;
+
+        // Repack into 32-bit words and add s, modulo 2^128.
+        std::uint32_t w0 = h0         | (h1 << 26);
+        std::uint32_t w1 = (h1 >>  6) | (h2 << 20);
+        std::uint32_t w2 = (h2 >> 12) | (h3 << 14);
+        std::uint32_t w3 = (h3 >> 18) | (h4 <<  8);
+
+        std::uint64_t f;
+        f = static_cast<std::uint64_t>(w0) + pad[0];             w0 = static_cast<std::uint32_t>(f);
+        f = static_cast<std::uint64_t>(w1) + pad[1] + (f >> 32); w1 = static_cast<std::uint32_t>(f);
+        f = static_cast<std::uint64_t>(w2) + pad[2] + (f >> 32); w2 = static_cast<std::uint32_t>(f);
+        f = static_cast<std::uint64_t>(w3) + pad[3] + (f >> 32); w3 = static_cast<std::uint32_t>(f);
+
+        writeLittleEndian(tag +  0, w0);
+        writeLittleEndian(tag +  4, w1);
+        writeLittleEndian(tag +  8, w2);
+        writeLittleEndian(tag + 12, w3);
+
+        scrub();
+    }
+
+
+    void Poly1305Engine::scrub() {
+        std::memset(r, 0, sizeof(r));
+        std::memset(h, 0, sizeof(h));
+        std::memset(pad, 0, sizeof(pad));
+        std::memset(buffer, 0, sizeof(buffer));
+        bufferedBytes = 0;
+    }
+
+
+    void Poly1305Engine::processBlocks(const std::uint8_t* data, std::size_t numberBlocks, std::uint32_t highBit) {
+        const std::uint32_t r0 = r[0];
+        const std::uint32_t r1 = r[1];
+        const std::uint32_t r2 = r[2];
+        const std::uint32_t r3 = r[3];
+        const std::uint32_t r4 = r[4];
+
+        const std::uint32_t s1 = r1 * 5;
+        const std::uint32_t s2 = r2 * 5;
+        const std::uint32_t s3 = r3 * 5;
+        const std::uint32_t s4 = r4 * 5;
+
+        std::uint32_t h0 = h[0];
+        std::uint32_t h1 = h[1];
+        std::uint32_t h2 = h[2];
+        std::uint32_t h3 = h[3];
+        std::uint32_t h4 = h[4];
+
+        while (numberBlocks > 0) {
+            h0 += readLittleEndian(data +  0)        & limbMask;
+            h1 += (readLittleEndian(data +  3) >> 2) & limbMask;
+            h2 += (readLittleEndian(data +  6) >> 4) & limbMask;
+            h3 += (readLittleEndian(data +  9) >> 6) & limbMask;
+            h4 += (readLittleEndian(data + 12) >> 8) | highBit;
+
+            // h *= r, modulo 2^130 - 5.  Limbs that wrap past 2^130 are folded back in multiplied by 5.
+            std::uint64_t d0 = (
+                  static_cast<std::uint64_t>(h0) * r0
+                + static_cast<std::uint64_t>(h1) * s4
+                + static_cast<std::uint64_t>(h2) * s3
+                + static_cast<std::uint64_t>(h3) * s2
+                + static_cast<std::uint64_t>(h4) * s1
+            );
+            std::uint64_t d1 = (
+                  static_cast<std::uint64_t>(h0) * r1
+                + static_cast<std::uint64_t>(h1) * r0
+                + static_cast<std::uint64_t>(h2) * s4
+                + static_cast<std::uint64_t>(h3) * s3
+                + static_cast<std::uint64_t>(h4) * s2
+            );
+            std::uint64_t d2 = (
+                  static_cast<std::uint64_t>(h0) * r2
+                + static_cast<std::uint64_t>(h1) * r1
+                + static_cast<std::uint64_t>(h2) * r0
+                + static_cast<std::uint64_t>(h3) * s4
+                + static_cast<std::uint64_t>(h4) * s3
+            );
+            std::uint64_t d3 = (
+                  static_cast<std::uint64_t>(h0) * r3
+                + static_cast<std::uint64_t>(h1) * r2
+                + static_cast<std::uint64_t>(h2) * r1
+                + static_cast<std::uint64_t>(h3) * r0
+                + static_cast<std::uint64_t>(h4) * s4
+            );
+            std::uint64_t d4 = (
+                  static_cast<std::uint64_t>(h0) * r4
+                + static_cast<std::uint64_t>(h1) * r3
+                + static_cast<std::uint64_t>(h2) * r2
+                + static_cast<std::uint64_t>(h3) * r1
+                + static_cast<std::uint64_t>(h4) * r0
+            );
+
+            std::uint32_t c;
+            c = static_cast<std::uint32_t>(d0 >> 26); h0 = static_cast<std::uint32_t>(d0) & limbMask;
+            d1 += c; c = static_cast<std::uint32_t>(d1 >> 26); h1 = static_cast<std::uint32_t>(d1) & limbMask;
+            d2 += c; c = static_cast<std::uint32_t>(d2 >> 26); h2 = static_cast<std::uint32_t>(d2) & limbMask;
+            d3 += c; c = static_cast<std::uint32_t>(d3 >> 26); h3 = static_cast<std::uint32_t>(d3) & limbMask;
+            d4 += c; c = static_cast<std::uint32_t>(d4 >> 26); h4 = static_cast<std::uint32_t>(d4) & limbMask;
+            h0 += c * 5; c = h0 >> 26; h0 &= limbMask;
+            h1 += c;
+
+            data += blockLength;
+            --numberBlocks;
+        }
+
+        h[0] = h0;
+        h[1] = h1;
+        h[2] = h2;
+        h[3] = h3;
+        h[4] = h4;
+    }
+}
@@ -0,0 +1,126 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::Poly1305Engine class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_POLY1305_ENGINE_H
+#define CRYPTO_POLY1305_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Crypto {
+    /**
+     * Class that calculates the Poly1305 one-time authenticator described in RFC 8439.  The accumulator is held as
+     * five 26-bit limbs so only 32x32 to 64-bit multiplies are needed.
+     */
+    class Poly1305Engine {
+        public:
+            /**
+             * The one-time key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The tag length, in bytes.
+             */
+            static constexpr unsigned tagLength = 16;
+
+            /**
+             * The Poly1305 block length, in bytes.
+             */
+            static constexpr unsigned blockLength = 16;
+
+            /**
+             * Method you can use to start a new message.
+             *
+             * \param[in] key The 32 byte one-time key.  A key must never be used for two different messages.
+             */
+            void setKey(const std::uint8_t* key);
+
+            /**
+             * Method you can use to add data to the message.
+             *
+             * \param[in] data   Pointer to the data to be added.
+             *
+             * \param[in] length The number of bytes to be added.
+             */
+            void update(const std::uint8_t* data, std::size_t length);
+
+            /**
+             * Method you can use to pad the message with zeros to the next 16 byte boundary.  The method does nothing
+             * if the message is already aligned.
+             */
+            void padBlock();
+
+            /**
+             * Method you can use to calculate the tag.  The engine must be given a new key before it can be used
+             * again.
+             *
+             * \param[out] tag Buffer to receive the 16 byte tag.
+             */
+            void finish(std::uint8_t* tag);
+
+            /**
+             * Method you can use to scrub the engine state.
+             */
+            void scrub();
+
+        private:
+            /**
+             * Method that processes whole blocks.
+             *
+             * \param[in] data         Pointer to the blocks to be processed.
+             *
+             * \param[in] numberBlocks The number of blocks to be processed.
+             *
+             * \param[in] highBit      The bit added above each block.  Full blocks use 1 << 24, the final partial
+             *                         block carries its own padding bit and uses 0.
+             */
+            void processBlocks(const std::uint8_t* data, std::size_t numberBlocks, std::uint32_t highBit);
+
+            /**
+             * The clamped multiplier, r, as 26-bit limbs.
+             */
+            std::uint32_t r[5];
+
+            /**
+             * The accumulator, h, as 26-bit limbs.
+             */
+            std::uint32_t h[5];
+
+            /**
+             * The final addend, s.
+             */
+            std::uint32_t pad[4];
+
+            /**
+             * Buffered bytes of a partial block.
+             */
+            std::uint8_t buffer[blockLength];
+
+            /**
+             * The number of bytes held in the partial block buffer.
+             */
+            unsigned bufferedBytes;
+    };
+}
+
+#endif
@@ -0,0 +1,470 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::SegmentEngine class.
+***********************************************************************************************************************/
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "crypto_kdf.h"
+#include "crypto_aes_gcm_engine.h"
+#include "crypto_segment_engine.h"
+
+namespace Crypto {
+    /**
+     * The magic value at the start of every container.
+     */
+    static const std::uint8_t containerMagic[4] = { 'I', 'E', 'S', 'G' };
+
+    /**
+     * The container format version.
+     */
+    static constexpr std::uint8_t containerVersion = 2;
+
+    /**
+     * The offset of the segment size within the header.
+     */
+    static constexpr unsigned segmentSizeOffset = 5;
+
+    /**
+     * The offset of the nonce prefix within the header.
+     */
+    static constexpr unsigned noncePrefixOffset = 9;
+
+    /**
+     * The offset of the salt within the header.
+     */
+    static constexpr unsigned saltOffset = 16;
+
+    /**
+     * The HKDF context used to derive the container keys.
+     */
+    static const std::uint8_t containerKeyInfo[] = "inecrypto segment container keys";
+
+    /**
+     * Runnable that processes one range of segments on a thread pool thread.
+     */
+    class SegmentEngine::RangeTask:public QRunnable {
+        public:
+            /**
+             * Constructor
+             *
+             * \param[in]  engine         The engine holding the keys and header.
+             *
+             * \param[in]  encrypting     If true, the range is encrypted.  If false, the range is decrypted.
+             *
+             * \param[in]  firstSegment   The index of the first segment in the range.
+             *
+             * \param[in]  inputData      Pointer to the input data.
+             *
+             * \param[out] outputData     Pointer to the buffer to receive the output data.
+             *
+             * \param[out] segmentOutputs Optional array holding a separate output buffer for each segment.
+             *
+             * \param[in]  dataLength     The number of unencrypted bytes the range holds.
+             *
+             * \param[in]  includesLast   If true, the final segment of the range ends the container.
+             *
+             * \param[out] rangesValid    Cleared if any segment of the range fails verification.
+             *
+             * \param[in]  rangesFinished Semaphore released once the range has been processed.
+             */
+            RangeTask(
+                    const SegmentEngine* engine,
+                    bool                 encrypting,
+                    unsigned long long   firstSegment,
+                    const std::uint8_t*  inputData,
+                    std::uint8_t*        outputData,
+                    std::uint8_t* const* segmentOutputs,
+                    std::size_t          dataLength,
+                    bool                 includesLast,
+                    std::atomic<bool>*   rangesValid,
+                    QSemaphore*          rangesFinished
+                ):currentEngine(
+                    engine
+                ),currentEncrypting(
+                    encrypting
+                ),currentFirstSegment(
+                    firstSegment
+                ),currentInputData(
+                    inputData
+                ),currentOutputData(
+                    outputData
+                ),currentSegmentOutputs(
+                    segmentOutputs
+                ),currentDataLength(
+                    dataLength
+                ),currentIncludesLast(
+                    includesLast
+                ),currentRangesValid(
+                    rangesValid
+                ),currentRangesFinished(
+                    rangesFinished
+                ) {}
+
+            ~RangeTask() override {}
+
+            /**
+             * Method that is called on the thread pool thread to process the range.
+             */
+            void run() override {
+                bool valid = currentEngine->processRange(
+                    currentEncrypting,
+                    currentFirstSegment,
+                    currentInputData,
+                    currentOutputData,
+                    currentSegmentOutputs,
+                    currentDataLength,
+                    currentIncludesLast
+                );
+
+                if (!valid) {
+                    currentRangesValid->store(false);
+                }
+
+                currentRangesFinished->release();
+            }
+
+        private:
+            const SegmentEngine* currentEngine;
+            bool                 currentEncrypting;
+            unsigned long long   currentFirstSegment;
+            const std::uint8_t*  currentInputData;
+            std::uint8_t*        currentOutputData;
+            std::uint8_t* const* currentSegmentOutputs;
+            std::size_t          currentDataLength;
+            bool                 currentIncludesLast;
+            std::atomic<bool>*   currentRangesValid;
+            QSemaphore*          currentRangesFinished;
+    };
+
+
+    void SegmentEngine::setKeys(const std::uint8_t* keys) {
+        std::memcpy(currentKeys, keys, keyLength);
+        containerKeysExpanded = false;
+    }
+
+
+    void SegmentEngine::startEncryption(unsigned segmentSize, std::uint8_t* header) {
+        // The nonce prefix and salt are sent in the clear and must not be predictable so we use the system generator.
+        std::uint32_t randomBytes[(noncePrefixLength + saltLength + 3) / 4];
+        QRandomGenerator::system()->fillRange(randomBytes);
+
+        std::memcpy(currentHeader, containerMagic, sizeof(containerMagic));
+        currentHeader[4] = containerVersion;
+        currentHeader[segmentSizeOffset + 0] = static_cast<std::uint8_t>(segmentSize >> 24);
+        currentHeader[segmentSizeOffset + 1] = static_cast<std::uint8_t>(segmentSize >> 16);
+        currentHeader[segmentSizeOffset + 2] = static_cast<std::uint8_t>(segmentSize >>  8);
+        currentHeader[segmentSizeOffset + 3] = static_cast<std::uint8_t>(segmentSize      );
+        std::memcpy(currentHeader + noncePrefixOffset, randomBytes, noncePrefixLength + saltLength);
+
+        std::memset(randomBytes, 0, sizeof(randomBytes));
+
+        currentSegmentSize    = segmentSize;
+        containerKeysExpanded = false;
+        expandContainerKeys();
+
+        std::memcpy(header, currentHeader, headerLength);
+    }
+
+
+    bool SegmentEngine::startDecryption(const std::uint8_t* header) {
+        unsigned segmentSize = (
+              (static_cast<unsigned>(header[segmentSizeOffset + 0]) << 24)
+            | (static_cast<unsigned>(header[segmentSizeOffset + 1]) << 16)
+            | (static_cast<unsigned>(header[segmentSizeOffset + 2]) <<  8)
+            | (static_cast<unsigned>(header[segmentSizeOffset + 3])      )
+        );
+
+        bool result = (
+               std::memcmp(header, containerMagic, sizeof(containerMagic)) == 0
+            && header[4] == containerVersion
+            && segmentSize > 0
+            && segmentSize <= maximumSegmentSize
+        );
+
+        if (result) {
+            // Reopening the same container is common so the container keys are only derived when the salt changes.
+            if (std::memcmp(currentHeader + saltOffset, header + saltOffset, saltLength) != 0) {
+                containerKeysExpanded = false;
+            }
+
+            std::memcpy(currentHeader, header, headerLength);
+            currentSegmentSize = segmentSize;
+
+            expandContainerKeys();
+        }
+
+        return result;
+    }
+
+
+    unsigned long long SegmentEngine::numberSegments(unsigned long long dataLength, bool includesLast) const {
+        unsigned long long result = (dataLength + currentSegmentSize - 1) / currentSegmentSize;
+        if (result == 0 && includesLast) {
+            result = 1;
+        }
+
+        return result;
+    }
+
+
+    unsigned long long SegmentEngine::containerLength(unsigned long long dataLength) const {
+        return headerLength + dataLength + numberSegments(dataLength, true) * tagLength;
+    }
+
+
+    bool SegmentEngine::dataLength(unsigned long long containerLength, unsigned long long& dataLength) const {
+        bool result;
+
+        if (containerLength >= headerLength + tagLength) {
+            unsigned long long bodyLength    = containerLength - headerLength;
+            unsigned long long encryptedSize = static_cast<unsigned long long>(currentSegmentSize) + tagLength;
+            unsigned long long fullSegments  = bodyLength / encryptedSize;
+            unsigned long long remainder     = bodyLength % encryptedSize;
+
+            // A final segment holding only a tag is only produced for an empty container.
+            if (remainder == 0) {
+                dataLength = fullSegments * currentSegmentSize;
+                result     = (fullSegments <= maximumNumberSegments);
+            } else if (remainder > tagLength || (remainder == tagLength && fullSegments == 0)) {
+                dataLength = fullSegments * currentSegmentSize + remainder - tagLength;
+                result     = (fullSegments < maximumNumberSegments);
+            } else {
+                result = false;
+            }
+        } else {
+            result = false;
+        }
+
+        return result;
+    }
+
+
+    void SegmentEngine::encrypt(
+            QThreadPool*        threadPool,
+            unsigned long long  firstSegment,
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         dataLength,
+            bool                includesLast
+        ) const {
+        process(threadPool, true, firstSegment, inputData, outputData, nullptr, dataLength, includesLast);
+    }
+
+
+    bool SegmentEngine::decrypt(
+            QThreadPool*        threadPool,
+            unsigned long long  firstSegment,
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         dataLength,
+            bool                includesLast
+        ) const {
+        return process(threadPool, false, firstSegment, inputData, outputData, nullptr, dataLength, includesLast);
+    }
+
+
+    bool SegmentEngine::decryptScattered(
+            QThreadPool*         threadPool,
+            unsigned long long   firstSegment,
+            const std::uint8_t*  inputData,
+            std::uint8_t* const* segmentOutputs,
+            std::size_t          dataLength,
+            bool                 includesLast
+        ) const {
+        return process(threadPool, false, firstSegment, inputData, nullptr, segmentOutputs, dataLength, includesLast);
+    }
+
+
+    void SegmentEngine::scrub() {
+        keyedEngine.scrub();
+        std::memset(currentKeys, 0, keyLength);
+        std::memset(currentHeader, 0, headerLength);
+
+        containerKeysExpanded = false;
+    }
+
+
+    bool SegmentEngine::processRange(
+            bool                 encrypting,
+            unsigned long long   firstSegment,
+            const std::uint8_t*  inputData,
+            std::uint8_t*        outputData,
+            std::uint8_t* const* segmentOutputs,
+            std::size_t          dataLength,
+            bool                 includesLast
+        ) const {
+        bool               result          = true;
+        unsigned long long segmentsInRange = numberSegments(dataLength, includesLast);
+        std::size_t        segmentSize     = currentSegmentSize;
+        std::size_t        bytesRemaining  = dataLength;
+
+        std::uint8_t iv[AesGcmEngine::ivLength];
+        std::memcpy(iv, currentHeader + noncePrefixOffset, noncePrefixLength);
+
+        for (unsigned long long segment=0 ; segment<segmentsInRange ; ++segment) {
+            unsigned long long segmentIndex      = firstSegment + segment;
+            std::size_t        segmentDataLength = std::min(segmentSize, bytesRemaining);
+
+            iv[noncePrefixLength + 0] = static_cast<std::uint8_t>(segmentIndex >> 24);
+            iv[noncePrefixLength + 1] = static_cast<std::uint8_t>(segmentIndex >> 16);
+            iv[noncePrefixLength + 2] = static_cast<std::uint8_t>(segmentIndex >>  8);
+            iv[noncePrefixLength + 3] = static_cast<std::uint8_t>(segmentIndex      );
+            iv[noncePrefixLength + 4] = (includesLast && segment + 1 == segmentsInRange) ? 1 : 0;
+
+            // The keyed engine is copied so that ranges can be processed concurrently from one set of keys.
+            AesGcmEngine engine = keyedEngine;
+            engine.start(iv, currentHeader, headerLength);
+
+            if (segmentOutputs != nullptr) {
+                outputData = segmentOutputs[segment];
+            }
+
+            if (encrypting) {
+                engine.encrypt(inputData, outputData, segmentDataLength);
+                engine.finish(outputData + segmentDataLength);
+
+                inputData  += segmentDataLength;
+                outputData += segmentDataLength + tagLength;
+            } else {
+                engine.decrypt(inputData, outputData, segmentDataLength);
+                if (!engine.verify(inputData + segmentDataLength)) {
+                    result = false;
+                }
+
+                inputData  += segmentDataLength + tagLength;
+                outputData += segmentDataLength;
+            }
+
+            engine.scrub();
+            bytesRemaining -= segmentDataLength;
+        }
+
+        return result;
+    }
+
+
+    bool SegmentEngine::process(
+            QThreadPool*         threadPool,
+            bool                 encrypting,
+            unsigned long long   firstSegment,
+            const std::uint8_t*  inputData,
+            std::uint8_t*        outputData,
+            std::uint8_t* const* segmentOutputs,
+            std::size_t          dataLength,
+            bool                 includesLast
+        ) const {
+        unsigned long long segmentsInRun = numberSegments(dataLength, includesLast);
+        unsigned long long numberRanges  = 1;
+        bool               result;
+
+        if (threadPool != nullptr && segmentsInRun > 1) {
+            // The calling thread processes the first range so we can use one more range than there are threads.
+            unsigned long long maximumRanges = static_cast<unsigned long long>(
+                std::max(threadPool->maxThreadCount(), 0)
+            ) + 1;
+
+            numberRanges = std::min(maximumRanges, segmentsInRun);
+        }
+
+        if (numberRanges > 1) {
+            std::size_t       inputSegmentSize  = currentSegmentSize + (encrypting ? 0 : tagLength);
+            std::size_t       outputSegmentSize = currentSegmentSize + (encrypting ? tagLength : 0);
+            std::atomic<bool> rangesValid(true);
+            QSemaphore        rangesFinished;
+
+            for (unsigned long long range=1 ; range<numberRanges ; ++range) {
+                std::size_t rangeFirst = static_cast<std::size_t>(range * segmentsInRun / numberRanges);
+                std::size_t rangeLast  = static_cast<std::size_t>((range + 1) * segmentsInRun / numberRanges);
+                std::size_t rangeEnd   = std::min(rangeLast * currentSegmentSize, dataLength);
+
+                threadPool->start(
+                    new RangeTask(
+                        this,
+                        encrypting,
+                        firstSegment + rangeFirst,
+                        inputData + rangeFirst * inputSegmentSize,
+                        segmentOutputs == nullptr ? outputData + rangeFirst * outputSegmentSize : nullptr,
+                        segmentOutputs == nullptr ? nullptr : segmentOutputs + rangeFirst,
+                        rangeEnd - rangeFirst * currentSegmentSize,
+                        includesLast && range + 1 == numberRanges,
+                        &rangesValid,
+                        &rangesFinished
+                    )
+                );
+            }
+
+            std::size_t firstRangeSegments = static_cast<std::size_t>(segmentsInRun / numberRanges);
+            bool        firstRangeValid    = processRange(
+                encrypting,
+                firstSegment,
+                inputData,
+                outputData,
+                segmentOutputs,
+                firstRangeSegments * currentSegmentSize,
+                false
+            );
+
+            rangesFinished.acquire(static_cast<int>(numberRanges - 1));
+            result = firstRangeValid && rangesValid.load();
+        } else {
+            result = processRange(
+                encrypting,
+                firstSegment,
+                inputData,
+                outputData,
+                segmentOutputs,
+                dataLength,
+                includesLast
+            );
+        }
+
+        return result;
+    }
+
+
+    void SegmentEngine::expandContainerKeys() {
+        if (!containerKeysExpanded) {
+            std::uint8_t containerKeys[keyLength];
+            Kdf::hkdf(
+                currentHeader + saltOffset,
+                saltLength,
+                currentKeys,
+                keyLength,
+                containerKeyInfo,
+                sizeof(containerKeyInfo) - 1,
+                containerKeys,
+                keyLength
+            );
+
+            keyedEngine.setKeys(containerKeys);
+            std::memset(containerKeys, 0, keyLength);
+
+            containerKeysExpanded = true;
+        }
+    }
+}
@@ -0,0 +1,339 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header defines the \ref Crypto::SegmentEngine class.  The class is private to the library.
+***********************************************************************************************************************/
+
+#ifndef CRYPTO_SEGMENT_ENGINE_H
+#define CRYPTO_SEGMENT_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "crypto_aes_gcm_engine.h"
+
+class QThreadPool;
+
+namespace Crypto {
+    /**
+     * Class that encrypts and decrypts the segments of the framed container used by
+     * \ref Crypto::SegmentedEncryptor and \ref Crypto::SegmentedDecryptor.
+     *
+     * The container starts with a 48 byte header holding a magic value, the format version, the segment size, a
+     * random 7 byte nonce prefix and a random 32 byte salt.  The header is followed by the segments.  Each segment
+     * holds up to one segment size of data encrypted with AES-256-GCM followed by its 16 byte tag.  Every segment
+     * other than the last is full.
+     *
+     * The segments are not encrypted with the supplied keys directly.  Each container is encrypted with its own key,
+     * derived from the supplied keys and the salt using HKDF, so IVs can not collide across containers no matter how
+     * many containers share the supplied keys.  The IV of each segment is the nonce prefix, the 32-bit big endian
+     * segment index and a final byte that is 1 for the last segment and 0 otherwise.  The header is authenticated as
+     * associated data with every segment.  Segments are therefore independent of one another and can be processed in
+     * any order, while reordering, truncating or extending the stream is detected.
+     */
+    class SegmentEngine {
+        public:
+            /**
+             * The container header length, in bytes.
+             */
+            static constexpr unsigned headerLength = 48;
+
+            /**
+             * The per-segment tag length, in bytes.
+             */
+            static constexpr unsigned tagLength = AesGcmEngine::tagLength;
+
+            /**
+             * The length of the random nonce prefix held in the header, in bytes.
+             */
+            static constexpr unsigned noncePrefixLength = 7;
+
+            /**
+             * The length of the random salt held in the header, in bytes.
+             */
+            static constexpr unsigned saltLength = 32;
+
+            /**
+             * The key length, in bytes.
+             */
+            static constexpr unsigned keyLength = 32;
+
+            /**
+             * The largest supported segment size, in bytes.
+             */
+            static constexpr unsigned maximumSegmentSize = 16 * 1024 * 1024;
+
+            /**
+             * The largest supported number of segments.
+             */
+            static constexpr unsigned long long maximumNumberSegments = 0x100000000ULL;
+
+            /**
+             * Method you can use to set a new set of AES-256 keys.  The container keys are derived from these keys
+             * when a container is started.
+             *
+             * \param[in] keys The 32 byte AES key.
+             */
+            void setKeys(const std::uint8_t* keys);
+
+            /**
+             * Method you can use to start a new container with a freshly generated header.
+             *
+             * \param[in]  segmentSize The segment size, in bytes.
+             *
+             * \param[out] header      Buffer to receive the headerLength byte container header.
+             */
+            void startEncryption(unsigned segmentSize, std::uint8_t* header);
+
+            /**
+             * Method you can use to start decoding a container from its header.
+             *
+             * \param[in] header The headerLength byte container header.
+             *
+             * \return Returns true on success.  Returns false if the header is not valid.
+             */
+            bool startDecryption(const std::uint8_t* header);
+
+            /**
+             * Method you can use to determine the segment size of the current container.
+             *
+             * \return Returns the segment size, in bytes.
+             */
+            inline unsigned segmentSize() const {
+                return currentSegmentSize;
+            }
+
+            /**
+             * Method you can use to determine the number of segments needed to hold a run of data.
+             *
+             * \param[in] dataLength   The length of the data, in bytes.
+             *
+             * \param[in] includesLast If true, the run ends the container so an empty run still needs one segment.
+             *
+             * \return Returns the number of segments.
+             */
+            unsigned long long numberSegments(unsigned long long dataLength, bool includesLast) const;
+
+            /**
+             * Method you can use to determine the length of the encrypted container for a given amount of data.
+             *
+             * \param[in] dataLength The length of the data, in bytes.
+             *
+             * \return Returns the container length, in bytes, including the header.
+             */
+            unsigned long long containerLength(unsigned long long dataLength) const;
+
+            /**
+             * Method you can use to determine the length of the data held by an encrypted container.
+             *
+             * \param[in]  containerLength The length of the container, in bytes, including the header.
+             *
+             * \param[out] dataLength      Returns the length of the data, in bytes.
+             *
+             * \return Returns true on success.  Returns false if no container has the supplied length.
+             */
+            bool dataLength(unsigned long long containerLength, unsigned long long& dataLength) const;
+
+            /**
+             * Method you can use to encrypt a run of consecutive segments.  Every segment other than the last in the
+             * run is full.  The run is split across the thread pool when one is supplied.
+             *
+             * \param[in]  threadPool   The thread pool to use.  A null pointer processes the run on the calling
+             *                          thread.
+             *
+             * \param[in]  firstSegment The index of the first segment in the run.
+             *
+             * \param[in]  inputData    Pointer to the data to be encrypted.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the encrypted segments and their tags.
+             *
+             * \param[in]  dataLength   The number of bytes to be encrypted.
+             *
+             * \param[in]  includesLast If true, the final segment of the run ends the container.
+             */
+            void encrypt(
+                QThreadPool*        threadPool,
+                unsigned long long  firstSegment,
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         dataLength,
+                bool                includesLast
+            ) const;
+
+            /**
+             * Method you can use to decrypt and verify a run of consecutive segments.  The run is split across the
+             * thread pool when one is supplied.
+             *
+             * \param[in]  threadPool   The thread pool to use.  A null pointer processes the run on the calling
+             *                          thread.
+             *
+             * \param[in]  firstSegment The index of the first segment in the run.
+             *
+             * \param[in]  inputData    Pointer to the encrypted segments and their tags.
+             *
+             * \param[out] outputData   Pointer to the buffer to receive the decrypted data.
+             *
+             * \param[in]  dataLength   The number of bytes of decrypted data the run holds.
+             *
+             * \param[in]  includesLast If true, the final segment of the run ends the container.
+             *
+             * \return Returns true if every tag is valid.  Returns false if any segment fails verification.
+             */
+            bool decrypt(
+                QThreadPool*        threadPool,
+                unsigned long long  firstSegment,
+                const std::uint8_t* inputData,
+                std::uint8_t*       outputData,
+                std::size_t         dataLength,
+                bool                includesLast
+            ) const;
+
+            /**
+             * Method you can use to decrypt and verify a run of consecutive segments into separate buffers, one per
+             * segment.  The run is split across the thread pool when one is supplied.
+             *
+             * \param[in]  threadPool     The thread pool to use.  A null pointer processes the run on the calling
+             *                            thread.
+             *
+             * \param[in]  firstSegment   The index of the first segment in the run.
+             *
+             * \param[in]  inputData      Pointer to the encrypted segments and their tags.
+             *
+             * \param[out] segmentOutputs Array holding a pointer to the buffer to receive each decrypted segment.
+             *
+             * \param[in]  dataLength     The number of bytes of decrypted data the run holds.
+             *
+             * \param[in]  includesLast   If true, the final segment of the run ends the container.
+             *
+             * \return Returns true if every tag is valid.  Returns false if any segment fails verification.
+             */
+            bool decryptScattered(
+                QThreadPool*         threadPool,
+                unsigned long long   firstSegment,
+                const std::uint8_t*  inputData,
+                std::uint8_t* const* segmentOutputs,
+                std::size_t          dataLength,
+                bool                 includesLast
+            ) const;
+
+            /**
+             * Method you can use to scrub the engine state.
+             */
+            void scrub();
+
+        private:
+            class RangeTask;
+
+            /**
+             * Method that encrypts or decrypts a run of segments on the calling thread.
+             *
+             * \param[in]  encrypting     If true, the run is encrypted.  If false, the run is decrypted and verified.
+             *
+             * \param[in]  firstSegment   The index of the first segment in the run.
+             *
+             * \param[in]  inputData      Pointer to the input data.
+             *
+             * \param[out] outputData     Pointer to the buffer to receive the output data.  Ignored if
+             *                            segmentOutputs is not null.
+             *
+             * \param[out] segmentOutputs Optional array holding a separate output buffer for each segment.
+             *
+             * \param[in]  dataLength     The number of unencrypted bytes the run holds.
+             *
+             * \param[in]  includesLast   If true, the final segment of the run ends the container.
+             *
+             * \return Returns true on success.  Returns false if any segment fails verification.
+             */
+            bool processRange(
+                bool                 encrypting,
+                unsigned long long   firstSegment,
+                const std::uint8_t*  inputData,
+                std::uint8_t*        outputData,
+                std::uint8_t* const* segmentOutputs,
+                std::size_t          dataLength,
+                bool                 includesLast
+            ) const;
+
+            /**
+             * Method that encrypts or decrypts a run of segments, splitting it across a thread pool.
+             *
+             * \param[in]  threadPool     The thread pool to use, may be null.
+             *
+             * \param[in]  encrypting     If true, the run is encrypted.  If false, the run is decrypted and verified.
+             *
+             * \param[in]  firstSegment   The index of the first segment in the run.
+             *
+             * \param[in]  inputData      Pointer to the input data.
+             *
+             * \param[out] outputData     Pointer to the buffer to receive the output data.  Ignored if
+             *                            segmentOutputs is not null.
+             *
+             * \param[out] segmentOutputs Optional array holding a separate output buffer for each segment.
+             *
+             * \param[in]  dataLength     The number of unencrypted bytes the run holds.
+             *
+             * \param[in]  includesLast   If true, the final segment of the run ends the container.
+             *
+             * \return Returns true on success.  Returns false if any segment fails verification.
+             */
+            bool process(
+                QThreadPool*         threadPool,
+                bool                 encrypting,
+                unsigned long long   firstSegment,
+                const std::uint8_t*  inputData,
+                std::uint8_t*        outputData,
+                std::uint8_t* const* segmentOutputs,
+                std::size_t          dataLength,
+                bool                 includesLast
+            ) const;
+
+            /**
+             * Method that derives and expands the container keys from the salt held in the current header.
+             */
+            void expandContainerKeys();
+
+            /**
+             * The AES-GCM engine keyed with the container keys.  Each segment works on a copy so the keys are only
+             * expanded once per container.
+             */
+            AesGcmEngine keyedEngine;
+
+            /**
+             * The keys the container keys are derived from.
+             */
+            std::uint8_t currentKeys[keyLength];
+
+            /**
+             * The container header, authenticated with every segment.
+             */
+            std::uint8_t currentHeader[headerLength];
+
+            /**
+             * The segment size, in bytes.
+             */
+            unsigned currentSegmentSize;
+
+            /**
+             * Flag indicating that the keyed engine holds the keys for the salt in the current header.
+             */
+            bool containerKeysExpanded;
+    };
+}
+
+#endif
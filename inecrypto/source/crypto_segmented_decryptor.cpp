@@ -0,0 +1,387 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::SegmentedDecryptor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+#include <QByteArray>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_segment_engine.h"
+#include "crypto_segmented_decryptor.h"
+
+namespace Crypto {
+    SegmentedDecryptor::SegmentedDecryptor(QIODevice* parent):QIODevice(parent) {
+        std::memset(initialKeys, 0, keyLength);
+
+        keysExpanded          = false;
+        currentThreadPool     = Q_NULLPTR;
+        currentInputDevice    = parent;
+        currentSegmentSize    = 0;
+        currentDataLength     = 0;
+        currentNumberSegments = 0;
+        currentPosition       = 0;
+
+        clearCache();
+    }
+
+
+    SegmentedDecryptor::SegmentedDecryptor(QObject* parent):QIODevice(parent) {
+        std::memset(initialKeys, 0, keyLength);
+
+        keysExpanded          = false;
+        currentThreadPool     = Q_NULLPTR;
+        currentInputDevice    = Q_NULLPTR;
+        currentSegmentSize    = 0;
+        currentDataLength     = 0;
+        currentNumberSegments = 0;
+        currentPosition       = 0;
+
+        clearCache();
+    }
+
+
+    SegmentedDecryptor::SegmentedDecryptor(const Keys& keys, QIODevice* parent):QIODevice(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+
+        keysExpanded          = false;
+        currentThreadPool     = Q_NULLPTR;
+        currentInputDevice    = parent;
+        currentSegmentSize    = 0;
+        currentDataLength     = 0;
+        currentNumberSegments = 0;
+        currentPosition       = 0;
+
+        clearCache();
+    }
+
+
+    SegmentedDecryptor::SegmentedDecryptor(const Keys& keys, QObject* parent):QIODevice(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+
+        keysExpanded          = false;
+        currentThreadPool     = Q_NULLPTR;
+        currentInputDevice    = Q_NULLPTR;
+        currentSegmentSize    = 0;
+        currentDataLength     = 0;
+        currentNumberSegments = 0;
+        currentPosition       = 0;
+
+        clearCache();
+    }
+
+
+    SegmentedDecryptor::~SegmentedDecryptor() {
+        std::memset(initialKeys, 0, keyLength);
+        clearCache();
+
+        engine()->scrub();
+    }
+
+
+    unsigned SegmentedDecryptor::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void SegmentedDecryptor::setKeys(const Keys& newKeys) {
+        std::memcpy(initialKeys, newKeys, keyLength);
+        keysExpanded = false;
+    }
+
+
+    void SegmentedDecryptor::setThreadPool(QThreadPool* newThreadPool) {
+        currentThreadPool = newThreadPool;
+    }
+
+
+    QThreadPool* SegmentedDecryptor::threadPool() const {
+        return currentThreadPool;
+    }
+
+
+    unsigned SegmentedDecryptor::segmentSize() const {
+        return currentSegmentSize;
+    }
+
+
+    QByteArray SegmentedDecryptor::decrypt(const QByteArray& inputBuffer) {
+        const std::uint8_t* inputData = reinterpret_cast<const std::uint8_t*>(inputBuffer.constData());
+        unsigned long long  inputLength = static_cast<unsigned long long>(inputBuffer.size());
+        unsigned long long  dataLength;
+        QByteArray          result;
+
+        expandKeys();
+
+        if (inputLength >= SegmentEngine::headerLength                         &&
+            engine()->startDecryption(inputData)                               &&
+            engine()->dataLength(inputLength, dataLength)                         ) {
+            result.resize(static_cast<int>(dataLength));
+
+            bool valid = engine()->decrypt(
+                currentThreadPool,
+                0,
+                inputData + SegmentEngine::headerLength,
+                reinterpret_cast<std::uint8_t*>(result.data()),
+                static_cast<std::size_t>(dataLength),
+                true
+            );
+
+            if (!valid) {
+                result.fill('\x00');
+                result.clear();
+
+                setErrorString(tr("Authentication failed."));
+            }
+        } else {
+            setErrorString(tr("Invalid container."));
+        }
+
+        return result;
+    }
+
+
+    void SegmentedDecryptor::setInputDevice(QIODevice* inputDevice) {
+        currentInputDevice = inputDevice;
+    }
+
+
+    QIODevice* SegmentedDecryptor::inputDevice() const {
+        return currentInputDevice;
+    }
+
+
+    bool SegmentedDecryptor::open(SegmentedDecryptor::OpenMode openMode) {
+        bool result;
+
+        clearCache();
+
+        if (openMode != OpenModeFlag::ReadOnly) {
+            result = false;
+        } else if (currentInputDevice == Q_NULLPTR) {
+            setErrorString(tr("No input device."));
+            result = false;
+        } else if (currentInputDevice->isSequential() || !currentInputDevice->isReadable()) {
+            setErrorString(tr("The input device must be a readable, random access device."));
+            result = false;
+        } else {
+            std::uint8_t header[SegmentEngine::headerLength];
+            qint64       headerBytesRead = -1;
+
+            if (currentInputDevice->seek(0)) {
+                headerBytesRead = currentInputDevice->read(reinterpret_cast<char*>(header), sizeof(header));
+            }
+
+            expandKeys();
+
+            result = (
+                   headerBytesRead == static_cast<qint64>(sizeof(header))
+                && engine()->startDecryption(header)
+                && engine()->dataLength(static_cast<unsigned long long>(currentInputDevice->size()), currentDataLength)
+            );
+
+            if (result) {
+                // We buffer decrypted segments ourselves.  Leaving the QIODevice buffer out keeps our position in step
+                // with the position reported to the caller across seeks.
+                currentSegmentSize    = engine()->segmentSize();
+                currentNumberSegments = engine()->numberSegments(currentDataLength, true);
+                currentPosition       = 0;
+
+                // Loading the first segments up front lets us report a wrong key or a damaged container from open.
+                result = loadSegments(0) && QIODevice::open(openMode | OpenModeFlag::Unbuffered);
+            } else {
+                setErrorString(tr("Invalid container."));
+            }
+
+            if (!result) {
+                clearCache();
+
+                currentSegmentSize    = 0;
+                currentDataLength     = 0;
+                currentNumberSegments = 0;
+            }
+        }
+
+        return result;
+    }
+
+
+    void SegmentedDecryptor::close() {
+        clearCache();
+        QIODevice::close();
+
+        currentSegmentSize    = 0;
+        currentDataLength     = 0;
+        currentNumberSegments = 0;
+        currentPosition       = 0;
+    }
+
+
+    bool SegmentedDecryptor::isSequential() const {
+        return false;
+    }
+
+
+    qint64 SegmentedDecryptor::size() const {
+        return static_cast<qint64>(currentDataLength);
+    }
+
+
+    bool SegmentedDecryptor::seek(qint64 position) {
+        bool result = (
+               isOpen()
+            && position >= 0
+            && static_cast<unsigned long long>(position) <= currentDataLength
+            && QIODevice::seek(position)
+        );
+
+        if (result) {
+            currentPosition = static_cast<unsigned long long>(position);
+        }
+
+        return result;
+    }
+
+
+    qint64 SegmentedDecryptor::readData(char* data, qint64 maxSize) {
+        qint64 result = 0;
+        bool   ok     = true;
+
+        while (ok && result < maxSize && currentPosition < currentDataLength) {
+            unsigned long long segment = currentPosition / currentSegmentSize;
+            if (segment < cachedFirstSegment || segment >= cachedFirstSegment + cachedNumberSegments) {
+                ok = loadSegments(segment);
+            }
+
+            if (ok) {
+                unsigned long long cacheOffset    = currentPosition - cachedFirstSegment * currentSegmentSize;
+                unsigned long long bytesAvailable = static_cast<unsigned long long>(cachedData.size()) - cacheOffset;
+                unsigned long long bytesToCopy    = std::min(
+                    bytesAvailable,
+                    static_cast<unsigned long long>(maxSize - result)
+                );
+
+                std::memcpy(data + result, cachedData.constData() + cacheOffset, bytesToCopy);
+
+                result          += static_cast<qint64>(bytesToCopy);
+                currentPosition += bytesToCopy;
+            }
+        }
+
+        if (!ok && result == 0) {
+            result = -1;
+        }
+
+        return result;
+    }
+
+
+    qint64 SegmentedDecryptor::writeData(const char* /* data */, qint64 /* maxSize */) {
+        return -1;
+    }
+
+
+    bool SegmentedDecryptor::loadSegments(unsigned long long firstSegment) {
+        unsigned long long segmentSize    = currentSegmentSize;
+        unsigned long long numberSegments = std::min(
+            static_cast<unsigned long long>(segmentsPerPass()),
+            currentNumberSegments - firstSegment
+        );
+
+        bool        includesLast    = (firstSegment + numberSegments == currentNumberSegments);
+        std::size_t dataLength      = static_cast<std::size_t>(
+            std::min(numberSegments * segmentSize, currentDataLength - firstSegment * segmentSize)
+        );
+        std::size_t encryptedLength = dataLength + static_cast<std::size_t>(numberSegments) * SegmentEngine::tagLength;
+        qint64      encryptedOffset = static_cast<qint64>(
+            SegmentEngine::headerLength + firstSegment * (segmentSize + SegmentEngine::tagLength)
+        );
+
+        clearCache();
+        encryptedData.resize(static_cast<int>(encryptedLength));
+
+        bool result = (
+               currentInputDevice->seek(encryptedOffset)
+            && currentInputDevice->read(encryptedData.data(), encryptedLength) == static_cast<qint64>(encryptedLength)
+        );
+
+        if (result) {
+            cachedData.resize(static_cast<int>(dataLength));
+            result = engine()->decrypt(
+                currentThreadPool,
+                firstSegment,
+                reinterpret_cast<const std::uint8_t*>(encryptedData.constData()),
+                reinterpret_cast<std::uint8_t*>(cachedData.data()),
+                dataLength,
+                includesLast
+            );
+
+            if (result) {
+                cachedFirstSegment   = firstSegment;
+                cachedNumberSegments = numberSegments;
+            } else {
+                clearCache();
+                setErrorString(tr("Authentication failed."));
+            }
+        } else {
+            setErrorString(tr("Could not read segment: %1").arg(currentInputDevice->errorString()));
+        }
+
+        return result;
+    }
+
+
+    void SegmentedDecryptor::clearCache() {
+        cachedData.fill('\x00');
+        cachedData.clear();
+
+        cachedFirstSegment   = 0;
+        cachedNumberSegments = 0;
+    }
+
+
+    void SegmentedDecryptor::expandKeys() {
+        static_assert(sizeof(SegmentEngine) <= engineStorageSize, "Insufficient segment engine storage.");
+
+        // The engine derives the container keys when it reads the header.  Passing in the supplied keys only when
+        // they change lets the engine skip the derivation and key expansion when the same container is reopened.
+        if (!keysExpanded) {
+            engine()->setKeys(initialKeys);
+            keysExpanded = true;
+        }
+    }
+
+
+    unsigned SegmentedDecryptor::segmentsPerPass() const {
+        unsigned result;
+
+        if (currentThreadPool != Q_NULLPTR) {
+            result = static_cast<unsigned>(std::max(currentThreadPool->maxThreadCount(), 0)) + 1;
+        } else {
+            result = 1;
+        }
+
+        return result;
+    }
+}
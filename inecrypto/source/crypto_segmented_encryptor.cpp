@@ -0,0 +1,297 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::SegmentedEncryptor class.
+***********************************************************************************************************************/
+
+#include <QObject>
+#include <QIODevice>
+#include <QByteArray>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_segment_engine.h"
+#include "crypto_segmented_encryptor.h"
+
+namespace Crypto {
+    static_assert(SegmentedEncryptor::headerLength == SegmentEngine::headerLength, "Header length mismatch.");
+    static_assert(SegmentedEncryptor::tagLength == SegmentEngine::tagLength, "Tag length mismatch.");
+    static_assert(
+        SegmentedEncryptor::maximumSegmentSize == SegmentEngine::maximumSegmentSize,
+        "Maximum segment size mismatch."
+    );
+
+    SegmentedEncryptor::SegmentedEncryptor(QIODevice* parent):QIODevice(parent) {
+        std::memset(initialKeys, 0, keyLength);
+
+        keysExpanded        = false;
+        currentSegmentSize  = defaultSegmentSize;
+        currentThreadPool   = Q_NULLPTR;
+        currentOutputDevice = parent;
+        nextSegment         = 0;
+    }
+
+
+    SegmentedEncryptor::SegmentedEncryptor(QObject* parent):QIODevice(parent) {
+        std::memset(initialKeys, 0, keyLength);
+
+        keysExpanded        = false;
+        currentSegmentSize  = defaultSegmentSize;
+        currentThreadPool   = Q_NULLPTR;
+        currentOutputDevice = Q_NULLPTR;
+        nextSegment         = 0;
+    }
+
+
+    SegmentedEncryptor::SegmentedEncryptor(const Keys& keys, QIODevice* parent):QIODevice(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+
+        keysExpanded        = false;
+        currentSegmentSize  = defaultSegmentSize;
+        currentThreadPool   = Q_NULLPTR;
+        currentOutputDevice = parent;
+        nextSegment         = 0;
+    }
+
+
+    SegmentedEncryptor::SegmentedEncryptor(const Keys& keys, QObject* parent):QIODevice(parent) {
+        std::memcpy(initialKeys, keys, keyLength);
+
+        keysExpanded        = false;
+        currentSegmentSize  = defaultSegmentSize;
+        currentThreadPool   = Q_NULLPTR;
+        currentOutputDevice = Q_NULLPTR;
+        nextSegment         = 0;
+    }
+
+
+    SegmentedEncryptor::~SegmentedEncryptor() {
+        std::memset(initialKeys, 0, keyLength);
+        pendingData.fill('\x00');
+
+        engine()->scrub();
+    }
+
+
+    unsigned SegmentedEncryptor::keyLengthInBytes() const {
+        return keyLength;
+    }
+
+
+    void SegmentedEncryptor::setKeys(const Keys& newKeys) {
+        std::memcpy(initialKeys, newKeys, keyLength);
+        keysExpanded = false;
+    }
+
+
+    void SegmentedEncryptor::setSegmentSize(unsigned newSegmentSize) {
+        currentSegmentSize = std::min(std::max(newSegmentSize, 1U), maximumSegmentSize);
+    }
+
+
+    unsigned SegmentedEncryptor::segmentSize() const {
+        return currentSegmentSize;
+    }
+
+
+    void SegmentedEncryptor::setThreadPool(QThreadPool* newThreadPool) {
+        currentThreadPool = newThreadPool;
+    }
+
+
+    QThreadPool* SegmentedEncryptor::threadPool() const {
+        return currentThreadPool;
+    }
+
+
+    QByteArray SegmentedEncryptor::encrypt(const QByteArray& inputBuffer) {
+        std::size_t numberInputBytes = static_cast<std::size_t>(inputBuffer.size());
+        QByteArray  result(static_cast<int>(encryptedSize(numberInputBytes)), '\x00');
+
+        std::uint8_t* outputData = reinterpret_cast<std::uint8_t*>(result.data());
+        startContainer(outputData);
+
+        engine()->encrypt(
+            currentThreadPool,
+            0,
+            reinterpret_cast<const std::uint8_t*>(inputBuffer.constData()),
+            outputData + headerLength,
+            numberInputBytes,
+            true
+        );
+
+        return result;
+    }
+
+
+    unsigned long long SegmentedEncryptor::encryptedSize(unsigned long long inputLength) const {
+        unsigned long long numberSegments = std::max((inputLength + currentSegmentSize - 1) / currentSegmentSize, 1ULL);
+        return headerLength + inputLength + numberSegments * tagLength;
+    }
+
+
+    void SegmentedEncryptor::setOutputDevice(QIODevice* outputDevice) {
+        currentOutputDevice = outputDevice;
+    }
+
+
+    QIODevice* SegmentedEncryptor::outputDevice() const {
+        return currentOutputDevice;
+    }
+
+
+    bool SegmentedEncryptor::open(SegmentedEncryptor::OpenMode openMode) {
+        bool result;
+
+        if (openMode == OpenModeFlag::WriteOnly || openMode == OpenModeFlag::Append) {
+            if (currentOutputDevice != Q_NULLPTR) {
+                result = QIODevice::open(openMode);
+            } else {
+                setErrorString(tr("No output device."));
+                result = false;
+            }
+        } else {
+            result = false;
+        }
+
+        if (result) {
+            QByteArray header(headerLength, '\x00');
+            startContainer(reinterpret_cast<std::uint8_t*>(header.data()));
+
+            pendingData.clear();
+            nextSegment = 0;
+
+            qint64 bytesWritten = currentOutputDevice->write(header);
+            if (bytesWritten != static_cast<qint64>(headerLength)) {
+                setErrorString(tr("Could not write header: %1").arg(currentOutputDevice->errorString()));
+                QIODevice::close();
+
+                result = false;
+            }
+        }
+
+        return result;
+    }
+
+
+    void SegmentedEncryptor::close() {
+        if (isOpen()) {
+            encryptPending(true);
+        }
+
+        QIODevice::close();
+    }
+
+
+    bool SegmentedEncryptor::isSequential() const {
+        return true;
+    }
+
+
+    qint64 SegmentedEncryptor::readData(char* /* data */, qint64 /* maxSize */) {
+        return -1;
+    }
+
+
+    qint64 SegmentedEncryptor::writeData(const char* data, qint64 maxSize) {
+        pendingData.append(data, static_cast<int>(maxSize));
+        return encryptPending(false) ? maxSize : -1;
+    }
+
+
+    void SegmentedEncryptor::startContainer(std::uint8_t* header) {
+        static_assert(sizeof(SegmentEngine) <= engineStorageSize, "Insufficient segment engine storage.");
+
+        // Every container gets its own keys, derived by the engine from the header salt, so the engine only needs the
+        // supplied keys when they change.
+        if (!keysExpanded) {
+            engine()->setKeys(initialKeys);
+            keysExpanded = true;
+        }
+
+        engine()->startEncryption(currentSegmentSize, header);
+    }
+
+
+    bool SegmentedEncryptor::encryptPending(bool final) {
+        std::size_t segmentSize  = engine()->segmentSize();
+        std::size_t pendingBytes = static_cast<std::size_t>(pendingData.size());
+        std::size_t numberSegments;
+        std::size_t dataLength;
+
+        if (final) {
+            numberSegments = static_cast<std::size_t>(engine()->numberSegments(pendingBytes, true));
+            dataLength     = pendingBytes;
+        } else {
+            // A full segment is only known not to be the last once more data follows it.  We also wait for a full
+            // batch so that every thread has work.
+            numberSegments = pendingBytes > 0 ? (pendingBytes - 1) / segmentSize : 0;
+            if (numberSegments < segmentsPerPass()) {
+                numberSegments = 0;
+            }
+
+            dataLength = numberSegments * segmentSize;
+        }
+
+        bool result = true;
+        if (numberSegments > 0) {
+            if (nextSegment + numberSegments <= SegmentEngine::maximumNumberSegments) {
+                encryptedData.resize(static_cast<int>(dataLength + numberSegments * tagLength));
+                engine()->encrypt(
+                    currentThreadPool,
+                    nextSegment,
+                    reinterpret_cast<const std::uint8_t*>(pendingData.constData()),
+                    reinterpret_cast<std::uint8_t*>(encryptedData.data()),
+                    dataLength,
+                    final
+                );
+
+                std::memset(pendingData.data(), 0, dataLength);
+                pendingData.remove(0, static_cast<int>(dataLength));
+                nextSegment += numberSegments;
+
+                qint64 bytesWritten = currentOutputDevice->write(encryptedData);
+                if (bytesWritten != static_cast<qint64>(encryptedData.size())) {
+                    setErrorString(tr("Could not write segment: %1").arg(currentOutputDevice->errorString()));
+                    result = false;
+                }
+            } else {
+                setErrorString(tr("Stream too long."));
+                result = false;
+            }
+        }
+
+        return result;
+    }
+
+
+    unsigned SegmentedEncryptor::segmentsPerPass() const {
+        unsigned result;
+
+        if (currentThreadPool != Q_NULLPTR) {
+            result = static_cast<unsigned>(std::max(currentThreadPool->maxThreadCount(), 0)) + 1;
+        } else {
+            result = 1;
+        }
+
+        return result;
+    }
+}
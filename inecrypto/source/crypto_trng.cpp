@@ -20,10 +20,11 @@
 * This file implements a small collection of true random number functions.
 ***********************************************************************************************************************/
 
-#include <QtGlobal>
-#include <QDebug>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 
-#if (defined(Q_OS_DARWIN) || defined(Q_OS_LINUX))
+#if (defined(__APPLE__) || defined(__linux__))
 
     #include <cstdio>
 
@@ -36,58 +37,80 @@
 
 #include "crypto_trng.h"
 
-#if (defined(Q_OS_DARWIN) || defined(Q_OS_LINUX))
-
-    quint32 Crypto::random32() {
-        FILE* f = std::fopen("/dev/urandom", "rb");
-        Q_ASSERT(f != NULL);
+#if (defined(__APPLE__) || defined(__linux__))
 
+    std::uint32_t Crypto::random32() {
         union {
-            quint32 value;
-            quint8  array[4];
+            std::uint32_t value;
+            std::uint8_t  array[4];
         } u;
 
-        int count = std::fread(u.array, 1, 4, f);
-        Q_ASSERT(count == 4);
+        bool ok = randomBytes(u.array, 4);
+        assert(ok);
+        (void) ok;
+
+        /* If we were concerned about protecting this value, we would wipe out the contents of the array */
+        return u.value;
+    }
+
+
+    std::uint64_t Crypto::random64() {
+        union {
+            std::uint64_t value;
+            std::uint8_t  array[8];
+        } u;
 
-        int exitCode = fclose(f);
-        Q_ASSERT(exitCode == 0);
+        bool ok = randomBytes(u.array, 8);
+        assert(ok);
+        (void) ok;
 
         /* If we were concerned about protecting this value, we would wipe out the contents of the array */
         return u.value;
     }
 
 
-    quint64 Crypto::random64() {
-        FILE* f = std::fopen("/dev/urandom", "rb");
-        Q_ASSERT(f != NULL);
+    bool Crypto::randomBytes(std::uint8_t* buffer, std::size_t length) {
+        bool  result = false;
+        FILE* f      = std::fopen("/dev/urandom", "rb");
+
+        if (f != nullptr) {
+            std::size_t count = std::fread(buffer, 1, length, f);
+            result = (count == length);
+
+            int exitCode = std::fclose(f);
+            assert(exitCode == 0);
+            (void) exitCode;
+        }
+
+        return result;
+    }
+
+#elif (defined(_WIN32)) // Assume Windows,
 
+    std::uint32_t Crypto::random32() {
         union {
-            quint64 value;
-            quint8  array[8];
+            std::uint32_t value;
+            std::uint8_t  array[4];
         } u;
 
-        int count = std::fread(u.array, 1, 8, f);
-        Q_ASSERT(count == 8);
-
-        int exitCode = fclose(f);
-        Q_ASSERT(exitCode == 0);
+        bool ok = randomBytes(u.array, 4);
+        assert(ok);
+        (void) ok;
 
         /* If we were concerned about protecting this value, we would wipe out the contents of the array */
         return u.value;
     }
 
-#elif (defined(Q_OS_WIN)) // Assume Windows,
 
-    quint32 Crypto::random32() {
+    std::uint64_t Crypto::random64() {
+        return static_cast<std::uint64_t>(Crypto::random32()) << 32 | static_cast<std::uint64_t>(Crypto::random32());
+    }
+
+
+    bool Crypto::randomBytes(std::uint8_t* buffer, std::size_t length) {
         HCRYPTPROV cryptoProvider = 0;
         BOOL       ok             = true;
 
-        union {
-            quint32 value;
-            BYTE    array[4];
-        } u;
-
         ok = CryptAcquireContext(&cryptoProvider, nullptr, nullptr, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
         if (!ok) {
             if (GetLastError() == NTE_BAD_KEYSET) {
@@ -95,25 +118,21 @@
             }
         }
 
-        if (!ok) {
-            qDebug() << "CryptAcquireContext failed " << GetLastError();
-            Q_ASSERT(false);
-        }
-
-        ok = CryptGenRandom(cryptoProvider, 4, u.array);
-        Q_ASSERT(ok);
-
-        /* If we were concerned about protecting this value, we would wipe out the contents of the array */
-
-        ok = CryptReleaseContext(cryptoProvider, 0);
-        Q_ASSERT(ok);
+        bool result = (ok != FALSE);
+        if (result) {
+            while (result && length > 0) {
+                DWORD bytesThisPass = length > 0x40000000 ? 0x40000000 : static_cast<DWORD>(length);
+                result = (CryptGenRandom(cryptoProvider, bytesThisPass, buffer) != FALSE);
 
-        return u.value;
-    }
+                buffer += bytesThisPass;
+                length -= bytesThisPass;
+            }
 
+            ok = CryptReleaseContext(cryptoProvider, 0);
+            assert(ok);
+        }
 
-    quint64 Crypto::random64() {
-        return static_cast<quint64>(Crypto::random32()) << 32 | static_cast<quint64>(Crypto::random32());
+        return result;
     }
 
 #else
@@ -23,40 +23,28 @@
 #include <QObject>
 #include <QIODevice>
 
+#include <algorithm>
 #include <cstring>
 
 #include "crypto_decryptor.h"
+#include "crypto_xtea_engine.h"
+#include "crypto_xtea_multi_stream.h"
 #include "crypto_xtea_decryptor.h"
 
 namespace Crypto {
-    XteaDecryptor::XteaDecryptor(QIODevice* parent):Decryptor(parent) {
-        std::memset(initialKeys, 0, keyLength);
-        std::memset(activeKeys, 0, keyLength);
-    }
+    XteaDecryptor::XteaDecryptor(QIODevice* parent):Decryptor(parent) {}
 
 
-    XteaDecryptor::XteaDecryptor(QObject* parent):Decryptor(parent) {
-        std::memset(initialKeys, 0, keyLength);
-        std::memset(activeKeys, 0, keyLength);
-    }
+    XteaDecryptor::XteaDecryptor(QObject* parent):Decryptor(parent) {}
 
 
-    XteaDecryptor::XteaDecryptor(const Keys& keys, QIODevice* parent):Decryptor(parent) {
-        std::memcpy(initialKeys, keys, keyLength);
-        std::memset(activeKeys, 0, keyLength);
-    }
+    XteaDecryptor::XteaDecryptor(const Keys& keys, QIODevice* parent):Decryptor(parent), engine(keys) {}
 
 
-    XteaDecryptor::XteaDecryptor(const Keys& keys, QObject* parent):Decryptor(parent) {
-        std::memcpy(initialKeys, keys, keyLength);
-        std::memset(activeKeys, 0, keyLength);
-    }
+    XteaDecryptor::XteaDecryptor(const Keys& keys, QObject* parent):Decryptor(parent), engine(keys) {}
 
 
-    XteaDecryptor::~XteaDecryptor() {
-        std::memset(initialKeys, 0, keyLength);
-        std::memset(activeKeys, 0, keyLength);
-    }
+    XteaDecryptor::~XteaDecryptor() {}
 
 
     unsigned XteaDecryptor::keyLengthInBytes() const {
@@ -65,66 +53,119 @@ namespace Crypto {
 
 
     void XteaDecryptor::setKeys(const Keys& keys) {
-        std::memcpy(initialKeys, keys, keyLength);
-        std::memset(activeKeys, 0, keyLength);
+        engine.setKeys(keys);
+    }
+
+
+    void XteaDecryptor::setKeySchedule(KeySchedule newKeySchedule) {
+        engine.setCipherTextChainingEnabled(newKeySchedule == CipherTextChaining);
+    }
+
+
+    XteaDecryptor::KeySchedule XteaDecryptor::keySchedule() const {
+        return engine.cipherTextChainingEnabled() ? CipherTextChaining : PlainTextChaining;
     }
 
 
     unsigned XteaDecryptor::outputChunkSize() const {
-        return 8;
+        return XteaDecryptEngine::blockSize;
+    }
+
+
+    bool XteaDecryptor::supportsRandomAccess() const {
+        return engine.cipherTextChainingEnabled();
+    }
+
+
+    bool XteaDecryptor::supportsParallelDecryption() const {
+        return engine.cipherTextChainingEnabled();
     }
 
 
     void XteaDecryptor::resetEngine() {
-        memcpy(activeKeys, initialKeys, keyLength);
+        engine.reset();
     }
 
 
-    void XteaDecryptor::decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
-        // The algorithm has been shamelessly lifted from:
-        //
-        //   http://en.wikipedia.org/wiki/XTEA
-        //
-        // We've modify the algorithm to roll our keys before each cycle so that the key in each cycle changes.
-
-        std::uint32_t v0 = (
-              (inputData[0]      )
-            | (inputData[1] <<  8)
-            | (inputData[2] << 16)
-            | (inputData[3] << 24)
-        );
-
-        std::uint32_t v1 = (
-              (inputData[4]      )
-            | (inputData[5] <<  8)
-            | (inputData[6] << 16)
-            | (inputData[7] << 24)
-        );
-
-        std::uint32_t sum = xteaDelta * numberFeistelRounds;
-        for (unsigned j=0 ; j<numberFeistelRounds ; ++j) {
-            v1 -= (((v0 << 4) ^ (v0 >> 5)) + v0) ^ (sum + activeKeys[(sum >> 11) & 3]);
-            sum -= xteaDelta;
-            v0 -= (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + activeKeys[sum & 3]);
+    bool XteaDecryptor::seekEngine(unsigned long long chunkIndex, const std::uint8_t* previousChunk) {
+        bool result;
+
+        if (engine.cipherTextChainingEnabled()) {
+            engine.seek(chunkIndex, previousChunk);
+            result = true;
+        } else {
+            result = false;
         }
 
-        outputData[0] = static_cast<unsigned char>(v0      );
-        outputData[1] = static_cast<unsigned char>(v0 >>  8);
-        outputData[2] = static_cast<unsigned char>(v0 >> 16);
-        outputData[3] = static_cast<unsigned char>(v0 >> 24);
-        outputData[4] = static_cast<unsigned char>(v1      );
-        outputData[5] = static_cast<unsigned char>(v1 >>  8);
-        outputData[6] = static_cast<unsigned char>(v1 >> 16);
-        outputData[7] = static_cast<unsigned char>(v1 >> 24);
-
-        activeKeys[0] = rollKey(activeKeys[0]) ^ v0;
-        activeKeys[1] = rollKey(activeKeys[1]);
-        activeKeys[2] = rollKey(activeKeys[2]);
-        activeKeys[3] = rollKey(activeKeys[3]);
+        return result;
+    }
+
+
+    void XteaDecryptor::decryptChunkRange(
+            unsigned long long  chunkIndex,
+            const std::uint8_t* previousChunk,
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        // Each run works on its own copy of the engine so the shared engine is only ever read.
+        XteaDecryptEngine rangeEngine(engine);
+        rangeEngine.seek(chunkIndex, previousChunk);
+
+        decryptChained(rangeEngine, inputData, outputData, numberChunks);
+    }
+
+
+    void XteaDecryptor::decryptChunk(const std::uint8_t* inputData, std::uint8_t* outputData) {
+        engine.decryptBlock(inputData, outputData);
+    }
+
+
+    void XteaDecryptor::decryptChunks(
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        if (engine.cipherTextChainingEnabled()) {
+            decryptChained(engine, inputData, outputData, numberChunks);
+        } else {
+            engine.decryptBlocks(inputData, outputData, numberChunks);
+        }
     }
 
 
-    std::uint32_t XteaDecryptor::rollKey(std::uint32_t currentKey) {
-        return currentKey & 0x80000000UL ? ((currentKey ^ keyRollPolynomial) << 1) | 0x00000001 : currentKey << 1;
+    void XteaDecryptor::decryptChained(
+            XteaDecryptEngine&  chainedEngine,
+            const std::uint8_t* inputData,
+            std::uint8_t*       outputData,
+            std::size_t         numberChunks
+        ) {
+        std::uint8_t            batchKeys[chainedBatchSize * keyLength];
+        XteaMultiStream::Stream streams[chainedBatchSize];
+
+        // Under cipher text chaining every chunk's keys can be derived from the cipher text alone, so each chunk is
+        // handed to the multi-stream engine as an independent single block stream and runs in its own SIMD lane.
+        while (numberChunks > 0) {
+            std::size_t batchSize = std::min(numberChunks, static_cast<std::size_t>(chainedBatchSize));
+
+            // The keys for the whole batch are derived before anything is decrypted since in place decryption
+            // overwrites the cipher text the chaining depends on.
+            chainedEngine.deriveBlockKeys(inputData, batchKeys, batchSize);
+
+            for (std::size_t i=0 ; i<batchSize ; ++i) {
+                streams[i].keys        = batchKeys + i * keyLength;
+                streams[i].inputData   = inputData + i * XteaDecryptEngine::blockSize;
+                streams[i].inputLength = XteaDecryptEngine::blockSize;
+                streams[i].outputData  = outputData + i * XteaDecryptEngine::blockSize;
+            }
+
+            XteaMultiStream::decryptEqualLength(streams, batchSize);
+
+            inputData    += batchSize * XteaDecryptEngine::blockSize;
+            outputData   += batchSize * XteaDecryptEngine::blockSize;
+            numberChunks -= batchSize;
+        }
+
+        std::memset(batchKeys, 0, sizeof(batchKeys));
     }
 }
@@ -0,0 +1,610 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements the \ref Crypto::XteaMultiStream class.
+***********************************************************************************************************************/
+
+#include <QByteArray>
+#include <QList>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "crypto_cpu_features.h"
+
+#if (CRYPTO_X86)
+    #include <emmintrin.h>
+    #include <immintrin.h>
+#endif
+
+#include "crypto_xtea_engine.h"
+#include "crypto_xtea_multi_stream.h"
+
+namespace Crypto {
+    /**
+     * The polynomial used to roll the keys after each block.  The value must match \ref Crypto::XteaEncryptor.
+     */
+    static constexpr std::uint32_t keyRollPolynomial = 0x100D4E63;
+
+    /**
+     * The number of XTEA Feistel rounds.
+     */
+    static constexpr std::uint32_t numberFeistelRounds = 64;
+
+    /**
+     * The XTEA key schedule constant.
+     */
+    static constexpr std::uint32_t xteaDelta = 0x9E3779B9UL;
+
+    /**
+     * Type of the functions that run the Feistel rounds on one block from each lane.
+     *
+     * \param[in,out] v0   The first word of the block in each lane.
+     *
+     * \param[in,out] v1   The second word of the block in each lane.
+     *
+     * \param[in]     keys The active keys, stored as four rows of one word per lane.
+     */
+    typedef void (*RoundFunction)(std::uint32_t* v0, std::uint32_t* v1, const std::uint32_t* keys);
+
+    /**
+     * Function that reads a little-endian 32-bit value.
+     *
+     * \param[in] data Pointer to the four bytes to be read.
+     *
+     * \return Returns the value.
+     */
+    static inline std::uint32_t readLittleEndian(const std::uint8_t* data) {
+        return (
+              static_cast<std::uint32_t>(data[0])
+            | (static_cast<std::uint32_t>(data[1]) <<  8)
+            | (static_cast<std::uint32_t>(data[2]) << 16)
+            | (static_cast<std::uint32_t>(data[3]) << 24)
+        );
+    }
+
+    /**
+     * Function that writes a little-endian 32-bit value.
+     *
+     * \param[in]  value The value to be written.
+     *
+     * \param[out] data  Pointer to the four bytes to receive the value.
+     */
+    static inline void writeLittleEndian(std::uint32_t value, std::uint8_t* data) {
+        data[0] = static_cast<std::uint8_t>(value      );
+        data[1] = static_cast<std::uint8_t>(value >>  8);
+        data[2] = static_cast<std::uint8_t>(value >> 16);
+        data[3] = static_cast<std::uint8_t>(value >> 24);
+    }
+
+    /**
+     * Function that encrypts a single block.
+     *
+     * \param[in,out] v0   The first word of the block.
+     *
+     * \param[in,out] v1   The second word of the block.
+     *
+     * \param[in]     keys The active keys.
+     */
+    static void encryptRoundsPortable(std::uint32_t* v0, std::uint32_t* v1, const std::uint32_t* keys) {
+        xteaEncryptBlock<numberFeistelRounds, xteaDelta>(*v0, *v1, keys);
+    }
+
+    /**
+     * Function that decrypts a single block.
+     *
+     * \param[in,out] v0   The first word of the block.
+     *
+     * \param[in,out] v1   The second word of the block.
+     *
+     * \param[in]     keys The active keys.
+     */
+    static void decryptRoundsPortable(std::uint32_t* v0, std::uint32_t* v1, const std::uint32_t* keys) {
+        xteaDecryptBlock<numberFeistelRounds, xteaDelta>(*v0, *v1, keys);
+    }
+
+    #if (CRYPTO_X86)
+
+        /**
+         * Function that calculates the XTEA mixing function on four lanes.
+         *
+         * \param[in] v The word in each lane.
+         *
+         * \return Returns ((v << 4) ^ (v >> 5)) + v for each lane.
+         */
+        CRYPTO_TARGET("sse2") static inline __m128i mixSse2(__m128i v) {
+            return _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v, 4), _mm_srli_epi32(v, 5)), v);
+        }
+
+        /**
+         * Function that encrypts one block in each of four lanes.
+         *
+         * \param[in,out] v0   The first word of the block in each lane.
+         *
+         * \param[in,out] v1   The second word of the block in each lane.
+         *
+         * \param[in]     keys The active keys, stored as four rows of four words.
+         */
+        CRYPTO_TARGET("sse2") static void encryptRoundsSse2(
+                std::uint32_t*       v0,
+                std::uint32_t*       v1,
+                const std::uint32_t* keys
+            ) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v0));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v1));
+            __m128i k[4];
+            for (unsigned i=0 ; i<4 ; ++i) {
+                k[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + 4 * i));
+            }
+
+            std::uint32_t sum = 0;
+            for (unsigned j=0 ; j<numberFeistelRounds ; ++j) {
+                __m128i roundKey = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(sum)), k[sum & 3]);
+                a = _mm_add_epi32(a, _mm_xor_si128(mixSse2(b), roundKey));
+
+                sum += xteaDelta;
+
+                roundKey = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(sum)), k[(sum >> 11) & 3]);
+                b = _mm_add_epi32(b, _mm_xor_si128(mixSse2(a), roundKey));
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(v0), a);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(v1), b);
+        }
+
+        /**
+         * Function that decrypts one block in each of four lanes.
+         *
+         * \param[in,out] v0   The first word of the block in each lane.
+         *
+         * \param[in,out] v1   The second word of the block in each lane.
+         *
+         * \param[in]     keys The active keys, stored as four rows of four words.
+         */
+        CRYPTO_TARGET("sse2") static void decryptRoundsSse2(
+                std::uint32_t*       v0,
+                std::uint32_t*       v1,
+                const std::uint32_t* keys
+            ) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v0));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v1));
+            __m128i k[4];
+            for (unsigned i=0 ; i<4 ; ++i) {
+                k[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + 4 * i));
+            }
+
+            std::uint32_t sum = xteaDelta * numberFeistelRounds;
+            for (unsigned j=0 ; j<numberFeistelRounds ; ++j) {
+                __m128i roundKey = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(sum)), k[(sum >> 11) & 3]);
+                b = _mm_sub_epi32(b, _mm_xor_si128(mixSse2(a), roundKey));
+
+                sum -= xteaDelta;
+
+                roundKey = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(sum)), k[sum & 3]);
+                a = _mm_sub_epi32(a, _mm_xor_si128(mixSse2(b), roundKey));
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(v0), a);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(v1), b);
+        }
+
+        /**
+         * Function that calculates the XTEA mixing function on eight lanes.
+         *
+         * \param[in] v The word in each lane.
+         *
+         * \return Returns ((v << 4) ^ (v >> 5)) + v for each lane.
+         */
+        CRYPTO_TARGET("avx2") static inline __m256i mixAvx2(__m256i v) {
+            return _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v, 4), _mm256_srli_epi32(v, 5)), v);
+        }
+
+        /**
+         * Function that encrypts one block in each of eight lanes.
+         *
+         * \param[in,out] v0   The first word of the block in each lane.
+         *
+         * \param[in,out] v1   The second word of the block in each lane.
+         *
+         * \param[in]     keys The active keys, stored as four rows of eight words.
+         */
+        CRYPTO_TARGET("avx2") static void encryptRoundsAvx2(
+                std::uint32_t*       v0,
+                std::uint32_t*       v1,
+                const std::uint32_t* keys
+            ) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v0));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v1));
+            __m256i k[4];
+            for (unsigned i=0 ; i<4 ; ++i) {
+                k[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + 8 * i));
+            }
+
+            std::uint32_t sum = 0;
+            for (unsigned j=0 ; j<numberFeistelRounds ; ++j) {
+                __m256i roundKey = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(sum)), k[sum & 3]);
+                a = _mm256_add_epi32(a, _mm256_xor_si256(mixAvx2(b), roundKey));
+
+                sum += xteaDelta;
+
+                roundKey = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(sum)), k[(sum >> 11) & 3]);
+                b = _mm256_add_epi32(b, _mm256_xor_si256(mixAvx2(a), roundKey));
+            }
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(v0), a);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(v1), b);
+        }
+
+        /**
+         * Function that decrypts one block in each of eight lanes.
+         *
+         * \param[in,out] v0   The first word of the block in each lane.
+         *
+         * \param[in,out] v1   The second word of the block in each lane.
+         *
+         * \param[in]     keys The active keys, stored as four rows of eight words.
+         */
+        CRYPTO_TARGET("avx2") static void decryptRoundsAvx2(
+                std::uint32_t*       v0,
+                std::uint32_t*       v1,
+                const std::uint32_t* keys
+            ) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v0));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v1));
+            __m256i k[4];
+            for (unsigned i=0 ; i<4 ; ++i) {
+                k[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + 8 * i));
+            }
+
+            std::uint32_t sum = xteaDelta * numberFeistelRounds;
+            for (unsigned j=0 ; j<numberFeistelRounds ; ++j) {
+                __m256i roundKey = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(sum)), k[(sum >> 11) & 3]);
+                b = _mm256_sub_epi32(b, _mm256_xor_si256(mixAvx2(a), roundKey));
+
+                sum -= xteaDelta;
+
+                roundKey = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(sum)), k[sum & 3]);
+                a = _mm256_sub_epi32(a, _mm256_xor_si256(mixAvx2(b), roundKey));
+            }
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(v0), a);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(v1), b);
+        }
+
+    #endif
+
+    /**
+     * Function that determines the number of blocks a stream occupies.
+     *
+     * \param[in] stream     The stream.
+     *
+     * \param[in] encrypting If true, a partial final block counts as a block.  If false, it is ignored.
+     *
+     * \return Returns the number of blocks.
+     */
+    static inline std::size_t numberBlocks(const XteaMultiStream::Stream& stream, bool encrypting) {
+        return (
+              encrypting
+            ? (stream.inputLength + XteaMultiStream::blockLength - 1) / XteaMultiStream::blockLength
+            : stream.inputLength / XteaMultiStream::blockLength
+        );
+    }
+
+    /**
+     * Function that runs a group of streams side by side, one stream per lane.
+     *
+     * \param[in] streams       Pointers to the streams in the group.
+     *
+     * \param[in] numberStreams The number of streams in the group.  The value must not exceed the lane count.
+     *
+     * \param[in] lanes         The number of lanes handled by the round function.
+     *
+     * \param[in] encrypting    If true, the streams are encrypted.  If false, the streams are decrypted.
+     *
+     * \param[in] rounds        The round function.
+     */
+    static void processGroup(
+            const XteaMultiStream::Stream* const* streams,
+            unsigned                              numberStreams,
+            unsigned                              lanes,
+            bool                                  encrypting,
+            RoundFunction                         rounds
+        ) {
+        constexpr unsigned maximumLanes = XteaMultiStream::maximumLanes;
+        constexpr unsigned blockLength  = XteaMultiStream::blockLength;
+
+        std::uint32_t keys[4 * maximumLanes] = { 0 };
+        std::uint32_t v0[maximumLanes]       = { 0 };
+        std::uint32_t v1[maximumLanes]       = { 0 };
+        std::uint32_t feedback[maximumLanes] = { 0 };
+        std::size_t   blocks[maximumLanes]   = { 0 };
+        std::size_t   groupBlocks            = 0;
+
+        for (unsigned lane=0 ; lane<numberStreams ; ++lane) {
+            std::uint32_t streamKeys[4];
+            std::memcpy(streamKeys, streams[lane]->keys, XteaMultiStream::keyLength);
+            for (unsigned i=0 ; i<4 ; ++i) {
+                keys[i * lanes + lane] = streamKeys[i];
+            }
+
+            blocks[lane] = numberBlocks(*streams[lane], encrypting);
+            groupBlocks  = std::max(groupBlocks, blocks[lane]);
+        }
+
+        for (std::size_t block=0 ; block<groupBlocks ; ++block) {
+            std::size_t offset = block * blockLength;
+
+            for (unsigned lane=0 ; lane<numberStreams ; ++lane) {
+                if (block < blocks[lane]) {
+                    const XteaMultiStream::Stream& stream    = *streams[lane];
+                    std::size_t                    remaining = stream.inputLength - offset;
+
+                    if (remaining >= blockLength) {
+                        v0[lane] = readLittleEndian(stream.inputData + offset);
+                        v1[lane] = readLittleEndian(stream.inputData + offset + 4);
+                    } else {
+                        // Pad the final block the same way as Crypto::Encryptor::encrypt.
+                        std::uint8_t tail[blockLength];
+                        std::memcpy(tail, stream.inputData + offset, remaining);
+                        std::size_t padding = blockLength - remaining;
+                        std::memset(tail + remaining, static_cast<int>(padding), padding);
+
+                        v0[lane] = readLittleEndian(tail);
+                        v1[lane] = readLittleEndian(tail + 4);
+                    }
+                }
+            }
+
+            if (encrypting) {
+                std::memcpy(feedback, v0, sizeof(v0));
+            }
+
+            rounds(v0, v1, keys);
+
+            if (!encrypting) {
+                std::memcpy(feedback, v0, sizeof(v0));
+            }
+
+            for (unsigned lane=0 ; lane<numberStreams ; ++lane) {
+                if (block < blocks[lane]) {
+                    std::uint8_t* output = streams[lane]->outputData + offset;
+                    writeLittleEndian(v0[lane], output);
+                    writeLittleEndian(v1[lane], output + 4);
+                }
+
+                keys[lane] = xteaRollKey<keyRollPolynomial>(keys[lane]) ^ feedback[lane];
+                for (unsigned i=1 ; i<4 ; ++i) {
+                    keys[i * lanes + lane] = xteaRollKey<keyRollPolynomial>(keys[i * lanes + lane]);
+                }
+            }
+        }
+
+        std::memset(keys, 0, sizeof(keys));
+        std::memset(v0, 0, sizeof(v0));
+        std::memset(v1, 0, sizeof(v1));
+        std::memset(feedback, 0, sizeof(feedback));
+    }
+
+    /**
+     * Function that selects the round function to use for a given lane count.
+     *
+     * \param[in] lanes      The number of lanes, as reported by \ref Crypto::XteaMultiStream::lanes.
+     *
+     * \param[in] encrypting If true, the encryption rounds are selected.  If false, the decryption rounds are selected.
+     *
+     * \return Returns the round function.
+     */
+    static RoundFunction roundFunction(unsigned lanes, bool encrypting) {
+        RoundFunction result = encrypting ? encryptRoundsPortable : decryptRoundsPortable;
+
+        #if (CRYPTO_X86)
+            if (lanes == 8) {
+                result = encrypting ? encryptRoundsAvx2 : decryptRoundsAvx2;
+            } else if (lanes == 4) {
+                result = encrypting ? encryptRoundsSse2 : decryptRoundsSse2;
+            }
+        #else
+            (void) lanes;
+        #endif
+
+        return result;
+    }
+
+    /**
+     * Function that processes a batch of streams that all occupy the same number of blocks.  No lane can idle while
+     * another finishes so the streams are grouped in order, without sorting or allocating.
+     *
+     * \param[in] streams       Array of streams to be processed.
+     *
+     * \param[in] numberStreams The number of streams.
+     *
+     * \param[in] encrypting    If true, the streams are encrypted.  If false, the streams are decrypted.
+     */
+    static void processEqualLengthStreams(
+            const XteaMultiStream::Stream* streams,
+            std::size_t                    numberStreams,
+            bool                           encrypting
+        ) {
+        unsigned      lanes  = XteaMultiStream::lanes();
+        RoundFunction rounds = roundFunction(lanes, encrypting);
+
+        const XteaMultiStream::Stream* group[XteaMultiStream::maximumLanes];
+        for (std::size_t first=0 ; first<numberStreams ; first+=lanes) {
+            std::size_t groupSize = std::min(static_cast<std::size_t>(lanes), numberStreams - first);
+            for (std::size_t lane=0 ; lane<groupSize ; ++lane) {
+                group[lane] = streams + first + lane;
+            }
+
+            processGroup(group, static_cast<unsigned>(groupSize), lanes, encrypting, rounds);
+        }
+    }
+
+    /**
+     * Function that processes a batch of streams.
+     *
+     * \param[in] streams       Array of streams to be processed.
+     *
+     * \param[in] numberStreams The number of streams.
+     *
+     * \param[in] encrypting    If true, the streams are encrypted.  If false, the streams are decrypted.
+     */
+    static void processStreams(const XteaMultiStream::Stream* streams, std::size_t numberStreams, bool encrypting) {
+        bool equalLength = true;
+        for (std::size_t i=1 ; equalLength && i<numberStreams ; ++i) {
+            equalLength = (numberBlocks(streams[i], encrypting) == numberBlocks(streams[0], encrypting));
+        }
+
+        if (equalLength) {
+            processEqualLengthStreams(streams, numberStreams, encrypting);
+        } else {
+            unsigned      lanes  = XteaMultiStream::lanes();
+            RoundFunction rounds = roundFunction(lanes, encrypting);
+
+            // Grouping streams of similar length keeps lanes from idling while the longest stream in a group
+            // finishes.
+            std::vector<const XteaMultiStream::Stream*> order(numberStreams);
+            for (std::size_t i=0 ; i<numberStreams ; ++i) {
+                order[i] = streams + i;
+            }
+
+            std::stable_sort(
+                order.begin(),
+                order.end(),
+                [encrypting](const XteaMultiStream::Stream* a, const XteaMultiStream::Stream* b) {
+                    return numberBlocks(*a, encrypting) > numberBlocks(*b, encrypting);
+                }
+            );
+
+            for (std::size_t first=0 ; first<numberStreams ; first+=lanes) {
+                std::size_t groupSize = std::min(static_cast<std::size_t>(lanes), numberStreams - first);
+                processGroup(order.data() + first, static_cast<unsigned>(groupSize), lanes, encrypting, rounds);
+            }
+        }
+    }
+
+    /**
+     * Function that processes a list of records.
+     *
+     * \param[in] keys       The keys for each record.
+     *
+     * \param[in] records    The records to be processed.
+     *
+     * \param[in] encrypting If true, the records are encrypted.  If false, the records are decrypted.
+     *
+     * \return Returns the processed records.  An empty list is returned if the keys are invalid.
+     */
+    static QList<QByteArray> processRecords(
+            const QList<QByteArray>& keys,
+            const QList<QByteArray>& records,
+            bool                     encrypting
+        ) {
+        QList<QByteArray> result;
+
+        bool keysValid = (keys.size() == records.size());
+        for (int i=0 ; keysValid && i<keys.size() ; ++i) {
+            keysValid = (static_cast<unsigned>(keys.at(i).size()) == XteaMultiStream::keyLength);
+        }
+
+        if (keysValid) {
+            std::vector<XteaMultiStream::Stream> streams(static_cast<std::size_t>(records.size()));
+
+            for (int i=0 ; i<records.size() ; ++i) {
+                const QByteArray& record      = records.at(i);
+                std::size_t       inputLength = static_cast<std::size_t>(record.size());
+                std::size_t       outputLength = (
+                      encrypting
+                    ? XteaMultiStream::encryptedSize(inputLength)
+                    : XteaMultiStream::decryptedSize(inputLength)
+                );
+
+                result.append(QByteArray(static_cast<int>(outputLength), '\x00'));
+
+                XteaMultiStream::Stream& stream = streams[static_cast<std::size_t>(i)];
+                stream.keys        = reinterpret_cast<const std::uint8_t*>(keys.at(i).constData());
+                stream.inputData   = reinterpret_cast<const std::uint8_t*>(record.constData());
+                stream.inputLength = inputLength;
+            }
+
+            // Output pointers are taken once the list is complete so that no detach can move the buffers.
+            for (int i=0 ; i<result.size() ; ++i) {
+                streams[static_cast<std::size_t>(i)].outputData = reinterpret_cast<std::uint8_t*>(result[i].data());
+            }
+
+            processStreams(streams.data(), streams.size(), encrypting);
+        }
+
+        return result;
+    }
+
+
+    void XteaMultiStream::encrypt(const Stream* streams, std::size_t numberStreams) {
+        processStreams(streams, numberStreams, true);
+    }
+
+
+    void XteaMultiStream::decrypt(const Stream* streams, std::size_t numberStreams) {
+        processStreams(streams, numberStreams, false);
+    }
+
+
+    void XteaMultiStream::encryptEqualLength(const Stream* streams, std::size_t numberStreams) {
+        processEqualLengthStreams(streams, numberStreams, true);
+    }
+
+
+    void XteaMultiStream::decryptEqualLength(const Stream* streams, std::size_t numberStreams) {
+        processEqualLengthStreams(streams, numberStreams, false);
+    }
+
+
+    QList<QByteArray> XteaMultiStream::encrypt(const QList<QByteArray>& keys, const QList<QByteArray>& plainTexts) {
+        return processRecords(keys, plainTexts, true);
+    }
+
+
+    QList<QByteArray> XteaMultiStream::decrypt(const QList<QByteArray>& keys, const QList<QByteArray>& cipherTexts) {
+        return processRecords(keys, cipherTexts, false);
+    }
+
+
+    std::size_t XteaMultiStream::encryptedSize(std::size_t inputLength) {
+        return ((inputLength + blockLength - 1) / blockLength) * blockLength;
+    }
+
+
+    std::size_t XteaMultiStream::decryptedSize(std::size_t inputLength) {
+        return (inputLength / blockLength) * blockLength;
+    }
+
+
+    unsigned XteaMultiStream::lanes() {
+        unsigned result = 1;
+
+        #if (CRYPTO_X86)
+            if (cpuHasAvx2()) {
+                result = 8;
+            } else if (cpuHasSse2()) {
+                result = 4;
+            }
+        #endif
+
+        return result;
+    }
+}
@@ -0,0 +1,126 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the heap allocations made by the encryption/decryption functions.  The tests replace
+* the global operator new so they are built as their own executable.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QByteArray>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+#include <crypto_aes_cbc_encryptor.h>
+#include <crypto_aes_cbc_decryptor.h>
+
+#include "test_allocations.h"
+
+/***********************************************************************************************************************
+ * Allocation counting:
+ */
+
+static std::atomic<unsigned long> numberAllocations(0);
+
+void* operator new(std::size_t size) {
+    ++numberAllocations;
+
+    void* result = std::malloc(size > 0 ? size : 1);
+    if (result == Q_NULLPTR) {
+        throw std::bad_alloc();
+    }
+
+    return result;
+}
+
+
+void* operator new[](std::size_t size) {
+    ++numberAllocations;
+
+    void* result = std::malloc(size > 0 ? size : 1);
+    if (result == Q_NULLPTR) {
+        throw std::bad_alloc();
+    }
+
+    return result;
+}
+
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+
+void operator delete(void* pointer, std::size_t /* size */) noexcept {
+    std::free(pointer);
+}
+
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+
+void operator delete[](void* pointer, std::size_t /* size */) noexcept {
+    std::free(pointer);
+}
+
+/***********************************************************************************************************************
+ * TestAllocations:
+ */
+
+void TestAllocations::testAesCbcAllocations() {
+    Crypto::AesCbcEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    // Length deliberately not a multiple of the block size so the padded tail is exercised.
+    QByteArray plainText(100, 'x');
+
+    Crypto::AesCbcEncryptor encryptor(keys);
+    Crypto::AesCbcDecryptor decryptor(keys);
+
+    QByteArray encrypted = encryptor.encrypt(plainText);
+    QByteArray decrypted = decryptor.decrypt(encrypted);
+
+    unsigned long startingAllocations = numberAllocations;
+
+    encrypted = encryptor.encrypt(plainText);
+    decrypted = decryptor.decrypt(encrypted);
+
+    unsigned long allocations = numberAllocations - startingAllocations;
+
+    // QByteArray allocates its storage with malloc so the result buffers never reach operator new.
+    QCOMPARE(allocations, 0UL);
+    QCOMPARE(decrypted.size(), 112);
+    QCOMPARE(decrypted.left(plainText.size()), plainText);
+}
+
+/***********************************************************************************************************************
+ * main:
+ */
+
+int main(int argumentCount, char** argumentValues) {
+    TestAllocations testAllocations;
+    return QTest::qExec(&testAllocations, argumentCount, argumentValues);
+}
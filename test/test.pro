@@ -21,7 +21,7 @@
 #
 
 TEMPLATE = app
-QT += core testlib
+QT += core testlib network
 CONFIG += testcase c++14
 
 HEADERS = test_trng.h \
@@ -29,7 +29,16 @@ HEADERS = test_trng.h \
           test_crc_generator.h \
           test_xtea.h \
           test_aes_cbc.h \
-          test_hmac.h
+          test_aes_ctr.h \
+          test_aes_gcm.h \
+          test_chacha20_poly1305.h \
+          test_hmac.h \
+          test_core.h \
+          test_segmented.h \
+          test_encrypted_log.h \
+          test_compression.h \
+          test_encrypted_channel.h \
+          test_kdf.h
 
 SOURCES = test_inecrypto.cpp \
           test_trng.cpp \
@@ -37,7 +46,16 @@ SOURCES = test_inecrypto.cpp \
           test_crc_generator.cpp \
           test_xtea.cpp \
           test_aes_cbc.cpp \
-          test_hmac.cpp
+          test_aes_ctr.cpp \
+          test_aes_gcm.cpp \
+          test_chacha20_poly1305.cpp \
+          test_hmac.cpp \
+          test_core.cpp \
+          test_segmented.cpp \
+          test_encrypted_log.cpp \
+          test_compression.cpp \
+          test_encrypted_channel.cpp \
+          test_kdf.cpp
 
 ########################################################################################################################
 # inecrypto library:
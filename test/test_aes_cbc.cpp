@@ -24,9 +24,11 @@
 #include <QString>
 #include <QByteArray>
 #include <QBuffer>
+#include <QThreadPool>
 #include <QtTest/QtTest>
 
 #include <cstdint>
+#include <cstring>
 #include <random>
 
 #include <crypto_aes_cbc_encryptor.h>
@@ -140,3 +142,413 @@ void TestAesCbc::testAesCbcEncryptDecryptFuzz() {
     }
 }
 
+
+
+void TestAesCbc::testAesCbcIVHeaderBasic() {
+    Crypto::AesCbcEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    QByteArray plainText("Weave a circle round him thrice, and close your eyes with holy dread.");
+    while (plainText.size() % 16 != 0) {
+        plainText.append('-');
+    }
+
+    Crypto::AesCbcEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+    QCOMPARE(encryptor.headerSize(), Crypto::AesCbcEncryptor::ivLength);
+
+    QByteArray encrypted1 = encryptor.encrypt(plainText);
+    QByteArray encrypted2 = encryptor.encrypt(plainText);
+
+    QCOMPARE(encrypted1.size(), static_cast<int>(plainText.size() + Crypto::AesCbcEncryptor::ivLength));
+    QCOMPARE(encrypted2.size(), encrypted1.size());
+    QVERIFY(encrypted1.left(Crypto::AesCbcEncryptor::ivLength) != encrypted2.left(Crypto::AesCbcEncryptor::ivLength));
+    QVERIFY(encrypted1.mid(Crypto::AesCbcEncryptor::ivLength) != encrypted2.mid(Crypto::AesCbcEncryptor::ivLength));
+
+    Crypto::AesCbcDecryptor decryptor(keys);
+    decryptor.setIVHeaderEnabled();
+
+    QCOMPARE(decryptor.decrypt(encrypted1), plainText);
+    QCOMPARE(decryptor.decrypt(encrypted2), plainText);
+
+    // The header IV must match what an explicitly configured decryptor would need.
+    Crypto::AesCbcDecryptor::IV iv;
+    std::memcpy(iv, encrypted1.constData(), Crypto::AesCbcDecryptor::ivLength);
+
+    Crypto::AesCbcDecryptor explicitDecryptor(keys, iv);
+    QCOMPARE(explicitDecryptor.decrypt(encrypted1.mid(Crypto::AesCbcDecryptor::ivLength)), plainText);
+}
+
+
+void TestAesCbc::testAesCbcIVHeaderFile() {
+    QString t1("And close your eyes with holy dread For he on honey-dew hath fed, and drunk the milk of paradise.");
+
+    Crypto::AesCbcEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    QByteArray plainText = t1.toUtf8();
+    while (plainText.size() % 16 != 0) {
+        plainText.append('-');
+    }
+
+    QByteArray encrypted;
+    QBuffer    encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+    Crypto::AesCbcEncryptor encryptor(keys, &encryptedBuffer);
+    encryptor.setIVHeaderEnabled();
+
+    encryptor.open(Crypto::Encryptor::OpenModeFlag::WriteOnly);
+    encryptor.write(plainText.left(7));
+    encryptor.write(plainText.mid(7));
+    encryptor.close();
+
+    encryptedBuffer.close();
+
+    QCOMPARE(encrypted.size(), static_cast<int>(plainText.size() + Crypto::AesCbcEncryptor::ivLength));
+    QCOMPARE(encryptor.numberOutputBytesProcessed(), static_cast<unsigned long long>(encrypted.size()));
+
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesCbcDecryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    decryptor.open(Crypto::AesCbcDecryptor::OpenModeFlag::ReadOnly);
+
+    unsigned bytesAvailable = decryptor.bytesAvailable();
+    QCOMPARE(bytesAvailable, static_cast<unsigned>(plainText.size()));
+
+    QByteArray decrypted = decryptor.read(bytesAvailable);
+
+    decryptor.close();
+
+    QCOMPARE(decrypted, plainText);
+}
+
+
+void TestAesCbc::testAesCbcKeyChange() {
+    std::mt19937                    rng(0x87654321);
+    std::uniform_int_distribution<> byteDistribution(0, 255);
+
+    // Reuse the same instances across many messages and keys, checking against freshly constructed instances.
+    Crypto::AesCbcEncryptor       encryptor;
+    Crypto::AesCbcDecryptor       decryptor;
+    Crypto::AesCbcEncryptor::Keys keys;
+
+    for (unsigned i=0 ; i<100 ; ++i) {
+        if (i % 4 == 0) {
+            for (unsigned ki=0 ; ki<32 ; ++ki) {
+                keys[ki] = byteDistribution(rng);
+            }
+
+            encryptor.setKeys(keys);
+            decryptor.setKeys(keys);
+        }
+
+        QByteArray plainText;
+        for (unsigned bi=0 ; bi<64 ; ++bi) {
+            plainText.append(static_cast<unsigned char>(byteDistribution(rng)));
+        }
+
+        Crypto::AesCbcEncryptor referenceEncryptor(keys);
+        QByteArray              encrypted = encryptor.encrypt(plainText);
+
+        QCOMPARE(encrypted, referenceEncryptor.encrypt(plainText));
+        QCOMPARE(decryptor.decrypt(encrypted), plainText);
+    }
+}
+
+
+void TestAesCbc::testAesCbcSpans() {
+    Crypto::AesCbcEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    Crypto::AesCbcEncryptor::IV iv = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+    };
+
+    QByteArray plainText("Beware! Beware! His flashing eyes, his floating hair!");
+
+    Crypto::AesCbcEncryptor encryptor(keys, iv);
+    Crypto::AesCbcDecryptor decryptor(keys, iv);
+
+    QByteArray  expected = encryptor.encrypt(plainText);
+    std::size_t length   = static_cast<std::size_t>(plainText.size());
+
+    QCOMPARE(encryptor.encryptedSize(length), static_cast<std::size_t>(expected.size()));
+
+    // Pointer/length overloads must match the QByteArray API and refuse short output buffers.
+    std::uint8_t buffer[128];
+    QCOMPARE(
+        encryptor.encrypt(reinterpret_cast<const std::uint8_t*>(plainText.constData()), length, buffer, 16),
+        static_cast<std::size_t>(0)
+    );
+
+    std::size_t encryptedLength = encryptor.encrypt(
+        reinterpret_cast<const std::uint8_t*>(plainText.constData()),
+        length,
+        buffer,
+        sizeof(buffer)
+    );
+
+    QCOMPARE(QByteArray(reinterpret_cast<const char*>(buffer), static_cast<int>(encryptedLength)), expected);
+
+    std::uint8_t decrypted[128];
+    std::size_t  decryptedLength = decryptor.decrypt(buffer, encryptedLength, decrypted, sizeof(decrypted));
+    QCOMPARE(decryptedLength, encryptedLength);
+    QCOMPARE(QByteArray(reinterpret_cast<const char*>(decrypted), static_cast<int>(length)), plainText);
+
+    // In-place operation, including with an IV header that shifts the data.
+    encryptor.setIVHeaderEnabled();
+    decryptor.setIVHeaderEnabled();
+
+    std::memcpy(buffer, plainText.constData(), length);
+    encryptedLength = encryptor.encryptInPlace(buffer, length, sizeof(buffer));
+    QCOMPARE(encryptedLength, encryptor.encryptedSize(length));
+    QCOMPARE(encryptedLength, expected.size() + static_cast<std::size_t>(Crypto::AesCbcEncryptor::ivLength));
+
+    decryptedLength = decryptor.decryptInPlace(buffer, encryptedLength);
+    QCOMPARE(decryptedLength, static_cast<std::size_t>(expected.size()));
+    QCOMPARE(QByteArray(reinterpret_cast<const char*>(buffer), static_cast<int>(length)), plainText);
+}
+
+
+void TestAesCbc::testAesCbcRandomAccess() {
+    Crypto::AesCbcEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    QByteArray plainText;
+    for (unsigned i=0 ; i<100000 ; ++i) {
+        plainText.append(static_cast<char>((i * 131) ^ (i >> 8)));
+    }
+
+    Crypto::AesCbcEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+
+    QByteArray encrypted = encryptor.encrypt(plainText);
+    QBuffer    encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesCbcDecryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    QVERIFY(decryptor.isSequential());
+
+    decryptor.setRandomAccessEnabled();
+    QVERIFY(!decryptor.isSequential());
+
+    decryptor.open(Crypto::AesCbcDecryptor::OpenModeFlag::ReadOnly);
+    QCOMPARE(decryptor.size(), static_cast<qint64>(plainText.size()));
+
+    // The first read must also pull in the IV header.
+    QCOMPARE(decryptor.read(100), plainText.left(100));
+
+    // Reads after a seek must only pull the chunks they need from the input device.
+    qint64 positions[] = { 99000, 17, 0, 65536, 50001, 99999 };
+    for (qint64 position : positions) {
+        QVERIFY(decryptor.seek(position));
+        QCOMPARE(decryptor.pos(), position);
+
+        QByteArray data = decryptor.read(100);
+        QCOMPARE(data, plainText.mid(static_cast<int>(position), 100));
+        QVERIFY(encryptedBuffer.pos() <= Crypto::AesCbcDecryptor::ivLength + position + 100 + 32);
+    }
+
+    QVERIFY(decryptor.seek(90000));
+    QCOMPARE(decryptor.readAll(), plainText.mid(90000));
+    QVERIFY(decryptor.atEnd());
+
+    QVERIFY(!decryptor.seek(plainText.size() + 1));
+
+    decryptor.close();
+    encryptedBuffer.close();
+}
+
+
+void TestAesCbc::testAesCbcParallel() {
+    Crypto::AesCbcEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    // Large enough to be split into several segments, with an odd number of blocks so the segments differ in size.
+    QByteArray plainText;
+    for (unsigned i=0 ; i<3 * 1024 * 1024 + 48 ; ++i) {
+        plainText.append(static_cast<char>((i * 131) ^ (i >> 8)));
+    }
+
+    Crypto::AesCbcEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(4);
+
+    Crypto::AesCbcDecryptor decryptor(keys);
+    decryptor.setIVHeaderEnabled();
+    QVERIFY(decryptor.supportsParallelDecryption());
+    QVERIFY(decryptor.threadPool() == Q_NULLPTR);
+
+    decryptor.setThreadPool(&threadPool);
+    QVERIFY(decryptor.threadPool() == &threadPool);
+
+    QCOMPARE(decryptor.decrypt(encrypted), plainText);
+
+    // In place decryption must not lose the ciphertext chaining each segment to the one ahead of it.
+    QByteArray  buffer     = encrypted;
+    std::size_t outputSize = decryptor.decryptInPlace(
+        reinterpret_cast<std::uint8_t*>(buffer.data()),
+        static_cast<std::size_t>(buffer.size())
+    );
+
+    QCOMPARE(outputSize, static_cast<std::size_t>(plainText.size()));
+    QCOMPARE(buffer.mid(0, plainText.size()), plainText);
+
+    // Small buffers stay on the calling thread but must still decrypt correctly.
+    QByteArray shortText = plainText.left(1024);
+    QCOMPARE(decryptor.decrypt(encryptor.encrypt(shortText)), shortText);
+
+    decryptor.setThreadPool(Q_NULLPTR);
+    QCOMPARE(decryptor.decrypt(encrypted), plainText);
+}
+
+
+void TestAesCbc::testAesCbcRekey() {
+    Crypto::AesCbcEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    QByteArray plainText;
+    for (unsigned i=0 ; i<100000 ; ++i) {
+        plainText.append(static_cast<char>((i * 131) ^ (i >> 8)));
+    }
+
+    Crypto::AesCbcEncryptor plainEncryptor(keys);
+    QByteArray              unrotated = plainEncryptor.encrypt(plainText);
+
+    Crypto::AesCbcEncryptor encryptor(keys);
+    encryptor.setRekeyInterval(1000);
+    QCOMPARE(encryptor.rekeyInterval(), 1008ULL);
+
+    // The first interval uses the initial keys.  Everything after it must differ.
+    QByteArray encrypted = encryptor.encrypt(plainText);
+    QCOMPARE(encrypted.size(), unrotated.size());
+    QCOMPARE(encrypted.left(1008), unrotated.left(1008));
+    QVERIFY(encrypted.mid(1008, 16) != unrotated.mid(1008, 16));
+
+    // Each stream starts again from the initial keys.
+    QCOMPARE(encryptor.encrypt(plainText), encrypted);
+
+    Crypto::AesCbcDecryptor decryptor(keys);
+    QVERIFY(decryptor.decrypt(encrypted).left(plainText.size()) != plainText);
+
+    decryptor.setRekeyInterval(1000);
+    QVERIFY(!decryptor.supportsParallelDecryption());
+    QCOMPARE(decryptor.decrypt(encrypted).left(plainText.size()), plainText);
+    QCOMPARE(decryptor.decrypt(unrotated.left(1008)), plainText.left(1008));
+
+    // Seeking must pick up the keys for the interval holding the new position.
+    QBuffer encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesCbcDecryptor streamDecryptor(keys, &encryptedBuffer);
+    streamDecryptor.setRekeyInterval(1000);
+    streamDecryptor.setRandomAccessEnabled();
+    streamDecryptor.open(Crypto::AesCbcDecryptor::OpenModeFlag::ReadOnly);
+
+    qint64 positions[] = { 99000, 1000, 1008, 0, 50001, 2015 };
+    for (qint64 position : positions) {
+        QVERIFY(streamDecryptor.seek(position));
+        QCOMPARE(streamDecryptor.read(3000), plainText.mid(static_cast<int>(position), 3000));
+    }
+
+    // Closing the device clears the rotated keys so reopening must start again from the initial keys.
+    streamDecryptor.close();
+    streamDecryptor.open(Crypto::AesCbcDecryptor::OpenModeFlag::ReadOnly);
+    QCOMPARE(streamDecryptor.read(3000), plainText.left(3000));
+
+    streamDecryptor.close();
+    encryptedBuffer.close();
+}
+
+void TestAesCbc::testAesCbcAsynchronous() {
+    Crypto::AesCbcEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    Crypto::AesCbcEncryptor::IV iv = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+    };
+
+    QByteArray plainText;
+    for (unsigned i=0 ; i<1000003 ; ++i) {
+        plainText.append(static_cast<char>((i * 131) ^ (i >> 8)));
+    }
+
+    QByteArray expected;
+    QBuffer    expectedBuffer(&expected);
+    expectedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+    Crypto::AesCbcEncryptor synchronousEncryptor(keys, iv);
+    synchronousEncryptor.setOutputDevice(&expectedBuffer);
+    synchronousEncryptor.open(Crypto::AesCbcEncryptor::OpenModeFlag::WriteOnly);
+    QCOMPARE(synchronousEncryptor.write(plainText), static_cast<qint64>(plainText.size()));
+    QVERIFY(synchronousEncryptor.flush());
+    synchronousEncryptor.close();
+
+    QByteArray encrypted;
+    QBuffer    encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+    Crypto::AesCbcEncryptor encryptor(keys, iv);
+    encryptor.setOutputDevice(&encryptedBuffer);
+    encryptor.setAsynchronousEnabled();
+    encryptor.setMaximumQueuedBytes(100000);
+    QVERIFY(encryptor.asynchronousEnabled());
+    QCOMPARE(encryptor.maximumQueuedBytes(), static_cast<qint64>(100000));
+
+    qint64 numberBytesWritten = 0;
+    QObject::connect(
+        &encryptor,
+        &Crypto::AesCbcEncryptor::bytesWritten,
+        [&numberBytesWritten](qint64 bytes) {
+            numberBytesWritten += bytes;
+        }
+    );
+
+    encryptor.open(Crypto::AesCbcEncryptor::OpenModeFlag::WriteOnly);
+
+    // Writes are accepted up to the queue limit; the remainder must wait for the worker to catch up.
+    int  offset   = 0;
+    bool backedUp = false;
+    while (offset < plainText.size()) {
+        int    length   = std::min(plainText.size() - offset, 30000);
+        qint64 accepted = encryptor.write(plainText.constData() + offset, length);
+        QVERIFY(accepted >= 0);
+        QVERIFY(encryptor.bytesToWrite() <= encryptor.maximumQueuedBytes());
+
+        offset += static_cast<int>(accepted);
+        if (accepted < length) {
+            backedUp = true;
+            encryptor.waitForBytesWritten(-1);
+        }
+    }
+
+    QVERIFY(backedUp);
+    QVERIFY(encryptor.flush());
+    QCOMPARE(encryptor.bytesToWrite(), static_cast<qint64>(0));
+    QCOMPARE(numberBytesWritten, static_cast<qint64>(plainText.size()));
+    QCOMPARE(encryptor.numberInputBytesProcessed(), synchronousEncryptor.numberInputBytesProcessed());
+    QCOMPARE(encryptor.numberOutputBytesProcessed(), static_cast<unsigned long long>(expected.size()));
+
+    encryptor.close();
+    QCOMPARE(encrypted, expected);
+}
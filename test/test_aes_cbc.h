@@ -37,6 +37,22 @@ class TestAesCbc:public QObject {
 
         void testAesCbcEncryptDecryptFuzz();
 
+        void testAesCbcIVHeaderBasic();
+
+        void testAesCbcIVHeaderFile();
+
+        void testAesCbcKeyChange();
+
+        void testAesCbcSpans();
+
+        void testAesCbcRandomAccess();
+
+        void testAesCbcParallel();
+
+        void testAesCbcRekey();
+
+        void testAesCbcAsynchronous();
+
     private:
         static constexpr unsigned N = 100000;
 };
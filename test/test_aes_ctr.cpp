@@ -0,0 +1,356 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Crypto AES (CTR) encryption/decryption functions.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QBuffer>
+#include <QThreadPool>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+#include <random>
+
+#include <crypto_aes_ctr_encryptor.h>
+#include <crypto_aes_ctr_decryptor.h>
+
+#include "test_aes_ctr.h"
+
+void TestAesCtr::testAesCtrEncryptDecryptBasic() {
+    // Values below taken from NIST SP 800-38A, section F.5.5.
+
+    Crypto::AesCtrEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    std::uint8_t rawExpected[] = {
+        0x60, 0x1e, 0xc3, 0x13, 0x77, 0x57, 0x89, 0xa5, 0xb7, 0xa7, 0xf5, 0x04, 0xbb, 0xf3, 0xd2, 0x28,
+        0xf4, 0x43, 0xe3, 0xca, 0x4d, 0x62, 0xb5, 0x9a, 0xca, 0x84, 0xe9, 0x90, 0xca, 0xca, 0xf5, 0xc5,
+        0x2b, 0x09, 0x30, 0xda, 0xa2, 0x3d, 0xe9, 0x4c, 0xe8, 0x70, 0x17, 0xba, 0x2d, 0x84, 0x98, 0x8d,
+        0xdf, 0xc9, 0xc5, 0x8d, 0xb6, 0x7a, 0xad, 0xa6, 0x13, 0xc2, 0xdd, 0x08, 0x45, 0x79, 0x41, 0xa6
+    };
+
+    Crypto::AesCtrEncryptor::IV iv  = {
+        0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+    };
+
+    std::uint8_t rawInput[]  = {
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+        0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+        0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+        0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+    };
+
+    QByteArray              input(reinterpret_cast<const char*>(rawInput), sizeof(rawInput));
+    QByteArray              expected(reinterpret_cast<const char*>(rawExpected), sizeof(rawExpected));
+    Crypto::AesCtrEncryptor encryptor(keys, iv);
+    QByteArray              encrypted = encryptor.encrypt(input);
+
+    QCOMPARE(encrypted, expected);
+
+    Crypto::AesCtrDecryptor decryptor(keys, iv);
+    QByteArray decrypted = decryptor.decrypt(encrypted);
+
+    QCOMPARE(decrypted, input);
+
+    // Counter mode applies no padding so partial blocks must be encrypted to exactly their own length.
+    QByteArray partial = encryptor.encrypt(input.left(37));
+    QCOMPARE(partial, expected.left(37));
+    QCOMPARE(decryptor.decrypt(partial), input.left(37));
+}
+
+
+void TestAesCtr::testAesCtrEncryptDecryptFile() {
+    QString t1("And close your eyes with holy dread For he on honey-dew hath fed, and drunk the milk of paradise.");
+
+    Crypto::AesCtrEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    QByteArray plainText;
+    while (plainText.size() < 20000) {
+        plainText.append(t1.toUtf8());
+    }
+
+    QByteArray encrypted;
+    QBuffer    encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+    Crypto::AesCtrEncryptor encryptor(keys, &encryptedBuffer);
+    encryptor.setIVHeaderEnabled();
+
+    encryptor.open(Crypto::Encryptor::OpenModeFlag::WriteOnly);
+
+    // Write in uneven pieces so the keystream is consumed across block and batch boundaries.
+    int index  = 0;
+    int length = 1;
+    while (index < plainText.size()) {
+        encryptor.write(plainText.mid(index, length));
+        index += length;
+        length = (length * 7 + 3) % 1031;
+    }
+
+    encryptor.close();
+
+    encryptedBuffer.close();
+    QCOMPARE(encrypted.size(), static_cast<int>(plainText.size() + Crypto::AesCtrEncryptor::ivLength));
+
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesCtrDecryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    decryptor.open(Crypto::AesCtrDecryptor::OpenModeFlag::ReadOnly);
+
+    unsigned bytesAvailable = decryptor.bytesAvailable();
+    QByteArray decrypted = decryptor.read(bytesAvailable);
+
+    decryptor.close();
+
+    QCOMPARE(decrypted, plainText);
+}
+
+
+void TestAesCtr::testAesCtrEncryptDecryptFuzz() {
+    std::mt19937                    rng(0x12345678);
+    std::uniform_int_distribution<> byteDistribution(0, 255);
+
+    for (unsigned i=0 ; i<N ; ++i) {
+        Crypto::AesCtrEncryptor::Keys keys;
+        for (unsigned ki=0 ; ki<32 ; ++ki) {
+            keys[ki] = byteDistribution(rng);
+        }
+
+        Crypto::AesCtrEncryptor::IV iv;
+        for (unsigned ii=0 ; ii<16 ; ++ii) {
+            iv[ii] = byteDistribution(rng);
+        }
+
+        QByteArray plainText;
+        unsigned   length = byteDistribution(rng) * 4 + byteDistribution(rng);
+
+        for (unsigned bi=0 ; bi<length ; ++bi) {
+            plainText.append(static_cast<unsigned char>(byteDistribution(rng)));
+        }
+
+        Crypto::AesCtrEncryptor encryptor(keys, iv);
+        Crypto::AesCtrDecryptor decryptor(keys, iv);
+
+        QByteArray encrypted = encryptor.encrypt(plainText);
+        QByteArray decrypted = decryptor.decrypt(encrypted);
+
+        QCOMPARE(encrypted.size(), plainText.size());
+        QCOMPARE(decrypted, plainText);
+    }
+}
+
+
+void TestAesCtr::testAesCtrStreamOffset() {
+    Crypto::AesCtrEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    // The low counter bytes are close to wrapping so the carry into the upper bytes is exercised.
+    Crypto::AesCtrEncryptor::IV iv  = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0xff, 0xff, 0xf0
+    };
+
+    std::mt19937                    rng(0x87654321);
+    std::uniform_int_distribution<> byteDistribution(0, 255);
+
+    QByteArray plainText;
+    for (unsigned i=0 ; i<5000 ; ++i) {
+        plainText.append(static_cast<unsigned char>(byteDistribution(rng)));
+    }
+
+    Crypto::AesCtrEncryptor encryptor(keys, iv);
+    Crypto::AesCtrDecryptor decryptor(keys, iv);
+
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    unsigned offsets[] = { 0, 1, 15, 16, 17, 127, 128, 129, 255, 256, 1000, 4095, 4999 };
+    for (unsigned offset : offsets) {
+        decryptor.setStreamOffset(offset);
+        QCOMPARE(decryptor.streamOffset(), static_cast<unsigned long long>(offset));
+        QCOMPARE(decryptor.decrypt(encrypted.mid(offset)), plainText.mid(offset));
+
+        encryptor.setStreamOffset(offset);
+        QCOMPARE(encryptor.encrypt(plainText.mid(offset, 100)), encrypted.mid(offset, 100));
+    }
+}
+
+
+void TestAesCtr::testAesCtrRandomAccess() {
+    Crypto::AesCtrEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    std::mt19937                    rng(0x13572468);
+    std::uniform_int_distribution<> byteDistribution(0, 255);
+
+    QByteArray plainText;
+    for (unsigned i=0 ; i<20000 ; ++i) {
+        plainText.append(static_cast<unsigned char>(byteDistribution(rng)));
+    }
+
+    Crypto::AesCtrEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+
+    QByteArray encrypted = encryptor.encrypt(plainText);
+    QBuffer    encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesCtrDecryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    decryptor.setRandomAccessEnabled();
+    decryptor.open(Crypto::AesCtrDecryptor::OpenModeFlag::ReadOnly);
+
+    QVERIFY(!decryptor.isSequential());
+    QCOMPARE(decryptor.size(), static_cast<qint64>(plainText.size()));
+
+    qint64 positions[] = { 19000, 1, 127, 128, 129, 0, 4097, 19999 };
+    for (qint64 position : positions) {
+        QVERIFY(decryptor.seek(position));
+        QCOMPARE(decryptor.read(300), plainText.mid(static_cast<int>(position), 300));
+        QVERIFY(encryptedBuffer.pos() <= Crypto::AesCtrDecryptor::ivLength + position + 300);
+    }
+
+    QVERIFY(decryptor.seek(5));
+    QCOMPARE(decryptor.readAll(), plainText.mid(5));
+
+    decryptor.close();
+    encryptedBuffer.close();
+}
+
+
+void TestAesCtr::testAesCtrParallel() {
+    Crypto::AesCtrEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    std::mt19937                    rng(0x24681357);
+    std::uniform_int_distribution<> byteDistribution(0, 255);
+
+    // Large enough to be split into several segments, with a length that is not a multiple of the block size.
+    QByteArray plainText;
+    for (unsigned i=0 ; i<3 * 1024 * 1024 + 37 ; ++i) {
+        plainText.append(static_cast<char>(byteDistribution(rng)));
+    }
+
+    Crypto::AesCtrEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+    encryptor.setStreamOffset(1000);
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(3);
+
+    Crypto::AesCtrDecryptor decryptor(keys);
+    decryptor.setIVHeaderEnabled();
+    decryptor.setStreamOffset(1000);
+    decryptor.setThreadPool(&threadPool);
+    QVERIFY(decryptor.supportsParallelDecryption());
+
+    QCOMPARE(decryptor.decrypt(encrypted), plainText);
+
+    QByteArray  buffer     = encrypted;
+    std::size_t outputSize = decryptor.decryptInPlace(
+        reinterpret_cast<std::uint8_t*>(buffer.data()),
+        static_cast<std::size_t>(buffer.size())
+    );
+
+    QCOMPARE(outputSize, static_cast<std::size_t>(plainText.size()));
+    QCOMPARE(buffer.mid(0, plainText.size()), plainText);
+}
+
+
+void TestAesCtr::testAesCtrReadLines() {
+    Crypto::AesCtrEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    // Lines of varying length, including empty lines, with no newline after the last line.
+    QList<QByteArray> lines;
+    QByteArray        plainText;
+    for (unsigned i=0 ; i<5000 ; ++i) {
+        QByteArray line(static_cast<int>((i * 37) % 211), static_cast<char>('a' + i % 26));
+        if (i < 4999) {
+            line.append('\n');
+        }
+
+        lines.append(line);
+        plainText.append(line);
+    }
+
+    Crypto::AesCtrEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    QBuffer encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesCtrDecryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    decryptor.open(Crypto::AesCtrDecryptor::OpenModeFlag::ReadOnly);
+
+    QCOMPARE(decryptor.readLine(), lines.first());
+
+    for (int i=1 ; i<lines.size() ; ++i) {
+        QCOMPARE(decryptor.canReadLine(), i < lines.size() - 1);
+        QVERIFY(decryptor.bytesAvailable() >= static_cast<qint64>(lines.at(i).size()));
+        QCOMPARE(decryptor.readLine(), lines.at(i));
+    }
+
+    QVERIFY(!decryptor.canReadLine());
+    QCOMPARE(decryptor.bytesAvailable(), static_cast<qint64>(0));
+}
+
+
+void TestAesCtr::testAesCtrIVHeaderDefault() {
+    Crypto::AesCtrEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    QByteArray plainText("Weave a circle round him thrice, and close your eyes with holy dread.");
+
+    // Without an IV the counter must start from a new random block for every stream.
+    Crypto::AesCtrEncryptor encryptor(keys);
+    QVERIFY(encryptor.ivHeaderEnabled());
+
+    QByteArray encrypted1 = encryptor.encrypt(plainText);
+    QByteArray encrypted2 = encryptor.encrypt(plainText);
+
+    QCOMPARE(encrypted1.size(), static_cast<int>(plainText.size() + Crypto::AesCtrEncryptor::ivLength));
+    QVERIFY(encrypted1.mid(Crypto::AesCtrEncryptor::ivLength) != encrypted2.mid(Crypto::AesCtrEncryptor::ivLength));
+
+    Crypto::AesCtrDecryptor decryptor(keys);
+    QVERIFY(decryptor.ivHeaderEnabled());
+    QCOMPARE(decryptor.decrypt(encrypted1), plainText);
+    QCOMPARE(decryptor.decrypt(encrypted2), plainText);
+}
@@ -0,0 +1,432 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Crypto AES (GCM) encryption/decryption functions.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QString>
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QBuffer>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#include <crypto_aes_gcm_encryptor.h>
+#include <crypto_aes_gcm_decryptor.h>
+
+#include "test_aes_gcm.h"
+
+void TestAesGcm::testAesGcmEncryptDecryptBasic() {
+    // Values below taken from the GCM specification test cases 13, 14 and 16.
+
+    Crypto::AesGcmEncryptor::Keys zeroKeys = { 0 };
+    Crypto::AesGcmEncryptor::IV   zeroIV   = { 0 };
+
+    Crypto::AesGcmEncryptor zeroEncryptor(zeroKeys, zeroIV);
+    Crypto::AesGcmDecryptor zeroDecryptor(zeroKeys, zeroIV);
+
+    QByteArray expected13 = QByteArray::fromHex("530f8afbc74536b9a963b4f1c4cb738b");
+    QCOMPARE(zeroEncryptor.encrypt(QByteArray()), expected13);
+
+    // Test cases 13 and 14 share an IV so the IV must be supplied again before the second stream.
+    QByteArray input14(16, '\x00');
+    QByteArray expected14 = QByteArray::fromHex("cea7403d4d606b6e074ec5d3baf39d18d0d1c8a799996bf0265b98b5d48ab919");
+    QVERIFY(zeroEncryptor.encrypt(input14).isEmpty());
+
+    zeroEncryptor.setIV(zeroIV);
+    QCOMPARE(zeroEncryptor.encrypt(input14), expected14);
+    QCOMPARE(zeroDecryptor.decrypt(expected14), input14);
+
+    Crypto::AesGcmEncryptor::Keys keys = {
+        0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+        0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+    };
+
+    Crypto::AesGcmEncryptor::IV iv = {
+        0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+    };
+
+    QByteArray input = QByteArray::fromHex(
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39"
+    );
+
+    QByteArray associatedData = QByteArray::fromHex("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+
+    QByteArray expected = QByteArray::fromHex(
+        "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+        "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662"
+        "76fc6ece0f4e1768cddf8853bb2d551b"
+    );
+
+    Crypto::AesGcmEncryptor encryptor(keys, iv);
+    encryptor.setAssociatedData(associatedData);
+
+    QByteArray encrypted = encryptor.encrypt(input);
+    QCOMPARE(encrypted, expected);
+    QCOMPARE(encryptor.encryptedSize(static_cast<std::size_t>(input.size())), static_cast<std::size_t>(expected.size()));
+
+    Crypto::AesGcmDecryptor decryptor(keys, iv);
+    decryptor.setAssociatedData(associatedData);
+
+    QCOMPARE(decryptor.decrypt(encrypted), input);
+}
+
+
+void TestAesGcm::testAesGcmAuthentication() {
+    Crypto::AesGcmEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    QByteArray plainText("Weave a circle round him thrice, and close your eyes with holy dread.");
+
+    Crypto::AesGcmEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+    encryptor.setAssociatedData(QByteArray("header"));
+
+    Crypto::AesGcmDecryptor decryptor(keys);
+    decryptor.setIVHeaderEnabled();
+    decryptor.setAssociatedData(QByteArray("header"));
+
+    QByteArray encrypted = encryptor.encrypt(plainText);
+    QCOMPARE(
+        encrypted.size(),
+        static_cast<int>(plainText.size() + Crypto::AesGcmEncryptor::ivLength + Crypto::AesGcmEncryptor::tagLength)
+    );
+
+    QCOMPARE(decryptor.decrypt(encrypted), plainText);
+
+    // Any change to the IV, the data, the tag or the associated data must be rejected.
+    int positions[] = { 0, 11, 12, 40, encrypted.size() - 16, encrypted.size() - 1 };
+    for (int position : positions) {
+        QByteArray tampered = encrypted;
+        tampered[position] = static_cast<char>(tampered[position] ^ 0x01);
+
+        QVERIFY(decryptor.decrypt(tampered).isEmpty());
+    }
+
+    QVERIFY(decryptor.decrypt(encrypted.left(encrypted.size() - 1)).isEmpty());
+
+    decryptor.setAssociatedData(QByteArray("Header"));
+    QVERIFY(decryptor.decrypt(encrypted).isEmpty());
+
+    decryptor.setAssociatedData(QByteArray("header"));
+    QCOMPARE(decryptor.decrypt(encrypted), plainText);
+
+    // The in-place API must leave no plaintext behind when the tag is rejected.
+    QByteArray buffer = encrypted;
+    buffer[20] = static_cast<char>(buffer[20] ^ 0x80);
+
+    std::uint8_t* data = reinterpret_cast<std::uint8_t*>(buffer.data());
+    QCOMPARE(decryptor.decryptInPlace(data, static_cast<std::size_t>(buffer.size())), static_cast<std::size_t>(0));
+    QCOMPARE(buffer, QByteArray(encrypted.size(), '\x00'));
+}
+
+
+void TestAesGcm::testAesGcmEncryptDecryptFile() {
+    QString t1("And close your eyes with holy dread For he on honey-dew hath fed, and drunk the milk of paradise.");
+
+    Crypto::AesGcmEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    QByteArray plainText;
+    while (plainText.size() < 20000) {
+        plainText.append(t1.toUtf8());
+    }
+
+    QByteArray encrypted;
+    QBuffer    encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+    Crypto::AesGcmEncryptor encryptor(keys, &encryptedBuffer);
+    encryptor.setIVHeaderEnabled();
+
+    encryptor.open(Crypto::Encryptor::OpenModeFlag::WriteOnly);
+
+    int index  = 0;
+    int length = 1;
+    while (index < plainText.size()) {
+        encryptor.write(plainText.mid(index, length));
+        index += length;
+        length = (length * 7 + 3) % 1031;
+    }
+
+    encryptor.close();
+    encryptedBuffer.close();
+
+    QCOMPARE(
+        encrypted.size(),
+        static_cast<int>(plainText.size() + Crypto::AesGcmEncryptor::ivLength + Crypto::AesGcmEncryptor::tagLength)
+    );
+
+    Crypto::AesGcmDecryptor blockDecryptor(keys);
+    blockDecryptor.setIVHeaderEnabled();
+    QCOMPARE(blockDecryptor.decrypt(encrypted), plainText);
+
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesGcmDecryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    decryptor.open(Crypto::AesGcmDecryptor::OpenModeFlag::ReadOnly);
+
+    QCOMPARE(decryptor.bytesAvailable(), static_cast<qint64>(plainText.size()));
+
+    QByteArray decrypted = decryptor.readAll();
+    QVERIFY(decryptor.trailerVerified());
+
+    decryptor.close();
+    encryptedBuffer.close();
+
+    QCOMPARE(decrypted, plainText);
+
+    // A corrupted tag must be reported when the end of the stream is reached.
+    encrypted[encrypted.size() - 3] = static_cast<char>(encrypted[encrypted.size() - 3] ^ 0x10);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesGcmDecryptor tamperedDecryptor(keys, &encryptedBuffer);
+    tamperedDecryptor.setIVHeaderEnabled();
+    tamperedDecryptor.open(Crypto::AesGcmDecryptor::OpenModeFlag::ReadOnly);
+
+    char readBuffer[256];
+    QCOMPARE(tamperedDecryptor.read(readBuffer, sizeof(readBuffer)), static_cast<qint64>(-1));
+    QVERIFY(!tamperedDecryptor.trailerVerified());
+}
+
+
+void TestAesGcm::testAesGcmEncryptDecryptFuzz() {
+    std::mt19937                    rng(0x12345678);
+    std::uniform_int_distribution<> byteDistribution(0, 255);
+
+    for (unsigned i=0 ; i<N ; ++i) {
+        Crypto::AesGcmEncryptor::Keys keys;
+        for (unsigned ki=0 ; ki<32 ; ++ki) {
+            keys[ki] = byteDistribution(rng);
+        }
+
+        Crypto::AesGcmEncryptor::IV iv;
+        for (unsigned ii=0 ; ii<12 ; ++ii) {
+            iv[ii] = byteDistribution(rng);
+        }
+
+        QByteArray plainText;
+        unsigned   length = byteDistribution(rng) * 4 + byteDistribution(rng);
+
+        for (unsigned bi=0 ; bi<length ; ++bi) {
+            plainText.append(static_cast<unsigned char>(byteDistribution(rng)));
+        }
+
+        QByteArray associatedData;
+        unsigned   associatedDataLength = byteDistribution(rng) % 40;
+
+        for (unsigned bi=0 ; bi<associatedDataLength ; ++bi) {
+            associatedData.append(static_cast<unsigned char>(byteDistribution(rng)));
+        }
+
+        Crypto::AesGcmEncryptor encryptor(keys, iv);
+        Crypto::AesGcmDecryptor decryptor(keys, iv);
+
+        encryptor.setAssociatedData(associatedData);
+        decryptor.setAssociatedData(associatedData);
+
+        QByteArray encrypted = encryptor.encrypt(plainText);
+        QByteArray decrypted = decryptor.decrypt(encrypted);
+
+        QCOMPARE(encrypted.size(), static_cast<int>(plainText.size() + Crypto::AesGcmEncryptor::tagLength));
+        QCOMPARE(decrypted, plainText);
+    }
+}
+
+
+void TestAesGcm::testAesGcmBoundedInput() {
+    Crypto::AesGcmEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    QByteArray plainText;
+    for (unsigned i=0 ; i<1000000 ; ++i) {
+        plainText.append(static_cast<char>((i * 131) ^ (i >> 8)));
+    }
+
+    Crypto::AesGcmEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    QBuffer encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    const qint64 limit = 100000;
+
+    Crypto::AesGcmDecryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    decryptor.setMaximumBufferedInput(limit);
+    QCOMPARE(decryptor.maximumBufferedInput(), limit);
+
+    decryptor.open(Crypto::AesGcmDecryptor::OpenModeFlag::ReadOnly);
+
+    // The decryptor must never read further ahead of the consumer than the limit allows.
+    QByteArray decrypted;
+    char       readBuffer[7000];
+    qint64     bytesRead;
+    do {
+        bytesRead = decryptor.read(readBuffer, sizeof(readBuffer));
+        QVERIFY(bytesRead >= 0);
+
+        decrypted.append(readBuffer, static_cast<int>(bytesRead));
+        QVERIFY(encryptedBuffer.pos() <= Crypto::AesGcmEncryptor::ivLength + decrypted.size() + limit);
+    } while (bytesRead > 0);
+
+    QVERIFY(decryptor.trailerVerified());
+    QCOMPARE(decrypted, plainText);
+
+    decryptor.close();
+    encryptedBuffer.close();
+
+    // A corrupted tag must still be caught when data is decrypted ahead of the reader.
+    encrypted[encrypted.size() - 1] = static_cast<char>(encrypted[encrypted.size() - 1] ^ 0x01);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesGcmDecryptor tamperedDecryptor(keys, &encryptedBuffer);
+    tamperedDecryptor.setIVHeaderEnabled();
+    tamperedDecryptor.setMaximumBufferedInput(limit);
+    tamperedDecryptor.open(Crypto::AesGcmDecryptor::OpenModeFlag::ReadOnly);
+
+    do {
+        bytesRead = tamperedDecryptor.read(readBuffer, sizeof(readBuffer));
+    } while (bytesRead > 0);
+
+    QCOMPARE(bytesRead, static_cast<qint64>(-1));
+    QVERIFY(!tamperedDecryptor.trailerVerified());
+}
+
+
+void TestAesGcm::testAesGcmScatterGather() {
+    Crypto::AesGcmEncryptor::Keys keys;
+    std::mt19937                  rng(0x5CA77E12);
+
+    for (unsigned i=0 ; i<sizeof(keys) ; ++i) {
+        keys[i] = static_cast<std::uint8_t>(rng());
+    }
+
+    Crypto::AesGcmEncryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+    encryptor.setAssociatedData(QByteArray("header"));
+
+    Crypto::AesGcmDecryptor decryptor(keys);
+    decryptor.setIVHeaderEnabled();
+    decryptor.setAssociatedData(QByteArray("header"));
+
+    for (unsigned iteration=0 ; iteration<200 ; ++iteration) {
+        // Split the message into pieces of random length, including empty pieces, so chunks, the IV header and the
+        // tag all straddle piece boundaries.
+        QByteArray     message;
+        QByteArrayList pieces;
+        unsigned       numberPieces = 1 + rng() % 6;
+        for (unsigned piece=0 ; piece<numberPieces ; ++piece) {
+            QByteArray pieceData(static_cast<int>(rng() % 70), '\x00');
+            for (int j=0 ; j<pieceData.size() ; ++j) {
+                pieceData[j] = static_cast<char>(rng());
+            }
+
+            pieces << pieceData;
+            message += pieceData;
+        }
+
+        QByteArray encrypted = encryptor.encrypt(pieces);
+        QCOMPARE(encrypted.size(), static_cast<int>(encryptor.encryptedSize(static_cast<std::size_t>(message.size()))));
+        QCOMPARE(decryptor.decrypt(encrypted), message);
+
+        QByteArrayList encryptedPieces;
+        int            offset = 0;
+        while (offset < encrypted.size()) {
+            int pieceLength = std::min(static_cast<int>(rng() % 40), encrypted.size() - offset);
+            encryptedPieces << encrypted.mid(offset, pieceLength);
+            offset += pieceLength;
+        }
+
+        QCOMPARE(decryptor.decrypt(encryptedPieces), message);
+
+        QByteArray tampered = encryptedPieces.last();
+        tampered[tampered.size() - 1] = static_cast<char>(tampered[tampered.size() - 1] ^ 0x01);
+        encryptedPieces.last() = tampered;
+
+        QVERIFY(decryptor.decrypt(encryptedPieces).isEmpty());
+    }
+}
+
+
+void TestAesGcm::testAesGcmNonceReuse() {
+    Crypto::AesGcmEncryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    QByteArray plainText("Weave a circle round him thrice, and close your eyes with holy dread.");
+
+    // The IV header is enabled by default so every stream must get a new IV.
+    Crypto::AesGcmEncryptor encryptor(keys);
+    QVERIFY(encryptor.ivHeaderEnabled());
+
+    QByteArray encrypted1 = encryptor.encrypt(plainText);
+    QByteArray encrypted2 = encryptor.encrypt(plainText);
+
+    QCOMPARE(
+        encrypted1.size(),
+        static_cast<int>(plainText.size() + Crypto::AesGcmEncryptor::ivLength + Crypto::AesGcmEncryptor::tagLength)
+    );
+    QVERIFY(encrypted1.left(Crypto::AesGcmEncryptor::ivLength) != encrypted2.left(Crypto::AesGcmEncryptor::ivLength));
+    QVERIFY(encrypted1.mid(Crypto::AesGcmEncryptor::ivLength) != encrypted2.mid(Crypto::AesGcmEncryptor::ivLength));
+
+    Crypto::AesGcmDecryptor decryptor(keys);
+    QVERIFY(decryptor.ivHeaderEnabled());
+    QCOMPARE(decryptor.decrypt(encrypted1), plainText);
+    QCOMPARE(decryptor.decrypt(encrypted2), plainText);
+
+    // An IV supplied by the caller can only be used for one stream.
+    Crypto::AesGcmEncryptor::IV iv = {
+        0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+    };
+
+    Crypto::AesGcmEncryptor fixedEncryptor(keys, iv);
+    QVERIFY(!fixedEncryptor.ivHeaderEnabled());
+
+    QByteArray first = fixedEncryptor.encrypt(plainText);
+    QCOMPARE(first.size(), static_cast<int>(plainText.size() + Crypto::AesGcmEncryptor::tagLength));
+
+    QVERIFY(fixedEncryptor.encrypt(plainText).isEmpty());
+    QVERIFY(!fixedEncryptor.open(Crypto::Encryptor::OpenModeFlag::WriteOnly));
+
+    iv[11] = 0x89;
+    fixedEncryptor.setIV(iv);
+
+    QByteArray second = fixedEncryptor.encrypt(plainText);
+    QCOMPARE(second.size(), first.size());
+    QVERIFY(second != first);
+
+    Crypto::AesGcmDecryptor fixedDecryptor(keys, iv);
+    QCOMPARE(fixedDecryptor.decrypt(second), plainText);
+}
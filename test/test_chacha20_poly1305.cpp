@@ -0,0 +1,329 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Crypto ChaCha20-Poly1305 encryption/decryption functions.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QString>
+#include <QByteArray>
+#include <QBuffer>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#include <crypto_chacha20_poly1305_encryptor.h>
+#include <crypto_chacha20_poly1305_decryptor.h>
+#include <crypto_poly1305.h>
+
+#include "test_chacha20_poly1305.h"
+
+void TestChaCha20Poly1305::testPoly1305() {
+    // Values below taken from RFC 8439 section 2.5.2.
+
+    QByteArray key     = QByteArray::fromHex("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+    QByteArray message = QByteArray("Cryptographic Forum Research Group");
+    QByteArray tag     = QByteArray::fromHex("a8061dc1305136c6c22b8baf0c0127a9");
+
+    QCOMPARE(Crypto::Poly1305(key, message).digest(), tag);
+
+    // Feeding the message in pieces must give the same result.
+    Crypto::Poly1305 poly1305(key);
+    for (int i=0 ; i<message.size() ; i+=5) {
+        poly1305.addData(message.mid(i, 5));
+    }
+
+    QCOMPARE(poly1305.digest(), tag);
+
+    poly1305.reset(key);
+    QCOMPARE(poly1305.digest(), QByteArray::fromHex("0103808afb0db2fd4abff6af4149f51b"));
+}
+
+
+void TestChaCha20Poly1305::testChaCha20Poly1305EncryptDecryptBasic() {
+    // Values below taken from RFC 8439 section 2.8.2.
+
+    Crypto::ChaCha20Poly1305Encryptor::Keys keys;
+    for (unsigned i=0 ; i<Crypto::ChaCha20Poly1305Encryptor::keyLength ; ++i) {
+        keys[i] = static_cast<std::uint8_t>(0x80 + i);
+    }
+
+    Crypto::ChaCha20Poly1305Encryptor::IV iv = {
+        0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47
+    };
+
+    QByteArray input(
+        "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would "
+        "be it."
+    );
+
+    QByteArray associatedData = QByteArray::fromHex("50515253c0c1c2c3c4c5c6c7");
+
+    QByteArray expected = QByteArray::fromHex(
+        "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+        "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+        "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+        "3ff4def08e4b7a9de576d26586cec64b6116"
+        "1ae10b594f09e26a7e902ecbd0600691"
+    );
+
+    Crypto::ChaCha20Poly1305Encryptor encryptor(keys, iv);
+    encryptor.setAssociatedData(associatedData);
+
+    QByteArray encrypted = encryptor.encrypt(input);
+    QCOMPARE(encrypted, expected);
+    QCOMPARE(
+        encryptor.encryptedSize(static_cast<std::size_t>(input.size())),
+        static_cast<std::size_t>(expected.size())
+    );
+
+    Crypto::ChaCha20Poly1305Decryptor decryptor(keys, iv);
+    decryptor.setAssociatedData(associatedData);
+
+    QCOMPARE(decryptor.decrypt(encrypted), input);
+}
+
+
+void TestChaCha20Poly1305::testChaCha20Poly1305Authentication() {
+    Crypto::ChaCha20Poly1305Encryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    QByteArray plainText("Weave a circle round him thrice, and close your eyes with holy dread.");
+
+    Crypto::ChaCha20Poly1305Encryptor encryptor(keys);
+    encryptor.setIVHeaderEnabled();
+    encryptor.setAssociatedData(QByteArray("header"));
+
+    Crypto::ChaCha20Poly1305Decryptor decryptor(keys);
+    decryptor.setIVHeaderEnabled();
+    decryptor.setAssociatedData(QByteArray("header"));
+
+    QByteArray encrypted = encryptor.encrypt(plainText);
+    QCOMPARE(
+        encrypted.size(),
+        static_cast<int>(
+              plainText.size()
+            + Crypto::ChaCha20Poly1305Encryptor::ivLength
+            + Crypto::ChaCha20Poly1305Encryptor::tagLength
+        )
+    );
+
+    QCOMPARE(decryptor.decrypt(encrypted), plainText);
+
+    // Any change to the IV, the data, the tag or the associated data must be rejected.
+    int positions[] = { 0, 11, 12, 40, encrypted.size() - 16, encrypted.size() - 1 };
+    for (int position : positions) {
+        QByteArray tampered = encrypted;
+        tampered[position] = static_cast<char>(tampered[position] ^ 0x01);
+
+        QVERIFY(decryptor.decrypt(tampered).isEmpty());
+    }
+
+    QVERIFY(decryptor.decrypt(encrypted.left(encrypted.size() - 1)).isEmpty());
+
+    decryptor.setAssociatedData(QByteArray("Header"));
+    QVERIFY(decryptor.decrypt(encrypted).isEmpty());
+
+    decryptor.setAssociatedData(QByteArray("header"));
+    QCOMPARE(decryptor.decrypt(encrypted), plainText);
+
+    // The in-place API must leave no plaintext behind when the tag is rejected.
+    QByteArray buffer = encrypted;
+    buffer[20] = static_cast<char>(buffer[20] ^ 0x80);
+
+    std::uint8_t* data = reinterpret_cast<std::uint8_t*>(buffer.data());
+    QCOMPARE(decryptor.decryptInPlace(data, static_cast<std::size_t>(buffer.size())), static_cast<std::size_t>(0));
+    QCOMPARE(buffer, QByteArray(encrypted.size(), '\x00'));
+}
+
+
+void TestChaCha20Poly1305::testChaCha20Poly1305EncryptDecryptFile() {
+    QString t1("And close your eyes with holy dread For he on honey-dew hath fed, and drunk the milk of paradise.");
+
+    Crypto::ChaCha20Poly1305Encryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    QByteArray plainText;
+    while (plainText.size() < 20000) {
+        plainText.append(t1.toUtf8());
+    }
+
+    QByteArray encrypted;
+    QBuffer    encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+    Crypto::ChaCha20Poly1305Encryptor encryptor(keys, &encryptedBuffer);
+    encryptor.setIVHeaderEnabled();
+
+    encryptor.open(Crypto::Encryptor::OpenModeFlag::WriteOnly);
+
+    int index  = 0;
+    int length = 1;
+    while (index < plainText.size()) {
+        encryptor.write(plainText.mid(index, length));
+        index += length;
+        length = (length * 7 + 3) % 1031;
+    }
+
+    encryptor.close();
+    encryptedBuffer.close();
+
+    QCOMPARE(
+        encrypted.size(),
+        static_cast<int>(
+              plainText.size()
+            + Crypto::ChaCha20Poly1305Encryptor::ivLength
+            + Crypto::ChaCha20Poly1305Encryptor::tagLength
+        )
+    );
+
+    Crypto::ChaCha20Poly1305Decryptor blockDecryptor(keys);
+    blockDecryptor.setIVHeaderEnabled();
+    QCOMPARE(blockDecryptor.decrypt(encrypted), plainText);
+
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::ChaCha20Poly1305Decryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    decryptor.open(Crypto::ChaCha20Poly1305Decryptor::OpenModeFlag::ReadOnly);
+
+    QCOMPARE(decryptor.bytesAvailable(), static_cast<qint64>(plainText.size()));
+
+    QByteArray decrypted = decryptor.readAll();
+    QVERIFY(decryptor.trailerVerified());
+
+    decryptor.close();
+    encryptedBuffer.close();
+
+    QCOMPARE(decrypted, plainText);
+
+    // A corrupted tag must be reported when the end of the stream is reached.
+    encrypted[encrypted.size() - 3] = static_cast<char>(encrypted[encrypted.size() - 3] ^ 0x10);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::ChaCha20Poly1305Decryptor tamperedDecryptor(keys, &encryptedBuffer);
+    tamperedDecryptor.setIVHeaderEnabled();
+    tamperedDecryptor.open(Crypto::ChaCha20Poly1305Decryptor::OpenModeFlag::ReadOnly);
+
+    char readBuffer[256];
+    QCOMPARE(tamperedDecryptor.read(readBuffer, sizeof(readBuffer)), static_cast<qint64>(-1));
+    QVERIFY(!tamperedDecryptor.trailerVerified());
+}
+
+
+void TestChaCha20Poly1305::testChaCha20Poly1305EncryptDecryptFuzz() {
+    std::mt19937                    rng(0x12345678);
+    std::uniform_int_distribution<> byteDistribution(0, 255);
+
+    for (unsigned i=0 ; i<N ; ++i) {
+        Crypto::ChaCha20Poly1305Encryptor::Keys keys;
+        for (unsigned ki=0 ; ki<32 ; ++ki) {
+            keys[ki] = byteDistribution(rng);
+        }
+
+        Crypto::ChaCha20Poly1305Encryptor::IV iv;
+        for (unsigned ii=0 ; ii<12 ; ++ii) {
+            iv[ii] = byteDistribution(rng);
+        }
+
+        QByteArray plainText;
+        unsigned   length = byteDistribution(rng) * 4 + byteDistribution(rng);
+
+        for (unsigned bi=0 ; bi<length ; ++bi) {
+            plainText.append(static_cast<unsigned char>(byteDistribution(rng)));
+        }
+
+        QByteArray associatedData;
+        unsigned   associatedDataLength = byteDistribution(rng) % 40;
+
+        for (unsigned bi=0 ; bi<associatedDataLength ; ++bi) {
+            associatedData.append(static_cast<unsigned char>(byteDistribution(rng)));
+        }
+
+        Crypto::ChaCha20Poly1305Encryptor encryptor(keys, iv);
+        Crypto::ChaCha20Poly1305Decryptor decryptor(keys, iv);
+
+        encryptor.setAssociatedData(associatedData);
+        decryptor.setAssociatedData(associatedData);
+
+        QByteArray encrypted = encryptor.encrypt(plainText);
+        QByteArray decrypted = decryptor.decrypt(encrypted);
+
+        QCOMPARE(encrypted.size(), static_cast<int>(plainText.size() + Crypto::ChaCha20Poly1305Encryptor::tagLength));
+        QCOMPARE(decrypted, plainText);
+    }
+}
+
+
+void TestChaCha20Poly1305::testChaCha20Poly1305NonceReuse() {
+    Crypto::ChaCha20Poly1305Encryptor::Keys keys = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+
+    QByteArray plainText("Weave a circle round him thrice, and close your eyes with holy dread.");
+    int        ivLength  = static_cast<int>(Crypto::ChaCha20Poly1305Encryptor::ivLength);
+    int        tagLength = static_cast<int>(Crypto::ChaCha20Poly1305Encryptor::tagLength);
+
+    // The IV header is enabled by default so every stream must get a new nonce.
+    Crypto::ChaCha20Poly1305Encryptor encryptor(keys);
+    QVERIFY(encryptor.ivHeaderEnabled());
+
+    QByteArray encrypted1 = encryptor.encrypt(plainText);
+    QByteArray encrypted2 = encryptor.encrypt(plainText);
+
+    QCOMPARE(encrypted1.size(), plainText.size() + ivLength + tagLength);
+    QVERIFY(encrypted1.left(ivLength) != encrypted2.left(ivLength));
+    QVERIFY(encrypted1.mid(ivLength) != encrypted2.mid(ivLength));
+
+    Crypto::ChaCha20Poly1305Decryptor decryptor(keys);
+    QVERIFY(decryptor.ivHeaderEnabled());
+    QCOMPARE(decryptor.decrypt(encrypted1), plainText);
+    QCOMPARE(decryptor.decrypt(encrypted2), plainText);
+
+    // A nonce supplied by the caller can only be used for one stream.
+    Crypto::ChaCha20Poly1305Encryptor::IV iv = {
+        0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47
+    };
+
+    Crypto::ChaCha20Poly1305Encryptor fixedEncryptor(keys, iv);
+    QVERIFY(!fixedEncryptor.ivHeaderEnabled());
+
+    QByteArray first = fixedEncryptor.encrypt(plainText);
+    QCOMPARE(first.size(), plainText.size() + tagLength);
+
+    QVERIFY(fixedEncryptor.encrypt(plainText).isEmpty());
+    QVERIFY(!fixedEncryptor.open(Crypto::Encryptor::OpenModeFlag::WriteOnly));
+
+    iv[0] = 0x08;
+    fixedEncryptor.setIV(iv);
+
+    QByteArray second = fixedEncryptor.encrypt(plainText);
+    QCOMPARE(second.size(), first.size());
+    QVERIFY(second != first);
+
+    Crypto::ChaCha20Poly1305Decryptor fixedDecryptor(keys, iv);
+    QCOMPARE(fixedDecryptor.decrypt(second), plainText);
+}
@@ -0,0 +1,190 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Crypto::Compressor and Crypto::Decompressor classes.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QString>
+#include <QByteArray>
+#include <QBuffer>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+
+#include <crypto_compressor.h>
+#include <crypto_decompressor.h>
+#include <crypto_aes_gcm_encryptor.h>
+#include <crypto_aes_gcm_decryptor.h>
+#include <crypto_helpers.h>
+
+#include "test_compression.h"
+
+static QByteArray generateText(unsigned length) {
+    static const QString words[] = {
+        "cipher ", "block ", "stream ", "segment ", "key ", "nonce ", "tag ", "record ", "index ", "device "
+    };
+
+    QByteArray result;
+    unsigned   wordIndex = 1;
+    while (static_cast<unsigned>(result.size()) < length) {
+        result.append(words[wordIndex % 10].toUtf8());
+        wordIndex = (wordIndex * 7 + 3) % 1009;
+    }
+
+    return result.left(length);
+}
+
+
+void TestCompression::testBlockRoundTrip() {
+    static const unsigned lengths[]    = { 0, 1, 100, 4095, 4096, 4097, 50000 };
+    static const unsigned blockSizes[] = { 1, 512, 4096, Crypto::Compressor::defaultBlockSize };
+
+    Crypto::Decompressor decompressor;
+
+    for (unsigned blockSize : blockSizes) {
+        Crypto::Compressor compressor;
+        compressor.setBlockSize(blockSize);
+
+        for (unsigned length : lengths) {
+            QByteArray text       = generateText(length);
+            QByteArray compressed = compressor.compress(text);
+            QCOMPARE(decompressor.decompress(compressed), text);
+
+            if (blockSize >= 512 && length >= 4096) {
+                QVERIFY(static_cast<unsigned>(compressed.size()) < length / 2);
+            }
+
+            // Random data is stored so it grows by no more than the block headers.
+            QByteArray random           = Crypto::generateRandomArray(length);
+            QByteArray compressedRandom = compressor.compress(random);
+            unsigned   numberBlocks     = (length + blockSize - 1) / blockSize;
+
+            QCOMPARE(
+                static_cast<unsigned>(compressedRandom.size()),
+                length + numberBlocks * Crypto::Compressor::blockHeaderLength
+            );
+            QCOMPARE(decompressor.decompress(compressedRandom), random);
+        }
+    }
+}
+
+
+void TestCompression::testEncryptedChain() {
+    Crypto::AesGcmEncryptor::Keys keys = {
+        0x60, 0x3D, 0xEB, 0x10, 0x15, 0xCA, 0x71, 0xBE, 0x2B, 0x73, 0xAE, 0xF0, 0x85, 0x7D, 0x77, 0x81,
+        0x1F, 0x35, 0x2C, 0x07, 0x3B, 0x61, 0x08, 0xD7, 0x2D, 0x98, 0x10, 0xA3, 0x09, 0x14, 0xDF, 0xF4
+    };
+
+    QByteArray plainText = generateText(300000);
+
+    QByteArray encrypted;
+    QBuffer    encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+    Crypto::AesGcmEncryptor encryptor(keys, &encryptedBuffer);
+    encryptor.setIVHeaderEnabled();
+    QVERIFY(encryptor.open(Crypto::AesGcmEncryptor::OpenModeFlag::WriteOnly));
+
+    Crypto::Compressor compressor(&encryptor);
+    compressor.setBlockSize(16 * 1024);
+    QVERIFY(compressor.open(Crypto::Compressor::OpenModeFlag::WriteOnly));
+
+    int index  = 0;
+    int length = 1;
+    while (index < plainText.size()) {
+        QByteArray piece = plainText.mid(index, length);
+        QCOMPARE(compressor.write(piece), static_cast<qint64>(piece.size()));
+        index += length;
+        length = (length * 7 + 3) % 4099;
+    }
+
+    compressor.close();
+    encryptor.close();
+    encryptedBuffer.close();
+
+    QVERIFY(encrypted.size() < plainText.size() / 2);
+
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::AesGcmDecryptor decryptor(keys, &encryptedBuffer);
+    decryptor.setIVHeaderEnabled();
+    QVERIFY(decryptor.open(Crypto::AesGcmDecryptor::OpenModeFlag::ReadOnly));
+
+    Crypto::Decompressor decompressor(&decryptor);
+    QVERIFY(decompressor.open(Crypto::Decompressor::OpenModeFlag::ReadOnly));
+
+    QByteArray decompressed;
+    QByteArray piece;
+    length = 1;
+    do {
+        piece = decompressor.read(length);
+        decompressed.append(piece);
+        length = (length * 5 + 1) % 7001;
+    } while (!piece.isEmpty());
+
+    decompressor.close();
+    decryptor.close();
+    encryptedBuffer.close();
+
+    QCOMPARE(decompressed, plainText);
+}
+
+
+void TestCompression::testInvalid() {
+    QByteArray text = generateText(20000);
+
+    Crypto::Compressor compressor;
+    compressor.setBlockSize(4096);
+    QByteArray compressed = compressor.compress(text);
+
+    Crypto::Decompressor decompressor;
+    QCOMPARE(decompressor.decompress(compressed), text);
+
+    // Truncated streams.
+    for (int length=1 ; length<compressed.size() ; length+=97) {
+        QVERIFY(decompressor.decompress(compressed.left(length)).isEmpty());
+    }
+
+    // A damaged zlib stream.
+    QByteArray damaged = compressed;
+    damaged[20] = static_cast<char>(damaged.at(20) ^ 0x40);
+    QVERIFY(decompressor.decompress(damaged).isEmpty());
+
+    // A block claiming a larger decompressed size than the limit allows.
+    decompressor.setBlockSizeLimit(2048);
+    QVERIFY(decompressor.decompress(compressed).isEmpty());
+
+    decompressor.setBlockSizeLimit(4096);
+    QCOMPARE(decompressor.decompress(compressed), text);
+
+    // Streaming reads report the error.
+    QBuffer damagedBuffer(&damaged);
+    damagedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::Decompressor streamDecompressor(&damagedBuffer);
+    QVERIFY(streamDecompressor.open(Crypto::Decompressor::OpenModeFlag::ReadOnly));
+
+    char buffer[100];
+    QCOMPARE(streamDecompressor.read(buffer, sizeof(buffer)), qint64(-1));
+    QVERIFY(!streamDecompressor.errorString().isEmpty());
+
+    streamDecompressor.close();
+    damagedBuffer.close();
+}
@@ -0,0 +1,221 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Qt-free core library functions.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+#include <cstring>
+
+#include <crypto_sha256.h>
+#include <crypto_hmac_sha256.h>
+#include <crypto_hmac.h>
+#include <crypto_aes.h>
+#include <crypto_aes_cbc_encryptor.h>
+#include <crypto_aes_ctr_encryptor.h>
+#include <crypto_crc.h>
+#include <crypto_crc_generator.h>
+#include <crypto_trng.h>
+#include <crypto_helpers.h>
+
+#include "test_core.h"
+
+static inline const std::uint8_t* bytes(const QByteArray& array) {
+    return reinterpret_cast<const std::uint8_t*>(array.constData());
+}
+
+
+void TestCore::testSha256() {
+    for (unsigned length=0 ; length<300 ; length+=7) {
+        QByteArray message  = Crypto::generateRandomArray(length);
+        QByteArray expected = QCryptographicHash::hash(message, QCryptographicHash::Sha256);
+
+        QByteArray digest(Crypto::Sha256::digestSize, '\x00');
+        Crypto::Sha256::hash(bytes(message), length, reinterpret_cast<std::uint8_t*>(digest.data()));
+        QCOMPARE(digest, expected);
+
+        // Feed the same message in uneven pieces.
+        Crypto::Sha256 sha;
+        unsigned       offset = 0;
+        unsigned       piece  = 1;
+        while (offset < length) {
+            unsigned bytesThisPass = qMin(piece, length - offset);
+            sha.addData(bytes(message) + offset, bytesThisPass);
+
+            offset += bytesThisPass;
+            piece  += 13;
+        }
+
+        QByteArray pieceDigest(Crypto::Sha256::digestSize, '\x00');
+        sha.result(reinterpret_cast<std::uint8_t*>(pieceDigest.data()));
+        QCOMPARE(pieceDigest, expected);
+    }
+}
+
+
+void TestCore::testHmacSha256() {
+    for (unsigned keyLength=1 ; keyLength<=Crypto::HmacSha256::blockSize ; keyLength+=9) {
+        QByteArray key     = Crypto::generateRandomArray(keyLength);
+        QByteArray message = Crypto::generateRandomArray(keyLength * 3);
+
+        QByteArray expected = Crypto::Hmac(key, message).digest();
+
+        QByteArray digest(Crypto::HmacSha256::digestSize, '\x00');
+        Crypto::HmacSha256::hmac(
+            bytes(key),
+            keyLength,
+            bytes(message),
+            message.size(),
+            reinterpret_cast<std::uint8_t*>(digest.data())
+        );
+
+        QCOMPARE(digest, expected);
+
+        // A keyed instance can be reused for several messages.
+        Crypto::HmacSha256 hmac(bytes(key), keyLength);
+        hmac.addData(bytes(key), keyLength);
+        hmac.reset();
+        hmac.addData(bytes(message), message.size());
+
+        QByteArray reusedDigest(Crypto::HmacSha256::digestSize, '\x00');
+        hmac.result(reinterpret_cast<std::uint8_t*>(reusedDigest.data()));
+        QCOMPARE(reusedDigest, expected);
+    }
+
+    // RFC 4231, test case 6, uses a key longer than the block size.
+    QByteArray longKey(131, '\xAA');
+    QByteArray longKeyMessage("Test Using Larger Than Block-Size Key - Hash Key First");
+    QByteArray longKeyExpected = QByteArray::fromHex(
+        "60E431591EE0B67F0D8A26AACBF5B77F8E0BC6213728C5140546040F0EE37F54"
+    );
+
+    QByteArray longKeyDigest(Crypto::HmacSha256::digestSize, '\x00');
+    Crypto::HmacSha256::hmac(
+        bytes(longKey),
+        longKey.size(),
+        bytes(longKeyMessage),
+        longKeyMessage.size(),
+        reinterpret_cast<std::uint8_t*>(longKeyDigest.data())
+    );
+
+    QCOMPARE(longKeyDigest, longKeyExpected);
+}
+
+
+void TestCore::testAes() {
+    Crypto::AesCbcEncryptor::Keys keys;
+    Crypto::AesCbcEncryptor::IV   iv;
+
+    QByteArray keyArray = Crypto::generateRandomArray(Crypto::aesKeyLength);
+    QByteArray ivArray  = Crypto::generateRandomArray(Crypto::aesBlockLength);
+    std::memcpy(keys, keyArray.constData(), Crypto::aesKeyLength);
+    std::memcpy(iv, ivArray.constData(), Crypto::aesBlockLength);
+
+    for (unsigned length=0 ; length<200 ; length+=11) {
+        QByteArray plainText = Crypto::generateRandomArray(length);
+
+        Crypto::AesCbcEncryptor cbcEncryptor(keys, iv);
+        cbcEncryptor.setIVHeaderEnabled(false);
+        QByteArray expectedCbc = cbcEncryptor.encrypt(plainText);
+
+        QByteArray cipherText(static_cast<int>(Crypto::aesCbcEncryptedSize(length)), '\x00');
+        std::size_t encryptedLength = Crypto::aesCbcEncrypt(
+            keys,
+            iv,
+            bytes(plainText),
+            length,
+            reinterpret_cast<std::uint8_t*>(cipherText.data()),
+            cipherText.size()
+        );
+
+        QCOMPARE(encryptedLength, static_cast<std::size_t>(cipherText.size()));
+        QCOMPARE(cipherText, expectedCbc);
+
+        QByteArray decrypted(cipherText.size(), '\x00');
+        std::size_t decryptedLength = Crypto::aesCbcDecrypt(
+            keys,
+            iv,
+            bytes(cipherText),
+            cipherText.size(),
+            reinterpret_cast<std::uint8_t*>(decrypted.data()),
+            decrypted.size()
+        );
+
+        QCOMPARE(decryptedLength, static_cast<std::size_t>(cipherText.size()));
+        QCOMPARE(decrypted.left(length), plainText);
+
+        Crypto::AesCtrEncryptor ctrEncryptor(keys, iv);
+        ctrEncryptor.setIVHeaderEnabled(false);
+        QByteArray expectedCtr = ctrEncryptor.encrypt(plainText);
+
+        QByteArray ctrText(length, '\x00');
+        Crypto::aesCtrApply(
+            keys,
+            iv,
+            0,
+            bytes(plainText),
+            reinterpret_cast<std::uint8_t*>(ctrText.data()),
+            length
+        );
+
+        QCOMPARE(ctrText, expectedCtr);
+    }
+
+    QByteArray tooSmall(Crypto::aesBlockLength, '\x00');
+    std::size_t rejectedLength = Crypto::aesCbcEncrypt(
+        keys,
+        iv,
+        bytes(tooSmall),
+        tooSmall.size() + 1,
+        reinterpret_cast<std::uint8_t*>(tooSmall.data()),
+        tooSmall.size()
+    );
+
+    QCOMPARE(rejectedLength, static_cast<std::size_t>(0));
+}
+
+
+void TestCore::testCrc() {
+    for (unsigned length=0 ; length<100 ; length+=5) {
+        QByteArray message = Crypto::generateRandomArray(length);
+
+        std::uint32_t expected = Crypto::systematicCrc<quint32, 0x104C11DB7ULL>(message);
+        std::uint32_t measured = Crypto::systematicCrc<std::uint32_t, 0x104C11DB7ULL>(bytes(message), length);
+
+        QCOMPARE(measured, expected);
+    }
+}
+
+
+void TestCore::testRandomBytes() {
+    std::uint8_t buffer[64];
+    std::uint8_t other[64];
+
+    std::memset(buffer, 0, sizeof(buffer));
+    std::memset(other, 0, sizeof(other));
+
+    QVERIFY(Crypto::randomBytes(buffer, sizeof(buffer)));
+    QVERIFY(Crypto::randomBytes(other, sizeof(other)));
+    QVERIFY(std::memcmp(buffer, other, sizeof(buffer)) != 0);
+}
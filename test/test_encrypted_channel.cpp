@@ -0,0 +1,255 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Crypto::EncryptedChannel class.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QString>
+#include <QByteArray>
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+#include <cstring>
+
+#include <crypto_encrypted_channel.h>
+
+#include "test_encrypted_channel.h"
+
+static const Crypto::EncryptedChannel::Keys clientKeys = {
+    0x60, 0x3D, 0xEB, 0x10, 0x15, 0xCA, 0x71, 0xBE, 0x2B, 0x73, 0xAE, 0xF0, 0x85, 0x7D, 0x77, 0x81,
+    0x1F, 0x35, 0x2C, 0x07, 0x3B, 0x61, 0x08, 0xD7, 0x2D, 0x98, 0x10, 0xA3, 0x09, 0x14, 0xDF, 0xF4
+};
+
+static const Crypto::EncryptedChannel::Keys serverKeys = {
+    0x8E, 0x73, 0xB0, 0xF7, 0xDA, 0x0E, 0x64, 0x52, 0xC8, 0x10, 0xF3, 0x2B, 0x80, 0x90, 0x79, 0xE5,
+    0x62, 0xF8, 0xEA, 0xD2, 0x52, 0x2C, 0x6B, 0x7B, 0xA3, 0x5F, 0x44, 0x8C, 0x1E, 0x92, 0x1D, 0x0D
+};
+
+static QByteArray generateData(unsigned length, unsigned seed) {
+    QByteArray result(static_cast<int>(length), '\x00');
+    std::uint32_t state = seed * 2654435761UL + 1;
+    for (unsigned i=0 ; i<length ; ++i) {
+        state     = state * 1664525UL + 1013904223UL;
+        result[i] = static_cast<char>(state >> 24);
+    }
+
+    return result;
+}
+
+
+static bool receive(Crypto::EncryptedChannel& channel, qint64 length, QByteArray& data) {
+    bool ok = true;
+    while (ok && channel.bytesAvailable() < length) {
+        ok = channel.waitForReadyRead(5000);
+    }
+
+    data = channel.read(length);
+    return ok && data.size() == length;
+}
+
+
+void TestEncryptedChannel::testLocalSocket() {
+    static const unsigned lengths[]     = { 1, 100, 4096, 16384, 16385, 50000 };
+    static const unsigned recordSizes[] = { 100, 1000, Crypto::EncryptedChannel::defaultRecordSize };
+
+    QString serverName = QString("inecrypto_test_%1").arg(QCoreApplication::applicationPid());
+
+    QLocalServer server;
+    QVERIFY(server.listen(serverName));
+
+    for (unsigned recordSize : recordSizes) {
+        QLocalSocket clientSocket;
+        clientSocket.connectToServer(serverName);
+        QVERIFY(clientSocket.waitForConnected(5000));
+        QVERIFY(server.waitForNewConnection(5000));
+
+        QLocalSocket* serverSocket = server.nextPendingConnection();
+        QVERIFY(serverSocket != Q_NULLPTR);
+
+        Crypto::EncryptedChannel clientChannel(clientKeys, serverKeys, &clientSocket);
+        Crypto::EncryptedChannel serverChannel(serverKeys, clientKeys, serverSocket);
+        clientChannel.setRecordSize(recordSize);
+
+        QVERIFY(clientChannel.open(QIODevice::ReadWrite));
+        QVERIFY(serverChannel.open(QIODevice::ReadWrite));
+
+        for (unsigned length : lengths) {
+            QByteArray request = generateData(length, recordSize + length);
+            QCOMPARE(clientChannel.write(request), static_cast<qint64>(length));
+            QVERIFY(clientChannel.waitForBytesWritten(5000));
+
+            QByteArray received;
+            QVERIFY(receive(serverChannel, length, received));
+            QCOMPARE(received, request);
+
+            // Several replies are sent before the client reads any of them.
+            QByteArray reply   = generateData(length, length);
+            QByteArray trailer = generateData(10, 0);
+            QCOMPARE(serverChannel.write(reply), static_cast<qint64>(length));
+            QCOMPARE(serverChannel.write(trailer), qint64(10));
+            QVERIFY(serverChannel.waitForBytesWritten(5000));
+
+            QVERIFY(receive(clientChannel, length + 10, received));
+            QCOMPARE(received, reply + trailer);
+            QCOMPARE(clientChannel.bytesAvailable(), qint64(0));
+        }
+
+        clientChannel.close();
+        serverChannel.close();
+
+        QVERIFY(clientSocket.isOpen());
+        delete serverSocket;
+    }
+}
+
+
+void TestEncryptedChannel::testBatching() {
+    static constexpr unsigned recordOverhead = (
+          Crypto::EncryptedChannel::recordHeaderLength
+        + Crypto::EncryptedChannel::tagLength
+    );
+
+    QBuffer wire;
+    wire.open(QBuffer::ReadWrite);
+
+    Crypto::EncryptedChannel sender(clientKeys, serverKeys, &wire);
+    QVERIFY(sender.open(QIODevice::WriteOnly));
+    QCOMPARE(wire.size(), qint64(Crypto::EncryptedChannel::helloLength));
+
+    QByteArray sent;
+    for (unsigned i=0 ; i<20 ; ++i) {
+        QByteArray message = generateData(10 + i, i);
+        QCOMPARE(sender.write(message), qint64(message.size()));
+        sent.append(message);
+    }
+
+    QCOMPARE(wire.size(), qint64(Crypto::EncryptedChannel::helloLength));
+    QCOMPARE(sender.bytesToWrite(), qint64(sent.size()));
+
+    QCoreApplication::processEvents();
+
+    QCOMPARE(wire.size(), qint64(Crypto::EncryptedChannel::helloLength + sent.size() + recordOverhead));
+    QCOMPARE(sender.bytesToWrite(), qint64(0));
+
+    // Writes larger than a record are split into full records.
+    sender.write(generateData(3 * Crypto::EncryptedChannel::defaultRecordSize + 5, 1));
+    sender.close();
+
+    qint64 expectedSize = (
+          Crypto::EncryptedChannel::helloLength
+        + sent.size()
+        + 3 * Crypto::EncryptedChannel::defaultRecordSize + 5
+        + 5 * recordOverhead
+    );
+    QCOMPARE(wire.size(), expectedSize);
+
+    wire.seek(0);
+    Crypto::EncryptedChannel receiver(serverKeys, clientKeys, &wire);
+    QVERIFY(receiver.open(QIODevice::ReadOnly));
+    QCOMPARE(receiver.read(sent.size()), sent);
+    QCOMPARE(receiver.readAll(), generateData(3 * Crypto::EncryptedChannel::defaultRecordSize + 5, 1));
+}
+
+
+void TestEncryptedChannel::testTamper() {
+    QBuffer wire;
+    wire.open(QBuffer::ReadWrite);
+
+    Crypto::EncryptedChannel sender(clientKeys, serverKeys, &wire);
+    QVERIFY(sender.open(QIODevice::WriteOnly));
+    sender.write(generateData(100, 1));
+    QVERIFY(sender.flush());
+    sender.write(generateData(100, 2));
+    sender.close();
+
+    QByteArray stream = wire.data();
+
+    {
+        QBuffer input(&stream);
+        input.open(QBuffer::ReadOnly);
+
+        Crypto::EncryptedChannel receiver(serverKeys, clientKeys, &input);
+        QVERIFY(receiver.open(QIODevice::ReadOnly));
+        QCOMPARE(receiver.readAll(), generateData(100, 1) + generateData(100, 2));
+    }
+
+    {
+        // Damaging the second record leaves the first record readable.
+        QByteArray damaged = stream;
+        damaged[damaged.size() - 30] = static_cast<char>(damaged.at(damaged.size() - 30) ^ 0x01);
+
+        QBuffer input(&damaged);
+        input.open(QBuffer::ReadOnly);
+
+        Crypto::EncryptedChannel receiver(serverKeys, clientKeys, &input);
+        QVERIFY(receiver.open(QIODevice::ReadOnly));
+        QCOMPARE(receiver.bytesAvailable(), qint64(100));
+        QCOMPARE(receiver.read(200), generateData(100, 1));
+        QCOMPARE(receiver.read(200).size(), 0);
+        QVERIFY(!receiver.errorString().isEmpty());
+    }
+
+    {
+        // Records can not be reordered.
+        int recordLength = static_cast<int>(
+            Crypto::EncryptedChannel::recordHeaderLength + 100 + Crypto::EncryptedChannel::tagLength
+        );
+
+        QByteArray reordered = (
+              stream.left(Crypto::EncryptedChannel::helloLength)
+            + stream.right(recordLength)
+            + stream.mid(Crypto::EncryptedChannel::helloLength, recordLength)
+        );
+
+        QBuffer input(&reordered);
+        input.open(QBuffer::ReadOnly);
+
+        Crypto::EncryptedChannel receiver(serverKeys, clientKeys, &input);
+        QVERIFY(receiver.open(QIODevice::ReadOnly));
+        QCOMPARE(receiver.bytesAvailable(), qint64(0));
+    }
+
+    {
+        QBuffer input(&stream);
+        input.open(QBuffer::ReadOnly);
+
+        Crypto::EncryptedChannel receiver(clientKeys, clientKeys, &input);
+        QVERIFY(receiver.open(QIODevice::ReadOnly));
+        QCOMPARE(receiver.bytesAvailable(), qint64(0));
+        QVERIFY(!receiver.errorString().isEmpty());
+    }
+
+    {
+        QByteArray invalid = stream;
+        invalid[0] = 'X';
+
+        QBuffer input(&invalid);
+        input.open(QBuffer::ReadOnly);
+
+        Crypto::EncryptedChannel receiver(serverKeys, clientKeys, &input);
+        QVERIFY(receiver.open(QIODevice::ReadOnly));
+        QCOMPARE(receiver.bytesAvailable(), qint64(0));
+        QVERIFY(!receiver.errorString().isEmpty());
+    }
+}
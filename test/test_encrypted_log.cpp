@@ -0,0 +1,362 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Crypto::EncryptedLog class.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+#include <cstring>
+
+#include <crypto_aes_gcm_encryptor.h>
+#include <crypto_aes_gcm_decryptor.h>
+#include <crypto_encrypted_log.h>
+#include <crypto_helpers.h>
+
+#include "test_encrypted_log.h"
+
+static const Crypto::AesGcmEncryptor::Keys encryptorKeys = {
+    0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+    0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+};
+
+static const Crypto::AesGcmDecryptor::Keys decryptorKeys = {
+    0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+    0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+};
+
+static QByteArrayList generateRecords(unsigned numberRecords) {
+    QByteArrayList result;
+    for (unsigned i=0 ; i<numberRecords ; ++i) {
+        result.append(Crypto::generateRandomArray((i * 37) % 300));
+    }
+
+    return result;
+}
+
+
+void TestEncryptedLog::testAppendAndRead() {
+    Crypto::AesGcmEncryptor encryptor(encryptorKeys);
+    Crypto::AesGcmDecryptor decryptor(decryptorKeys);
+    encryptor.setIVHeaderEnabled();
+    decryptor.setIVHeaderEnabled();
+
+    QByteArray logData;
+    QByteArray indexData;
+    QBuffer    logBuffer(&logData);
+    QBuffer    indexBuffer(&indexData);
+    logBuffer.open(QBuffer::OpenModeFlag::ReadWrite);
+    indexBuffer.open(QBuffer::OpenModeFlag::ReadWrite);
+
+    QByteArrayList records = generateRecords(150);
+
+    Crypto::EncryptedLog log(&encryptor, &decryptor, &logBuffer, &indexBuffer);
+    QVERIFY(log.open());
+    QCOMPARE(log.numberRecords(), 0ULL);
+
+    for (const QByteArray& record : records) {
+        QVERIFY(log.append(record));
+    }
+
+    QCOMPARE(log.numberRecords(), static_cast<unsigned long long>(records.size()));
+    QCOMPARE(
+        static_cast<unsigned>(indexData.size()),
+        Crypto::EncryptedLog::indexHeaderLength + records.size() * Crypto::EncryptedLog::indexEntryLength
+    );
+
+    for (unsigned i=0 ; i<static_cast<unsigned>(records.size()) ; ++i) {
+        unsigned   recordIndex = (i * 61) % records.size();
+        QByteArray record;
+
+        QVERIFY(log.readRecord(recordIndex, record));
+        QCOMPARE(record, records.at(recordIndex));
+    }
+
+    QByteArray missing;
+    QVERIFY(!log.readRecord(records.size(), missing));
+
+    QByteArrayList run;
+    QVERIFY(log.readRecords(20, 35, run));
+    QCOMPARE(run, records.mid(20, 35));
+
+    QVERIFY(log.readRecords(140, 100, run));
+    QCOMPARE(run, records.mid(140));
+
+    QVERIFY(log.readRecords(0, records.size(), run));
+    QCOMPARE(run, records);
+
+    log.close();
+
+    // Reopening picks up the existing records and appends after them.
+    Crypto::EncryptedLog reopened(&encryptor, &decryptor, &logBuffer, &indexBuffer);
+    QVERIFY(reopened.open());
+    QCOMPARE(reopened.numberRecords(), static_cast<unsigned long long>(records.size()));
+
+    QByteArray extra = Crypto::generateRandomArray(77);
+    QVERIFY(reopened.append(extra));
+
+    QByteArray record;
+    QVERIFY(reopened.readRecord(records.size(), record));
+    QCOMPARE(record, extra);
+    QVERIFY(reopened.readRecord(3, record));
+    QCOMPARE(record, records.at(3));
+}
+
+
+void TestEncryptedLog::testRecovery() {
+    Crypto::AesGcmEncryptor encryptor(encryptorKeys);
+    Crypto::AesGcmDecryptor decryptor(decryptorKeys);
+    encryptor.setIVHeaderEnabled();
+    decryptor.setIVHeaderEnabled();
+
+    QByteArray logData;
+    QByteArray indexData;
+    QBuffer    logBuffer(&logData);
+    QBuffer    indexBuffer(&indexData);
+    logBuffer.open(QBuffer::OpenModeFlag::ReadWrite);
+    indexBuffer.open(QBuffer::OpenModeFlag::ReadWrite);
+
+    QByteArrayList records = generateRecords(12);
+
+    Crypto::EncryptedLog log(&encryptor, &decryptor, &logBuffer, &indexBuffer);
+    QVERIFY(log.open());
+    for (const QByteArray& record : records) {
+        QVERIFY(log.append(record));
+    }
+
+    log.close();
+
+    QByteArray completeLog   = logData;
+    QByteArray completeIndex = indexData;
+
+    // Records written to the log but missing from the index, including a torn index entry.
+    indexData.resize(Crypto::EncryptedLog::indexHeaderLength + 5 * Crypto::EncryptedLog::indexEntryLength + 3);
+    QVERIFY(log.open());
+    QCOMPARE(log.numberRecords(), static_cast<unsigned long long>(records.size()));
+    QCOMPARE(indexData, completeIndex);
+    log.close();
+
+    // Index entries for records that never reached the log and a partially written record.
+    QByteArray lastRecord;
+    QVERIFY(log.open());
+    QVERIFY(log.readRecord(records.size() - 1, lastRecord));
+    log.close();
+
+    logData.chop(5);
+    QVERIFY(log.open());
+    QCOMPARE(log.numberRecords(), static_cast<unsigned long long>(records.size() - 1));
+    QCOMPARE(
+        static_cast<unsigned>(indexData.size()),
+        Crypto::EncryptedLog::indexHeaderLength + (records.size() - 1) * Crypto::EncryptedLog::indexEntryLength
+    );
+
+    QVERIFY(log.append(lastRecord));
+    QCOMPARE(log.numberRecords(), static_cast<unsigned long long>(records.size()));
+
+    QByteArrayList run;
+    QVERIFY(log.readRecords(0, records.size(), run));
+    QCOMPARE(run, records);
+    log.close();
+
+    // An empty log with an empty index.
+    logData.clear();
+    indexData.clear();
+    QVERIFY(log.open());
+    QCOMPARE(log.numberRecords(), 0ULL);
+    QVERIFY(!log.readRecords(0, 10, run));
+    log.close();
+
+    // An index that is not an index.
+    indexData = QByteArray("not an index at all");
+    QVERIFY(!log.open());
+    QVERIFY(!log.errorString().isEmpty());
+}
+
+
+void TestEncryptedLog::testTamper() {
+    Crypto::AesGcmEncryptor encryptor(encryptorKeys);
+    Crypto::AesGcmDecryptor decryptor(decryptorKeys);
+    encryptor.setIVHeaderEnabled();
+    decryptor.setIVHeaderEnabled();
+
+    QByteArray logData;
+    QByteArray indexData;
+    QBuffer    logBuffer(&logData);
+    QBuffer    indexBuffer(&indexData);
+    logBuffer.open(QBuffer::OpenModeFlag::ReadWrite);
+    indexBuffer.open(QBuffer::OpenModeFlag::ReadWrite);
+
+    QByteArrayList records = generateRecords(6);
+
+    Crypto::EncryptedLog log(&encryptor, &decryptor, &logBuffer, &indexBuffer);
+    QVERIFY(log.open());
+    for (const QByteArray& record : records) {
+        QVERIFY(log.append(record));
+    }
+
+    // Flip a bit in the body of record 3.
+    QByteArray record;
+    unsigned long long offset = 0;
+    for (unsigned i=0 ; i<3 ; ++i) {
+        QVERIFY(log.readRecord(i, record));
+
+        std::size_t recordLength = static_cast<std::size_t>(records.at(i).size());
+        offset += (
+              Crypto::EncryptedLog::frameHeaderLength
+            + encryptor.encryptedSize(recordLength + Crypto::EncryptedLog::recordHeaderLength)
+        );
+    }
+
+    int tamperOffset = static_cast<int>(offset + Crypto::EncryptedLog::frameHeaderLength + 20);
+    logData[tamperOffset] = static_cast<char>(logData.at(tamperOffset) ^ 0x01);
+
+    QVERIFY(!log.readRecord(3, record));
+    QVERIFY(!log.errorString().isEmpty());
+
+    QVERIFY(log.readRecord(2, record));
+    QCOMPARE(record, records.at(2));
+    QVERIFY(log.readRecord(4, record));
+    QCOMPARE(record, records.at(4));
+
+    QByteArrayList run;
+    QVERIFY(!log.readRecords(0, records.size(), run));
+    QVERIFY(run.isEmpty());
+
+    // The wrong key.
+    Crypto::AesGcmDecryptor::Keys wrongKeys;
+    std::memcpy(wrongKeys, decryptorKeys, sizeof(wrongKeys));
+    wrongKeys[5] ^= 0x80;
+
+    Crypto::AesGcmDecryptor wrongDecryptor(wrongKeys);
+    wrongDecryptor.setIVHeaderEnabled();
+    log.setDecryptor(&wrongDecryptor);
+    QVERIFY(!log.readRecord(0, record));
+}
+
+
+void TestEncryptedLog::testReorder() {
+    Crypto::AesGcmEncryptor encryptor(encryptorKeys);
+    Crypto::AesGcmDecryptor decryptor(decryptorKeys);
+    encryptor.setIVHeaderEnabled();
+    decryptor.setIVHeaderEnabled();
+
+    QByteArray logData;
+    QByteArray indexData;
+    QBuffer    logBuffer(&logData);
+    QBuffer    indexBuffer(&indexData);
+    logBuffer.open(QBuffer::OpenModeFlag::ReadWrite);
+    indexBuffer.open(QBuffer::OpenModeFlag::ReadWrite);
+
+    // Records of equal length give frames of equal length so frames can be moved without touching the index.
+    QByteArrayList records;
+    for (unsigned i=0 ; i<5 ; ++i) {
+        records.append(Crypto::generateRandomArray(40));
+    }
+
+    Crypto::EncryptedLog log(&encryptor, &decryptor, &logBuffer, &indexBuffer);
+    QVERIFY(log.open());
+    for (const QByteArray& record : records) {
+        QVERIFY(log.append(record));
+    }
+
+    int        frameLength = logData.size() / records.size();
+    QByteArray original    = logData;
+
+    // Swap records 1 and 2.
+    QByteArray frame1 = logData.mid(1 * frameLength, frameLength);
+    QByteArray frame2 = logData.mid(2 * frameLength, frameLength);
+    logData.replace(1 * frameLength, frameLength, frame2);
+    logData.replace(2 * frameLength, frameLength, frame1);
+
+    QByteArray record;
+    QVERIFY(!log.readRecord(1, record));
+    QVERIFY(!log.readRecord(2, record));
+    QVERIFY(log.readRecord(0, record));
+    QCOMPARE(record, records.at(0));
+    QVERIFY(log.readRecord(3, record));
+    QCOMPARE(record, records.at(3));
+
+    QByteArrayList run;
+    QVERIFY(!log.readRecords(0, records.size(), run));
+    QVERIFY(run.isEmpty());
+
+    log.close();
+
+    // Delete record 1 along with the last index entry so the log and index remain consistent.
+    logData = original;
+    logData.remove(1 * frameLength, frameLength);
+    indexData.chop(Crypto::EncryptedLog::indexEntryLength);
+
+    QVERIFY(log.open());
+    QCOMPARE(log.numberRecords(), static_cast<unsigned long long>(records.size() - 1));
+
+    QVERIFY(log.readRecord(0, record));
+    QCOMPARE(record, records.at(0));
+    QVERIFY(!log.readRecord(1, record));
+    QVERIFY(!log.readRecord(3, record));
+}
+
+
+void TestEncryptedLog::testFiles() {
+    Crypto::AesGcmEncryptor encryptor(encryptorKeys);
+    Crypto::AesGcmDecryptor decryptor(decryptorKeys);
+    encryptor.setIVHeaderEnabled();
+    decryptor.setIVHeaderEnabled();
+
+    QTemporaryFile logFile;
+    QTemporaryFile indexFile;
+    QVERIFY(logFile.open());
+    QVERIFY(indexFile.open());
+
+    QByteArrayList records = generateRecords(40);
+
+    Crypto::EncryptedLog log(&encryptor, &decryptor, &logFile, &indexFile);
+    QVERIFY(log.open());
+    for (unsigned i=0 ; i<30 ; ++i) {
+        QVERIFY(log.append(records.at(i)));
+    }
+
+    log.close();
+
+    // Reopening maps the index holding the first 30 entries.  The remaining entries are appended after the mapping.
+    QVERIFY(log.open());
+    for (unsigned i=30 ; i<static_cast<unsigned>(records.size()) ; ++i) {
+        QVERIFY(log.append(records.at(i)));
+    }
+
+    for (unsigned i=0 ; i<static_cast<unsigned>(records.size()) ; ++i) {
+        unsigned   recordIndex = (i * 7) % records.size();
+        QByteArray record;
+
+        QVERIFY(log.readRecord(recordIndex, record));
+        QCOMPARE(record, records.at(recordIndex));
+    }
+
+    QByteArrayList run;
+    QVERIFY(log.readRecords(25, 10, run));
+    QCOMPARE(run, records.mid(25, 10));
+
+    log.close();
+}
@@ -0,0 +1,60 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header provides tests for the Crypto::EncryptedLog class.
+***********************************************************************************************************************/
+
+#ifndef TEST_ENCRYPTED_LOG_H
+#define TEST_ENCRYPTED_LOG_H
+
+#include <QtGlobal>
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestEncryptedLog:public QObject {
+    Q_OBJECT
+
+    private slots:
+        /**
+         * Tests appending records and reading them back individually and in runs.
+         */
+        void testAppendAndRead();
+
+        /**
+         * Tests recovery from an index that is out of step with the log and from a partially written record.
+         */
+        void testRecovery();
+
+        /**
+         * Tests that altered records are rejected without affecting other records.
+         */
+        void testTamper();
+
+        /**
+         * Tests that records swapped or shifted to another position are rejected.
+         */
+        void testReorder();
+
+        /**
+         * Tests a log held in files with a memory mapped index.
+         */
+        void testFiles();
+};
+
+#endif
@@ -23,9 +23,11 @@
 #include <QDebug>
 #include <QString>
 #include <QByteArray>
+#include <QByteArrayList>
 #include <QtTest/QtTest>
 
 #include <crypto_hmac.h>
+#include <crypto_const_buffer.h>
 
 #include "test_hmac.h"
 
@@ -66,3 +68,29 @@ void TestHmac::testHmac() {
 
     QCOMPARE(digest, expectedDigest);
 }
+
+
+void TestHmac::testHmacScatterGather() {
+    QByteArray key("scatter-gather key");
+
+    QByteArrayList pieces;
+    pieces << QByteArray("header:") << QByteArray() << QByteArray("a body that is longer than one hash block, ")
+           << QByteArray("and continues past the block boundary.") << QByteArray(":trailer");
+
+    QByteArray message = pieces.join();
+    QByteArray expectedDigest = Crypto::Hmac(key, message).digest();
+
+    Crypto::Hmac listHmac(key);
+    listHmac.addData(pieces);
+    QCOMPARE(listHmac.digest(), expectedDigest);
+
+    Crypto::ConstBuffer buffers[5];
+    for (int i=0 ; i<5 ; ++i) {
+        buffers[i].data   = reinterpret_cast<const std::uint8_t*>(pieces[i].constData());
+        buffers[i].length = static_cast<std::size_t>(pieces[i].size());
+    }
+
+    Crypto::Hmac bufferHmac(key);
+    bufferHmac.addData(buffers, 5);
+    QCOMPARE(bufferHmac.digest(), expectedDigest);
+}
@@ -40,6 +40,11 @@ class TestHmac:public QObject {
          * Tests the Crypto::Hmac class.
          */
         void testHmac();
+
+        /**
+         * Tests the Crypto::Hmac scatter-gather methods.
+         */
+        void testHmacScatterGather();
 };
 
 #endif
@@ -27,7 +27,16 @@
 #include "test_crc_generator.h"
 #include "test_xtea.h"
 #include "test_aes_cbc.h"
+#include "test_aes_ctr.h"
+#include "test_aes_gcm.h"
+#include "test_chacha20_poly1305.h"
 #include "test_hmac.h"
+#include "test_core.h"
+#include "test_segmented.h"
+#include "test_encrypted_log.h"
+#include "test_compression.h"
+#include "test_encrypted_channel.h"
+#include "test_kdf.h"
 
 #define TEST(_X) {                                                  \
     _X _x;                                                          \
@@ -42,7 +51,16 @@ int main(int argumentCount, char** argumentValues) {
     TEST(TestCrcGenerator)
     TEST(TestXtea)
     TEST(TestAesCbc)
+    TEST(TestAesCtr)
+    TEST(TestAesGcm)
+    TEST(TestChaCha20Poly1305)
     TEST(TestHmac)
+    TEST(TestCore)
+    TEST(TestSegmented)
+    TEST(TestEncryptedLog)
+    TEST(TestCompression)
+    TEST(TestEncryptedChannel)
+    TEST(TestKdf)
 
     return testStatus;
 }
@@ -0,0 +1,271 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Crypto::Kdf and Crypto::DerivedKeyCache classes.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QString>
+#include <QByteArray>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <crypto_const_buffer.h>
+#include <crypto_kdf.h>
+#include <crypto_derived_key_cache.h>
+#include <crypto_aes_cbc_encryptor.h>
+#include <crypto_aes_cbc_decryptor.h>
+
+#include "test_kdf.h"
+
+static inline const std::uint8_t* bytes(const QByteArray& array) {
+    return reinterpret_cast<const std::uint8_t*>(array.constData());
+}
+
+
+static QByteArray pbkdf2(const QByteArray& password, const QByteArray& salt, unsigned long iterations, int length) {
+    QByteArray result(length, '\x00');
+    bool success = Crypto::Kdf::pbkdf2(
+        bytes(password),
+        static_cast<std::size_t>(password.size()),
+        bytes(salt),
+        static_cast<std::size_t>(salt.size()),
+        iterations,
+        reinterpret_cast<std::uint8_t*>(result.data()),
+        static_cast<std::size_t>(length)
+    );
+
+    return success ? result : QByteArray();
+}
+
+
+void TestKdf::testHkdf() {
+    QByteArray inputKey = QByteArray::fromHex("0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B");
+    QByteArray salt     = QByteArray::fromHex("000102030405060708090A0B0C");
+    QByteArray info     = QByteArray::fromHex("F0F1F2F3F4F5F6F7F8F9");
+
+    QByteArray pseudoRandomKey(Crypto::Kdf::digestSize, '\x00');
+    Crypto::Kdf::hkdfExtract(
+        bytes(salt),
+        static_cast<std::size_t>(salt.size()),
+        bytes(inputKey),
+        static_cast<std::size_t>(inputKey.size()),
+        reinterpret_cast<std::uint8_t*>(pseudoRandomKey.data())
+    );
+
+    QCOMPARE(
+        pseudoRandomKey,
+        QByteArray::fromHex("077709362C2E32DF0DDC3F0DC47BBA6390B6C73BB50F9C3122EC844AD7C2B3E5")
+    );
+
+    QByteArray outputKey(42, '\x00');
+    QVERIFY(
+        Crypto::Kdf::hkdf(
+            bytes(salt),
+            static_cast<std::size_t>(salt.size()),
+            bytes(inputKey),
+            static_cast<std::size_t>(inputKey.size()),
+            bytes(info),
+            static_cast<std::size_t>(info.size()),
+            reinterpret_cast<std::uint8_t*>(outputKey.data()),
+            static_cast<std::size_t>(outputKey.size())
+        )
+    );
+
+    QCOMPARE(
+        outputKey,
+        QByteArray::fromHex(
+            "3CB25F25FAACD57A90434F64D0362F2A2D2D0A90CF1A5A4C5DB02D56ECC4C5BF34007208D5B887185865"
+        )
+    );
+
+    // Test case 3 uses an empty salt and empty info.
+    QVERIFY(
+        Crypto::Kdf::hkdf(
+            Q_NULLPTR,
+            0,
+            bytes(inputKey),
+            static_cast<std::size_t>(inputKey.size()),
+            Q_NULLPTR,
+            0,
+            reinterpret_cast<std::uint8_t*>(outputKey.data()),
+            static_cast<std::size_t>(outputKey.size())
+        )
+    );
+
+    QCOMPARE(
+        outputKey,
+        QByteArray::fromHex(
+            "8DA4E775A563C18F715F802A063C5A31B8A11F5C5EE1879EC3454E5F3C738D2D9D201395FAA4B61A96C8"
+        )
+    );
+
+    std::uint8_t tooLong[1];
+    QVERIFY(
+        !Crypto::Kdf::hkdfExpand(
+            bytes(pseudoRandomKey),
+            Crypto::Kdf::digestSize,
+            Q_NULLPTR,
+            0,
+            tooLong,
+            Crypto::Kdf::maximumHkdfLength + 1
+        )
+    );
+}
+
+
+void TestKdf::testPbkdf2() {
+    QCOMPARE(
+        pbkdf2("password", "salt", 1, 32),
+        QByteArray::fromHex("120FB6CFFCF8B32C43E7225256C4F837A86548C92CCC35480805987CB70BE17B")
+    );
+
+    QCOMPARE(
+        pbkdf2("password", "salt", 2, 32),
+        QByteArray::fromHex("AE4D0C95AF6B46D32D0ADFF928F06DD02A303F8EF3C251DFD6E2D85A95474C43")
+    );
+
+    QCOMPARE(
+        pbkdf2("password", "salt", 4096, 32),
+        QByteArray::fromHex("C5E478D59288C841AA530DB6845C4C8D962893A001CE4E11A4963873AA98134A")
+    );
+
+    // More than one output block, with a partial final block.
+    QCOMPARE(
+        pbkdf2("passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096, 40),
+        QByteArray::fromHex("348C89DBCBD32B2F32D814B8116E84CF2B17347EBC1800181C4E2A1FB8DD53E1C635518C7DAC47E9")
+    );
+
+    QVERIFY(pbkdf2("password", "salt", 0, 32).isEmpty());
+}
+
+
+void TestKdf::testPbkdf2Batch() {
+    // Enough passwords and blocks to fill more than one group of lanes, including a long password that is hashed
+    // before use.
+    QList<QByteArray> passwords;
+    for (unsigned i=0 ; i<11 ; ++i) {
+        passwords.append(QByteArray(static_cast<int>(i * 9), static_cast<char>('a' + i)));
+    }
+
+    QByteArray salt("batch salt");
+
+    for (unsigned keyLength : { 16U, 32U, 80U }) {
+        std::vector<Crypto::ConstBuffer> buffers;
+        for (const QByteArray& password : passwords) {
+            buffers.push_back({ bytes(password), static_cast<std::size_t>(password.size()) });
+        }
+
+        QByteArray derivedKeys(static_cast<int>(keyLength) * passwords.size(), '\x00');
+        QVERIFY(
+            Crypto::Kdf::pbkdf2(
+                buffers.data(),
+                buffers.size(),
+                bytes(salt),
+                static_cast<std::size_t>(salt.size()),
+                100,
+                reinterpret_cast<std::uint8_t*>(derivedKeys.data()),
+                keyLength
+            )
+        );
+
+        for (int i=0 ; i<passwords.size() ; ++i) {
+            QCOMPARE(
+                derivedKeys.mid(i * static_cast<int>(keyLength), static_cast<int>(keyLength)),
+                pbkdf2(passwords.at(i), salt, 100, static_cast<int>(keyLength))
+            );
+        }
+    }
+}
+
+
+void TestKdf::testDeriveKey() {
+    QByteArray salt("0123456789ABCDEF");
+
+    Crypto::AesCbcEncryptor       encryptor;
+    Crypto::AesCbcEncryptor::Keys keys;
+    QVERIFY(encryptor.deriveKey(keys, QString("correct horse battery staple"), salt, 1000));
+
+    QCOMPARE(
+        QByteArray(reinterpret_cast<const char*>(keys), Crypto::AesCbcEncryptor::keyLength),
+        pbkdf2("correct horse battery staple", salt, 1000, Crypto::AesCbcEncryptor::keyLength)
+    );
+
+    Crypto::AesCbcDecryptor       decryptor;
+    Crypto::AesCbcDecryptor::Keys decryptorKeys;
+    QVERIFY(decryptor.deriveKey(decryptorKeys, QByteArray("correct horse battery staple"), salt, 1000));
+    QCOMPARE(std::memcmp(keys, decryptorKeys, Crypto::AesCbcEncryptor::keyLength), 0);
+
+    encryptor.setKeys(keys);
+    decryptor.setKeys(decryptorKeys);
+
+    QByteArray plainText("Where Alph, the sacred river, ran");
+    QCOMPARE(decryptor.decrypt(encryptor.encrypt(plainText)), plainText);
+
+    QVERIFY(!encryptor.deriveKey(keys, QString("password"), salt, 0));
+}
+
+
+void TestKdf::testDerivedKeyCache() {
+    Crypto::DerivedKeyCache cache(2);
+    QCOMPARE(cache.capacity(), 2U);
+    QCOMPARE(cache.size(), 0U);
+
+    QByteArray first = cache.pbkdf2("password", "salt", 4096, 32);
+    QCOMPARE(first, pbkdf2("password", "salt", 4096, 32));
+    QCOMPARE(cache.size(), 1U);
+
+    QCOMPARE(cache.pbkdf2("password", "salt", 4096, 32), first);
+    QCOMPARE(cache.size(), 1U);
+
+    // Each parameter forms part of the lookup.
+    QCOMPARE(cache.pbkdf2("password", "salt", 4095, 32), pbkdf2("password", "salt", 4095, 32));
+    QCOMPARE(cache.pbkdf2("password", "salt", 4096, 16), pbkdf2("password", "salt", 4096, 16));
+    QCOMPARE(cache.pbkdf2("passwor", "dsalt", 4096, 32), pbkdf2("passwor", "dsalt", 4096, 32));
+    QCOMPARE(cache.size(), 2U);
+
+    QByteArray inputKey = QByteArray::fromHex("0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B0B");
+    QCOMPARE(
+        cache.hkdf(inputKey, QByteArray(), QByteArray(), 42),
+        QByteArray::fromHex(
+            "8DA4E775A563C18F715F802A063C5A31B8A11F5C5EE1879EC3454E5F3C738D2D9D201395FAA4B61A96C8"
+        )
+    );
+
+    QVERIFY(cache.pbkdf2("password", "salt", 0, 32).isEmpty());
+    QVERIFY(cache.hkdf(inputKey, QByteArray(), QByteArray(), Crypto::Kdf::maximumHkdfLength + 1).isEmpty());
+
+    // Modifying a returned key must not change the cached key.
+    QByteArray hkdfKey = cache.hkdf(inputKey, QByteArray(), QByteArray(), 42);
+    hkdfKey[0] = '\x00';
+    QCOMPARE(cache.hkdf(inputKey, QByteArray(), QByteArray(), 42).at(0), '\x8D');
+
+    cache.setCapacity(1);
+    QCOMPARE(cache.size(), 1U);
+
+    cache.clear();
+    QCOMPARE(cache.size(), 0U);
+
+    cache.setCapacity(0);
+    QCOMPARE(cache.pbkdf2("password", "salt", 4096, 32), first);
+    QCOMPARE(cache.size(), 0U);
+}
@@ -0,0 +1,394 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This file implements tests of the Crypto::SegmentedEncryptor, Crypto::SegmentedDecryptor and Crypto::DecryptedView
+* classes.
+***********************************************************************************************************************/
+
+#include <QDebug>
+#include <QByteArray>
+#include <QBuffer>
+#include <QThreadPool>
+#include <QtTest/QtTest>
+
+#include <cstdint>
+#include <cstring>
+
+#include <crypto_segmented_encryptor.h>
+#include <crypto_segmented_decryptor.h>
+#include <crypto_decrypted_view.h>
+#include <crypto_helpers.h>
+
+#include "test_segmented.h"
+
+static const Crypto::SegmentedEncryptor::Keys encryptorKeys = {
+    0x60, 0x3D, 0xEB, 0x10, 0x15, 0xCA, 0x71, 0xBE, 0x2B, 0x73, 0xAE, 0xF0, 0x85, 0x7D, 0x77, 0x81,
+    0x1F, 0x35, 0x2C, 0x07, 0x3B, 0x61, 0x08, 0xD7, 0x2D, 0x98, 0x10, 0xA3, 0x09, 0x14, 0xDF, 0xF4
+};
+
+static const Crypto::DecryptedView::Keys viewKeys = {
+    0x60, 0x3D, 0xEB, 0x10, 0x15, 0xCA, 0x71, 0xBE, 0x2B, 0x73, 0xAE, 0xF0, 0x85, 0x7D, 0x77, 0x81,
+    0x1F, 0x35, 0x2C, 0x07, 0x3B, 0x61, 0x08, 0xD7, 0x2D, 0x98, 0x10, 0xA3, 0x09, 0x14, 0xDF, 0xF4
+};
+
+static const Crypto::SegmentedDecryptor::Keys decryptorKeys = {
+    0x60, 0x3D, 0xEB, 0x10, 0x15, 0xCA, 0x71, 0xBE, 0x2B, 0x73, 0xAE, 0xF0, 0x85, 0x7D, 0x77, 0x81,
+    0x1F, 0x35, 0x2C, 0x07, 0x3B, 0x61, 0x08, 0xD7, 0x2D, 0x98, 0x10, 0xA3, 0x09, 0x14, 0xDF, 0xF4
+};
+
+void TestSegmented::testBlockRoundTrip() {
+    static const unsigned segmentSize = 64;
+    static const unsigned lengths[]   = { 0, 1, 63, 64, 65, 127, 128, 129, 1000, 4096 };
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(3);
+
+    for (unsigned pass=0 ; pass<2 ; ++pass) {
+        Crypto::SegmentedEncryptor encryptor(encryptorKeys);
+        Crypto::SegmentedDecryptor decryptor(decryptorKeys);
+
+        encryptor.setSegmentSize(segmentSize);
+        if (pass == 1) {
+            encryptor.setThreadPool(&threadPool);
+            decryptor.setThreadPool(&threadPool);
+        }
+
+        for (unsigned length : lengths) {
+            QByteArray plainText = Crypto::generateRandomArray(length);
+            QByteArray encrypted = encryptor.encrypt(plainText);
+
+            QCOMPARE(static_cast<unsigned long long>(encrypted.size()), encryptor.encryptedSize(length));
+            QCOMPARE(decryptor.decrypt(encrypted), plainText);
+
+            // Every container gets a fresh salt and nonce prefix.
+            QVERIFY(encryptor.encrypt(plainText) != encrypted);
+        }
+    }
+}
+
+
+void TestSegmented::testStreaming() {
+    static const unsigned segmentSize = 100;
+
+    QByteArray plainText = Crypto::generateRandomArray(5000);
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(4);
+
+    for (unsigned pass=0 ; pass<2 ; ++pass) {
+        QByteArray encrypted;
+        QBuffer    encryptedBuffer(&encrypted);
+        encryptedBuffer.open(QBuffer::OpenModeFlag::WriteOnly);
+
+        Crypto::SegmentedEncryptor encryptor(encryptorKeys, &encryptedBuffer);
+        encryptor.setSegmentSize(segmentSize);
+        if (pass == 1) {
+            encryptor.setThreadPool(&threadPool);
+        }
+
+        QVERIFY(encryptor.open(Crypto::SegmentedEncryptor::OpenModeFlag::WriteOnly));
+
+        int index  = 0;
+        int length = 1;
+        while (index < plainText.size()) {
+            encryptor.write(plainText.mid(index, length));
+            index += length;
+            length = (length * 7 + 3) % 257;
+        }
+
+        encryptor.close();
+        encryptedBuffer.close();
+
+        QCOMPARE(
+            static_cast<unsigned long long>(encrypted.size()),
+            encryptor.encryptedSize(static_cast<unsigned long long>(plainText.size()))
+        );
+
+        Crypto::SegmentedDecryptor blockDecryptor(decryptorKeys);
+        QCOMPARE(blockDecryptor.decrypt(encrypted), plainText);
+
+        encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+        Crypto::SegmentedDecryptor decryptor(decryptorKeys, &encryptedBuffer);
+        if (pass == 1) {
+            decryptor.setThreadPool(&threadPool);
+        }
+
+        QVERIFY(decryptor.open(Crypto::SegmentedDecryptor::OpenModeFlag::ReadOnly));
+        QCOMPARE(decryptor.segmentSize(), segmentSize);
+        QCOMPARE(decryptor.size(), static_cast<qint64>(plainText.size()));
+        QCOMPARE(decryptor.readAll(), plainText);
+
+        decryptor.close();
+        encryptedBuffer.close();
+    }
+}
+
+
+void TestSegmented::testSeek() {
+    static const unsigned segmentSize = 128;
+
+    QByteArray plainText = Crypto::generateRandomArray(10000);
+
+    Crypto::SegmentedEncryptor encryptor(encryptorKeys);
+    encryptor.setSegmentSize(segmentSize);
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(2);
+
+    QBuffer encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::SegmentedDecryptor decryptor(decryptorKeys, &encryptedBuffer);
+    decryptor.setThreadPool(&threadPool);
+    QVERIFY(decryptor.open(Crypto::SegmentedDecryptor::OpenModeFlag::ReadOnly));
+
+    unsigned position = 7;
+    for (unsigned i=0 ; i<200 ; ++i) {
+        unsigned length = (position * 13 + 5) % 700;
+
+        QVERIFY(decryptor.seek(position));
+        QCOMPARE(decryptor.read(length), plainText.mid(position, length));
+
+        position = (position * 31 + 977) % (plainText.size() + 1);
+    }
+
+    QVERIFY(decryptor.seek(plainText.size()));
+    QVERIFY(decryptor.read(10).isEmpty());
+    QVERIFY(!decryptor.seek(plainText.size() + 1));
+
+    decryptor.close();
+    encryptedBuffer.close();
+}
+
+
+void TestSegmented::testTamper() {
+    static const unsigned segmentSize = 64;
+    static const unsigned segmentStride = segmentSize + Crypto::SegmentedEncryptor::tagLength;
+
+    QByteArray plainText = Crypto::generateRandomArray(segmentSize * 3 + 10);
+
+    Crypto::SegmentedEncryptor encryptor(encryptorKeys);
+    encryptor.setSegmentSize(segmentSize);
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    Crypto::SegmentedDecryptor decryptor(decryptorKeys);
+    QCOMPARE(decryptor.decrypt(encrypted), plainText);
+
+    // Flipped bits in the header or in any segment.
+    for (int offset=0 ; offset<encrypted.size() ; offset+=11) {
+        QByteArray modified = encrypted;
+        modified[offset] = static_cast<char>(modified.at(offset) ^ 0x04);
+
+        QVERIFY(decryptor.decrypt(modified).isEmpty());
+    }
+
+    // Swapped segments.
+    QByteArray reordered = encrypted;
+    std::memcpy(
+        reordered.data() + Crypto::SegmentedEncryptor::headerLength,
+        encrypted.constData() + Crypto::SegmentedEncryptor::headerLength + segmentStride,
+        segmentStride
+    );
+    std::memcpy(
+        reordered.data() + Crypto::SegmentedEncryptor::headerLength + segmentStride,
+        encrypted.constData() + Crypto::SegmentedEncryptor::headerLength,
+        segmentStride
+    );
+    QVERIFY(decryptor.decrypt(reordered).isEmpty());
+
+    // Truncated on a segment boundary, where the last remaining segment was not encrypted as the last segment.
+    QByteArray truncated = encrypted.left(Crypto::SegmentedEncryptor::headerLength + 2 * segmentStride);
+    QVERIFY(decryptor.decrypt(truncated).isEmpty());
+
+    // Truncated part way through a segment.
+    for (int length=0 ; length<encrypted.size() ; length+=7) {
+        QVERIFY(decryptor.decrypt(encrypted.left(length)).isEmpty());
+    }
+
+    // A damaged final segment is reported when it is read, not at open.
+    QByteArray damaged = encrypted;
+    damaged[damaged.size() - 1] = static_cast<char>(damaged.at(damaged.size() - 1) ^ 0x80);
+
+    QBuffer damagedBuffer(&damaged);
+    damagedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::SegmentedDecryptor streamDecryptor(decryptorKeys, &damagedBuffer);
+    QVERIFY(streamDecryptor.open(Crypto::SegmentedDecryptor::OpenModeFlag::ReadOnly));
+    QCOMPARE(streamDecryptor.read(segmentSize), plainText.left(segmentSize));
+    QVERIFY(streamDecryptor.seek(segmentSize * 3));
+    QCOMPARE(streamDecryptor.read(10), QByteArray());
+    streamDecryptor.close();
+
+    // The wrong key is reported at open.
+    Crypto::SegmentedDecryptor::Keys wrongKeys;
+    std::memcpy(wrongKeys, decryptorKeys, sizeof(wrongKeys));
+    wrongKeys[0] ^= 0x01;
+
+    Crypto::SegmentedDecryptor wrongKeyDecryptor(wrongKeys, &damagedBuffer);
+    QVERIFY(!wrongKeyDecryptor.open(Crypto::SegmentedDecryptor::OpenModeFlag::ReadOnly));
+
+    damagedBuffer.close();
+}
+
+
+void TestSegmented::testContainerKeys() {
+    static const unsigned segmentSize = 64;
+    static const int      saltOffset  = 16;
+    static const int      saltLength  = 32;
+
+    QByteArray plainText = Crypto::generateRandomArray(segmentSize * 2 + 5);
+
+    Crypto::SegmentedEncryptor encryptor(encryptorKeys);
+    encryptor.setSegmentSize(segmentSize);
+
+    QByteArray first  = encryptor.encrypt(plainText);
+    QByteArray second = encryptor.encrypt(plainText);
+
+    QCOMPARE(first.size(), second.size());
+    QVERIFY(first.mid(saltOffset, saltLength) != second.mid(saltOffset, saltLength));
+
+    // No segment may be shared between the two containers.
+    for (int offset=Crypto::SegmentedEncryptor::headerLength ; offset<first.size() ; offset+=segmentSize) {
+        QVERIFY(first.mid(offset, segmentSize) != second.mid(offset, segmentSize));
+    }
+
+    // One decryptor moving between containers must pick up the keys of each container.
+    Crypto::SegmentedDecryptor decryptor(decryptorKeys);
+    QCOMPARE(decryptor.decrypt(first), plainText);
+    QCOMPARE(decryptor.decrypt(second), plainText);
+    QCOMPARE(decryptor.decrypt(first), plainText);
+
+    // The body of one container under the header of the other is rejected.
+    QByteArray spliced = second.left(Crypto::SegmentedEncryptor::headerLength)
+                         + first.mid(Crypto::SegmentedEncryptor::headerLength);
+    QVERIFY(decryptor.decrypt(spliced).isEmpty());
+}
+
+
+void TestSegmented::testDecryptedView() {
+    static const unsigned segmentSize = 96;
+
+    QByteArray plainText = Crypto::generateRandomArray(7777);
+
+    Crypto::SegmentedEncryptor encryptor(encryptorKeys);
+    encryptor.setSegmentSize(segmentSize);
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(3);
+
+    QBuffer encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    for (unsigned pass=0 ; pass<2 ; ++pass) {
+        Crypto::DecryptedView view(viewKeys);
+        view.setCacheCapacity(5);
+
+        if (pass == 0) {
+            view.setInputDevice(&encryptedBuffer);
+        } else {
+            view.setInputData(reinterpret_cast<const std::uint8_t*>(encrypted.constData()), encrypted.size());
+            view.setThreadPool(&threadPool);
+        }
+
+        QVERIFY(view.open(Crypto::DecryptedView::OpenModeFlag::ReadOnly));
+        QCOMPARE(view.pageSize(), segmentSize);
+        QCOMPARE(view.size(), static_cast<qint64>(plainText.size()));
+
+        unsigned offset = 11;
+        for (unsigned i=0 ; i<300 ; ++i) {
+            unsigned length = (offset * 17 + 3) % 900;
+            QCOMPARE(view.readAt(offset, length), plainText.mid(offset, length));
+
+            offset = (offset * 29 + 1013) % (plainText.size() + 1);
+        }
+
+        QCOMPARE(view.readAt(plainText.size() - 5, 100), plainText.right(5));
+        QVERIFY(view.readAt(plainText.size(), 100).isEmpty());
+
+        QVERIFY(view.seek(1000));
+        QCOMPARE(view.read(500), plainText.mid(1000, 500));
+        QCOMPARE(view.pos(), 1500);
+        QVERIFY(view.seek(0));
+        QCOMPARE(view.readAll(), plainText);
+
+        view.close();
+    }
+
+    // Damaged pages are only reported when they are read.
+    QByteArray damaged = encrypted;
+    int        damagedOffset = Crypto::SegmentedEncryptor::headerLength + 3 * (segmentSize + 16) + 5;
+    damaged[damagedOffset] = static_cast<char>(damaged.at(damagedOffset) ^ 0x10);
+
+    Crypto::DecryptedView damagedView(viewKeys);
+    damagedView.setInputData(reinterpret_cast<const std::uint8_t*>(damaged.constData()), damaged.size());
+    QVERIFY(damagedView.open(Crypto::DecryptedView::OpenModeFlag::ReadOnly));
+    QCOMPARE(damagedView.readAt(0, 3 * segmentSize), plainText.left(3 * segmentSize));
+    QVERIFY(damagedView.readAt(3 * segmentSize, 1).isEmpty());
+    QCOMPARE(damagedView.readAt(4 * segmentSize, 10), plainText.mid(4 * segmentSize, 10));
+    damagedView.close();
+
+    encryptedBuffer.close();
+}
+
+
+void TestSegmented::testDecryptedViewCache() {
+    static const unsigned segmentSize = 64;
+
+    QByteArray plainText = Crypto::generateRandomArray(segmentSize * 20);
+
+    Crypto::SegmentedEncryptor encryptor(encryptorKeys);
+    encryptor.setSegmentSize(segmentSize);
+    QByteArray encrypted = encryptor.encrypt(plainText);
+
+    Crypto::DecryptedView view(viewKeys);
+    view.setInputData(reinterpret_cast<const std::uint8_t*>(encrypted.constData()), encrypted.size());
+    view.setCacheCapacity(4);
+    QVERIFY(view.open(Crypto::DecryptedView::OpenModeFlag::ReadOnly));
+    QCOMPARE(view.pagesDecrypted(), 0ULL);
+
+    // A cold read only decrypts the pages it touches.
+    QCOMPARE(view.readAt(segmentSize + 10, segmentSize), plainText.mid(segmentSize + 10, segmentSize));
+    QCOMPARE(view.pagesDecrypted(), 2ULL);
+
+    // Repeated reads are served from the cache.
+    for (unsigned i=0 ; i<10 ; ++i) {
+        unsigned length = 2 * segmentSize - 2 * i;
+        QCOMPARE(view.readAt(segmentSize + i, length), plainText.mid(segmentSize + i, length));
+    }
+    QCOMPARE(view.pagesDecrypted(), 2ULL);
+
+    // Fill the cache with pages 1 through 4, then touch page 1 so page 2 becomes the least recently used.
+    QCOMPARE(view.readAt(3 * segmentSize, 2 * segmentSize), plainText.mid(3 * segmentSize, 2 * segmentSize));
+    QCOMPARE(view.pagesDecrypted(), 4ULL);
+    QCOMPARE(view.readAt(segmentSize, 1), plainText.mid(segmentSize, 1));
+
+    QCOMPARE(view.readAt(10 * segmentSize, 1), plainText.mid(10 * segmentSize, 1));
+    QCOMPARE(view.pagesDecrypted(), 5ULL);
+
+    QCOMPARE(view.readAt(segmentSize, 1), plainText.mid(segmentSize, 1));
+    QCOMPARE(view.pagesDecrypted(), 5ULL);
+
+    QCOMPARE(view.readAt(2 * segmentSize, 1), plainText.mid(2 * segmentSize, 1));
+    QCOMPARE(view.pagesDecrypted(), 6ULL);
+
+    view.close();
+}
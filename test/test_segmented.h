@@ -0,0 +1,71 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright 2016 - 2022 Inesonic, LLC.
+*
+* MIT License:
+*   Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+*   documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+*   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+*   permit persons to whom the Software is furnished to do so, subject to the following conditions:
+*   
+*   The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+*   Software.
+*   
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+*   WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+*   OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+*   OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+********************************************************************************************************************//**
+* \file
+*
+* This header provides tests for the Crypto::SegmentedEncryptor, Crypto::SegmentedDecryptor and Crypto::DecryptedView
+* classes.
+***********************************************************************************************************************/
+
+#ifndef TEST_SEGMENTED_H
+#define TEST_SEGMENTED_H
+
+#include <QtGlobal>
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestSegmented:public QObject {
+    Q_OBJECT
+
+    private slots:
+        /**
+         * Tests the block encrypt and decrypt methods across segment boundaries.
+         */
+        void testBlockRoundTrip();
+
+        /**
+         * Tests streaming encryption with and without a thread pool.
+         */
+        void testStreaming();
+
+        /**
+         * Tests seeking and random reads through the decryptor.
+         */
+        void testSeek();
+
+        /**
+         * Tests that modified, reordered and truncated containers are rejected.
+         */
+        void testTamper();
+
+        /**
+         * Tests that every container is encrypted with its own keys.
+         */
+        void testContainerKeys();
+
+        /**
+         * Tests random access reads through the Crypto::DecryptedView class.
+         */
+        void testDecryptedView();
+
+        /**
+         * Tests the Crypto::DecryptedView page cache.
+         */
+        void testDecryptedViewCache();
+};
+
+#endif
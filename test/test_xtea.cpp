@@ -24,12 +24,19 @@
 #include <QString>
 #include <QByteArray>
 #include <QBuffer>
+#include <QList>
+#include <QThreadPool>
 #include <QtTest/QtTest>
 
+#include <cstdint>
+#include <cstring>
 #include <random>
+#include <vector>
 
 #include <crypto_xtea_encryptor.h>
 #include <crypto_xtea_decryptor.h>
+#include <crypto_xtea_engine.h>
+#include <crypto_xtea_multi_stream.h>
 
 #include "test_xtea.h"
 
@@ -123,3 +130,282 @@ void TestXtea::testXteaEncryptDecryptFuzz() {
     }
 }
 
+
+void TestXtea::testXteaInPlace() {
+    Crypto::XteaEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    QByteArray plainText("For he on honey-dew hath fed.");
+
+    Crypto::XteaEncryptor encryptor(keys);
+    Crypto::XteaDecryptor decryptor(keys);
+
+    QByteArray  expected = encryptor.encrypt(plainText);
+    std::size_t length   = static_cast<std::size_t>(plainText.size());
+
+    QByteArray buffer = plainText;
+    buffer.resize(static_cast<int>(encryptor.encryptedSize(length)));
+
+    std::uint8_t* data = reinterpret_cast<std::uint8_t*>(buffer.data());
+    QCOMPARE(encryptor.encryptInPlace(data, length, static_cast<std::size_t>(buffer.size())), length + 3);
+    QCOMPARE(buffer, expected);
+
+    QCOMPARE(decryptor.decryptInPlace(data, static_cast<std::size_t>(buffer.size())), length + 3);
+    QCOMPARE(buffer.left(plainText.size()), plainText);
+}
+
+
+void TestXtea::testXteaMultiStream() {
+    std::mt19937                    rng(0x87654321);
+    std::uniform_int_distribution<> byteDistribution(0, 255);
+
+    unsigned lanes = Crypto::XteaMultiStream::lanes();
+    QVERIFY(lanes == 1 || lanes == 4 || lanes == 8);
+
+    QList<QByteArray> keys;
+    QList<QByteArray> plainTexts;
+    QList<QByteArray> expected;
+    for (unsigned i=0 ; i<37 ; ++i) {
+        Crypto::XteaEncryptor::Keys recordKeys;
+        for (unsigned ki=0 ; ki<Crypto::XteaEncryptor::keyLength ; ++ki) {
+            recordKeys[ki] = static_cast<std::uint8_t>(byteDistribution(rng));
+        }
+
+        QByteArray plainText;
+        unsigned   length = (byteDistribution(rng) * 7) % 1021;
+        for (unsigned bi=0 ; bi<length ; ++bi) {
+            plainText.append(static_cast<char>(byteDistribution(rng)));
+        }
+
+        Crypto::XteaEncryptor encryptor(recordKeys);
+
+        keys.append(QByteArray(reinterpret_cast<const char*>(recordKeys), Crypto::XteaEncryptor::keyLength));
+        plainTexts.append(plainText);
+        expected.append(encryptor.encrypt(plainText));
+    }
+
+    QList<QByteArray> encrypted = Crypto::XteaMultiStream::encrypt(keys, plainTexts);
+    QCOMPARE(encrypted, expected);
+
+    QList<QByteArray> decrypted = Crypto::XteaMultiStream::decrypt(keys, encrypted);
+    QCOMPARE(decrypted.size(), plainTexts.size());
+    for (int i=0 ; i<plainTexts.size() ; ++i) {
+        Crypto::XteaDecryptor::Keys recordKeys;
+        std::memcpy(recordKeys, keys.at(i).constData(), Crypto::XteaDecryptor::keyLength);
+
+        Crypto::XteaDecryptor decryptor(recordKeys);
+        QCOMPARE(decrypted.at(i), decryptor.decrypt(encrypted.at(i)));
+        QCOMPARE(decrypted.at(i).left(plainTexts.at(i).size()), plainTexts.at(i));
+    }
+
+    // Streams of equal length are grouped in order rather than sorted.
+    constexpr unsigned equalLength = 64;
+    QByteArray equalPlainText;
+    for (unsigned bi=0 ; bi<equalLength * static_cast<unsigned>(keys.size()) ; ++bi) {
+        equalPlainText.append(static_cast<char>(byteDistribution(rng)));
+    }
+
+    QByteArray                                   equalCipherText(equalPlainText.size(), '\x00');
+    QByteArray                                   equalDecrypted(equalPlainText.size(), '\x00');
+    std::vector<Crypto::XteaMultiStream::Stream> encryptStreams(static_cast<std::size_t>(keys.size()));
+    std::vector<Crypto::XteaMultiStream::Stream> decryptStreams(static_cast<std::size_t>(keys.size()));
+    for (int i=0 ; i<keys.size() ; ++i) {
+        std::size_t         offset     = static_cast<std::size_t>(i) * equalLength;
+        const std::uint8_t* recordKeys = reinterpret_cast<const std::uint8_t*>(keys.at(i).constData());
+
+        encryptStreams[static_cast<std::size_t>(i)] = {
+            recordKeys,
+            reinterpret_cast<const std::uint8_t*>(equalPlainText.constData()) + offset,
+            equalLength,
+            reinterpret_cast<std::uint8_t*>(equalCipherText.data()) + offset
+        };
+
+        decryptStreams[static_cast<std::size_t>(i)] = {
+            recordKeys,
+            reinterpret_cast<const std::uint8_t*>(equalCipherText.constData()) + offset,
+            equalLength,
+            reinterpret_cast<std::uint8_t*>(equalDecrypted.data()) + offset
+        };
+    }
+
+    Crypto::XteaMultiStream::encryptEqualLength(encryptStreams.data(), encryptStreams.size());
+    Crypto::XteaMultiStream::decryptEqualLength(decryptStreams.data(), decryptStreams.size());
+
+    for (int i=0 ; i<keys.size() ; ++i) {
+        Crypto::XteaEncryptor::Keys recordKeys;
+        std::memcpy(recordKeys, keys.at(i).constData(), Crypto::XteaEncryptor::keyLength);
+
+        Crypto::XteaEncryptor encryptor(recordKeys);
+        int offset = i * static_cast<int>(equalLength);
+        QCOMPARE(
+            equalCipherText.mid(offset, equalLength),
+            encryptor.encrypt(equalPlainText.mid(offset, equalLength))
+        );
+    }
+
+    QCOMPARE(equalDecrypted, equalPlainText);
+
+    keys.removeLast();
+    QVERIFY(Crypto::XteaMultiStream::encrypt(keys, plainTexts).isEmpty());
+}
+
+
+void TestXtea::testXteaCipherTextChaining() {
+    Crypto::XteaEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    QByteArray plainText;
+    for (unsigned i=0 ; i<1024 * 1024 + 13 ; ++i) {
+        plainText.append(static_cast<char>((i * 131) ^ (i >> 8)));
+    }
+
+    Crypto::XteaEncryptor legacyEncryptor(keys);
+    Crypto::XteaEncryptor encryptor(keys);
+    QCOMPARE(encryptor.keySchedule(), Crypto::XteaEncryptor::PlainTextChaining);
+
+    encryptor.setKeySchedule(Crypto::XteaEncryptor::CipherTextChaining);
+    QCOMPARE(encryptor.keySchedule(), Crypto::XteaEncryptor::CipherTextChaining);
+
+    QByteArray encrypted = encryptor.encrypt(plainText);
+    QCOMPARE(encrypted.size(), legacyEncryptor.encrypt(plainText).size());
+    QVERIFY(encrypted != legacyEncryptor.encrypt(plainText));
+
+    Crypto::XteaDecryptor legacyDecryptor(keys);
+    QVERIFY(!legacyDecryptor.supportsParallelDecryption());
+    QVERIFY(legacyDecryptor.decrypt(encrypted).left(plainText.size()) != plainText);
+
+    Crypto::XteaDecryptor decryptor(keys);
+    decryptor.setKeySchedule(Crypto::XteaDecryptor::CipherTextChaining);
+    QVERIFY(decryptor.supportsParallelDecryption());
+    QVERIFY(decryptor.supportsRandomAccess());
+    QCOMPARE(decryptor.decrypt(encrypted).left(plainText.size()), plainText);
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(4);
+    decryptor.setThreadPool(&threadPool);
+    QCOMPARE(decryptor.decrypt(encrypted).left(plainText.size()), plainText);
+
+    QByteArray  buffer     = encrypted;
+    std::size_t outputSize = decryptor.decryptInPlace(
+        reinterpret_cast<std::uint8_t*>(buffer.data()),
+        static_cast<std::size_t>(buffer.size())
+    );
+
+    QCOMPARE(outputSize, static_cast<std::size_t>(encrypted.size()));
+    QCOMPARE(buffer.left(plainText.size()), plainText);
+
+    // Seeks must derive the keys for the target block directly.
+    QBuffer encryptedBuffer(&encrypted);
+    encryptedBuffer.open(QBuffer::OpenModeFlag::ReadOnly);
+
+    Crypto::XteaDecryptor streamDecryptor(keys, &encryptedBuffer);
+    streamDecryptor.setKeySchedule(Crypto::XteaDecryptor::CipherTextChaining);
+    streamDecryptor.setRandomAccessEnabled();
+    streamDecryptor.open(Crypto::XteaDecryptor::OpenModeFlag::ReadOnly);
+
+    qint64 positions[] = { 1000000, 17, 0, 65536, 500001 };
+    for (qint64 position : positions) {
+        QVERIFY(streamDecryptor.seek(position));
+        QCOMPARE(streamDecryptor.read(100), plainText.mid(static_cast<int>(position), 100));
+    }
+
+    streamDecryptor.close();
+}
+
+void TestXtea::testXteaBlockEngine() {
+    Crypto::XteaEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    QByteArray plainText("Weave a circle round him thrice, and close your eyes with holy dread.");
+
+    for (unsigned schedule=0 ; schedule<2 ; ++schedule) {
+        Crypto::XteaEncryptor encryptor(keys);
+        Crypto::XteaDecryptor decryptor(keys);
+
+        Crypto::XteaEncryptEngine encryptEngine(keys);
+        Crypto::XteaDecryptEngine decryptEngine(keys);
+
+        if (schedule == 1) {
+            encryptor.setKeySchedule(Crypto::XteaEncryptor::CipherTextChaining);
+            decryptor.setKeySchedule(Crypto::XteaDecryptor::CipherTextChaining);
+            encryptEngine.setCipherTextChainingEnabled();
+            decryptEngine.setCipherTextChainingEnabled();
+        }
+
+        QByteArray  expected = encryptor.encrypt(plainText);
+        std::size_t length   = static_cast<std::size_t>(plainText.size());
+        QCOMPARE(
+            Crypto::XteaEncryptEngine::encryptedSize(length),
+            static_cast<std::size_t>(expected.size())
+        );
+
+        QByteArray encrypted(expected.size(), '\x00');
+        std::uint8_t* encryptedData = reinterpret_cast<std::uint8_t*>(encrypted.data());
+
+        QCOMPARE(encryptEngine.encrypt(encryptedData, length, encryptedData, 0), static_cast<std::size_t>(0));
+        QCOMPARE(
+            encryptEngine.encrypt(
+                reinterpret_cast<const std::uint8_t*>(plainText.constData()),
+                length,
+                encryptedData,
+                static_cast<std::size_t>(encrypted.size())
+            ),
+            static_cast<std::size_t>(expected.size())
+        );
+        QCOMPARE(encrypted, expected);
+
+        std::size_t decryptedLength = decryptEngine.decrypt(
+            encryptedData,
+            static_cast<std::size_t>(encrypted.size()),
+            encryptedData,
+            static_cast<std::size_t>(encrypted.size())
+        );
+
+        QCOMPARE(decryptedLength, static_cast<std::size_t>(encrypted.size()));
+        QCOMPARE(encrypted, decryptor.decrypt(expected));
+        QCOMPARE(encrypted.left(plainText.size()), plainText);
+    }
+}
+
+void TestXtea::benchmarkXteaEncrypt() {
+    Crypto::XteaEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    Crypto::XteaEncryptor encryptor(keys);
+    QByteArray            plainText(1024 * 1024, '\x5A');
+    QByteArray            encrypted;
+
+    QBENCHMARK {
+        encrypted = encryptor.encrypt(plainText);
+    }
+
+    QCOMPARE(encrypted.size(), plainText.size());
+}
+
+
+void TestXtea::benchmarkXteaDecrypt() {
+    Crypto::XteaEncryptor::Keys keys = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10
+    };
+
+    Crypto::XteaEncryptor encryptor(keys);
+    Crypto::XteaDecryptor decryptor(keys);
+    QByteArray            plainText(1024 * 1024, '\x5A');
+    QByteArray            encrypted = encryptor.encrypt(plainText);
+    QByteArray            decrypted;
+
+    QBENCHMARK {
+        decrypted = decryptor.decrypt(encrypted);
+    }
+
+    QCOMPARE(decrypted, plainText);
+}
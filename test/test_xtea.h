@@ -37,6 +37,18 @@ class TestXtea:public QObject {
 
         void testXteaEncryptDecryptFuzz();
 
+        void testXteaInPlace();
+
+        void testXteaMultiStream();
+
+        void testXteaCipherTextChaining();
+
+        void testXteaBlockEngine();
+
+        void benchmarkXteaEncrypt();
+
+        void benchmarkXteaDecrypt();
+
     private:
         static constexpr unsigned N = 100000;
 };